@@ -0,0 +1,270 @@
+#include "Bench.h"
+#include "Trace.h"
+#include "MemoryTracking.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+
+/**
+ * @file Bench.cpp
+ * @brief Харнесс бенчмарков: счетчики выделений, отчет, JSON
+ */
+
+// ===================================================================
+// ПОДСЧЕТ ВЫДЕЛЕНИЙ ПАМЯТИ
+// ===================================================================
+
+/*
+  Глобальные operator new/delete заменяются только в исполняемом файле
+  bench: библиотека и тесты работают со стандартными.
+  Счетчики атомарные - бенчмарки параллельных алгоритмов выделяют
+  память из нескольких потоков.
+*/
+static std::atomic<long long> allocCount(0);
+static std::atomic<long long> allocBytes(0);
+
+static void* countedAlloc(std::size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add((long long)size, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+/*
+  Фигуры и буферы Array выделяются мимо глобального operator new
+  (через trackedAllocate), их считает перехватчик из MemoryTracking.h
+*/
+class BenchAllocationHook : public AllocationHook {
+public:
+    void allocated(void*, std::size_t bytes) override {
+        allocCount.fetch_add(1, std::memory_order_relaxed);
+        allocBytes.fetch_add((long long)bytes, std::memory_order_relaxed);
+    }
+    void freed(void*, std::size_t) override {}
+};
+
+static BenchAllocationHook benchHook;
+
+AllocCounters allocCounters() {
+    AllocCounters c;
+    c.count = allocCount.load(std::memory_order_relaxed);
+    c.bytes = allocBytes.load(std::memory_order_relaxed);
+    return c;
+}
+
+// ===================================================================
+// СОСТОЯНИЕ ПРОГОНА
+// ===================================================================
+
+BenchState::BenchState() {
+    elapsedNs = 0;
+    allocStart = {0, 0};
+    allocTotal = {0, 0};
+    running = false;
+}
+
+void BenchState::start() {
+    running = true;
+    allocStart = allocCounters();
+    started = Clock::now();
+}
+
+void BenchState::stop() {
+    if (!running) return;
+    Clock::time_point now = Clock::now();
+    AllocCounters a = allocCounters();
+    elapsedNs += std::chrono::duration<double, std::nano>(now - started).count();
+    allocTotal.count += a.count - allocStart.count;
+    allocTotal.bytes += a.bytes - allocStart.bytes;
+    running = false;
+}
+
+void BenchState::pause() { stop(); }
+
+void BenchState::resume() {
+    if (!running) start();
+}
+
+// ===================================================================
+// ЗАПУСК И ОТЧЕТ
+// ===================================================================
+
+BenchRunner::BenchRunner(int argc, char** argv) {
+    filter = nullptr;
+    jsonPath = nullptr;
+    tracePath = nullptr;
+    minTimeNs = 50e6;
+    repeats = 5;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+            filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0 && hasValue) {
+            jsonPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace") == 0 && hasValue) {
+            tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+            minTimeNs = std::atof(argv[++i]) * 1e6;
+        } else if (std::strcmp(argv[i], "--repeats") == 0 && hasValue) {
+            repeats = std::atoi(argv[++i]);
+            if (repeats < 1) repeats = 1;
+        } else {
+            std::cerr << "Неизвестный аргумент: " << argv[i] << std::endl;
+        }
+    }
+
+    count = 0;
+    capacity = 16;
+    results = new BenchResult[capacity];
+    metricCount = 0;
+    metricCapacity = 4;
+    metrics = new BenchMetric[metricCapacity];
+
+    setAllocationHook(&benchHook);
+    if (tracePath) traceStart();
+
+    std::printf("%-32s %12s %12s %14s %10s %12s %8s\n",
+                "benchmark", "ns/op", "min ns/op", "ops/s", "allocs/op", "MB/s", "GB/s");
+}
+
+BenchRunner::~BenchRunner() {
+    setAllocationHook(nullptr);
+    delete[] results;
+    delete[] metrics;
+}
+
+bool BenchRunner::selected(const char* name) const {
+    return filter == nullptr || std::strstr(name, filter) != nullptr;
+}
+
+bool BenchRunner::anySelected(const char* const* names, int n) const {
+    for (int i = 0; i < n; i++) {
+        if (selected(names[i])) return true;
+    }
+    return false;
+}
+
+void BenchRunner::record(const BenchResult& result) {
+    if (count >= capacity) {
+        capacity *= 2;
+        BenchResult* grown = new BenchResult[capacity];
+        for (int i = 0; i < count; i++) grown[i] = results[i];
+        delete[] results;
+        results = grown;
+    }
+    results[count++] = result;
+
+    if (result.bytesPerSec > 0) {
+        std::printf("%-32s %12.2f %12.2f %14.0f %10.3f %12.1f %8.3f\n", result.name,
+                    result.nsPerOp, result.nsPerOpMin, result.opsPerSec,
+                    result.allocsPerOp, result.bytesPerSec / 1e6, result.bytesPerSec / 1e9);
+    } else {
+        std::printf("%-32s %12.2f %12.2f %14.0f %10.3f %12s %8s\n", result.name,
+                    result.nsPerOp, result.nsPerOpMin, result.opsPerSec,
+                    result.allocsPerOp, "-", "-");
+    }
+    std::fflush(stdout);
+}
+
+void BenchRunner::metric(const char* name, double value) {
+    if (!selected(name)) return;
+    if (metricCount >= metricCapacity) {
+        metricCapacity *= 2;
+        BenchMetric* grown = new BenchMetric[metricCapacity];
+        for (int i = 0; i < metricCount; i++) grown[i] = metrics[i];
+        delete[] metrics;
+        metrics = grown;
+    }
+    BenchMetric& m = metrics[metricCount++];
+    std::snprintf(m.name, sizeof(m.name), "%s", name);
+    m.value = value;
+
+    std::printf("%-32s %12.6g (metric)\n", m.name, value);
+    std::fflush(stdout);
+}
+
+/*
+  Формат - плоский список объектов, по одному на бенчмарк, список
+  величин metric() и сведения о сборке. Имена не содержат кавычек
+  и обратных слэшей, поэтому экранирование не нужно.
+*/
+void BenchRunner::writeJson(std::ostream& os) const {
+    os << "{\n";
+    os << "  \"context\": {\n";
+#ifdef BENCH_BUILD_TYPE
+    os << "    \"build_type\": \"" << BENCH_BUILD_TYPE << "\",\n";
+#endif
+#if defined(__clang__)
+    os << "    \"compiler\": \"clang " << __clang_major__ << "." << __clang_minor__ << "\",\n";
+#elif defined(__GNUC__)
+    os << "    \"compiler\": \"gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "\",\n";
+#elif defined(_MSC_VER)
+    os << "    \"compiler\": \"msvc " << _MSC_VER << "\",\n";
+#endif
+    os << "    \"repeats\": " << repeats << ",\n";
+    os << "    \"min_time_ms\": " << minTimeNs / 1e6 << "\n";
+    os << "  },\n";
+    os << "  \"benchmarks\": [\n";
+    for (int i = 0; i < count; i++) {
+        const BenchResult& r = results[i];
+        os << "    {\"name\": \"" << r.name << "\""
+           << ", \"iterations\": " << r.iterations
+           << ", \"ns_per_op\": " << r.nsPerOp
+           << ", \"ns_per_op_min\": " << r.nsPerOpMin
+           << ", \"ops_per_sec\": " << r.opsPerSec
+           << ", \"bytes_per_sec\": " << r.bytesPerSec
+           << ", \"allocs_per_op\": " << r.allocsPerOp
+           << ", \"alloc_bytes_per_op\": " << r.allocBytesPerOp << "}"
+           << (i + 1 < count ? ",\n" : "\n");
+    }
+    os << "  ],\n";
+    os << "  \"metrics\": [\n";
+    for (int i = 0; i < metricCount; i++) {
+        os << "    {\"name\": \"" << metrics[i].name << "\", \"value\": " << metrics[i].value << "}"
+           << (i + 1 < metricCount ? ",\n" : "\n");
+    }
+    os << "  ]\n";
+    os << "}\n";
+}
+
+int BenchRunner::finish() {
+    int status = 0;
+
+    if (jsonPath) {
+        std::ofstream out(jsonPath);
+        if (out) {
+            out.precision(6);
+            writeJson(out);
+            std::cout << "Результаты записаны в " << jsonPath << std::endl;
+        } else {
+            std::cerr << "Не удалось открыть " << jsonPath << std::endl;
+            status = 1;
+        }
+    }
+
+    if (tracePath) {
+        traceStop();
+        std::ofstream out(tracePath);
+        if (out && writeTrace(out)) {
+            std::cout << "Трасса (" << traceEventCount() << " событий) записана в "
+                      << tracePath << std::endl;
+        } else {
+            std::cerr << "Не удалось записать " << tracePath << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
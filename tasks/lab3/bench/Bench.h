@@ -0,0 +1,252 @@
+#pragma once
+#include <chrono>
+#include <ostream>
+
+/**
+ * @file Bench.h
+ * @brief Минимальный харнесс для замеров производительности
+ *
+ * Без внешних зависимостей: замер времени через std::chrono,
+ * подсчет выделений памяти через подмену глобального operator new
+ * (см. Bench.cpp), результаты - таблица в консоль и JSON в файл.
+ *
+ * @code
+ * BenchRunner runner(argc, argv);
+ * runner.run("area/Square", 1024, [&](BenchState& st) {
+ *     for (int i = 0; i < 1024; i++) doNotOptimize(squares[i]->area());
+ * });
+ * return runner.finish();
+ * @endcode
+ */
+
+/**
+ * @brief Не дает компилятору выбросить вычисление значения
+ */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * @brief Счетчики выделений памяти с момента запуска программы
+ */
+struct AllocCounters {
+    long long count;  ///< Количество вызовов operator new
+    long long bytes;  ///< Суммарный запрошенный размер
+};
+
+/**
+ * @brief Текущие значения счетчиков выделений
+ */
+AllocCounters allocCounters();
+
+/**
+ * @brief Состояние одного прогона: позволяет исключить подготовку из замера
+ *
+ * Все, что выполняется между pause() и resume(), не входит
+ * ни во время, ни в счетчики выделений.
+ */
+class BenchState {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point started;
+    double elapsedNs;
+    AllocCounters allocStart;
+    AllocCounters allocTotal;
+    bool running;
+
+    friend class BenchRunner;
+    void start();
+    void stop();
+
+public:
+    BenchState();
+
+    /**
+     * @brief Останавливает замер (время и выделения)
+     */
+    void pause();
+
+    /**
+     * @brief Продолжает замер после pause()
+     */
+    void resume();
+};
+
+/**
+ * @brief Результат одного бенчмарка
+ */
+struct BenchResult {
+    char name[64];          ///< Имя вида "группа/вариант"
+    long long iterations;   ///< Сколько операций измерено
+    double nsPerOp;         ///< Медиана по повторам, нс на операцию
+    double nsPerOpMin;      ///< Лучший повтор, нс на операцию
+    double opsPerSec;       ///< Пропускная способность по медиане
+    double bytesPerSec;     ///< Байт данных в секунду (0 - не задано)
+    double allocsPerOp;     ///< Выделений памяти на операцию
+    double allocBytesPerOp; ///< Выделенных байт на операцию
+};
+
+/**
+ * @brief Величина, которая не является замером времени (доля, счетчик)
+ *
+ * Пишется в JSON рядом с результатами, чтобы ее рост при сравнении
+ * сборок был виден так же, как рост ns/op.
+ */
+struct BenchMetric {
+    char name[64];          ///< Имя вида "группа/величина"
+    double value;
+};
+
+/**
+ * @brief Запускает бенчмарки, печатает таблицу и пишет JSON
+ *
+ * АРГУМЕНТЫ КОМАНДНОЙ СТРОКИ:
+ * - --filter <подстрока>  запускать только бенчмарки с подстрокой в имени
+ * - --json <файл>         записать результаты в JSON (для сравнения сборок)
+ * - --min-time <мс>       минимальная длительность одного повтора (по умолчанию 50)
+ * - --repeats <n>         количество повторов (по умолчанию 5)
+ * - --trace <файл>        записать временную шкалу в формате Chrome trace-event
+ *
+ * ЗАМЕР: число вызовов тела подбирается удвоением, пока один повтор
+ * не займет min-time, затем выполняется repeats повторов; в отчет
+ * идет медиана (устойчива к случайным помехам) и минимум.
+ */
+class BenchRunner {
+private:
+    const char* filter;
+    const char* jsonPath;
+    const char* tracePath;
+    double minTimeNs;
+    int repeats;
+
+    BenchResult* results;
+    int count;
+    int capacity;
+
+    BenchMetric* metrics;
+    int metricCount;
+    int metricCapacity;
+
+    void record(const BenchResult& result);
+    void writeJson(std::ostream& os) const;
+
+public:
+    BenchRunner(int argc, char** argv);
+    ~BenchRunner();
+
+    BenchRunner(const BenchRunner&) = delete;
+    BenchRunner& operator=(const BenchRunner&) = delete;
+
+    /**
+     * @brief true, если бенчмарк name проходит --filter
+     */
+    bool selected(const char* name) const;
+
+    /**
+     * @brief true, если --filter проходит хотя бы одно из n имен
+     *
+     * Для групп с дорогой подготовкой (файлы, большие наборы): если
+     * ни один бенчмарк группы не запустится, подготовку можно пропустить.
+     */
+    bool anySelected(const char* const* names, int n) const;
+
+    /**
+     * @brief true, если задан --trace (события библиотеки записываются)
+     */
+    bool tracing() const { return tracePath != nullptr; }
+
+    /**
+     * @brief Измеряет body
+     * @param name Имя бенчмарка
+     * @param opsPerCall Сколько операций выполняет один вызов body
+     * @param body Вызываемый объект вида void(BenchState&)
+     * @param bytesPerCall Сколько байт данных обрабатывает один вызов
+     *                     (для пропускной способности в байтах; 0 - не считать)
+     */
+    template <typename Body>
+    void run(const char* name, int opsPerCall, Body body, double bytesPerCall = 0);
+
+    /**
+     * @brief Записывает величину name = value (печать и JSON)
+     *
+     * Как и run(), учитывает --filter: при несовпадении имени
+     * ничего не записывается.
+     */
+    void metric(const char* name, double value);
+
+    /**
+     * @brief Пишет JSON (если задан --json) и трассу (если задан --trace)
+     * @return Код возврата для main()
+     */
+    int finish();
+};
+
+// ===================================================================
+// РЕАЛИЗАЦИЯ ШАБЛОНА
+// ===================================================================
+
+template <typename Body>
+void BenchRunner::run(const char* name, int opsPerCall, Body body, double bytesPerCall) {
+    if (!selected(name)) return;
+
+    // Калибровка: удваиваем число вызовов, пока повтор не станет достаточно длинным
+    long long calls = 1;
+    while (true) {
+        BenchState st;
+        st.start();
+        for (long long c = 0; c < calls; c++) body(st);
+        st.stop();
+        if (st.elapsedNs >= minTimeNs || calls >= (1LL << 40)) break;
+        calls *= 2;
+    }
+
+    double* samples = new double[repeats];
+    AllocCounters allocs = {0, 0};
+    for (int r = 0; r < repeats; r++) {
+        BenchState st;
+        st.start();
+        for (long long c = 0; c < calls; c++) body(st);
+        st.stop();
+        samples[r] = st.elapsedNs / ((double)calls * opsPerCall);
+        allocs.count += st.allocTotal.count;
+        allocs.bytes += st.allocTotal.bytes;
+    }
+
+    // Сортировка вставками: повторов единицы
+    for (int i = 1; i < repeats; i++) {
+        double v = samples[i];
+        int j = i - 1;
+        while (j >= 0 && samples[j] > v) {
+            samples[j + 1] = samples[j];
+            j--;
+        }
+        samples[j + 1] = v;
+    }
+
+    BenchResult result;
+    int len = 0;
+    while (name[len] && len < (int)sizeof(result.name) - 1) {
+        result.name[len] = name[len];
+        len++;
+    }
+    result.name[len] = '\0';
+
+    double ops = (double)calls * opsPerCall * repeats;
+    result.iterations = (long long)ops;
+    result.nsPerOp = samples[repeats / 2];
+    result.nsPerOpMin = samples[0];
+    result.opsPerSec = result.nsPerOp > 0 ? 1e9 / result.nsPerOp : 0;
+    result.bytesPerSec = bytesPerCall > 0 ? result.opsPerSec * bytesPerCall / opsPerCall : 0;
+    result.allocsPerOp = allocs.count / ops;
+    result.allocBytesPerOp = allocs.bytes / ops;
+    delete[] samples;
+
+    record(result);
+}
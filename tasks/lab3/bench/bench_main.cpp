@@ -0,0 +1,806 @@
+#include "Bench.h"
+#include "Square.h"
+#include "Rectangle.h"
+#include "Trapezoid.h"
+#include "Array.h"
+#include "ConcurrentArray.h"
+#include "ShardedStore.h"
+#include "ThreadPool.h"
+#include "Ingest.h"
+#include "Journal.h"
+#include "Codec.h"
+#include "Stream.h"
+#include "Query.h"
+#include "QueryLanguage.h"
+#include "Generator.h"
+#ifdef GEOMETRY_HAS_INT128
+#include "FixedPoint.h"
+#endif
+#include "Orientation.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <mutex>
+
+/**
+ * @file bench_main.cpp
+ * @brief Бенчмарки geometry_lib
+ *
+ * Запуск: ./bench [--filter area] [--json result.json] [--trace trace.json]
+ * Сравнение двух сборок - diff двух JSON-файлов.
+ */
+
+// Размер пакета: одна операция тела бенчмарка выполняется над BATCH фигурами,
+// чтобы накладные расходы цикла замера не влияли на результат
+const int BATCH = 1024;
+
+// ===================================================================
+// ВХОДНЫЕ ДАННЫЕ
+// ===================================================================
+
+/*
+  Вершины фигур в случайном порядке: конструктор вызывает sortPoints(),
+  и на уже упорядоченных данных замер был бы нечестно оптимистичным.
+  Генератор с фиксированным seed - данные одинаковы от запуска к запуску.
+*/
+struct Quads {
+    Point squares[BATCH][4];
+    Point rectangles[BATCH][4];
+    Point trapezoids[BATCH][4];
+
+    Quads() {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> coord(-100, 100);
+        std::uniform_real_distribution<double> size(0.5, 10);
+        std::uniform_real_distribution<double> angle(0, 6.283185307179586);
+
+        for (int i = 0; i < BATCH; i++) {
+            double cx = coord(rng), cy = coord(rng);
+            double w = size(rng), h = size(rng), a = angle(rng);
+            double cs = cos(a), sn = sin(a);
+
+            // Локальные вершины до поворота
+            double sq[4][2] = {{-w, -w}, {w, -w}, {w, w}, {-w, w}};
+            double rc[4][2] = {{-w, -h}, {w, -h}, {w, h}, {-w, h}};
+            double tr[4][2] = {{-w, -h}, {w, -h}, {w / 2, h}, {-w / 2, h}};
+
+            for (int k = 0; k < 4; k++) {
+                squares[i][k] = Point(cx + cs * sq[k][0] - sn * sq[k][1], cy + sn * sq[k][0] + cs * sq[k][1]);
+                rectangles[i][k] = Point(cx + cs * rc[k][0] - sn * rc[k][1], cy + sn * rc[k][0] + cs * rc[k][1]);
+                trapezoids[i][k] = Point(cx + cs * tr[k][0] - sn * tr[k][1], cy + sn * tr[k][0] + cs * tr[k][1]);
+            }
+            std::shuffle(squares[i], squares[i] + 4, rng);
+            std::shuffle(rectangles[i], rectangles[i] + 4, rng);
+            std::shuffle(trapezoids[i], trapezoids[i] + 4, rng);
+        }
+    }
+};
+
+/*
+  Заполняет массив указателей фигурами всех трех типов по очереди.
+*/
+static void makeMixed(const Quads& q, Figure** out) {
+    for (int i = 0; i < BATCH; i++) {
+        switch (i % 3) {
+            case 0: out[i] = new Square(q.squares[i]); break;
+            case 1: out[i] = new Rectangle(q.rectangles[i]); break;
+            default: out[i] = new Trapezoid(q.trapezoids[i]); break;
+        }
+    }
+}
+
+// ===================================================================
+// ФИГУРЫ
+// ===================================================================
+
+/*
+  Конструктор = копирование вершин + sortPoints()
+*/
+template <typename T>
+static void benchConstruct(BenchRunner& runner, const char* name, const Point (*quads)[4]) {
+    runner.run(name, BATCH, [quads](BenchState&) {
+        for (int i = 0; i < BATCH; i++) {
+            T fig(quads[i]);
+            doNotOptimize(fig.getPoints()[0]);
+        }
+    });
+}
+
+/*
+  area() и center() через виртуальный вызов, как в Array
+*/
+template <typename T>
+static void benchMetrics(BenchRunner& runner, const char* areaName, const char* centerName,
+                         const Point (*quads)[4]) {
+    Figure** figs = new Figure*[BATCH];
+    for (int i = 0; i < BATCH; i++) figs[i] = new T(quads[i]);
+
+    runner.run(areaName, BATCH, [figs](BenchState&) {
+        double sum = 0;
+        for (int i = 0; i < BATCH; i++) sum += figs[i]->area();
+        doNotOptimize(sum);
+    });
+    runner.run(centerName, BATCH, [figs](BenchState&) {
+        double sum = 0;
+        for (int i = 0; i < BATCH; i++) {
+            Point c = figs[i]->center();
+            sum += c.x + c.y;
+        }
+        doNotOptimize(sum);
+    });
+
+    for (int i = 0; i < BATCH; i++) delete figs[i];
+    delete[] figs;
+}
+
+/*
+  area() при известном типе: массив объектов Square (area() объявлен
+  final - вызов прямой) и массив значений Quad<Square> без vptr
+*/
+static void benchTyped(BenchRunner& runner, const Point (*quads)[4]) {
+    Square* squares = new Square[BATCH];
+    Quad<Square>* values = new Quad<Square>[BATCH];
+    for (int i = 0; i < BATCH; i++) {
+        squares[i].setPoints(quads[i]);
+        values[i] = Quad<Square>(quads[i]);
+    }
+
+    runner.run("area/Square_typed", BATCH, [squares](BenchState&) {
+        doNotOptimize(sumAreas(squares, BATCH));
+    });
+    runner.run("area/Quad_static", BATCH, [values](BenchState&) {
+        doNotOptimize(sumAreas(values, BATCH));
+    });
+
+    delete[] squares;
+    delete[] values;
+}
+
+static void benchFigures(BenchRunner& runner, const Quads& q) {
+    benchConstruct<Square>(runner, "construct/Square", q.squares);
+    benchConstruct<Rectangle>(runner, "construct/Rectangle", q.rectangles);
+    benchConstruct<Trapezoid>(runner, "construct/Trapezoid", q.trapezoids);
+
+    benchMetrics<Square>(runner, "area/Square", "center/Square", q.squares);
+    benchMetrics<Rectangle>(runner, "area/Rectangle", "center/Rectangle", q.rectangles);
+    benchMetrics<Trapezoid>(runner, "area/Trapezoid", "center/Trapezoid", q.trapezoids);
+    benchTyped(runner, q.squares);
+
+    // operator==: равные фигуры (худший случай - перебираются все сдвиги)
+    // и разные (ранний выход)
+    Figure** a = new Figure*[BATCH];
+    Figure** b = new Figure*[BATCH];
+    makeMixed(q, a);
+    makeMixed(q, b);
+    runner.run("equals/same", BATCH, [a, b](BenchState&) {
+        int hits = 0;
+        for (int i = 0; i < BATCH; i++) hits += *a[i] == *b[i];
+        doNotOptimize(hits);
+    });
+    runner.run("equals/different", BATCH, [a, b](BenchState&) {
+        int hits = 0;
+        for (int i = 0; i < BATCH; i++) hits += *a[i] == *b[(i + 3) % BATCH];
+        doNotOptimize(hits);
+    });
+    for (int i = 0; i < BATCH; i++) {
+        delete a[i];
+        delete b[i];
+    }
+    delete[] a;
+    delete[] b;
+}
+
+// ===================================================================
+// КОЛЛЕКЦИЯ
+// ===================================================================
+
+static void benchArray(BenchRunner& runner, const Quads& q) {
+    Figure** figs = new Figure*[BATCH];
+
+    // push в пустой массив: включает все resize() от 4 до 1024
+    runner.run("array/push_grow", BATCH, [&q, figs](BenchState& st) {
+        st.pause();
+        makeMixed(q, figs);
+        Array* arr = new Array();
+        st.resume();
+
+        for (int i = 0; i < BATCH; i++) arr->push(figs[i]);
+
+        st.pause();
+        delete arr;
+        st.resume();
+    });
+
+    // push в массив, который уже вырос: только запись в конец
+    Array* warm = new Array();
+    runner.run("array/push_warm", BATCH, [&q, figs, warm](BenchState& st) {
+        st.pause();
+        makeMixed(q, figs);
+        st.resume();
+
+        for (int i = 0; i < BATCH; i++) warm->push(figs[i]);
+
+        st.pause();
+        while (warm->size() > 0) warm->remove(warm->size() - 1);
+        st.resume();
+    });
+    delete warm;
+
+    // remove с конца (без сдвига) и с начала (сдвиг всего хвоста)
+    runner.run("array/remove_back", BATCH, [&q, figs](BenchState& st) {
+        st.pause();
+        makeMixed(q, figs);
+        Array* arr = new Array();
+        for (int i = 0; i < BATCH; i++) arr->push(figs[i]);
+        st.resume();
+
+        for (int i = BATCH - 1; i >= 0; i--) arr->remove(i);
+
+        st.pause();
+        delete arr;
+        st.resume();
+    });
+    runner.run("array/remove_front", BATCH, [&q, figs](BenchState& st) {
+        st.pause();
+        makeMixed(q, figs);
+        Array* arr = new Array();
+        for (int i = 0; i < BATCH; i++) arr->push(figs[i]);
+        st.resume();
+
+        for (int i = 0; i < BATCH; i++) arr->remove(0);
+
+        st.pause();
+        delete arr;
+        st.resume();
+    });
+
+    // totalArea(): операция - одна фигура
+    Array full;
+    makeMixed(q, figs);
+    for (int i = 0; i < BATCH; i++) full.push(figs[i]);
+    runner.run("array/totalArea", BATCH, [&full](BenchState&) {
+        doNotOptimize(full.totalArea());
+    });
+
+    // То же через общий пул: при BATCH фигурах задача одна
+    // (зерно 4096), замер показывает накладные расходы пула
+    runner.run("array/totalArea_pool", BATCH, [&full](BenchState&) {
+        doNotOptimize(full.totalArea(ThreadPool::shared()));
+    });
+
+    delete[] figs;
+}
+
+// ===================================================================
+// ПОТОКОБЕЗОПАСНЫЕ ХРАНИЛИЩА
+// ===================================================================
+
+/*
+  push() одновременно из всех ядер: Array под общим мьютексом,
+  ConcurrentArray и ShardedStore. Создание и удаление коллекции
+  не входят в замер; время запуска потоков входит, поэтому пакет
+  на поток большой.
+*/
+template <typename Store, typename Push>
+static void benchParallelPush(BenchRunner& runner, const char* name, const Quads& q, Push push) {
+    const int perThread = 8 * BATCH;
+    int threads = (int)std::thread::hardware_concurrency();
+    if (threads < 2) threads = 2;
+
+    runner.run(name, threads * perThread, [&q, push, threads, perThread](BenchState& st) {
+        st.pause();
+        Store* store = new Store();
+        std::thread* workers = new std::thread[threads];
+        st.resume();
+
+        for (int t = 0; t < threads; t++) {
+            workers[t] = std::thread([&q, push, store, perThread]() {
+                for (int i = 0; i < perThread; i++) push(*store, new Square(q.squares[i % BATCH]));
+            });
+        }
+        for (int t = 0; t < threads; t++) workers[t].join();
+
+        st.pause();
+        delete[] workers;
+        delete store;
+        st.resume();
+    });
+}
+
+struct LockedArray {
+    std::mutex lock;
+    Array figures;
+};
+
+static void benchStores(BenchRunner& runner, const Quads& q) {
+    benchParallelPush<LockedArray>(runner, "store/push_mutex_array", q, [](LockedArray& s, Figure* f) {
+        std::lock_guard<std::mutex> guard(s.lock);
+        s.figures.push(f);
+    });
+    benchParallelPush<ConcurrentArray>(runner, "store/push_concurrent", q,
+                                       [](ConcurrentArray& s, Figure* f) { s.push(f); });
+    benchParallelPush<ShardedStore>(runner, "store/push_sharded", q,
+                                    [](ShardedStore& s, Figure* f) { s.push(f); });
+}
+
+// ===================================================================
+// ТЕКСТОВЫЙ ВВОД/ВЫВОД
+// ===================================================================
+
+static void benchText(BenchRunner& runner, const Quads& q) {
+    // Текст для разбора: 8 чисел на фигуру, как вводит пользователь в lab03
+    std::ostringstream text;
+    text.precision(17);
+    for (int i = 0; i < BATCH; i++) {
+        for (int k = 0; k < 4; k++) text << q.squares[i][k].x << ' ' << q.squares[i][k].y << ' ';
+        text << '\n';
+    }
+    const std::string input = text.str();
+
+    runner.run("text/parse", BATCH, [&input](BenchState&) {
+        std::istringstream is(input);
+        Square fig;
+        for (int i = 0; i < BATCH; i++) is >> fig;
+        doNotOptimize(fig.getPoints()[0]);
+    }, (double)input.size());
+
+    Figure** figs = new Figure*[BATCH];
+    makeMixed(q, figs);
+    std::ostringstream os;
+    runner.run("text/print", BATCH, [figs, &os](BenchState&) {
+        os.str(std::string());
+        for (int i = 0; i < BATCH; i++) os << *figs[i] << '\n';
+        doNotOptimize(os.tellp());
+    });
+    for (int i = 0; i < BATCH; i++) delete figs[i];
+    delete[] figs;
+}
+
+/*
+  Загрузка "Type x1 y1 ... x4 y4": последовательно, как lab03
+  (read() -> sortPoints() -> push() для каждой фигуры), и конвейером
+  стадий. Операция - одна строка; отчет конвейера выводится в stderr,
+  чтобы видеть узкую стадию.
+*/
+static void benchIngest(BenchRunner& runner, const Quads& q) {
+    const char* names[2] = {"ingest/serial", "ingest/pipeline"};
+    if (!runner.anySelected(names, 2)) return;
+    const int lines = 16 * BATCH;
+    std::ostringstream text;
+    text.precision(17);
+    for (int i = 0; i < lines; i++) {
+        text << "Square";
+        for (int k = 0; k < 4; k++) text << ' ' << q.squares[i % BATCH][k].x << ' ' << q.squares[i % BATCH][k].y;
+        text << '\n';
+    }
+    const std::string input = text.str();
+
+    runner.run(names[0], lines, [&input](BenchState& st) {
+        std::istringstream is(input);
+        Array* arr = new Array();
+        std::string type;
+        while (is >> type) {
+            Square* fig = new Square();
+            is >> *fig;
+            arr->push(fig);
+        }
+        st.pause();
+        delete arr;
+        st.resume();
+    }, (double)input.size());
+
+    IngestReport report;
+    runner.run(names[1], lines, [&input, &report](BenchState& st) {
+        std::istringstream is(input);
+        Array* arr = new Array();
+        ingestFigures(is, *arr, &report);
+        st.pause();
+        delete arr;
+        st.resume();
+    }, (double)input.size());
+    if (runner.selected(names[1])) report.print(std::cerr);
+}
+
+// ===================================================================
+// ЖУРНАЛ
+// ===================================================================
+
+/*
+  push() с журналом: fsync на каждую операцию и групповая фиксация
+  по 64 операции. Файлы - в текущем каталоге, удаляются после замера;
+  цена fsync целиком зависит от диска.
+*/
+static void benchJournal(BenchRunner& runner, const Quads& q) {
+    const char* base = "bench_journal";
+    const int ops = 256;
+    int groups[2] = {1, 64};
+    const char* names[2] = {"journal/push_sync_each", "journal/push_group64"};
+    if (!runner.anySelected(names, 2)) return;
+
+    for (int g = 0; g < 2; g++) {
+        JournalOptions options;
+        options.groupCommit = groups[g];
+        options.compactBytes = 0;
+        runner.run(names[g], ops, [&q, &options, base](BenchState& st) {
+            st.pause();
+            std::remove("bench_journal.snapshot");
+            std::remove("bench_journal.journal");
+            JournaledArray* figures = new JournaledArray(options);
+            figures->open(base);
+            st.resume();
+
+            for (int i = 0; i < ops; i++) figures->push(new Square(q.squares[i % BATCH]));
+            figures->commit();
+
+            st.pause();
+            delete figures;
+            st.resume();
+        });
+    }
+    std::remove("bench_journal.snapshot");
+    std::remove("bench_journal.journal");
+}
+
+// ===================================================================
+// СЖАТОЕ ПРЕДСТАВЛЕНИЕ
+// ===================================================================
+
+/*
+  Кодирование и декодирование BATCH фигур вперемешку. Байты на вызов -
+  несжатый размер (тип + 8 double), так что ГБ/с сравнимы между
+  замерами; степень сжатия выводится в stderr.
+*/
+static void benchCodec(BenchRunner& runner, const Quads& q) {
+    const char* names[3] = {"codec/encode", "codec/decode_records", "codec/decode_figures"};
+    if (!runner.anySelected(names, 3)) return;
+    Figure** figs = new Figure*[BATCH];
+    makeMixed(q, figs);
+    Array figures;
+    for (int i = 0; i < BATCH; i++) figures.push(figs[i]);
+    delete[] figs;
+
+    const double rawBytes = (double)BATCH * CODEC_RAW_FIGURE_BYTES;
+    unsigned char* code = new unsigned char[encodedSizeBound(BATCH)];
+    // Кодируем заранее: декодирование замеряется и без codec/encode
+    long long size = encodeFigures(figures, code);
+    runner.run(names[0], BATCH, [&figures, code, &size](BenchState&) {
+        size = encodeFigures(figures, code);
+        doNotOptimize(size);
+    }, rawBytes);
+
+    double* records = new double[8 * BATCH];
+    FigureKind* kinds = new FigureKind[BATCH];
+    runner.run(names[1], BATCH, [code, &size, records, kinds](BenchState&) {
+        doNotOptimize(decodeRecords(code, size, records, kinds));
+    }, rawBytes);
+
+    runner.run(names[2], BATCH, [code, &size](BenchState& st) {
+        Array* out = new Array();
+        decodeFigures(code, size, *out);
+        st.pause();
+        delete out;
+        st.resume();
+    }, rawBytes);
+
+    std::cerr << "codec: " << size << " bytes for " << BATCH << " figures, ratio "
+              << rawBytes / size << "\n";
+    delete[] kinds;
+    delete[] records;
+    delete[] code;
+}
+
+// ===================================================================
+// ПОТОКОВОЕ ЧТЕНИЕ
+// ===================================================================
+
+/*
+  streamStats() по файлу в 64K фигур (текст и кадры Codec): чтение
+  и разбор по очереди и с двойной буферизацией. Файл читается из
+  кэша страниц, поэтому выигрыш двойной буферизации здесь - только
+  копирование fread, на диске он больше. Операция - одна фигура.
+*/
+static void benchStream(BenchRunner& runner, const Quads& q) {
+    const int figures = 64 * BATCH;
+    const char* names[4] = {"stream/text_single", "stream/text_double",
+                            "stream/codec_single", "stream/codec_double"};
+    if (!runner.anySelected(names, 4)) return;
+    const char* textPath = "bench_stream.txt";
+    const char* codecPath = "bench_stream.bin";
+
+    std::ofstream text(textPath);
+    text.precision(17);
+    std::FILE* codec = std::fopen(codecPath, "wb");
+    for (int f = 0; f < figures / BATCH; f++) {
+        Figure** figs = new Figure*[BATCH];
+        makeMixed(q, figs);
+        Array block;
+        for (int i = 0; i < BATCH; i++) {
+            text << figs[i]->getType();
+            for (int k = 0; k < 4; k++) text << ' ' << figs[i]->getPoints()[k].x << ' ' << figs[i]->getPoints()[k].y;
+            text << '\n';
+            block.push(figs[i]);
+        }
+        delete[] figs;
+        appendCodecFrame(codec, block);
+    }
+    double textBytes = (double)text.tellp();
+    text.close();
+    double codecBytes = (double)std::ftell(codec);
+    std::fclose(codec);
+
+    StreamStats stats;
+    for (int v = 0; v < 4; v++) {
+        StreamOptions options;
+        options.doubleBuffer = v % 2 == 1;
+        StreamFormat format = v < 2 ? StreamFormat::Text : StreamFormat::Codec;
+        const char* path = v < 2 ? textPath : codecPath;
+        runner.run(names[v], figures, [&stats, path, format, options](BenchState&) {
+            streamStats(path, format, stats, options);
+            doNotOptimize(stats.totalArea);
+        }, v < 2 ? textBytes : codecBytes);
+    }
+    stats.print(std::cerr);
+    std::remove(textPath);
+    std::remove(codecPath);
+}
+
+// ===================================================================
+// СОСТАВНЫЕ ЗАПРОСЫ
+// ===================================================================
+
+/*
+  Площадь квадратов с центром в области на 64K фигурах: отдельными
+  проходами с временными массивами указателей, одним слитым проходом
+  query() и им же на общем пуле. Операция - одна фигура.
+*/
+static void benchQuery(BenchRunner& runner, const Quads& q) {
+    const int n = 64 * BATCH;
+    Array figures;
+    Figure** figs = new Figure*[BATCH];
+    for (int r = 0; r < n / BATCH; r++) {
+        makeMixed(q, figs);
+        for (int i = 0; i < BATCH; i++) figures.push(figs[i]);
+    }
+    delete[] figs;
+    const BoundingBox region(-50, -50, 50, 50);
+
+    runner.run("query/separate_passes", n, [&figures, &region](BenchState&) {
+        const Figure** squares = new const Figure*[figures.size()];
+        int count = 0;
+        for (int i = 0; i < figures.size(); i++) {
+            if (figureKind(*figures.get(i)) == FigureKind::Square) squares[count++] = figures.get(i);
+        }
+        const Figure** inside = new const Figure*[count > 0 ? count : 1];
+        int kept = 0;
+        for (int i = 0; i < count; i++) {
+            if (region.contains(squares[i]->center())) inside[kept++] = squares[i];
+        }
+        double area = 0;
+        for (int i = 0; i < kept; i++) area += inside[i]->area();
+        delete[] inside;
+        delete[] squares;
+        doNotOptimize(area);
+    });
+
+    auto areaInRegion = query(figures)
+        .filter(ofKind(FigureKind::Square))
+        .filter(centerIn(region))
+        .map([](const Figure& fig) { return fig.area(); });
+    runner.run("query/fused", n, [&areaInRegion](BenchState&) {
+        doNotOptimize(areaInRegion.sum());
+    });
+    runner.run("query/fused_parallel", n, [&areaInRegion](BenchState&) {
+        doNotOptimize(areaInRegion.parallel().sum());
+    });
+
+    // Запрос языком lab03 с узкой областью на наборе генератора (фигуры
+    // мельче ячеек сетки индекса): без индекса - просмотр, с индексом -
+    // только кандидаты области. Для широкой области или крупных фигур
+    // план сам выбирает просмотр (QueryPlan::access)
+    GeneratorOptions options;
+    options.scale = 100;
+    Array generated;
+    for (int i = 0; i < n; i++) {
+        double r[8];
+        FigureKind kind;
+        generateRecord(i, n, options, kind, r);
+        Point p[4] = {Point(r[0], r[1]), Point(r[2], r[3]), Point(r[4], r[5]), Point(r[6], r[7])};
+        generated.push(createFigure(kind, p));
+    }
+    QueryPlan plan;
+    compileQuery("SELECT SUM(area) WHERE type=Square AND center IN box(-10, -10, 10, 10)", plan);
+    FigureIndex index(generated);
+    runner.run("query/select_scan", n, [&plan, &generated](BenchState&) {
+        doNotOptimize(runQuery(plan, generated).sum);
+    });
+    runner.run("query/select_index", n, [&plan, &generated, &index](BenchState&) {
+        doNotOptimize(runQuery(plan, generated, &index).sum);
+    });
+}
+
+// ===================================================================
+// ФИКСИРОВАННАЯ ТОЧКА
+// ===================================================================
+
+#ifdef GEOMETRY_HAS_INT128
+
+/*
+  Поиск равных ключу: Figure::operator== с допуском (виртуальный вызов,
+  перебор соответствий вершин) против 8 целых столбцов FixedQuadArray.
+  Повторы на наборе генератора с 10% повторов - через хеш-таблицу.
+*/
+static void benchFixed(BenchRunner& runner, const Quads& q) {
+    runner.run("fixed/convert", BATCH, [&q](BenchState&) {
+        FixedQuad fixed;
+        for (int i = 0; i < BATCH; i++) {
+            toFixed(q.rectangles[i], FIXED_DEFAULT_SCALE, fixed);
+            doNotOptimize(fixed);
+        }
+    });
+
+    const int n = 64 * BATCH;
+    GeneratorOptions options;
+    options.duplicateRatio = 0.1;
+    Array figures;
+    for (int i = 0; i < n; i++) {
+        double r[8];
+        FigureKind kind;
+        generateRecord(i, n, options, kind, r);
+        Point p[4] = {Point(r[0], r[1]), Point(r[2], r[3]), Point(r[4], r[5]), Point(r[6], r[7])};
+        figures.push(createFigure(kind, p));
+    }
+    FixedQuadArray set;
+    set.append(figures);
+    const Figure& key = *figures.get(n / 2);
+    FixedQuad fixedKey = set.get(n / 2);
+
+    runner.run("fixed/find_equal_eps", n, [&figures, &key](BenchState&) {
+        int found = 0;
+        for (int i = 0; i < figures.size(); i++) found += *figures.get(i) == key;
+        doNotOptimize(found);
+    });
+    unsigned char* equal = new unsigned char[n];
+    runner.run("fixed/find_equal", n, [&set, &fixedKey, equal](BenchState&) {
+        doNotOptimize(set.findEqual(fixedKey, equal));
+    });
+    bool* duplicate = new bool[n];
+    runner.run("fixed/mark_duplicates", n, [&set, duplicate](BenchState&) {
+        doNotOptimize(set.markDuplicates(duplicate));
+    });
+    delete[] duplicate;
+    delete[] equal;
+}
+
+#endif  // GEOMETRY_HAS_INT128
+
+// ===================================================================
+// ПРЕДИКАТЫ ОРИЕНТАЦИИ
+// ===================================================================
+
+/*
+  orientation() против формулы в double на тройках вершин фигур
+  (решает фильтр) и на почти коллинеарных тройках (0.5 + k * 2^-53,
+  12, 24 - точные ступени). Доля обращений к точным ступеням
+  записывается величинами metric() (и в JSON): для обычных данных
+  она должна быть нулевой, ее рост между сборками - регрессия.
+*/
+static void benchOrientation(BenchRunner& runner, const Quads& q) {
+    Point (*typical)[3] = new Point[BATCH][3];
+    Point (*degenerate)[3] = new Point[BATCH][3];
+    for (int i = 0; i < BATCH; i++) {
+        for (int k = 0; k < 3; k++) typical[i][k] = q.trapezoids[i][k];
+        degenerate[i][0] = Point(0.5 + (i % 32) * 0x1p-53, 0.5 + (i / 32) * 0x1p-53);
+        degenerate[i][1] = Point(12, 12);
+        degenerate[i][2] = Point(24, 24);
+    }
+
+    runner.run("orient/naive", BATCH, [typical](BenchState&) {
+        int sum = 0;
+        for (int i = 0; i < BATCH; i++) {
+            const Point* t = typical[i];
+            double det = (t[1].x - t[0].x) * (t[2].y - t[0].y) - (t[1].y - t[0].y) * (t[2].x - t[0].x);
+            sum += (det > 0) - (det < 0);
+        }
+        doNotOptimize(sum);
+    });
+    auto filtered = [](const Point (*triples)[3]) {
+        int sum = 0;
+        for (int i = 0; i < BATCH; i++) sum += orientation(triples[i][0], triples[i][1], triples[i][2]);
+        return sum;
+    };
+    runner.run("orient/filtered", BATCH, [typical, &filtered](BenchState&) {
+        doNotOptimize(filtered(typical));
+    });
+    runner.run("orient/filtered_degenerate", BATCH, [degenerate, &filtered](BenchState&) {
+        doNotOptimize(filtered(degenerate));
+    });
+
+    // Доля точных ступеней: тройки и упорядочивание вершин при
+    // создании фигур (6 сравнений направлений на фигуру)
+    const char* rates[3] = {"orient/fallback_rate_typical", "orient/fallback_rate_degenerate",
+                            "orient/fallback_rate_sort"};
+    if (!runner.anySelected(rates, 3)) {
+        delete[] degenerate;
+        delete[] typical;
+        return;
+    }
+    resetOrientationFallbacks();
+    doNotOptimize(filtered(typical));
+    long long typicalFallbacks = orientationFallbacks();
+    resetOrientationFallbacks();
+    doNotOptimize(filtered(degenerate));
+    long long degenerateFallbacks = orientationFallbacks();
+    resetOrientationFallbacks();
+    Figure** figs = new Figure*[BATCH];
+    makeMixed(q, figs);
+    long long sortFallbacks = orientationFallbacks();
+    for (int i = 0; i < BATCH; i++) delete figs[i];
+    delete[] figs;
+
+    runner.metric(rates[0], (double)typicalFallbacks / BATCH);
+    runner.metric(rates[1], (double)degenerateFallbacks / BATCH);
+    runner.metric(rates[2], (double)sortFallbacks / BATCH);
+    delete[] degenerate;
+    delete[] typical;
+}
+
+// ===================================================================
+// НАКЛАДНЫЕ РАСХОДЫ ТРАССИРОВКИ
+// ===================================================================
+
+/*
+  Цена одной области GEOMETRY_TRACE_SCOPE (пара событий B/E) при
+  выключенной и включенной трассировке. С --trace не запускается:
+  замер очищает буферы и стер бы записанную трассу.
+*/
+static void benchTrace(BenchRunner& runner) {
+    if (runner.tracing()) return;
+
+    runner.run("trace/scope_disabled", BATCH, [](BenchState&) {
+        for (int i = 0; i < BATCH; i++) {
+            GEOMETRY_TRACE_SCOPE("bench");
+        }
+    });
+
+    traceStart();
+    runner.run("trace/scope_enabled", BATCH, [](BenchState& st) {
+        for (int i = 0; i < BATCH; i++) {
+            GEOMETRY_TRACE_SCOPE("bench");
+        }
+        st.pause();
+        traceClear();
+        st.resume();
+    });
+    traceStop();
+    traceClear();
+}
+
+int main(int argc, char** argv) {
+    BenchRunner runner(argc, argv);
+    Quads* quads = new Quads();
+
+    benchFigures(runner, *quads);
+    benchArray(runner, *quads);
+    benchStores(runner, *quads);
+    benchText(runner, *quads);
+    benchIngest(runner, *quads);
+    benchJournal(runner, *quads);
+    benchCodec(runner, *quads);
+    benchStream(runner, *quads);
+    benchQuery(runner, *quads);
+#ifdef GEOMETRY_HAS_INT128
+    benchFixed(runner, *quads);
+#endif
+    benchOrientation(runner, *quads);
+    benchTrace(runner);
+
+    delete quads;
+    return runner.finish();
+}
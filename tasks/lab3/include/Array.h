@@ -1,5 +1,9 @@
 #pragma once
 #include "Figure.h"
+#include "MemoryTracking.h"
+#include "SmallArray.h"
+
+class ThreadPool;
 
 /**
  * @file Array.h
@@ -22,8 +26,9 @@
  * 
  * 2. ДИНАМИЧЕСКИЙ РАЗМЕР
  *    - Автоматически растет при добавлении элементов
- *    - Начальная вместимость: 4 элемента
- *    - При заполнении: удваивается (4→8→16→32...)
+ *    - Первые 4 указателя лежат внутри самого объекта Array
+ *      (SmallArray, см. SmallArray.h) - куча не нужна
+ *    - При заполнении: удваивается (4→8→16→32...), с 8 - в куче
  * 
  * 3. УПРАВЛЕНИЕ ПАМЯТЬЮ
  *    - Массив "владеет" указателями
@@ -52,42 +57,34 @@
  * @endcode
  */
 class Array {
-private:
+public:
     /**
-     * @brief Динамический массив указателей на фигуры
-     * 
-     * Figure** означает: "указатель на указатель"
-     * - Figure* - указатель на одну фигуру
-     * - Figure** - указатель на массив указателей
-     * 
-     * Память выделяется через: data = new Figure*[capacity]
+     * @brief Сколько указателей помещается без выделений в куче
      */
-    Figure** data;
+    static constexpr int INLINE_CAPACITY = 4;
     
+private:
     /**
-     * @brief Текущее количество фигур в массиве
+     * @brief Указатели на фигуры
      * 
-     * Инвариант: 0 <= count <= capacity
-     */
-    int count;
-    
-    /**
-     * @brief Вместимость массива (выделенная память)
+     * SmallArray хранит первые INLINE_CAPACITY указателей прямо
+     * в объекте, остальные - в буфере в куче, который растет
+     * удвоением. Array добавляет к нему владение фигурами.
      * 
-     * Сколько элементов может вместить массив без перевыделения памяти.
+     * Инвариант: 0 <= items.size() <= items.getCapacity()
      */
-    int capacity;
+    SmallArray<Figure*, INLINE_CAPACITY> items;
     
     /**
      * @brief Увеличивает вместимость массива в 2 раза
      * 
-     * АЛГОРИТМ:
-     * 1. Создаем новый массив размером capacity*2
+     * АЛГОРИТМ (SmallArray::reserve):
+     * 1. Создаем новый буфер в куче размером capacity*2
      * 2. Копируем все указатели из старого в новый
-     * 3. Удаляем старый массив (НЕ сами фигуры!)
-     * 4. Переключаемся на новый массив
+     * 3. Удаляем старый буфер, если он был в куче (НЕ сами фигуры!)
+     * 4. Переключаемся на новый буфер
      * 
-     * СЛОЖНОСТЬ: O(n), где n = count
+     * СЛОЖНОСТЬ: O(n), где n = size()
      * АМОРТИЗИРОВАННАЯ: O(1) на одно добавление
      */
     void resize();
@@ -100,8 +97,8 @@ public:
     /**
      * @brief Конструктор - создает пустой массив
      * 
-     * Выделяет память для 4 указателей.
-     * Начальная вместимость = 4 (можно изменить).
+     * Память не выделяет: начальная вместимость INLINE_CAPACITY
+     * обеспечена встроенным буфером.
      */
     Array();
     
@@ -111,11 +108,10 @@ public:
      * КРИТИЧЕСКИ ВАЖНО: правильно освободить память!
      * 
      * ДВА ШАГА:
-     * 1. Удалить все фигуры: delete data[i] для каждого i
-     * 2. Удалить массив указателей: delete[] data
+     * 1. Удалить все фигуры: delete items[i] для каждого i
+     * 2. Удалить массив указателей (делает деструктор SmallArray)
      * 
      * Если забыть шаг 1 - утечка памяти (фигуры останутся в памяти).
-     * Если забыть шаг 2 - утечка памяти (массив указателей останется).
      */
     ~Array();
     
@@ -151,17 +147,12 @@ public:
     /**
      * @brief Запрещаем конструктор перемещения
      * 
-     * Можно было бы реализовать так:
-     * @code
-     * Array(Array&& other) noexcept 
-     *     : data(other.data), count(other.count), capacity(other.capacity) {
-     *     other.data = nullptr;
-     *     other.count = 0;
-     *     other.capacity = 0;
-     * }
-     * @endcode
-     * 
-     * Но для простоты запрещаем.
+     * Перемещение нельзя свести к копированию указателя на буфер:
+     * пока фигур не больше INLINE_CAPACITY, items хранит их во
+     * встроенном буфере внутри самого объекта, и указатель на данные
+     * other указывал бы в other. Корректное перемещение копирует
+     * встроенные элементы и забирает только внешний буфер - для
+     * учебной работы проще запретить.
      */
     Array(Array&&) = delete;
     
@@ -182,7 +173,7 @@ public:
      * После вызова push() НЕ удаляйте фигуру вручную.
      * Массив сам удалит ее в деструкторе или при remove().
      * 
-     * Если массив заполнен (count == capacity), автоматически
+     * Если массив заполнен (size() == вместимость), автоматически
      * увеличивает размер через resize().
      * 
      * СЛОЖНОСТЬ: O(1) амортизированная
@@ -194,9 +185,9 @@ public:
      * @param index Индекс фигуры (от 0 до size()-1)
      * 
      * АЛГОРИТМ:
-     * 1. Удаляем фигуру: delete data[index]
-     * 2. Сдвигаем все последующие элементы влево
-     * 3. Уменьшаем count на 1
+     * 1. Удаляем фигуру: delete items[index]
+     * 2. items.remove(index): сдвигает последующие элементы влево
+     *    и уменьшает размер на 1
      * 
      * СЛОЖНОСТЬ: O(n), где n = количество элементов после index
      * 
@@ -222,7 +213,7 @@ public:
      * Определена прямо в заголовке (inline).
      * СЛОЖНОСТЬ: O(1)
      */
-    int size() const { return count; }
+    int size() const { return items.size(); }
     
     /**
      * @brief Вычисляет общую площадь всех фигур
@@ -238,6 +229,40 @@ public:
      */
     double totalArea() const;
     
+    /**
+     * @brief Общая площадь, параллельно задачами пула
+     * @param pool Пул потоков
+     * @return Сумма площадей
+     * 
+     * Куски массива суммируются независимо и складываются по порядку:
+     * результат может отличаться от totalArea() в последних битах
+     * (другой порядок сложения), но не меняется от запуска к запуску.
+     */
+    double totalArea(ThreadPool& pool) const;
+    
+    /**
+     * @brief Вычисляет площадь объединения всех фигур
+     * @return Площадь, покрытая хотя бы одной фигурой
+     * 
+     * В отличие от totalArea(), перекрывающиеся части считаются
+     * один раз. Подробности алгоритма - в UnionArea.h.
+     * 
+     * СЛОЖНОСТЬ: O(n log n) для типичных данных
+     */
+    double unionArea() const;
+    
+    /**
+     * @brief Сколько памяти занимает массив вместе с фигурами
+     * @return Разбивка по категориям (буфер, запас емкости, объекты,
+     *         vptr, накладные расходы аллокатора) и по типам фигур
+     * 
+     * Пример: 100 квадратов - буфер на 128 указателей (28 в запасе
+     * после удвоения), 100 объектов Square, 101 блок в куче.
+     * До INLINE_CAPACITY фигур буфер встроенный: он входит
+     * в containerBytes, а блоки в куче - только фигуры.
+     */
+    MemoryReport memoryReport() const;
+    
     /**
      * @brief Выводит информацию обо всех фигурах
      * 
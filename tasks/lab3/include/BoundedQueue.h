@@ -0,0 +1,98 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * @file BoundedQueue.h
+ * @brief Ограниченная блокирующая очередь между стадиями конвейера
+ */
+
+/**
+ * @class BoundedQueue
+ * @brief Кольцевой буфер фиксированной вместимости под мьютексом,
+ *        любое число производителей и потребителей (MPMC)
+ *
+ * ОБРАТНОЕ ДАВЛЕНИЕ (backpressure): push() в полную очередь ждет,
+ * пока потребитель не заберет элемент. Быстрая стадия не уходит
+ * вперед медленной больше чем на capacity элементов - память
+ * конвейера ограничена, а время ожидания показывает узкое место.
+ *
+ * ЗАКРЫТИЕ: после close() push() возвращает false, а pop() отдает
+ * оставшиеся элементы и затем возвращает false - сигнал потребителю,
+ * что данных больше не будет.
+ *
+ * T - небольшое значение (обычно указатель на пакет): элементы
+ * копируются в буфер и из него.
+ */
+template <typename T>
+class BoundedQueue {
+private:
+    std::mutex lock;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    T* slots;
+    int capacity;
+    int head;     ///< Индекс первого элемента
+    int count;
+    bool closed;
+
+public:
+    /**
+     * @param capacity Вместимость (не меньше 1)
+     */
+    explicit BoundedQueue(int capacity)
+        : slots(new T[capacity > 0 ? capacity : 1]),
+          capacity(capacity > 0 ? capacity : 1),
+          head(0), count(0), closed(false) {}
+
+    ~BoundedQueue() { delete[] slots; }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Добавляет элемент, ожидая свободного места
+     * @return false, если очередь закрыта (элемент не добавлен)
+     */
+    bool push(const T& value) {
+        std::unique_lock<std::mutex> guard(lock);
+        while (count == capacity && !closed) notFull.wait(guard);
+        if (closed) return false;
+        slots[(head + count) % capacity] = value;
+        count++;
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Забирает первый элемент, ожидая его появления
+     * @return false, если очередь закрыта и пуста
+     */
+    bool pop(T& value) {
+        std::unique_lock<std::mutex> guard(lock);
+        while (count == 0 && !closed) notEmpty.wait(guard);
+        if (count == 0) return false;
+        value = slots[head];
+        head = (head + 1) % capacity;
+        count--;
+        notFull.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Закрывает очередь и будит всех ожидающих
+     */
+    void close() {
+        std::lock_guard<std::mutex> guard(lock);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+    int size() {
+        std::lock_guard<std::mutex> guard(lock);
+        return count;
+    }
+
+    int getCapacity() const { return capacity; }
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include "Point.h"
+
+/**
+ * @file BoundingBox.h
+ * @brief Ограничивающий прямоугольник (AABB), выровненный по осям
+ */
+
+/**
+ * @brief Ограничивающий прямоугольник со сторонами, параллельными осям
+ *
+ * Используется для быстрого отсечения: если точка (или другой
+ * прямоугольник) не попадает в AABB фигуры, то точно не попадает
+ * и в саму фигуру. Проверка стоит 4 сравнения вместо 4 векторных
+ * произведений.
+ *
+ * Границы включаются: точка на стороне считается лежащей внутри.
+ */
+struct BoundingBox {
+    double minX;  ///< Левая граница
+    double minY;  ///< Нижняя граница
+    double maxX;  ///< Правая граница
+    double maxY;  ///< Верхняя граница
+
+    constexpr BoundingBox(double minX = 0, double minY = 0, double maxX = 0, double maxY = 0)
+        : minX(minX), minY(minY), maxX(maxX), maxY(maxY) {}
+
+    /**
+     * @brief Лежит ли точка внутри прямоугольника (включая границу)
+     */
+    constexpr bool contains(const Point& p) const {
+        return p.x >= minX && p.x <= maxX && p.y >= minY && p.y <= maxY;
+    }
+
+    /**
+     * @brief Пересекаются ли два прямоугольника (касание считается пересечением)
+     */
+    constexpr bool intersects(const BoundingBox& other) const {
+        return minX <= other.maxX && other.minX <= maxX &&
+               minY <= other.maxY && other.minY <= maxY;
+    }
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include "Array.h"
+
+/**
+ * @file Classifier.h
+ * @brief Автоматическая классификация "сырых" четырехугольников
+ */
+
+/**
+ * @brief Результат классификации записи
+ */
+enum class FigureKind : unsigned char {
+    Square,     ///< Прямоугольник с равными сторонами
+    Rectangle,  ///< Параллелограмм с равными диагоналями
+    Trapezoid,  ///< Выпуклый четырехугольник с хотя бы одной парой параллельных сторон
+    Rejected    ///< Не подходит ни под один тип (см. RejectReason)
+};
+
+/**
+ * @brief Причина отказа
+ */
+enum class RejectReason : unsigned char {
+    None,             ///< Запись принята
+    NonFinite,        ///< Есть NaN или бесконечность
+    Degenerate,       ///< Совпадающие точки или три точки на одной прямой
+    NonConvex,        ///< Одна точка внутри треугольника из остальных трех
+    NoParallelSides   ///< Выпуклый, но без параллельных сторон
+};
+
+const int FIGURE_KIND_COUNT = 4;
+const int REJECT_REASON_COUNT = 5;
+
+/**
+ * @brief Название типа ("Square", ..., "Rejected")
+ */
+const char* kindName(FigureKind kind);
+
+/**
+ * @brief Название причины отказа ("None", "NonFinite", ...)
+ */
+const char* reasonName(RejectReason reason);
+
+/**
+ * @brief Создает фигуру заданного типа (вершины упорядочиваются)
+ * @return Новая фигура или nullptr для FigureKind::Rejected
+ */
+Figure* createFigure(FigureKind kind, const Point p[4]);
+
+/**
+ * @brief Тип фигуры по getType() (Rejected для неизвестного типа)
+ */
+FigureKind figureKind(const Figure& fig);
+
+/**
+ * @brief Счетчики классификации по типам и причинам отказа
+ */
+struct ClassifyStats {
+    int kinds[FIGURE_KIND_COUNT] = {0};      ///< Индекс - (int)FigureKind
+    int reasons[REJECT_REASON_COUNT] = {0};  ///< Индекс - (int)RejectReason
+
+    int count(FigureKind kind) const { return kinds[(int)kind]; }
+    int count(RejectReason reason) const { return reasons[(int)reason]; }
+
+    /**
+     * @brief Выводит счетчики в поток, по строке на тип и причину
+     */
+    void print(std::ostream& os) const;
+};
+
+/**
+ * @brief Классифицирует записи из 8 чисел (x1 y1 x2 y2 x3 y3 x4 y4)
+ * @param records Записи подряд: 8 * n чисел, порядок вершин любой
+ * @param n Количество записей
+ * @param kinds Массив из n элементов для типов
+ * @param reasons Массив из n элементов для причин отказа (может быть nullptr)
+ * @param stats Счетчики, к которым прибавляется результат (может быть nullptr)
+ * @param tolerance Относительный допуск сравнений
+ *
+ * ПРОВЕРКИ (не зависят от порядка вершин):
+ * 1. Ориентации 4 троек точек: почти нулевая - вырождение.
+ * 2. По знакам ориентаций (разбиение Радона) определяется, какая пара
+ *    отрезков - диагонали (они пересекаются). Если одна точка лежит
+ *    внутри треугольника остальных - фигура невыпуклая.
+ * 3. Остальные две пары отрезков - противоположные стороны:
+ *    обе параллельны и диагонали равны - прямоугольник,
+ *    плюс диагонали перпендикулярны - квадрат,
+ *    хотя бы одна пара параллельна - трапеция.
+ *
+ * Допуски относительные: длины сравниваются с точностью
+ * tolerance * (сумма длин), параллельность и перпендикулярность -
+ * по синусу/косинусу угла, вырождение - относительно квадрата диаметра.
+ *
+ * ВЕКТОРИЗАЦИЯ: записи обрабатываются блоками по 64; внутри блока данные
+ * перекладываются в столбцы (SoA), и все вычисления - прямолинейная
+ * арифметика без ветвлений, которую компилятор векторизует по записям.
+ */
+void classifyRecords(const double* records, int n, FigureKind* kinds,
+                     RejectReason* reasons, ClassifyStats* stats,
+                     double tolerance = 1e-6);
+
+/**
+ * @brief Классифицирует одну четверку точек
+ * @param p 4 точки в любом порядке
+ * @param reason Причина отказа (может быть nullptr)
+ * @param tolerance Относительный допуск сравнений
+ */
+FigureKind classifyPoints(const Point p[4], RejectReason* reason = nullptr,
+                          double tolerance = 1e-6);
+
+/**
+ * @brief Массовая загрузка: классификация + создание фигур нужного типа
+ * @param records Записи из 8 чисел подряд
+ * @param n Количество записей
+ * @param out Коллекция, в конец которой добавляются принятые фигуры
+ * @param stats Счетчики (может быть nullptr)
+ * @param tolerance Относительный допуск сравнений
+ * @return Количество добавленных фигур
+ *
+ * Вместо того чтобы заранее решать, Square это или Trapezoid,
+ * вызывающий код передает сырые координаты, а тип определяется по ним.
+ */
+int loadClassified(const double* records, int n, Array& out,
+                   ClassifyStats* stats = nullptr, double tolerance = 1e-6);
@@ -0,0 +1,72 @@
+#pragma once
+#include "Array.h"
+#include "Classifier.h"
+
+/**
+ * @file Codec.h
+ * @brief Сжатое двоичное представление наборов фигур
+ */
+
+/**
+ * @brief Параметры кодирования
+ */
+struct CodecOptions {
+    /**
+     * @brief Не хранить четвертую вершину квадратов и прямоугольников,
+     *        если она точно (бит в бит) равна p0 + p2 - p1
+     */
+    bool elideDerived = true;
+};
+
+/**
+ * @brief Байт несжатой записи фигуры: тип и 8 double
+ *
+ * Относительно этого размера считаются степень сжатия и скорость (ГБ/с).
+ */
+const int CODEC_RAW_FIGURE_BYTES = 1 + 8 * sizeof(double);
+
+/**
+ * @brief Верхняя граница размера кода n фигур (для буфера encodeFigures)
+ */
+long long encodedSizeBound(int n);
+
+/**
+ * @brief Кодирует коллекцию
+ * @param figures Фигуры (типы Square, Rectangle, Trapezoid)
+ * @param out Буфер не меньше encodedSizeBound(figures.size()) байт
+ * @return Размер кода в байтах
+ *
+ * ФОРМАТ:
+ * 1. "GFC1", количество фигур (varint).
+ * 2. Теги: тип фигуры и флаг "вершина 3 выведена", серии одинаковых
+ *    тегов - (длина серии varint, тег). Однородный набор - несколько байт.
+ * 3. Координаты - два потока (X и Y), каждое значение - XOR с предыдущим
+ *    значением своего потока. Управляющий байт: сколько нулевых байт
+ *    XOR справа (старшая тетрада) и сколько значащих байт (младшая),
+ *    затем сами значащие байты. Совпадающие координаты (у прямоугольника
+ *    вдоль осей соседние вершины делят X или Y) занимают 1 байт.
+ *
+ * Кодирование без потерь: decode возвращает те же биты double.
+ * Числа пишутся в порядке байтов машины (little-endian на x86/ARM).
+ */
+long long encodeFigures(const Array& figures, unsigned char* out,
+                        const CodecOptions& options = CodecOptions());
+
+/**
+ * @brief Количество фигур в коде или -1, если это не код encodeFigures
+ */
+int encodedCount(const unsigned char* data, long long size);
+
+/**
+ * @brief Декодирует в записи из 8 чисел (формат classifyRecords)
+ * @param records Буфер на 8 * encodedCount() чисел
+ * @param kinds Буфер на encodedCount() типов
+ * @return Количество фигур или -1 для поврежденного/обрезанного кода
+ */
+int decodeRecords(const unsigned char* data, long long size, double* records, FigureKind* kinds);
+
+/**
+ * @brief Декодирует и добавляет фигуры в конец коллекции
+ * @return Количество добавленных фигур или -1 (коллекция не меняется)
+ */
+int decodeFigures(const unsigned char* data, long long size, Array& out);
@@ -0,0 +1,145 @@
+#pragma once
+#include "Figure.h"
+#include "MemoryTracking.h"
+#include <atomic>
+
+/**
+ * @file ConcurrentArray.h
+ * @brief Коллекция фигур с добавлением из многих потоков без блокировок
+ */
+
+/**
+ * @brief Количество сегментов ConcurrentArray
+ *
+ * Сегмент k вмещает CONCURRENT_FIRST_SEGMENT << k указателей, первые
+ * k сегментов - 64 * (2^k - 1). 25 сегментов - это 2^31 - 64 слота,
+ * меньше INT_MAX; 26-й сегмент покрывает все неотрицательные int
+ * (он выделяется, только если до него дошли индексы).
+ */
+const int CONCURRENT_SEGMENTS = 26;
+const int CONCURRENT_FIRST_SEGMENT = 64;
+
+/**
+ * @class ConcurrentArray
+ * @brief Владеющий массив указателей на Figure только для добавления,
+ *        push() из любого числа потоков одновременно
+ *
+ * Array не потокобезопасен: два push() гонятся за count и resize().
+ * Здесь буфер не перевыделяется никогда:
+ *
+ * УСТРОЙСТВО:
+ * 1. Слоты разбиты на сегменты растущего размера (64, 128, 256, ...).
+ *    Выделенный сегмент не перемещается, поэтому писать в него можно,
+ *    пока другие потоки создают следующие.
+ * 2. push() резервирует номер слота атомарным fetch_add (без ожидания),
+ *    при необходимости создает сегмент (CAS: проигравший поток
+ *    освобождает свой) и записывает указатель в слот.
+ * 3. Опубликованный префикс: published - количество слотов подряд
+ *    с начала, уже записанных. Поток после записи продвигает его
+ *    (CAS), пока следующий слот заполнен, - в том числе за другие
+ *    потоки.
+ *
+ * ЧТЕНИЕ: size() - длина опубликованного префикса (acquire); все
+ * фигуры с меньшими индексами полностью построены и видны. Префикс
+ * только растет, поэтому обход [0, size()) согласован: никаких
+ * пропусков и повторов, даже пока идут push().
+ *
+ * ГАРАНТИИ: push() lock-free (свободен от блокировок). Если поток
+ * остановлен между резервированием и записью слота, размер
+ * опубликованного префикса временно не растет, но остальные
+ * производители не ждут.
+ *
+ * Удаление не поддерживается: коллекция - журнал добавлений.
+ * Сами фигуры после публикации только читаются.
+ *
+ * @code
+ * ConcurrentArray figures;
+ * // в каждом потоке-производителе:
+ * figures.push(new Square(p));
+ * // в любом потоке:
+ * double area = figures.totalArea();   // по опубликованному префиксу
+ * @endcode
+ */
+class ConcurrentArray {
+private:
+    std::atomic<std::atomic<Figure*>*> segments[CONCURRENT_SEGMENTS];
+    std::atomic<int> reserved;   ///< Сколько слотов выдано производителям
+    std::atomic<int> published;  ///< Длина заполненного префикса
+
+    /**
+     * @brief Слот с номером index (сегмент создается при необходимости)
+     */
+    std::atomic<Figure*>& slot(int index);
+
+    /**
+     * @brief Слот уже существующего сегмента (для index < reserved)
+     */
+    std::atomic<Figure*>* existingSlot(int index) const;
+
+    /**
+     * @brief Продвигает published по заполненным слотам
+     */
+    void advancePublished();
+
+public:
+    ConcurrentArray();
+    ~ConcurrentArray();
+
+    ConcurrentArray(const ConcurrentArray&) = delete;
+    ConcurrentArray& operator=(const ConcurrentArray&) = delete;
+
+    /**
+     * @brief Добавляет фигуру (потокобезопасно, без блокировок)
+     * @param fig Фигура; коллекция берет владение (nullptr игнорируется)
+     * @return Индекс фигуры или -1 для nullptr
+     *
+     * Фигура станет видна читателям, когда будут записаны
+     * и все слоты с меньшими индексами.
+     */
+    int push(Figure* fig);
+
+    /**
+     * @brief Количество опубликованных фигур
+     */
+    int size() const { return published.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Фигура по индексу или nullptr, если index >= size()
+     */
+    const Figure* get(int index) const;
+
+    /**
+     * @brief Вызывает fn(index, const Figure&) для опубликованного префикса
+     * @return Количество обойденных фигур
+     *
+     * Длина префикса фиксируется в начале обхода: фигуры, добавленные
+     * во время обхода, в него не попадают.
+     */
+    template <typename Fn>
+    int forEach(Fn fn) const;
+
+    /**
+     * @brief Суммарная площадь опубликованных фигур
+     */
+    double totalArea() const;
+
+    /**
+     * @brief Отчет о памяти: сегменты и фигуры
+     *
+     * Незаполненная часть сегментов - bufferUnused.
+     */
+    MemoryReport memoryReport() const;
+};
+
+// ===================================================================
+// РЕАЛИЗАЦИЯ ШАБЛОНА
+// ===================================================================
+
+template <typename Fn>
+int ConcurrentArray::forEach(Fn fn) const {
+    int n = size();
+    for (int i = 0; i < n; i++) {
+        fn(i, *existingSlot(i)->load(std::memory_order_relaxed));
+    }
+    return n;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "Array.h"
+
+class ThreadPool;
+
+/**
+ * @file ConvexHull.h
+ * @brief Выпуклая оболочка вершин фигур: пакетно, параллельно и потоково
+ */
+
+/**
+ * @brief Строит выпуклую оболочку набора точек на месте
+ * @param points Точки (массив переупорядочивается)
+ * @param n Количество точек
+ * @return Количество вершин оболочки h; оболочка записана в points[0..h)
+ *
+ * Алгоритм Эндрю (monotone chain): сортировка по (x, y), затем нижняя
+ * и верхняя цепочки за один проход каждая.
+ * Вершины идут против часовой стрелки, начиная с самой левой-нижней;
+ * точки на сторонах оболочки (коллинеарные) не включаются.
+ *
+ * СЛОЖНОСТЬ: O(n log n)
+ */
+int convexHull(Point* points, int n);
+
+/**
+ * @brief Выпуклая оболочка всех вершин коллекции
+ * @param figures Коллекция фигур (вершины берутся через getPoints())
+ * @param out Буфер минимум на 4 * figures.size() точек
+ * @param pool Пул потоков (nullptr - ThreadPool::shared())
+ * @return Количество вершин оболочки в out
+ *
+ * ПАРАЛЛЕЛЬНАЯ СХЕМА:
+ * 1. Массив делится на куски (по числу потоков пула); задача пула
+ *    строит оболочку вершин своего куска (тоже алгоритмом Эндрю).
+ * 2. Шаг слияния: оболочка объединения частичных оболочек.
+ *    Частичные оболочки малы, поэтому слияние почти бесплатно.
+ */
+int collectionHull(const Array& figures, Point* out, ThreadPool* pool = nullptr);
+
+/**
+ * @class StreamingHull
+ * @brief Выпуклая оболочка, обновляемая по мере добавления фигур
+ *
+ * Используется рядом с Array::push(): каждая добавленная фигура
+ * передается в push(), и оболочка всегда актуальна.
+ *
+ * Если все 4 вершины новой фигуры лежат внутри текущей оболочки
+ * (проверка за O(log h) бинарным поиском по "вееру" из первой вершины),
+ * оболочка не меняется. Иначе она перестраивается из h + 4 точек.
+ *
+ * @code
+ * StreamingHull hull;
+ * Square* sq = new Square(p);
+ * figures.push(sq);
+ * hull.push(*sq);
+ * cout << hull.size() << endl;
+ * @endcode
+ */
+class StreamingHull {
+private:
+    Point* hull;    ///< Вершины оболочки против часовой стрелки
+    int count;      ///< Количество вершин оболочки
+    int capacity;   ///< Вместимость буфера hull
+
+    bool insideHull(const Point& p) const;
+
+public:
+    StreamingHull();
+    ~StreamingHull();
+
+    StreamingHull(const StreamingHull&) = delete;
+    StreamingHull& operator=(const StreamingHull&) = delete;
+
+    /**
+     * @brief Учитывает вершины новой фигуры
+     */
+    void push(const Figure& fig);
+
+    /**
+     * @brief Учитывает вершины всех фигур коллекции
+     */
+    void pushAll(const Array& figures);
+
+    /**
+     * @brief Количество вершин оболочки
+     */
+    int size() const { return count; }
+
+    /**
+     * @brief Вершины оболочки против часовой стрелки
+     */
+    const Point* points() const { return hull; }
+
+    /**
+     * @brief Сбрасывает оболочку в пустое состояние
+     */
+    void clear() { count = 0; }
+};
@@ -1,5 +1,8 @@
 #pragma once
 #include "Point.h"
+#include "BoundingBox.h"
+#include "Transform.h"
+#include "FigureKernels.h"
 #include <iostream>
 
 /**
@@ -56,9 +59,9 @@ protected:
      * Для правильного вычисления площади по формуле Гаусса (Shoelace)
      * необходимо, чтобы вершины шли последовательно по контуру.
      * 
-     * АЛГОРИТМ:
+     * АЛГОРИТМ (orderCounterClockwise() из FigureKernels.h):
      * 1. Находим центр масс (среднее всех точек)
-     * 2. Вычисляем угол каждой точки относительно центра
+     * 2. Сравниваем направления на точки из центра по углу
      * 3. Сортируем точки по возрастанию угла
      * 
      * СЛОЖНОСТЬ: O(n²) где n=4, но для 4 точек это быстро
@@ -255,6 +258,27 @@ public:
      */
     virtual const char* getType() const = 0;
     
+    /**
+     * @brief Размер объекта динамического типа (sizeof(Square) и т.д.)
+     * 
+     * Используется отчетом о памяти коллекций (Array::memoryReport()).
+     */
+    virtual std::size_t objectSize() const = 0;
+    
+    // ===================================================================
+    // ВЫДЕЛЕНИЕ ПАМЯТИ
+    // ===================================================================
+    
+    /**
+     * @brief Фигуры в куче выделяются через trackedAllocate()
+     * 
+     * Так перехватчик выделений (см. MemoryTracking.h) видит каждую
+     * фигуру. Виртуальный деструктор гарантирует, что в operator delete
+     * придет размер динамического типа.
+     */
+    static void* operator new(std::size_t size);
+    static void operator delete(void* p, std::size_t size);
+    
     // ===================================================================
     // ПЕРЕГРУЗКА ОПЕРАТОРОВ
     // ===================================================================
@@ -362,4 +386,101 @@ public:
      * Используется для чтения вершин извне.
      */
     const Point* getPoints() const { return points; }
+    
+    /**
+     * @brief Применяет аффинное преобразование к вершинам на месте
+     * @param m Преобразование (сдвиг, поворот, масштаб, отражение)
+     * 
+     * В отличие от setPoints(), sortPoints() НЕ вызывается:
+     * - определитель m > 0 - порядок против часовой стрелки сохраняется;
+     * - определитель m < 0 (отражение) - обход меняется на обратный,
+     *   поэтому достаточно развернуть порядок вершин.
+     * Начальная вершина обхода может отличаться от той, что выбрал бы
+     * sortPoints(), но обход остается против часовой стрелки.
+     */
+    void transform(const AffineTransform& m);
+    
+    // ===================================================================
+    // ГЕОМЕТРИЧЕСКИЕ ЗАПРОСЫ
+    // ===================================================================
+    
+    /**
+     * @brief Вычисляет ограничивающий прямоугольник фигуры
+     * @return AABB, содержащий все 4 вершины
+     * 
+     * Используется для быстрого отсечения кандидатов
+     * перед точными (и более дорогими) проверками.
+     */
+    BoundingBox bounds() const;
+    
+    /**
+     * @brief Проверяет, лежит ли точка внутри фигуры
+     * @param p Проверяемая точка
+     * @return true если точка внутри или на границе
+     * 
+     * Вершины упорядочены против часовой стрелки (sortPoints()),
+     * поэтому для выпуклого четырехугольника точка внутри тогда и
+     * только тогда, когда она лежит слева от всех 4 сторон:
+     * cross(b - a, p - a) >= 0 для каждой стороны (a, b).
+     * 
+     * Для массовых запросов используйте FigureIndex.
+     */
+    bool contains(const Point& p) const;
+    
+    /**
+     * @brief Вычисляет площадь пересечения с другой фигурой
+     * @param other Вторая фигура
+     * @return Площадь общей части (0, если фигуры не пересекаются)
+     * 
+     * Обе фигуры - выпуклые четырехугольники, поэтому их пересечение -
+     * выпуклый многоугольник (не более 8 вершин). Он строится отсечением
+     * (Sutherland-Hodgman) этой фигуры сторонами other, а его площадь
+     * считается той же формулой Гаусса, что и area().
+     */
+    double intersectionArea(const Figure& other) const;
+    
+    /**
+     * @brief Площадь простого многоугольника по формуле Гаусса (Shoelace)
+     * @param p Вершины по контуру (в любом направлении обхода)
+     * @param n Количество вершин
+     * @return Площадь
+     * 
+     * S = 1/2 * |sum(xi * yi+1 - xi+1 * yi)|
+     * 
+     * Общая реализация для area() всех фигур и для многоугольников,
+     * которые получаются при отсечении (пересечения фигур).
+     * Вычисляет shoelaceArea() из FigureKernels.h.
+     */
+    static double polygonArea(const Point* p, int n);
+};
+
+/**
+ * @class FigureAdapter
+ * @brief Общая часть классов фигур: виртуальный интерфейс Figure
+ *        поверх constexpr-ядер из FigureKernels.h
+ * @tparam Derived Класс фигуры (CRTP): class Square : public FigureAdapter<Square>
+ *
+ * center(), area(), getType() и objectSize() одинаковы у всех наших
+ * фигур и реализованы здесь один раз. Они объявлены final: если тип
+ * фигуры известен при компиляции (Square&, массив Square), вызов
+ * не виртуальный и встраивается. Через Figure* - обычный
+ * виртуальный вызов той же функции.
+ *
+ * Derived объявляет static constexpr const char* TYPE_NAME.
+ */
+template <typename Derived>
+class FigureAdapter : public Figure {
+public:
+    /**
+     * @brief Центр - среднее арифметическое вершин (vertexCentroid())
+     */
+    Point center() const final { return vertexCentroid(points, 4); }
+    
+    /**
+     * @brief Площадь по формуле Гаусса (shoelaceArea())
+     */
+    double area() const final { return shoelaceArea(points, 4); }
+    
+    const char* getType() const final { return Derived::TYPE_NAME; }
+    std::size_t objectSize() const final { return sizeof(Derived); }
 };
\ No newline at end of file
@@ -0,0 +1,244 @@
+#pragma once
+#include "Array.h"
+#include "BoundingBox.h"
+
+/**
+ * @file FigureIndex.h
+ * @brief Пространственный индекс фигур для массовых геометрических запросов
+ */
+
+/**
+ * @class PointHits
+ * @brief Результат массового запроса "какие фигуры содержат точку"
+ *
+ * Для каждой точки запроса хранится список индексов фигур (по
+ * возрастанию), которые ее содержат. Все списки лежат подряд в одном
+ * массиве hitData, а offsets[i]..offsets[i+1] задает диапазон i-й точки
+ * (формат CSR). Так результат на миллионы точек занимает два массива,
+ * а не миллионы маленьких.
+ */
+class PointHits {
+private:
+    int* offsets;    ///< offsets[i] - начало списка i-й точки, размер pointTotal + 1
+    int* hitData;    ///< Индексы фигур всех точек подряд
+    int pointTotal;  ///< Количество точек запроса
+
+    friend class FigureIndex;
+
+public:
+    PointHits() : offsets(nullptr), hitData(nullptr), pointTotal(0) {}
+    ~PointHits() {
+        delete[] offsets;
+        delete[] hitData;
+    }
+
+    // Владеет буферами - копирование запрещено, как и у Array
+    PointHits(const PointHits&) = delete;
+    PointHits& operator=(const PointHits&) = delete;
+
+    /**
+     * @brief Количество точек, для которых выполнен запрос
+     */
+    int pointCount() const { return pointTotal; }
+
+    /**
+     * @brief Сколько фигур содержит i-ю точку
+     */
+    int hitCount(int point) const { return offsets[point + 1] - offsets[point]; }
+
+    /**
+     * @brief Индексы фигур (в исходном Array), содержащих i-ю точку
+     * @return Указатель на hitCount(point) индексов по возрастанию
+     */
+    const int* hits(int point) const { return hitData + offsets[point]; }
+
+    /**
+     * @brief Суммарное количество попаданий по всем точкам
+     */
+    int totalHits() const { return pointTotal == 0 ? 0 : offsets[pointTotal]; }
+};
+
+/**
+ * @class FigureIndex
+ * @brief Неизменяемый снимок коллекции фигур, подготовленный для запросов
+ *
+ * ЗАЧЕМ ЭТО НУЖНО?
+ * Наивный ответ на вопрос "в каких фигурах лежит точка" - пройти по
+ * всему Array и вызвать Figure::contains() у каждой фигуры: O(n) на точку
+ * плюс виртуальные вызовы и разыменования указателей.
+ *
+ * УСТРОЙСТВО:
+ * 1. Ограничивающие прямоугольники всех фигур лежат в одном массиве.
+ * 2. Стороны каждой фигуры хранятся в формате SoA (отдельно ax, ay, dx, dy
+ *    для 4 сторон), выровненно - проверка точки против всех 4 сторон
+ *    выполняется двумя (SSE2) или одной (AVX) векторной операцией.
+ * 3. Плоскость разбита равномерной сеткой примерно из n ячеек; каждая
+ *    ячейка хранит фигуры, чей AABB ее задевает. Точка проверяется только
+ *    против фигур своей ячейки.
+ *
+ * Для типичных данных (фигуры сравнимого размера) запрос стоит O(1).
+ *
+ * ВАЖНО: индекс - это снимок. После изменения Array (push, remove,
+ * изменение вершин) индекс нужно построить заново.
+ *
+ * @code
+ * FigureIndex index(figures);
+ * int first[1000];
+ * index.locateAll(queries, 1000, first);   // первая фигура или -1
+ *
+ * PointHits hits;
+ * index.queryAll(queries, 1000, hits);     // все фигуры для каждой точки
+ * @endcode
+ */
+class FigureIndex {
+private:
+    /**
+     * @brief Стороны одной фигуры в формате SoA
+     *
+     * Сторона i идет из (ax[i], ay[i]) в (ax[i] + dx[i], ay[i] + dy[i]).
+     * Выравнивание на 32 байта позволяет загружать 4 double одной
+     * инструкцией AVX (или двумя SSE2).
+     */
+    struct alignas(32) EdgeBlock {
+        double ax[4];
+        double ay[4];
+        double dx[4];
+        double dy[4];
+    };
+
+    int count;             ///< Количество фигур в снимке
+    BoundingBox* boxes;    ///< AABB каждой фигуры
+    EdgeBlock* edges;      ///< Стороны каждой фигуры
+    BoundingBox extent;    ///< AABB всей коллекции
+
+    // Равномерная сетка
+    int cellsX;            ///< Количество ячеек по X
+    int cellsY;            ///< Количество ячеек по Y
+    double invCellW;       ///< 1 / ширина ячейки
+    double invCellH;       ///< 1 / высота ячейки
+    int* cellStart;        ///< Начало списка фигур ячейки, размер cellsX*cellsY + 1
+    int* cellItems;        ///< Индексы фигур всех ячеек подряд
+
+    void buildGrid();
+
+    // Ограничение в double до приведения: (int) от значения вне
+    // диапазона int (область запроса далеко за extent) - UB
+    int cellX(double x) const {
+        double c = (x - extent.minX) * invCellW;
+        if (!(c > 0)) return 0;
+        if (c >= cellsX) return cellsX - 1;
+        return (int)c;
+    }
+
+    int cellY(double y) const {
+        double c = (y - extent.minY) * invCellH;
+        if (!(c > 0)) return 0;
+        if (c >= cellsY) return cellsY - 1;
+        return (int)c;
+    }
+
+public:
+    /**
+     * @brief Строит индекс по текущему содержимому массива
+     * @param figures Коллекция фигур
+     *
+     * СЛОЖНОСТЬ: O(n + k), где k - суммарное число пар (фигура, ячейка).
+     */
+    explicit FigureIndex(const Array& figures);
+
+    ~FigureIndex();
+
+    FigureIndex(const FigureIndex&) = delete;
+    FigureIndex& operator=(const FigureIndex&) = delete;
+
+    /**
+     * @brief Количество фигур в снимке
+     */
+    int size() const { return count; }
+
+    /**
+     * @brief AABB фигуры с индексом figure
+     */
+    const BoundingBox& bounds(int figure) const { return boxes[figure]; }
+
+    /**
+     * @brief AABB всей коллекции (за ним фигур нет)
+     */
+    const BoundingBox& getExtent() const { return extent; }
+
+    /**
+     * @brief Векторная проверка "точка внутри фигуры figure"
+     *
+     * Результат совпадает с Figure::contains() для той же фигуры.
+     */
+    bool contains(int figure, const Point& p) const;
+
+    /**
+     * @brief Находит фигуру с наименьшим индексом, содержащую точку
+     * @return Индекс фигуры или -1, если точка не лежит ни в одной
+     */
+    int locate(const Point& p) const;
+
+    /**
+     * @brief Массовый вариант locate()
+     * @param queries Массив точек
+     * @param n Количество точек
+     * @param out Массив из n элементов для результатов
+     */
+    void locateAll(const Point* queries, int n, int* out) const;
+
+    /**
+     * @brief Для каждой точки считает, сколько фигур ее содержат
+     * @param counts Массив из n элементов для результатов
+     */
+    void countAll(const Point* queries, int n, int* counts) const;
+
+    /**
+     * @brief Для каждой точки находит все содержащие ее фигуры
+     * @param out Результат (предыдущее содержимое заменяется)
+     *
+     * Работает в два прохода: сначала подсчет, затем заполнение.
+     * Так память под результат выделяется ровно один раз.
+     */
+    void queryAll(const Point* queries, int n, PointHits& out) const;
+
+    /**
+     * @brief Сколько записей ячеек просмотрит forEachCandidate(box)
+     *
+     * Цена запроса по области до его выполнения: O(строк сетки).
+     * Крупные фигуры лежат во многих ячейках, и для широкой области
+     * это число может быть больше size() - тогда дешевле просмотр.
+     */
+    long long cellEntriesIn(const BoundingBox& box) const;
+
+    /**
+     * @brief Перебирает фигуры, чей AABB пересекается с box
+     * @param box Область запроса
+     * @param callback Вызывается как callback(int figure) ровно один раз
+     *                 для каждой подходящей фигуры
+     *
+     * Фигура, задевающая несколько ячеек, сообщается только из той ячейки,
+     * в которую попадает левый нижний угол пересечения AABB - поэтому
+     * повторы отсекаются без дополнительной памяти.
+     */
+    template <typename Callback>
+    void forEachCandidate(const BoundingBox& box, Callback callback) const {
+        if (count == 0 || !extent.intersects(box)) return;
+        int x0 = cellX(box.minX), x1 = cellX(box.maxX);
+        int y0 = cellY(box.minY), y1 = cellY(box.maxY);
+        for (int cy = y0; cy <= y1; cy++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                int cell = cy * cellsX + cx;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                    int f = cellItems[k];
+                    const BoundingBox& fb = boxes[f];
+                    if (!fb.intersects(box)) continue;
+                    double refX = fb.minX > box.minX ? fb.minX : box.minX;
+                    double refY = fb.minY > box.minY ? fb.minY : box.minY;
+                    if (cellX(refX) != cx || cellY(refY) != cy) continue;
+                    callback(f);
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,173 @@
+#pragma once
+#include "Point.h"
+#include "BoundingBox.h"
+#include "Orientation.h"
+
+/**
+ * @file FigureKernels.h
+ * @brief Общие constexpr-ядра фигур и статический (CRTP) интерфейс
+ *
+ * Площадь по формуле Гаусса, центр и упорядочивание вершин одинаковы
+ * для всех наших четырехугольников. Здесь они написаны один раз как
+ * constexpr-функции, которые используют:
+ * - Figure и FigureAdapter (виртуальный интерфейс - тонкая обертка);
+ * - Quad<Kind> - фигура-значение без виртуальных функций: ее методы
+ *   встраиваются компилятором и вычисляются во время компиляции.
+ *
+ * @code
+ * constexpr Quad<Square> unit({Point(1, 1), Point(0, 0), Point(0, 1), Point(1, 0)});
+ * static_assert(unit.area() == 1, "");
+ * Square sq(unit.vertices());   // та же фигура для полиморфных коллекций
+ * @endcode
+ */
+
+// ===================================================================
+// ЯДРА
+// ===================================================================
+
+/**
+ * @brief Площадь многоугольника по формуле Гаусса (Shoelace)
+ * @param p Вершины в порядке обхода (любого направления)
+ * @param n Количество вершин
+ *
+ * S = 1/2 * |sum(xi * yi+1 - xi+1 * yi)|: каждое слагаемое - удвоенная
+ * ориентированная площадь треугольника (0, pi, pi+1).
+ */
+constexpr double shoelaceArea(const Point* p, int n) {
+    double sum = 0;
+    for (int i = 0; i < n; i++) {
+        int j = (i + 1) % n;  // замыкание контура: n-1 -> 0
+        sum += p[i].x * p[j].y;
+        sum -= p[j].x * p[i].y;
+    }
+    return (sum < 0 ? -sum : sum) / 2.0;
+}
+
+/**
+ * @brief Центр фигуры - среднее арифметическое вершин
+ */
+constexpr Point vertexCentroid(const Point* p, int n) {
+    double cx = 0, cy = 0;
+    for (int i = 0; i < n; i++) {
+        cx += p[i].x;
+        cy += p[i].y;
+    }
+    return Point(cx / n, cy / n);
+}
+
+/**
+ * @brief Лежит ли направление a раньше b при обходе против часовой стрелки
+ *
+ * Порядок тот же, что у atan2(y, x) по возрастанию (от -pi до pi),
+ * но без тригонометрии: сначала нижняя полуплоскость (y < 0), затем
+ * верхняя; внутри полуплоскости - по точному знаку векторного
+ * произведения (angleBeforeAround(), Orientation.h).
+ * Угол нулевого вектора, как и у atan2(0, 0), считается нулевым.
+ */
+constexpr bool angleBefore(const Point& a, const Point& b) {
+    return angleBeforeAround(Point(0, 0), a, b);
+}
+
+/**
+ * @brief Упорядочивает 4 вершины против часовой стрелки вокруг их центра
+ *
+ * Сортировка обменами по angleBeforeAround(): для 4 элементов это
+ * 6 сравнений. Разности p - c считаются один раз; когда их точности
+ * не хватает для знака, решают исходные вершины и центр, поэтому
+ * порядок верен и для почти вырожденных фигур и фигур далеко от
+ * начала координат.
+ */
+constexpr void orderCounterClockwise(Point* p) {
+    Point c = vertexCentroid(p, 4);
+    Point d[4] = {};
+    for (int i = 0; i < 4; i++) d[i] = Point(p[i].x - c.x, p[i].y - c.y);
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = i + 1; j < 4; j++) {
+            if (angleBeforeAround(c, p[j], p[i], d[j], d[i])) {
+                Point t = d[i]; d[i] = d[j]; d[j] = t;
+                t = p[i]; p[i] = p[j]; p[j] = t;
+            }
+        }
+    }
+}
+
+/**
+ * @brief AABB набора вершин
+ */
+constexpr BoundingBox vertexBounds(const Point* p, int n) {
+    BoundingBox box(p[0].x, p[0].y, p[0].x, p[0].y);
+    for (int i = 1; i < n; i++) {
+        if (p[i].x < box.minX) box.minX = p[i].x;
+        if (p[i].x > box.maxX) box.maxX = p[i].x;
+        if (p[i].y < box.minY) box.minY = p[i].y;
+        if (p[i].y > box.maxY) box.maxY = p[i].y;
+    }
+    return box;
+}
+
+// ===================================================================
+// СТАТИЧЕСКИЙ ИНТЕРФЕЙС
+// ===================================================================
+
+/**
+ * @class QuadKernel
+ * @brief Статический (CRTP) интерфейс четырехугольника
+ *
+ * Derived предоставляет vertices() - 4 вершины против часовой стрелки;
+ * QuadKernel добавляет к нему area(), center() и bounds(). Вызовы
+ * разрешаются при компиляции, без таблицы виртуальных функций.
+ */
+template <typename Derived>
+class QuadKernel {
+public:
+    constexpr double area() const { return shoelaceArea(self().vertices(), 4); }
+    constexpr Point center() const { return vertexCentroid(self().vertices(), 4); }
+    constexpr BoundingBox bounds() const { return vertexBounds(self().vertices(), 4); }
+
+private:
+    constexpr const Derived& self() const { return static_cast<const Derived&>(*this); }
+};
+
+/**
+ * @class Quad
+ * @brief Четырехугольник-значение с типом Kind (Square, Rectangle, Trapezoid)
+ *
+ * Литеральный тип: может быть constexpr-константой. Kind - только метка,
+ * от нее берется название типа (Kind::TYPE_NAME); объекты Kind
+ * не создаются.
+ *
+ * Вершины упорядочиваются в конструкторе тем же orderCounterClockwise(),
+ * что и у Figure, поэтому Quad<Square>(p) и Square(p) хранят одинаковые
+ * вершины в одинаковом порядке.
+ */
+template <typename Kind>
+class Quad : public QuadKernel<Quad<Kind>> {
+private:
+    Point points[4];
+
+public:
+    constexpr Quad() : points{Point(0, 0), Point(1, 0), Point(1, 1), Point(0, 1)} {}
+
+    constexpr explicit Quad(const Point (&p)[4]) : points{p[0], p[1], p[2], p[3]} {
+        orderCounterClockwise(points);
+    }
+
+    constexpr const Point* vertices() const { return points; }
+
+    static constexpr const char* type() { return Kind::TYPE_NAME; }
+};
+
+/**
+ * @brief Суммарная площадь массива фигур одного конкретного типа
+ *
+ * Для Quad<Kind> и для классов фигур (Square и др., где area()
+ * объявлен final в FigureAdapter) вызов area() не виртуальный
+ * и встраивается в цикл.
+ */
+template <typename Shape>
+constexpr double sumAreas(const Shape* shapes, int n) {
+    double total = 0;
+    for (int i = 0; i < n; i++) total += shapes[i].area();
+    return total;
+}
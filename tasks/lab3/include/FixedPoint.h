@@ -0,0 +1,167 @@
+#pragma once
+#include "Array.h"
+#include "Classifier.h"
+
+/**
+ * @file FixedPoint.h
+ * @brief Целочисленные координаты с фиксированной точкой: точная площадь,
+ *        транзитивное равенство и хеш фигур, пакетное сравнение
+ */
+
+// Собирается только при GEOMETRY_HAS_INT128 (проверка в CMakeLists.txt)
+#if !defined(GEOMETRY_HAS_INT128)
+#error "FixedPoint.h: нужен 128-битный целый тип (__int128, GCC/Clang)"
+#endif
+
+/**
+ * @brief Удвоенная площадь в единицах 1 / scale^2 (точно)
+ */
+typedef __int128 FixedArea;
+
+/**
+ * @brief Масштаб по умолчанию: 10^4 единиц на единицу координат
+ *        (шаг 1e-4, как допуск Figure::operator==)
+ */
+const double FIXED_DEFAULT_SCALE = 1e4;
+
+/**
+ * @brief Наибольший модуль координаты в единицах масштаба (2^53)
+ *
+ * До 2^53 double переводится в целое без потери, а удвоенная площадь
+ * (произведения разностей, до 2^108) помещается в FixedArea.
+ */
+const long long FIXED_COORD_LIMIT = 1LL << 53;
+
+/**
+ * @brief Четырехугольник в целых координатах
+ *
+ * КАНОНИЧЕСКИЙ ВИД: вершины против часовой стрелки, первая - с наименьшим
+ * (y, x). Порядок вершин во входных данных на него не влияет, поэтому
+ * равенство - 8 сравнений целых, а хеш - функция от этих 8 чисел.
+ *
+ * Равенство транзитивно: фигуры равны, если равны их координаты,
+ * округленные до шага 1 / scale. Сравнение с допуском (operator==)
+ * может считать a == b и b == c, но a != c.
+ */
+struct FixedQuad {
+    long long x[4];
+    long long y[4];
+
+    bool operator==(const FixedQuad& other) const {
+        bool same = true;
+        for (int i = 0; i < 4; i++) same &= x[i] == other.x[i] && y[i] == other.y[i];
+        return same;
+    }
+
+    bool operator!=(const FixedQuad& other) const { return !(*this == other); }
+
+    /**
+     * @brief Удвоенная площадь (точно, в единицах 1 / scale^2)
+     */
+    FixedArea doubledArea() const;
+
+    /**
+     * @brief Площадь в исходных единицах (одно округление в конце)
+     */
+    double area(double scale) const;
+
+    /**
+     * @brief Хеш канонического вида
+     */
+    unsigned long long hash() const;
+};
+
+/**
+ * @brief Переводит 4 точки в канонический FixedQuad
+ * @param p Вершины в любом порядке (выпуклый четырехугольник)
+ * @param scale Единиц фиксированной точки на единицу координат
+ * @return false для NaN, бесконечности или |координата * scale| > FIXED_COORD_LIMIT
+ *
+ * Координаты округляются к ближайшему целому (llround). Порядок
+ * обхода определяется точными целочисленными векторными
+ * произведениями, без atan2 и без ошибок округления.
+ */
+bool toFixed(const Point p[4], double scale, FixedQuad& out);
+
+/**
+ * @brief Вершины фигуры в FixedQuad (см. toFixed(const Point*, ...))
+ */
+bool toFixed(const Figure& fig, double scale, FixedQuad& out);
+
+/**
+ * @class FixedQuadArray
+ * @brief Набор FixedQuad в столбцах (SoA) для пакетных операций
+ *
+ * Каждая из 8 координат хранится своим массивом, рядом - столбец
+ * хешей. Поиск равных ключу - проход по хешам без ветвлений, который
+ * компилятор векторизует (сравнения 64-битных целых); координаты
+ * читаются только у совпавших хешей.
+ *
+ * @code
+ * FixedQuadArray set(FIXED_DEFAULT_SCALE);
+ * set.append(figures);                // фигуры вне диапазона пропускаются
+ * int dup = set.markDuplicates(flags);
+ * @endcode
+ */
+class FixedQuadArray {
+private:
+    double scale;
+    long long* columns[8];   ///< x0..x3, y0..y3
+    unsigned long long* hashes;   ///< FixedQuad::hash() каждой фигуры
+    FigureKind* kinds;
+    int count;
+    int capacity;
+
+    void grow();
+
+public:
+    explicit FixedQuadArray(double scale = FIXED_DEFAULT_SCALE);
+    ~FixedQuadArray();
+
+    FixedQuadArray(const FixedQuadArray&) = delete;
+    FixedQuadArray& operator=(const FixedQuadArray&) = delete;
+
+    double getScale() const { return scale; }
+    int size() const { return count; }
+
+    /**
+     * @brief Добавляет фигуру
+     * @return false, если координаты вне диапазона (ничего не добавлено)
+     */
+    bool push(const Figure& fig);
+
+    /**
+     * @brief Добавляет все фигуры коллекции
+     * @return Сколько добавлено
+     */
+    int append(const Array& figures);
+
+    FixedQuad get(int index) const;
+    FigureKind kind(int index) const { return kinds[index]; }
+
+    /**
+     * @brief Отмечает фигуры, равные key (хеш, затем 8 координат)
+     * @param equal Массив из size() флагов (1 - равна)
+     * @return Количество равных
+     */
+    int findEqual(const FixedQuad& key, unsigned char* equal) const;
+
+    /**
+     * @brief Отмечает повторы: фигура равна одной из предыдущих
+     * @param duplicate Массив из size() флагов
+     * @return Количество повторов
+     *
+     * Хеш-таблица с открытой адресацией по сохраненным хешам;
+     * совпадение хеша проверяется точным сравнением. O(n) в среднем.
+     */
+    int markDuplicates(bool* duplicate) const;
+
+    /**
+     * @brief Сумма площадей: целые удвоенные площади складываются
+     *        точно, округление одно - в конце
+     *
+     * Точна, пока сумма удвоенных площадей меньше 2^127 (координаты
+     * до 2^40 единиц - при любом числе фигур).
+     */
+    double totalArea() const;
+};
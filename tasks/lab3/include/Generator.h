@@ -0,0 +1,79 @@
+#pragma once
+#include "Classifier.h"
+#include "Stream.h"
+#include "ThreadPool.h"
+
+/**
+ * @file Generator.h
+ * @brief Воспроизводимые синтетические наборы фигур для нагрузочных тестов
+ */
+
+/**
+ * @brief Фигур в одном блоке генерации (и в одном кадре Codec)
+ */
+const int GENERATOR_BLOCK = 4096;
+
+/**
+ * @brief Параметры набора
+ */
+struct GeneratorOptions {
+    unsigned long long seed = 1;
+
+    /**
+     * @brief Поворачивать фигуры на случайный угол (false - стороны вдоль осей)
+     */
+    bool rotate = true;
+
+    /**
+     * @brief Центры фигур - в квадрате [-scale, scale] x [-scale, scale]
+     */
+    double scale = 1000;
+
+    /**
+     * @brief Плотность перекрытий: сколько фигур в среднем накрывают
+     *        точку поля
+     *
+     * Средняя площадь фигуры = overlap * (2 * scale)^2 / count:
+     * при 0.1 фигуры почти не пересекаются, при 10 - лежат слоями.
+     */
+    double overlap = 1;
+
+    /**
+     * @brief Доля фигур, повторяющих одну из предыдущих (те же вершины
+     *        в другом порядке - равные по operator==)
+     */
+    double duplicateRatio = 0;
+};
+
+/**
+ * @brief Фигура номер index набора из count фигур
+ * @param kind Тип (Square, Rectangle или Trapezoid, поровну в среднем)
+ * @param record 8 чисел: вершины в случайном порядке
+ *
+ * Фигура зависит только от seed, index и count - не от порядка
+ * и числа потоков генерации, поэтому любой кусок набора можно
+ * получить заново без остальных.
+ *
+ * Фигуры проходят проверку заявленного типа (classifyRecords
+ * с допуском по умолчанию): трапеции никогда не параллелограммы.
+ */
+void generateRecord(long long index, long long count, const GeneratorOptions& options,
+                    FigureKind& kind, double* record);
+
+/**
+ * @brief Записывает набор из count фигур в файл
+ * @param path Путь к файлу (перезаписывается)
+ * @param format Text - строки "Type x1 y1 ... x4 y4" (ingestFigures,
+ *        streamStats; после слова типа - формат Figure::read);
+ *        Codec - кадры appendCodecFrame по GENERATOR_BLOCK фигур
+ * @param pool Пул потоков (nullptr - ThreadPool::shared())
+ * @return Записано байт или -1 при ошибке записи
+ *
+ * Блоки по GENERATOR_BLOCK фигур генерируются и форматируются
+ * параллельно (числа - std::to_chars, кратчайшая точная запись)
+ * в отдельные буферы, затем пишутся в файл по порядку. Файл
+ * одинаков побайтно при любом числе потоков.
+ */
+long long generateFigures(const char* path, StreamFormat format, long long count,
+                          const GeneratorOptions& options = GeneratorOptions(),
+                          ThreadPool* pool = nullptr);
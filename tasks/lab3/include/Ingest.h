@@ -0,0 +1,132 @@
+#pragma once
+#include "Array.h"
+#include "Classifier.h"
+#include <istream>
+#include <ostream>
+
+/**
+ * @file Ingest.h
+ * @brief Конвейерная загрузка фигур из текста: разбор, проверка,
+ *        упорядочивание вершин, добавление в коллекцию
+ */
+
+/**
+ * @brief Записей в одном пакете конвейера
+ */
+const int INGEST_BATCH_SIZE = 256;
+
+/**
+ * @brief Стадии конвейера
+ */
+enum class IngestStage : unsigned char {
+    Parse,     ///< Строки текста -> тип и 8 чисел
+    Validate,  ///< Классификация (classifyRecords) и сверка с заявленным типом
+    Order,     ///< Создание фигур: sortPoints() в конструкторе
+    Store      ///< Array::push() (в вызывающем потоке)
+};
+
+const int INGEST_STAGE_COUNT = 4;
+
+/**
+ * @brief Название стадии ("parse", "validate", ...)
+ */
+const char* stageName(IngestStage stage);
+
+/**
+ * @brief Параметры конвейера
+ */
+struct IngestOptions {
+    int queueCapacity = 4;       ///< Пакетов в каждой очереди между стадиями
+    int orderThreads = 1;        ///< Потоков стадии Order
+    double tolerance = 1e-6;     ///< Допуск классификации (см. classifyRecords)
+    /// Вызывается потоком Order перед обработкой пакета с номером sequence
+    /// (для тестов и замеров: например, искусственно медленный пакет)
+    void (*orderHook)(long long sequence) = nullptr;
+};
+
+/**
+ * @brief Замеры одной стадии (по всем ее потокам)
+ *
+ * busyNs - время собственной работы; waitInNs - ожидание входного
+ * пакета (стадия простаивает, потому что предыдущая не успевает);
+ * waitOutNs - ожидание места в выходной очереди (следующая стадия
+ * не успевает, обратное давление).
+ */
+struct IngestStageStats {
+    int threads = 0;
+    long long items = 0;      ///< Обработано записей
+    long long busyNs = 0;
+    long long waitInNs = 0;
+    long long waitOutNs = 0;
+
+    /**
+     * @brief Пропускная способность стадии: записей в секунду работы
+     *        (с учетом числа потоков)
+     */
+    double itemsPerSecond() const;
+};
+
+/**
+ * @brief Итог загрузки: счетчики записей и замеры стадий
+ */
+struct IngestReport {
+    IngestStageStats stages[INGEST_STAGE_COUNT];  ///< Индекс - (int)IngestStage
+    ClassifyStats classify;   ///< Результаты классификации разобранных записей
+    int lines = 0;            ///< Непустых строк
+    int malformed = 0;        ///< Строки с неизвестным типом или не 8 числами
+    int mismatched = 0;       ///< Фигура не того типа, что заявлен в строке
+    int stored = 0;           ///< Добавлено в коллекцию
+    int maxReordered = 0;     ///< Наибольшее число пакетов, ждавших своей очереди в Store
+    long long wallNs = 0;     ///< Время всей загрузки
+
+    const IngestStageStats& stage(IngestStage s) const { return stages[(int)s]; }
+
+    /**
+     * @brief Стадия с наименьшей пропускной способностью
+     */
+    IngestStage bottleneck() const;
+
+    /**
+     * @brief Выводит таблицу стадий и счетчики записей
+     */
+    void print(std::ostream& os) const;
+};
+
+/**
+ * @brief Разбирает строку "Type x1 y1 ... x4 y4": тип, затем ровно 8 чисел
+ * @param s Строка, завершенная нулем (без перевода строки)
+ * @param kind Заявленный тип
+ * @param record 8 чисел
+ * @return false для неизвестного типа, нечисла или лишнего текста
+ */
+bool parseFigureLine(const char* s, FigureKind& kind, double* record);
+
+/**
+ * @brief Загружает фигуры из текста конвейером стадий
+ * @param in Поток строк вида "Square x1 y1 x2 y2 x3 y3 x4 y4"
+ *        (тип - Square, Rectangle или Trapezoid; пустые строки пропускаются)
+ * @param out Коллекция, в конец которой добавляются фигуры
+ * @param report Счетчики и замеры стадий (может быть nullptr)
+ * @param options Параметры конвейера
+ * @return Количество добавленных фигур
+ *
+ * В lab03 каждая фигура проходит read(), sortPoints() и push() по
+ * очереди в одном потоке. Здесь это стадии, работающие одновременно
+ * в своих потоках над пакетами по INGEST_BATCH_SIZE записей:
+ *
+ *   Parse -> [очередь] -> Validate -> [очередь] -> Order (N потоков)
+ *         -> [очередь] -> Store
+ *
+ * Очереди ограничены (BoundedQueue): быстрая стадия ждет медленную.
+ * Окно восстановления порядка тоже ограничено: поток Order отдает пакет,
+ * только если его номер меньше next + queueCapacity + orderThreads
+ * (next - пакет, которого ждет Store), поэтому один медленный поток
+ * Order останавливает остальные. В памяти не больше
+ * ~3 * queueCapacity + 2 * orderThreads пакетов. Validate отбрасывает
+ * вырожденные записи и записи, не подходящие под заявленный тип
+ * (квадрат подходит под Rectangle и Trapezoid, но не наоборот).
+ * Store восстанавливает исходный порядок пакетов, поэтому порядок фигур
+ * в out совпадает с порядком строк при любом orderThreads.
+ */
+int ingestFigures(std::istream& in, Array& out, IngestReport* report = nullptr,
+                  const IngestOptions& options = IngestOptions());
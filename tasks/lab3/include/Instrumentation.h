@@ -0,0 +1,170 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+/**
+ * @file Instrumentation.h
+ * @brief Счетчики и гистограммы задержек горячих операций
+ *
+ * Включается на этапе компиляции: cmake -DGEOMETRY_INSTRUMENTATION=ON.
+ * Без этого флага макрос GEOMETRY_PROBE раскрывается в пустой оператор,
+ * и в инструментированных методах не остается ни одной лишней инструкции.
+ *
+ * @code
+ * void Array::push(Figure* fig) {
+ *     GEOMETRY_PROBE(Probe::ArrayPush);  // замер до конца области видимости
+ *     ...
+ * }
+ *
+ * dumpInstrumentation(std::cout);        // таблица: count, mean, p50, p99, max
+ * @endcode
+ */
+
+/**
+ * @brief Инструментированные операции
+ */
+enum class Probe : unsigned char {
+    ArrayPush,    ///< Array::push()
+    ArrayRemove,  ///< Array::remove()
+    ArrayResize,  ///< Array::resize() (входит и в замер push)
+    TotalArea,    ///< Array::totalArea()
+    SortPoints,   ///< Figure::sortPoints() (конструкторы, setPoints)
+    Read,         ///< read() всех типов фигур
+    Print         ///< print() всех типов фигур
+};
+
+const int PROBE_COUNT = 7;
+
+/**
+ * @brief Название операции ("Array::push", ...)
+ */
+const char* probeName(Probe probe);
+
+/**
+ * @brief Гистограмма задержек в наносекундах в стиле HDR
+ *
+ * Логарифмически-линейные корзины: значения до 32 нс хранятся точно,
+ * дальше каждая степень двойки делится на 16 равных корзин. Относительная
+ * погрешность любого перцентиля - не больше 1/16 (~6%) при фиксированном
+ * размере (976 счетчиков) для всего диапазона 64-битных значений.
+ *
+ * Счетчики атомарные (relaxed): запись из нескольких потоков безопасна,
+ * чтение во время записи дает согласованный "почти снимок".
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKETS = 16;
+    static constexpr int BUCKET_COUNT = 976;
+
+private:
+    std::atomic<unsigned long long> buckets[BUCKET_COUNT];
+    std::atomic<unsigned long long> total;
+    std::atomic<unsigned long long> sum;
+    std::atomic<unsigned long long> minValue;
+    std::atomic<unsigned long long> maxValue;
+
+public:
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /**
+     * @brief Номер корзины для значения
+     */
+    static int bucketOf(unsigned long long value);
+
+    /**
+     * @brief Наибольшее значение, попадающее в корзину
+     */
+    static unsigned long long bucketUpper(int bucket);
+
+    /**
+     * @brief Добавляет одно значение
+     */
+    void record(unsigned long long value);
+
+    /**
+     * @brief Обнуляет гистограмму
+     */
+    void reset();
+
+    unsigned long long count() const { return total.load(std::memory_order_relaxed); }
+    unsigned long long totalValue() const { return sum.load(std::memory_order_relaxed); }
+    unsigned long long min() const;
+    unsigned long long max() const { return maxValue.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Среднее значение (0 для пустой гистограммы)
+     */
+    double mean() const;
+
+    /**
+     * @brief Перцентиль
+     * @param q Доля от 0 до 1 (0.5 - медиана, 0.99 - p99)
+     * @return Верхняя граница корзины, в которую попал перцентиль
+     *         (не больше max())
+     */
+    unsigned long long percentile(double q) const;
+};
+
+/**
+ * @brief true, если библиотека собрана с инструментированием
+ */
+constexpr bool instrumentationEnabled() {
+#ifdef GEOMETRY_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Гистограмма операции (доступна и без инструментирования, но пуста)
+ */
+LatencyHistogram& probeHistogram(Probe probe);
+
+/**
+ * @brief Обнуляет все гистограммы
+ */
+void resetInstrumentation();
+
+/**
+ * @brief Печатает таблицу: операция, количество, среднее, p50, p90, p99, max
+ *
+ * Операции без вызовов пропускаются. Без инструментирования печатает
+ * подсказку, как его включить.
+ */
+void dumpInstrumentation(std::ostream& os);
+
+/**
+ * @brief Замер от конструктора до деструктора
+ */
+class ScopedProbe {
+private:
+    LatencyHistogram& histogram;
+    std::chrono::steady_clock::time_point started;
+
+public:
+    explicit ScopedProbe(Probe probe)
+        : histogram(probeHistogram(probe)), started(std::chrono::steady_clock::now()) {}
+
+    ~ScopedProbe() {
+        auto elapsed = std::chrono::steady_clock::now() - started;
+        histogram.record((unsigned long long)
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    ScopedProbe(const ScopedProbe&) = delete;
+    ScopedProbe& operator=(const ScopedProbe&) = delete;
+};
+
+#define GEOMETRY_PROBE_CONCAT_(a, b) a##b
+#define GEOMETRY_PROBE_NAME_(line) GEOMETRY_PROBE_CONCAT_(geometryProbe_, line)
+
+#ifdef GEOMETRY_INSTRUMENTATION
+#define GEOMETRY_PROBE(probe) ScopedProbe GEOMETRY_PROBE_NAME_(__LINE__)(probe)
+#else
+#define GEOMETRY_PROBE(probe) ((void)0)
+#endif
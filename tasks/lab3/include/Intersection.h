@@ -0,0 +1,89 @@
+#pragma once
+#include "Array.h"
+#include "SmallArray.h"
+
+/**
+ * @file Intersection.h
+ * @brief Площади пересечения фигур: попарно, пакетно и "все со всеми"
+ */
+
+/**
+ * @brief Максимальное суммарное число вершин двух отсекаемых многоугольников
+ *
+ * Пересечение выпуклых n- и m-угольника имеет не более n + m вершин.
+ * Для наших четырехугольников это 8, запас оставлен для многоугольников,
+ * полученных предыдущими отсечениями.
+ */
+const int MAX_CLIP_VERTICES = 32;
+
+/**
+ * @brief Отсекает выпуклый многоугольник subject выпуклым многоугольником clip
+ * @param subject Вершины первого многоугольника (против часовой стрелки)
+ * @param n Количество вершин subject
+ * @param clip Вершины второго многоугольника (против часовой стрелки)
+ * @param m Количество вершин clip
+ * @param out Буфер минимум на n + m точек для результата
+ * @return Количество вершин пересечения (меньше 3 - пересечения нет)
+ *
+ * Алгоритм Sutherland-Hodgman: subject по очереди обрезается
+ * полуплоскостью слева от каждой стороны clip.
+ * Контракт: n + m <= MAX_CLIP_VERTICES.
+ */
+int clipConvexPolygon(const Point* subject, int n, const Point* clip, int m, Point* out);
+
+/**
+ * @brief Площадь пересечения двух выпуклых многоугольников
+ *
+ * Сначала сравниваются ограничивающие прямоугольники - для далеких
+ * фигур отсечение не выполняется вовсе.
+ * Контракт: na + nb <= MAX_CLIP_VERTICES, обход против часовой стрелки.
+ */
+double convexIntersectionArea(const Point* a, int na, const Point* b, int nb);
+
+/**
+ * @brief Пакетный расчет площадей пересечения для заданных пар
+ * @param figures Коллекция фигур
+ * @param first Индексы первых фигур пар
+ * @param second Индексы вторых фигур пар
+ * @param n Количество пар
+ * @param out Массив из n элементов для площадей
+ *
+ * Пары с неверными индексами получают площадь 0.
+ */
+void intersectionAreas(const Array& figures, const int* first, const int* second,
+                       int n, double* out);
+
+/**
+ * @brief Пара пересекающихся фигур и площадь их общей части
+ */
+struct Overlap {
+    int first;    ///< Индекс первой фигуры (first < second)
+    int second;   ///< Индекс второй фигуры
+    double area;  ///< Площадь пересечения (> 0)
+};
+
+/**
+ * @brief Динамический массив результатов findOverlaps()
+ *
+ * Первые 4 пары - во встроенном буфере, дальше буфер в куче
+ * с удвоением (см. SmallArray.h).
+ */
+using OverlapList = SmallArray<Overlap, 4>;
+
+/**
+ * @brief Находит все пары пересекающихся фигур коллекции
+ * @param figures Коллекция фигур
+ * @param out Результат (предыдущее содержимое удаляется)
+ *
+ * ДВЕ ФАЗЫ:
+ * 1. Широкая (broad phase): FigureIndex отбирает только пары
+ *    с пересекающимися AABB.
+ * 2. Узкая (narrow phase): для кандидатов выполняется точное отсечение.
+ *
+ * В результат попадают пары с ненулевой площадью пересечения
+ * (касание по стороне или вершине не считается), упорядоченные
+ * по первому индексу.
+ *
+ * СЛОЖНОСТЬ: O(n + k) для k пар-кандидатов вместо O(n²) отсечений.
+ */
+void findOverlaps(const Array& figures, OverlapList& out);
@@ -0,0 +1,183 @@
+#pragma once
+#include "Array.h"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+/**
+ * @file Journal.h
+ * @brief Коллекция с журналом упреждающей записи (write-ahead log),
+ *        групповой фиксацией и восстановлением после сбоя
+ */
+
+/**
+ * @brief Параметры журнала
+ */
+struct JournalOptions {
+    /**
+     * @brief Сколько незафиксированных операций push()/remove() вызывают
+     *        автоматическую фиксацию (1 - fsync на каждую операцию)
+     */
+    int groupCommit = 64;
+
+    /**
+     * @brief Размер журнала в байтах, после которого он сворачивается
+     *        в новый снимок (0 - только явный compact())
+     */
+    long long compactBytes = 4 << 20;
+};
+
+/**
+ * @brief Счетчики журнала
+ */
+struct JournalStats {
+    long long records = 0;       ///< Записано операций с момента open()
+    long long syncs = 0;         ///< Вызовов fsync журнала
+    long long compactions = 0;   ///< Записано снимков
+    int snapshotFigures = 0;     ///< Фигур в снимке при восстановлении
+    int replayed = 0;            ///< Операций журнала, примененных при восстановлении
+    long long tornBytes = 0;     ///< Отброшенный недописанный хвост журнала
+    long long journalBytes = 0;  ///< Текущий размер журнала
+};
+
+/**
+ * @class JournaledArray
+ * @brief Array, изменения которого сохраняются в журнал на диске
+ *
+ * ФАЙЛЫ (рядом, по базовому пути base):
+ * - base.snapshot - снимок: все фигуры коллекции (тип и 4 вершины),
+ *   номер поколения и CRC32 всего файла;
+ * - base.journal - заголовок с тем же номером поколения и записи
+ *   операций после снимка: push (тип, 4 вершины) и remove (индекс),
+ *   каждая со своим CRC32.
+ * Числа пишутся в порядке байтов машины: файлы переносимы между
+ * машинами одной архитектуры.
+ *
+ * ГРУППОВАЯ ФИКСАЦИЯ (group commit): операции копятся в буфере
+ * и уходят на диск одной записью с одним fsync - после groupCommit
+ * операций или по commit(). Если commit() вызывают несколько потоков,
+ * первый (лидер) пишет и синхронизирует все накопленное, остальные
+ * ждут его и не делают собственных fsync, если их операции уже вошли
+ * в запись; операции, добавленные во время fsync, уходят следующей группой.
+ *
+ * ВОССТАНОВЛЕНИЕ (open): снимок загружается, затем поверх него
+ * применяются записи журнала того же поколения до первой оборванной
+ * или поврежденной (сбой посреди записи). Если хвост был оборван,
+ * сразу пишется новый снимок - журнал снова начинается с чистого места.
+ *
+ * СВОРАЧИВАНИЕ (compact): снимок пишется во временный файл, fsync,
+ * атомарно заменяет старый (rename), затем создается пустой журнал
+ * нового поколения. Журнал старого поколения, оставшийся после сбоя
+ * между этими шагами, при восстановлении не применяется: его операции
+ * уже есть в снимке.
+ *
+ * Методы потокобезопасны (общий мьютекс). Ошибки ввода-вывода
+ * возвращаются как false; после ошибки коллекция в памяти верна,
+ * но ее изменения могут быть не сохранены.
+ *
+ * @code
+ * JournaledArray figures;
+ * figures.open("data/figures");   // восстановление или новая коллекция
+ * figures.push(new Square(p));
+ * figures.commit();               // теперь переживет сбой
+ * @endcode
+ */
+class JournaledArray {
+private:
+    JournalOptions options;
+    Array figures;
+    std::string basePath;
+    std::FILE* journal;
+    unsigned long long generation;   ///< Поколение текущего снимка и журнала
+
+    mutable std::mutex lock;
+    std::condition_variable flushed;
+
+    /**
+     * @brief Буфер операций, еще не отданных на запись
+     */
+    unsigned char* pending;
+    int pendingBytes;
+    int pendingCapacity;
+    unsigned char* writing;     ///< Буфер, который сейчас пишет лидер
+    int writingCapacity;
+
+    long long appendedOps;      ///< Номер последней операции
+    long long durableOps;       ///< Номер последней операции на диске
+    bool flushing;              ///< Лидер пишет журнал (без мьютекса)
+    bool failed;                ///< Была ошибка ввода-вывода
+    JournalStats stats;
+
+    void append(const unsigned char* bytes, int n);
+    void logRecord(unsigned char op, const unsigned char* payload, int n);
+
+    bool commitLocked(std::unique_lock<std::mutex>& guard, long long upTo);
+    bool compactLocked(std::unique_lock<std::mutex>& guard);
+    void afterChange(std::unique_lock<std::mutex>& guard);
+
+    bool loadSnapshot();
+    bool replayJournal(bool& torn);
+    bool openJournal(bool create);
+    void closeJournal();
+
+public:
+    explicit JournaledArray(const JournalOptions& options = JournalOptions());
+
+    /**
+     * @brief Фиксирует незаписанные операции и закрывает файлы
+     */
+    ~JournaledArray();
+
+    JournaledArray(const JournaledArray&) = delete;
+    JournaledArray& operator=(const JournaledArray&) = delete;
+
+    /**
+     * @brief Восстанавливает коллекцию по base.snapshot и base.journal
+     *        (или создает пустую) и открывает журнал для записи
+     * @param base Путь без расширения
+     * @return false, если файлы не читаются, снимок поврежден
+     *         или журнал не создается
+     */
+    bool open(const char* base);
+
+    /**
+     * @brief Добавляет фигуру (коллекция берет владение) и журналирует
+     *
+     * На диске операция окажется после ближайшей фиксации.
+     * Фигуры с типом, не известным журналу, не добавляются и удаляются.
+     */
+    void push(Figure* fig);
+
+    /**
+     * @brief Удаляет фигуру по индексу и журналирует удаление
+     * @return false для некорректного индекса (в журнал ничего не пишется)
+     */
+    bool remove(int index);
+
+    /**
+     * @brief Дожидается записи на диск всех операций, выполненных до вызова
+     * @return false при ошибке ввода-вывода
+     */
+    bool commit();
+
+    /**
+     * @brief Сворачивает журнал в новый снимок текущей коллекции
+     * @return false при ошибке ввода-вывода
+     *
+     * На время записи снимка изменения коллекции ждут.
+     */
+    bool compact();
+
+    /**
+     * @brief Коллекция (читать, пока другие потоки ее не меняют)
+     */
+    const Array& getFigures() const { return figures; }
+
+    int size() const;
+
+    /**
+     * @brief Копия счетчиков
+     */
+    JournalStats getStats() const;
+};
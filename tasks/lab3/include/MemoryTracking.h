@@ -0,0 +1,193 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+
+/**
+ * @file MemoryTracking.h
+ * @brief Учет памяти: перехватчик выделений и отчет о памяти коллекций
+ *
+ * Через trackedAllocate()/trackedFree() выделяются объекты фигур
+ * (Figure::operator new) и буферы коллекций. Если установлен
+ * перехватчик (AllocationHook), он видит каждое такое выделение
+ * с точным размером - это позволяет тестам проверять количество
+ * выделений массовых операций.
+ *
+ * @code
+ * AllocationCounter counter;
+ * {
+ *     ScopedAllocationHook hook(counter);
+ *     for (int i = 0; i < 100; i++) arr.push(new Square(p));
+ * }
+ * EXPECT_EQ(counter.allocations(), 100 + 5);  // фигуры + буферы 8 ... 128
+ * @endcode
+ */
+
+/**
+ * @brief Перехватчик выделений памяти
+ *
+ * Методы вызываются из любых потоков, выполняющих выделения,
+ * поэтому реализация должна быть потокобезопасной.
+ */
+class AllocationHook {
+public:
+    virtual ~AllocationHook() {}
+
+    /**
+     * @brief Выделен блок p размером bytes
+     */
+    virtual void allocated(void* p, std::size_t bytes) = 0;
+
+    /**
+     * @brief Освобожден блок p размером bytes
+     */
+    virtual void freed(void* p, std::size_t bytes) = 0;
+};
+
+/**
+ * @brief Устанавливает перехватчик (nullptr - снять)
+ * @return Предыдущий перехватчик
+ */
+AllocationHook* setAllocationHook(AllocationHook* hook);
+
+/**
+ * @brief Выделяет bytes байт и сообщает перехватчику
+ * @throws std::bad_alloc если памяти нет
+ */
+void* trackedAllocate(std::size_t bytes);
+
+/**
+ * @brief Освобождает блок, выделенный trackedAllocate()
+ * @param bytes Размер, запрошенный при выделении
+ */
+void trackedFree(void* p, std::size_t bytes);
+
+/**
+ * @brief Сколько байт аллокатор фактически отдал под блок
+ * @param p Блок из trackedAllocate()
+ * @param requested Запрошенный размер
+ *
+ * На glibc - malloc_usable_size(); на других платформах - оценка
+ * (округление до 16 байт).
+ */
+std::size_t allocationFootprint(const void* p, std::size_t requested);
+
+/**
+ * @brief Накладные расходы аллокатора на один блок (служебный заголовок)
+ */
+std::size_t allocationHeaderBytes();
+
+/**
+ * @brief Перехватчик-счетчик: количество и объем выделений
+ */
+class AllocationCounter : public AllocationHook {
+private:
+    std::atomic<long long> allocCount;
+    std::atomic<long long> freeCount;
+    std::atomic<long long> allocBytes;
+    std::atomic<long long> freeBytes;
+
+public:
+    AllocationCounter();
+
+    void allocated(void* p, std::size_t bytes) override;
+    void freed(void* p, std::size_t bytes) override;
+
+    long long allocations() const { return allocCount.load(std::memory_order_relaxed); }
+    long long frees() const { return freeCount.load(std::memory_order_relaxed); }
+    long long bytesAllocated() const { return allocBytes.load(std::memory_order_relaxed); }
+    long long bytesFreed() const { return freeBytes.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Байт выделено и еще не освобождено
+     */
+    long long liveBytes() const { return bytesAllocated() - bytesFreed(); }
+
+    void reset();
+};
+
+/**
+ * @brief Устанавливает перехватчик на время жизни объекта
+ */
+class ScopedAllocationHook {
+private:
+    AllocationHook* previous;
+
+public:
+    explicit ScopedAllocationHook(AllocationHook& hook) : previous(setAllocationHook(&hook)) {}
+    ~ScopedAllocationHook() { setAllocationHook(previous); }
+
+    ScopedAllocationHook(const ScopedAllocationHook&) = delete;
+    ScopedAllocationHook& operator=(const ScopedAllocationHook&) = delete;
+};
+
+// ===================================================================
+// ОТЧЕТ О ПАМЯТИ
+// ===================================================================
+
+/**
+ * @brief Память фигур одного типа
+ */
+struct TypeMemory {
+    const char* type;  ///< Название типа (getType())
+    int count;         ///< Количество объектов
+    long long bytes;   ///< Суммарный sizeof объектов
+};
+
+const int MEMORY_REPORT_TYPES = 8;
+
+/**
+ * @brief Разбивка памяти коллекции по категориям и типам
+ *
+ * КАТЕГОРИИ (все в байтах):
+ * - containerBytes: сам объект коллекции (sizeof);
+ * - bufferUsed / bufferUnused: занятая и свободная часть буферов
+ *   (свободная - запас после удвоения вместимости);
+ * - objectBytes: объекты фигур (sizeof динамического типа),
+ *   из них vptrBytes - указатели на таблицы виртуальных функций;
+ * - allocatorSlack: округление размера блоков аллокатором;
+ * - allocatorHeaders: служебные заголовки блоков.
+ */
+struct MemoryReport {
+    long long containerBytes = 0;
+    long long bufferUsed = 0;
+    long long bufferUnused = 0;
+    long long objectBytes = 0;
+    long long vptrBytes = 0;
+    long long allocatorSlack = 0;
+    long long allocatorHeaders = 0;
+    int allocations = 0;  ///< Количество блоков в куче
+
+    TypeMemory types[MEMORY_REPORT_TYPES] = {};
+    int typeCount = 0;
+
+    /**
+     * @brief Учитывает блок кучи: запрошенный размер и фактический
+     */
+    void addBlock(const void* p, std::size_t requested);
+
+    /**
+     * @brief Строка таблицы типов для type (создается при первом обращении)
+     */
+    TypeMemory& typeSlot(const char* type);
+
+    /**
+     * @brief Учитывает объект типа type размером bytes
+     */
+    void addObject(const char* type, std::size_t bytes);
+
+    /**
+     * @brief Итого: все категории (vptrBytes уже входит в objectBytes)
+     */
+    long long total() const;
+
+    /**
+     * @brief Объединяет с отчетом другой коллекции
+     */
+    void merge(const MemoryReport& other);
+
+    /**
+     * @brief Печатает таблицу категорий и типов
+     */
+    void print(std::ostream& os) const;
+};
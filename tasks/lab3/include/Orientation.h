@@ -0,0 +1,281 @@
+#pragma once
+#include "Point.h"
+#include <type_traits>
+
+/**
+ * @file Orientation.h
+ * @brief Точные предикаты ориентации с быстрым фильтром:
+ *        поворот трех точек, порядок направлений, выпуклость
+ *
+ * Знак векторного произведения (b - o) x (c - o), посчитанного в double,
+ * может быть неверным, когда точки почти коллинеарны или координаты
+ * велики по сравнению с размером фигуры: ошибка округления разностей
+ * и произведений больше самого результата. Неверный знак - неверный
+ * порядок вершин, и площадь по формуле Гаусса считается по
+ * самопересекающемуся контуру.
+ *
+ * Здесь знак всегда точный (схема Shewchuk, "Adaptive Precision
+ * Floating-Point Arithmetic and Fast Robust Geometric Predicates"):
+ * 1) ФИЛЬТР: то же произведение в double плюс оценка ошибки - одно
+ *    умножение и сравнение. Для обычных фигур ответ здесь.
+ * 2) Разности координат вычислены точно: точные произведения
+ *    (twoProduct) - 4 слагаемых.
+ * 3) Иначе - точная сумма 12 слагаемых (разложение определителя по
+ *    координатам) в виде расширения (expansion) без округлений.
+ *
+ * Все функции constexpr: упорядочивание Quad<Kind> при компиляции
+ * использует те же предикаты. Переполнение не проверяется
+ * (|координаты| < 1e150).
+ *
+ * @code
+ * if (orientation(a, b, c) > 0) { ... }   // поворот a -> b -> c против часовой
+ * long long before = orientationFallbacks();
+ * orderCounterClockwise(p);
+ * long long exact = orientationFallbacks() - before;   // сколько раз не хватило фильтра
+ * @endcode
+ */
+
+// ===================================================================
+// ПЕРЕНОСИМОСТЬ
+// ===================================================================
+
+/*
+  Встроенные функции GCC/Clang с запасными вариантами для остальных
+  компиляторов. Все варианты допустимы в constexpr (C++17).
+  ORIENT_IS_CONSTANT_EVALUATED() без встроенной функции и без
+  std::is_constant_evaluated (C++20) - всегда true: вычисление
+  корректно, но orientationFallbacks() тогда не считает обращения.
+*/
+#if defined(__GNUC__) || defined(__clang__)
+#define ORIENT_NOINLINE __attribute__((noinline))
+#define ORIENT_LIKELY(cond) __builtin_expect(!!(cond), 1)
+#define ORIENT_FABS(v) __builtin_fabs(v)
+#define ORIENT_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define ORIENT_NOINLINE
+#define ORIENT_LIKELY(cond) (cond)
+#define ORIENT_FABS(v) orientAbs(v)
+#if defined(__cpp_lib_is_constant_evaluated)
+#define ORIENT_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#else
+#define ORIENT_IS_CONSTANT_EVALUATED() true
+#endif
+#endif
+
+/**
+ * @brief Модуль без std::fabs (она не constexpr до C++23)
+ */
+constexpr double orientAbs(double v) {
+    return v < 0 ? -v : v;
+}
+
+// ===================================================================
+// ТОЧНАЯ АРИФМЕТИКА
+// ===================================================================
+
+/**
+ * @brief Машинный эпсилон Shewchuk: 2^-53 (половина ulp единицы)
+ */
+constexpr double ORIENT_EPSILON = 1.1102230246251565e-16;
+
+/**
+ * @brief Относительная оценка ошибки фильтра orientation()
+ */
+constexpr double ORIENT_ERRBOUND = (3.0 + 16.0 * ORIENT_EPSILON) * ORIENT_EPSILON;
+
+/**
+ * @brief a + b = sum + err точно (|err| <= ulp(sum) / 2)
+ */
+constexpr void twoSum(double a, double b, double& sum, double& err) {
+    sum = a + b;
+    double bv = sum - a;
+    double av = sum - bv;
+    err = (a - av) + (b - bv);
+}
+
+/**
+ * @brief a * b = product + err точно
+ *
+ * С аппаратным FMA ошибка - fma(a, b, -product). Без него - разбиение
+ * Деккера на половины по 26 бит, произведения которых точны.
+ */
+constexpr void twoProduct(double a, double b, double& product, double& err) {
+    product = a * b;
+#if defined(__FP_FAST_FMA) && (defined(__GNUC__) || defined(__clang__))
+    err = __builtin_fma(a, b, -product);
+#else
+    const double splitter = 134217729.0;   // 2^27 + 1
+    double ca = splitter * a;
+    double aHi = ca - (ca - a);
+    double aLo = a - aHi;
+    double cb = splitter * b;
+    double bHi = cb - (cb - b);
+    double bLo = b - bHi;
+    err = aLo * bLo - (((product - aHi * bHi) - aLo * bHi) - aHi * bLo);
+#endif
+}
+
+/**
+ * @brief Добавляет b к расширению e из n компонент (по возрастанию
+ *        модуля, без нулей)
+ * @return Новое число компонент (не больше n + 1)
+ *
+ * Сумма компонент равна сумме до добавления плюс b точно; знак
+ * расширения - знак последней (старшей) компоненты.
+ */
+constexpr int growExpansion(double* e, int n, double b) {
+    double q = b;
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        double sum = 0, err = 0;
+        twoSum(q, e[i], sum, err);
+        if (err != 0) e[m++] = err;
+        q = sum;
+    }
+    if (q != 0) e[m++] = q;
+    return m;
+}
+
+/**
+ * @brief Знак суммы произведений sum(a[i] * b[i]) по n парам (n <= 6), точно
+ */
+constexpr int exactDotSign(const double* a, const double* b, int n) {
+    double e[12] = {};
+    int size = 0;
+    for (int i = 0; i < n; i++) {
+        double product = 0, err = 0;
+        twoProduct(a[i], b[i], product, err);
+        size = growExpansion(e, size, err);
+        size = growExpansion(e, size, product);
+    }
+    if (size == 0) return 0;
+    return e[size - 1] > 0 ? 1 : -1;
+}
+
+/**
+ * @brief Счетчик обращений к точным ступеням (для бенчмарков и тестов)
+ *
+ * Увеличивается только вне вычислений при компиляции; атомарный
+ * (relaxed), поэтому безопасен из нескольких потоков.
+ */
+void noteOrientationFallback();
+
+/**
+ * @brief Сколько раз фильтр не решил знак с начала программы
+ *        (или с resetOrientationFallbacks())
+ */
+long long orientationFallbacks();
+
+void resetOrientationFallbacks();
+
+// ===================================================================
+// ПРЕДИКАТЫ
+// ===================================================================
+
+/**
+ * @brief Точный знак (a - o) x (b - o) без фильтра (ступени 2 и 3)
+ *
+ * Не встраивается: редкая ветка не должна раздувать циклы, в которых
+ * вызывается фильтр (иначе они перестают разворачиваться).
+ */
+ORIENT_NOINLINE constexpr int orientationExact(const Point& o, const Point& a, const Point& b) {
+    double ax = 0, axErr = 0, ay = 0, ayErr = 0, bx = 0, bxErr = 0, by = 0, byErr = 0;
+    twoSum(a.x, -o.x, ax, axErr);
+    twoSum(a.y, -o.y, ay, ayErr);
+    twoSum(b.x, -o.x, bx, bxErr);
+    twoSum(b.y, -o.y, by, byErr);
+    if (axErr == 0 && ayErr == 0 && bxErr == 0 && byErr == 0) {
+        double l[2] = {ax, -ay};
+        double r[2] = {by, bx};
+        return exactDotSign(l, r, 2);
+    }
+
+    // ax*by - ax*oy - ox*by - ay*bx + ay*ox + oy*bx
+    double l[6] = {a.x, -a.x, -o.x, -a.y, a.y, o.y};
+    double r[6] = {b.y, o.y, b.y, b.x, o.x, b.x};
+    return exactDotSign(l, r, 6);
+}
+
+/**
+ * @brief Ориентация тройки o, a, b по готовым разностям
+ * @param da a - o, посчитанная в double
+ * @param db b - o, посчитанная в double
+ *
+ * Для циклов, где разности с одной точкой o нужны многократно
+ * (orderCounterClockwise()): фильтр работает с ними же, исходные
+ * точки нужны только точным ступеням.
+ */
+constexpr int orientationOf(const Point& o, const Point& a, const Point& b, const Point& da, const Point& db) {
+    double left = da.x * db.y;
+    double right = da.y * db.x;
+    double det = left - right;
+    // Произведения разного знака или одно из них ноль: |det| > bound, знак верен сразу
+    double bound = ORIENT_ERRBOUND * (ORIENT_FABS(left) + ORIENT_FABS(right));
+    if (ORIENT_LIKELY(ORIENT_FABS(det) > bound)) return det > 0 ? 1 : -1;
+    if (bound == 0) return 0;   // оба произведения - точный ноль
+
+    if (!ORIENT_IS_CONSTANT_EVALUATED()) noteOrientationFallback();
+    return orientationExact(o, a, b);
+}
+
+/**
+ * @brief Ориентация тройки o, a, b
+ * @return 1 - поворот против часовой стрелки, -1 - по часовой,
+ *         0 - точки коллинеарны (точно)
+ *
+ * Фильтр (orient2d Shewchuk): знак det = left - right в double верен
+ * при |det| > ORIENT_ERRBOUND * (|left| + |right|).
+ */
+constexpr int orientation(const Point& o, const Point& a, const Point& b) {
+    return orientationOf(o, a, b, Point(a.x - o.x, a.y - o.y), Point(b.x - o.x, b.y - o.y));
+}
+
+/**
+ * @brief Направление на a раньше направления на b при обходе вокруг c
+ *        против часовой стрелки (da = a - c, db = b - c в double)
+ *
+ * Порядок тот же, что у atan2(a.y - c.y, a.x - c.x) по возрастанию (от -pi
+ * до pi): сначала нижняя полуплоскость, затем верхняя; внутри -
+ * по точной ориентации orientationOf(). Знак и равенство нулю разности
+ * double точны, поэтому полуплоскости сравниваются по da и db.
+ * Направление a == c считается углом 0.
+ */
+constexpr bool angleBeforeAround(const Point& c, const Point& a, const Point& b, const Point& da, const Point& db) {
+    bool lowerA = da.y < 0;
+    bool lowerB = db.y < 0;
+    if (lowerA != lowerB) return lowerA;
+
+    int turn = orientationOf(c, a, b, da, db);
+    if (turn != 0) return turn > 0;
+
+    // Коллинеарны: различаются только углы 0 и pi (верхняя полуплоскость)
+    bool zeroA = da.y == 0 && da.x >= 0;
+    bool zeroB = db.y == 0 && db.x >= 0;
+    return zeroA && !zeroB;
+}
+
+constexpr bool angleBeforeAround(const Point& c, const Point& a, const Point& b) {
+    return angleBeforeAround(c, a, b, Point(a.x - c.x, a.y - c.y), Point(b.x - c.x, b.y - c.y));
+}
+
+/**
+ * @brief Строго выпуклый многоугольник с обходом против часовой стрелки
+ *
+ * Каждая тройка соседних вершин - точный левый поворот, и контур
+ * обходит центр ровно один раз (нет самопересечений "звездой").
+ * Проверка порядка вершин после orderCounterClockwise().
+ */
+constexpr bool isConvexCounterClockwise(const Point* p, int n) {
+    if (n < 3) return false;
+    int lowerToUpper = 0;
+    for (int i = 0; i < n; i++) {
+        const Point& a = p[i];
+        const Point& b = p[(i + 1) % n];
+        if (orientation(a, b, p[(i + 2) % n]) <= 0) return false;
+        // Переходы по y вверх: у выпуклого контура ровно один "минимум"
+        bool down = b.y < a.y || (b.y == a.y && b.x < a.x);
+        bool nextUp = p[(i + 2) % n].y > b.y || (p[(i + 2) % n].y == b.y && p[(i + 2) % n].x > b.x);
+        lowerToUpper += down && nextUp;
+    }
+    return lowerToUpper == 1;
+}
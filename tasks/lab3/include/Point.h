@@ -30,6 +30,9 @@ struct Point {
      * 
      * Список инициализации : x(x), y(y) инициализирует поля напрямую,
      * это эффективнее чем присваивание в теле конструктора.
+     * 
+     * constexpr позволяет создавать точки во время компиляции
+     * (см. FigureKernels.h).
      */
-    Point(double x = 0, double y = 0) : x(x), y(y) {}
+    constexpr Point(double x = 0, double y = 0) : x(x), y(y) {}
 };
\ No newline at end of file
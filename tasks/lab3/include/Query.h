@@ -0,0 +1,217 @@
+#pragma once
+#include "Array.h"
+#include "Classifier.h"
+#include "ThreadPool.h"
+
+/**
+ * @file Query.h
+ * @brief Ленивые составные запросы к коллекциям: filter / map / reduce
+ *        за один проход, последовательно или на пуле потоков
+ */
+
+/**
+ * @brief Минимальный кусок параллельного прохода запроса
+ *        (шаг запроса стоит несколько наносекунд на фигуру)
+ */
+const int QUERY_MIN_GRAIN = 4096;
+
+// ===================================================================
+// ШАГИ
+// ===================================================================
+
+/*
+  Шаг запроса - функтор step(fig, sink): вызывает sink(value) для
+  каждого значения, которое фигура дает на выходе шага (ноль или одно).
+  filter и map оборачивают предыдущий шаг, так что весь запрос - одна
+  вложенная функция без промежуточных коллекций; компилятор
+  встраивает ее в цикл прохода.
+*/
+
+struct QuerySource {
+    template <typename Sink>
+    void operator()(const Figure& fig, Sink& sink) const { sink(fig); }
+};
+
+template <typename Prev, typename Pred>
+struct QueryFilter {
+    Prev prev;
+    Pred pred;
+
+    template <typename Sink>
+    void operator()(const Figure& fig, Sink& sink) const {
+        auto next = [this, &sink](const auto& value) {
+            if (pred(value)) sink(value);
+        };
+        prev(fig, next);
+    }
+};
+
+template <typename Prev, typename Fn>
+struct QueryMap {
+    Prev prev;
+    Fn fn;
+
+    template <typename Sink>
+    void operator()(const Figure& fig, Sink& sink) const {
+        auto next = [this, &sink](const auto& value) { sink(fn(value)); };
+        prev(fig, next);
+    }
+};
+
+// ===================================================================
+// ЗАПРОС
+// ===================================================================
+
+/**
+ * @class Query
+ * @brief Описание запроса к коллекции; выполняется только терминальной
+ *        операцией (reduce, sum, count, forEach)
+ *
+ * Source - коллекция с size() и get(i) -> Figure* (Array и др.).
+ * Запрос хранит указатель на коллекцию: она должна жить и не меняться,
+ * пока запрос выполняется.
+ *
+ * СЛИЯНИЕ: "площадь квадратов с центром в области" цепочкой отдельных
+ * операций - это проход с отбором по типу во временный массив, проход
+ * с отбором по центру, проход с площадями. Здесь filter и map только
+ * строят тип шага, а терминальная операция делает один проход:
+ * для каждой фигуры шаги выполняются подряд, пока фильтр не отбросит ее.
+ *
+ * ПАРАЛЛЕЛЬНО: parallel() выполняет тот же проход кусками на пуле
+ * (ThreadPool::parallelReduce) - частичные результаты кусков сливаются
+ * по порядку, поэтому сумма double одинакова от запуска к запуску.
+ * Функторы шагов вызываются из разных потоков одновременно и не должны
+ * менять общее состояние.
+ *
+ * @code
+ * double area = query(figures)
+ *     .filter(ofKind(FigureKind::Square))
+ *     .filter(centerIn(BoundingBox(0, 0, 10, 10)))
+ *     .map([](const Figure& fig) { return fig.area(); })
+ *     .parallel()
+ *     .sum();
+ * @endcode
+ */
+template <typename Source, typename Step>
+class Query {
+private:
+    const Source* source;
+    Step step;
+    ThreadPool* pool;
+    bool parallelRun;
+
+public:
+    Query(const Source* source, Step step, ThreadPool* pool = nullptr, bool parallelRun = false)
+        : source(source), step(step), pool(pool), parallelRun(parallelRun) {}
+
+    /**
+     * @brief Оставляет значения, для которых pred(value) == true
+     */
+    template <typename Pred>
+    Query<Source, QueryFilter<Step, Pred>> filter(Pred pred) const {
+        return Query<Source, QueryFilter<Step, Pred>>(source, QueryFilter<Step, Pred>{step, pred},
+                                                      pool, parallelRun);
+    }
+
+    /**
+     * @brief Заменяет значение на fn(value)
+     */
+    template <typename Fn>
+    Query<Source, QueryMap<Step, Fn>> map(Fn fn) const {
+        return Query<Source, QueryMap<Step, Fn>>(source, QueryMap<Step, Fn>{step, fn}, pool, parallelRun);
+    }
+
+    /**
+     * @brief Выполнять терминальные операции на пуле
+     * @param workers Пул (nullptr - ThreadPool::shared())
+     */
+    Query parallel(ThreadPool* workers = nullptr) const {
+        return Query(source, step, workers, true);
+    }
+
+    /**
+     * @brief Свертка результатов запроса
+     * @param identity Начальное значение свертки каждого куска
+     * @param fold fold(T, value) -> T
+     * @param merge merge(T, T) -> T: слияние кусков (parallel)
+     */
+    template <typename T, typename Fold, typename Merge>
+    T reduce(T identity, Fold fold, Merge merge) const {
+        auto pass = [this, &identity, &fold](int begin, int end) {
+            T acc = identity;
+            auto sink = [&acc, &fold](const auto& value) { acc = fold(acc, value); };
+            for (int i = begin; i < end; i++) step(*source->get(i), sink);
+            return acc;
+        };
+        if (!parallelRun) return pass(0, source->size());
+        ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+        return workers.parallelReduce(0, source->size(), identity, pass, merge, QUERY_MIN_GRAIN);
+    }
+
+    /**
+     * @brief Сумма значений (после map в число)
+     */
+    template <typename T = double>
+    T sum() const {
+        auto add = [](T a, T b) { return a + b; };
+        return reduce(T(0), add, add);
+    }
+
+    /**
+     * @brief Количество значений на выходе запроса
+     */
+    int count() const {
+        return reduce(0, [](int n, const auto&) { return n + 1; }, [](int a, int b) { return a + b; });
+    }
+
+    /**
+     * @brief Вызывает fn(value) для каждого значения по порядку фигур
+     *        (всегда в вызывающем потоке)
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (int i = 0; i < source->size(); i++) step(*source->get(i), fn);
+    }
+};
+
+/**
+ * @brief Начинает запрос к коллекции: значения - фигуры (const Figure&)
+ */
+template <typename Source>
+Query<Source, QuerySource> query(const Source& source) {
+    return Query<Source, QuerySource>(&source, QuerySource());
+}
+
+// ===================================================================
+// ГОТОВЫЕ ПРЕДИКАТЫ
+// ===================================================================
+
+struct KindPredicate {
+    FigureKind kind;
+    bool operator()(const Figure& fig) const { return figureKind(fig) == kind; }
+};
+
+struct CenterPredicate {
+    BoundingBox box;
+    bool operator()(const Figure& fig) const { return box.contains(fig.center()); }
+};
+
+struct BoundsPredicate {
+    BoundingBox box;
+    bool operator()(const Figure& fig) const { return box.intersects(fig.bounds()); }
+};
+
+/**
+ * @brief Фигура заданного типа
+ */
+inline KindPredicate ofKind(FigureKind kind) { return KindPredicate{kind}; }
+
+/**
+ * @brief Центр фигуры внутри прямоугольника (включая границу)
+ */
+inline CenterPredicate centerIn(const BoundingBox& box) { return CenterPredicate{box}; }
+
+/**
+ * @brief AABB фигуры пересекает прямоугольник
+ */
+inline BoundsPredicate boundsIntersect(const BoundingBox& box) { return BoundsPredicate{box}; }
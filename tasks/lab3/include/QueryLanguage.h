@@ -0,0 +1,147 @@
+#pragma once
+#include "Array.h"
+#include "BoundingBox.h"
+#include "FigureIndex.h"
+#include "ThreadPool.h"
+#include <ostream>
+#include <string>
+
+/**
+ * @file QueryLanguage.h
+ * @brief Язык запросов lab03: SELECT ... WHERE ..., компиляция в план
+ *        с выбором пути доступа (индекс или параллельный просмотр)
+ */
+
+/**
+ * @brief Агрегат в списке SELECT
+ */
+enum class QueryAggregate : unsigned char {
+    Count,    ///< COUNT
+    Sum,      ///< SUM(area)
+    Avg,      ///< AVG(area)
+    Min,      ///< MIN(area)
+    Max       ///< MAX(area)
+};
+
+/**
+ * @brief Как план перебирает фигуры
+ */
+enum class QueryAccess : unsigned char {
+    Empty,          ///< Условия противоречат друг другу - перебора нет
+    Scan,           ///< Просмотр всей коллекции в вызывающем потоке
+    ParallelScan,   ///< Просмотр кусками на пуле потоков
+    IndexBox,       ///< Кандидаты FigureIndex::forEachCandidate по области
+    IndexPoint      ///< Кандидаты по точке CONTAINS, проверка FigureIndex::contains
+};
+
+const int QUERY_MAX_AGGREGATES = 8;
+
+/**
+ * @brief Коллекция, начиная с которой выбирается ParallelScan
+ */
+const int QUERY_PARALLEL_MIN = 16384;
+
+/**
+ * @brief Скомпилированный запрос
+ *
+ * Все условия WHERE (только AND) сводятся к фиксированному набору
+ * проверок, которые выполняются по порядку от дешевых к дорогим:
+ * тип (маска), AABB пересекает область, центр в области, интервал
+ * площади, точка внутри фигуры. Несколько условий одного вида
+ * сливаются при компиляции: type=A AND type=B - пустая маска,
+ * area>1 AND area>4 - интервал (4, inf), два IN box - пересечение
+ * областей. Дерево выражения на фигуре не обходится.
+ */
+struct QueryPlan {
+    QueryAggregate aggregates[QUERY_MAX_AGGREGATES];
+    int aggregateCount = 0;
+    bool explain = false;       ///< EXPLAIN SELECT ...: показать план, не выполнять
+
+    int kindMask = 7;           ///< Бит (1 << (int)FigureKind) - тип допустим
+    double areaMin = -1;        ///< Нижняя граница площади
+    bool areaMinStrict = true;
+    double areaMax = 1e308;     ///< Верхняя граница площади
+    bool areaMaxStrict = false;
+
+    bool hasCenterBox = false;  ///< center IN box(...)
+    BoundingBox centerBox;
+    bool hasBoundsBox = false;  ///< bounds INTERSECTS box(...)
+    BoundingBox boundsBox;
+    bool hasPoint = false;      ///< CONTAINS point(...)
+    Point point;
+
+    bool empty = false;         ///< Противоречие найдено при компиляции
+
+    /**
+     * @brief Может ли индекс сузить перебор (есть область или точка)
+     */
+    bool wantsIndex() const { return !empty && (hasPoint || hasCenterBox || hasBoundsBox); }
+
+    /**
+     * @brief Путь доступа для коллекции из n фигур
+     * @param index Индекс этой коллекции (nullptr - нет)
+     *
+     * Область выбирается по стоимости: если кандидатов индекса
+     * (FigureIndex::cellEntriesIn) больше n, просмотр дешевле.
+     */
+    QueryAccess access(int n, const FigureIndex* index) const;
+
+    /**
+     * @brief Выводит путь доступа и проверки, оставшиеся на фигуру
+     */
+    void describe(std::ostream& os, int n, const FigureIndex* index) const;
+};
+
+/**
+ * @brief Результат: все агрегаты считаются за один проход
+ */
+struct QueryResult {
+    int count = 0;
+    double sum = 0;
+    double min = 0;      ///< При count > 0
+    double max = 0;      ///< При count > 0
+    QueryAccess access = QueryAccess::Scan;
+
+    /**
+     * @brief Значение агрегата (AVG, MIN, MAX пустой выборки - 0)
+     */
+    double value(QueryAggregate aggregate) const;
+
+    /**
+     * @brief Выводит агрегаты в порядке SELECT: "COUNT = 3, SUM(area) = 12"
+     */
+    void print(std::ostream& os, const QueryPlan& plan) const;
+};
+
+/**
+ * @brief Компилирует текст запроса
+ * @param text Например, "SELECT COUNT, SUM(area) WHERE type=Square
+ *        AND area>4 AND center IN box(0, 0, 10, 10)"
+ * @param plan Результат компиляции
+ * @param error Сообщение об ошибке (может быть nullptr)
+ * @return false при синтаксической ошибке
+ *
+ * ГРАММАТИКА (ключевые слова без учета регистра):
+ *   [EXPLAIN] SELECT агрегат {, агрегат} [WHERE условие {AND условие}]
+ *   агрегат: COUNT | SUM(area) | AVG(area) | MIN(area) | MAX(area)
+ *   условие: type (= | !=) Square | Rectangle | Trapezoid
+ *          | area (< | <= | > | >= | =) число
+ *          | center IN box(x1, y1, x2, y2)
+ *          | bounds INTERSECTS box(x1, y1, x2, y2)
+ *          | CONTAINS point(x, y)
+ */
+bool compileQuery(const char* text, QueryPlan& plan, std::string* error = nullptr);
+
+/**
+ * @brief Выполняет план над коллекцией
+ * @param index Индекс этой коллекции (nullptr - только просмотр)
+ * @param pool Пул для ParallelScan (nullptr - ThreadPool::shared())
+ *
+ * Индекс должен быть построен по текущему содержимому figures.
+ * Области box(...) и точка запроса сужают перебор до кандидатов
+ * индекса; без них (или без индекса) коллекция просматривается
+ * целиком, большая - параллельно (ThreadPool::parallelReduce,
+ * частичные результаты сливаются по порядку).
+ */
+QueryResult runQuery(const QueryPlan& plan, const Array& figures, const FigureIndex* index = nullptr,
+                     ThreadPool* pool = nullptr);
@@ -15,8 +15,10 @@
  * - 4 прямых угла (90°)
  * - НЕ все стороны равны (иначе это квадрат)
  */
-class Rectangle : public Figure {
+class Rectangle : public FigureAdapter<Rectangle> {
 public:
+    static constexpr const char* TYPE_NAME = "Rectangle";
+    
     /**
      * @brief Конструктор по умолчанию
      * 
@@ -39,9 +41,6 @@ public:
     Rectangle& operator=(Rectangle&& other) noexcept;
     
     // Виртуальные методы
-    Point center() const override;
-    double area() const override;
     void print(std::ostream& os) const override;
     void read(std::istream& is) override;
-    const char* getType() const override { return "Rectangle"; }
 };
\ No newline at end of file
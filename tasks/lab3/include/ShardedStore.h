@@ -0,0 +1,154 @@
+#pragma once
+#include "Array.h"
+#include "SmallArray.h"
+#include <atomic>
+#include <mutex>
+
+class ThreadPool;
+
+/**
+ * @file ShardedStore.h
+ * @brief Хранилище фигур, разделенное на независимые шарды
+ */
+
+/**
+ * @brief Идентификатор фигуры в ShardedStore (не меняется при удалении других)
+ */
+typedef long long FigureHandle;
+
+/**
+ * @class ShardedStore
+ * @brief Владеющее хранилище фигур из N шардов, у каждого свой мьютекс
+ *        и свой Array
+ *
+ * Один мьютекс вокруг Array превращает все изменения в очередь.
+ * Здесь фигура попадает в шард по хешу своего идентификатора,
+ * и потоки, работающие с разными шардами, не мешают друг другу:
+ * при равномерном хеше конфликтует лишь 1/N операций.
+ *
+ * УСТРОЙСТВО:
+ * - push() выдает следующий идентификатор (атомарный счетчик),
+ *   шард - хеш идентификатора; блокируется только этот шард;
+ * - remove(handle) находит шард по тому же хешу и ищет фигуру
+ *   внутри шарда (O(n / N));
+ * - шарды выровнены по кэш-линии, чтобы мьютексы соседних шардов
+ *   не попадали в одну линию (false sharing).
+ *
+ * ОПЕРАЦИИ НАД ВСЕЙ КОЛЛЕКЦИЕЙ (totalArea, removeDuplicates)
+ * выполняются параллельно по шардам задачами ThreadPool, результаты
+ * объединяются. totalArea() блокирует шарды
+ * по одному, поэтому не является атомарным снимком всей коллекции;
+ * removeDuplicates() блокирует все шарды сразу.
+ *
+ * @code
+ * ShardedStore store;               // 16 шардов
+ * FigureHandle h = store.push(new Square(p));   // из любого потока
+ * store.remove(h);
+ * double area = store.totalArea();
+ * @endcode
+ */
+class ShardedStore {
+private:
+    /**
+     * @brief Шард: фигуры и их идентификаторы (handles[i] - для figures.get(i))
+     */
+    struct alignas(64) Shard {
+        mutable std::mutex lock;
+        Array figures;
+        SmallArray<FigureHandle, 0> handles;
+    };
+
+    Shard* shards;
+    int shardCount;
+    std::atomic<FigureHandle> nextHandle;
+
+    int shardOf(FigureHandle handle) const;
+
+public:
+    /**
+     * @brief Создает пустое хранилище
+     * @param shardCount Количество шардов (не меньше 1)
+     */
+    explicit ShardedStore(int shardCount = 16);
+    ~ShardedStore();
+
+    ShardedStore(const ShardedStore&) = delete;
+    ShardedStore& operator=(const ShardedStore&) = delete;
+
+    int getShardCount() const { return shardCount; }
+
+    /**
+     * @brief Добавляет фигуру (хранилище берет владение)
+     * @return Идентификатор фигуры или -1 для nullptr
+     */
+    FigureHandle push(Figure* fig);
+
+    /**
+     * @brief Удаляет фигуру по идентификатору
+     * @return true, если фигура была в хранилище
+     */
+    bool remove(FigureHandle handle);
+
+    /**
+     * @brief Есть ли фигура с таким идентификатором
+     */
+    bool contains(FigureHandle handle) const;
+
+    /**
+     * @brief Количество фигур (сумма по шардам)
+     */
+    int size() const;
+
+    /**
+     * @brief Количество фигур в одном шарде (для проверки распределения)
+     */
+    int shardSize(int shard) const;
+
+    /**
+     * @brief Вызывает fn(FigureHandle, const Figure&) для всех фигур
+     *
+     * Шарды обходятся по очереди, каждый - под своим мьютексом;
+     * fn не должна обращаться к хранилищу.
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const;
+
+    /**
+     * @brief Суммарная площадь, параллельно по шардам
+     * @param pool Пул потоков (nullptr - ThreadPool::shared())
+     */
+    double totalArea(ThreadPool* pool = nullptr) const;
+
+    /**
+     * @brief Удаляет фигуры, равные (operator==) ранее добавленным
+     * @param pool Пул потоков (nullptr - ThreadPool::shared())
+     * @return Сколько фигур удалено
+     *
+     * Равные фигуры могут лежать в разных шардах. Шарды параллельно
+     * выписывают свои фигуры, упорядоченные по левой границе AABB;
+     * списки сливаются и делятся на участки там, где левые границы
+     * расходятся больше чем на точность сравнения. Участки проверяются
+     * параллельно; внутри участка равные фигуры ищутся среди соседей
+     * по нижней границе AABB.
+     * Из каждой группы равных остается фигура с меньшим идентификатором.
+     */
+    int removeDuplicates(ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Отчет о памяти: шарды, их буферы и фигуры
+     */
+    MemoryReport memoryReport() const;
+};
+
+// ===================================================================
+// РЕАЛИЗАЦИЯ ШАБЛОНА
+// ===================================================================
+
+template <typename Fn>
+void ShardedStore::forEach(Fn fn) const {
+    for (int s = 0; s < shardCount; s++) {
+        Shard& shard = shards[s];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        for (int i = 0; i < shard.figures.size(); i++) fn(shard.handles[i], *shard.figures.get(i));
+    }
+}
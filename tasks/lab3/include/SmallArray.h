@@ -0,0 +1,144 @@
+#pragma once
+#include "MemoryTracking.h"
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @file SmallArray.h
+ * @brief Шаблонный динамический массив со встроенным буфером
+ */
+
+/**
+ * @class SmallArray
+ * @brief Динамический массив элементов T с первыми InlineCapacity
+ *        элементами внутри самого объекта
+ *
+ * То же устройство, что у Array (счетчик, вместимость, удвоение при
+ * заполнении), но для любого тривиально копируемого типа: указатели,
+ * индексы, Point, небольшие структуры результатов.
+ *
+ * ОПТИМИЗАЦИЯ МАЛЕНЬКОГО БУФЕРА (small-buffer optimization):
+ * пока элементов не больше InlineCapacity, они лежат в поле inlineData
+ * и память в куче не выделяется вовсе. При переполнении элементы
+ * переезжают в буфер в куче, дальше он растет удвоением.
+ *
+ * Буфер в куче выделяется через trackedAllocate() - его видит
+ * перехватчик выделений (MemoryTracking.h).
+ *
+ * ОГРАНИЧЕНИЯ:
+ * - T должен быть тривиально копируемым: элементы переносятся memcpy,
+ *   деструкторы элементов не вызываются;
+ * - копирование и перемещение запрещены (как у Array): data может
+ *   указывать внутрь самого объекта.
+ *
+ * @code
+ * SmallArray<int, 8> ids;      // до 8 элементов - без выделений
+ * ids.push(3);
+ * ids.push(5);
+ * for (int i = 0; i < ids.size(); i++) use(ids[i]);
+ * @endcode
+ */
+template <typename T, int InlineCapacity = 4>
+class SmallArray {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SmallArray stores trivially copyable elements only");
+    static_assert(InlineCapacity >= 0, "InlineCapacity must be non-negative");
+
+private:
+    T* data;
+    int count;
+    int capacity;
+
+    // При InlineCapacity = 0 массив нулевой длины недопустим - один
+    // неиспользуемый элемент
+    T inlineData[InlineCapacity > 0 ? InlineCapacity : 1];
+
+    bool onHeap() const { return data != inlineData; }
+
+public:
+    SmallArray() : data(inlineData), count(0), capacity(InlineCapacity) {}
+
+    ~SmallArray() {
+        if (onHeap()) trackedFree(data, (std::size_t)capacity * sizeof(T));
+    }
+
+    SmallArray(const SmallArray&) = delete;
+    SmallArray& operator=(const SmallArray&) = delete;
+    SmallArray(SmallArray&&) = delete;
+    SmallArray& operator=(SmallArray&&) = delete;
+
+    /**
+     * @brief Гарантирует вместимость не меньше minCapacity
+     *
+     * Если места уже хватает - ничего не делает. Иначе переносит
+     * элементы в новый буфер в куче ровно на minCapacity элементов.
+     *
+     * СЛОЖНОСТЬ: O(n) при переносе
+     */
+    void reserve(int minCapacity) {
+        if (minCapacity <= capacity) return;
+        T* grown = static_cast<T*>(trackedAllocate((std::size_t)minCapacity * sizeof(T)));
+        if (count > 0) std::memcpy(grown, data, (std::size_t)count * sizeof(T));
+        if (onHeap()) trackedFree(data, (std::size_t)capacity * sizeof(T));
+        data = grown;
+        capacity = minCapacity;
+    }
+
+    /**
+     * @brief Добавляет элемент в конец
+     *
+     * При заполнении вместимость удваивается (с 0 - сразу до 4).
+     * СЛОЖНОСТЬ: амортизированная O(1)
+     */
+    void push(const T& value) {
+        if (count >= capacity) reserve(capacity > 0 ? capacity * 2 : 4);
+        data[count++] = value;
+    }
+
+    /**
+     * @brief Удаляет элемент по индексу со сдвигом хвоста влево
+     *
+     * Некорректный индекс игнорируется (как в Array::remove()).
+     * СЛОЖНОСТЬ: O(n - index)
+     */
+    void remove(int index) {
+        if (index < 0 || index >= count) return;
+        std::memmove(data + index, data + index + 1, (std::size_t)(count - index - 1) * sizeof(T));
+        count--;
+    }
+
+    /**
+     * @brief Удаляет все элементы (вместимость и буфер сохраняются)
+     */
+    void clear() { count = 0; }
+
+    int size() const { return count; }
+
+    /**
+     * @brief Текущая вместимость (InlineCapacity, пока буфер встроенный)
+     */
+    int getCapacity() const { return capacity; }
+
+    /**
+     * @brief true, если элементы лежат во встроенном буфере
+     */
+    bool isInline() const { return !onHeap(); }
+
+    /**
+     * @brief Байт в куче под буфер (0 для встроенного)
+     */
+    std::size_t heapBytes() const { return onHeap() ? (std::size_t)capacity * sizeof(T) : 0; }
+
+    /**
+     * @brief Начало буфера в куче (nullptr для встроенного)
+     */
+    const void* heapBlock() const { return onHeap() ? data : nullptr; }
+
+    T& operator[](int index) { return data[index]; }
+    const T& operator[](int index) const { return data[index]; }
+
+    T* begin() { return data; }
+    T* end() { return data + count; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + count; }
+};
@@ -0,0 +1,196 @@
+#pragma once
+#include "Figure.h"
+#include "MemoryTracking.h"
+#include "SmallArray.h"
+#include <atomic>
+#include <mutex>
+
+/**
+ * @file SnapshotArray.h
+ * @brief Коллекция фигур с неблокирующими читателями (RCU с эпохами)
+ */
+
+/**
+ * @brief Сколько читателей могут одновременно держать снимки
+ *
+ * Следующий читатель ждет (уступая процессор), пока не освободится слот.
+ */
+const int SNAPSHOT_READERS = 64;
+
+/**
+ * @brief Неизменяемая версия коллекции: count первых указателей буфера
+ *
+ * Буфер общий для нескольких версий: push() дописывает в свободную
+ * часть буфера за count, которую старые версии не читают.
+ */
+struct SnapshotVersion {
+    Figure** items;
+    int count;
+    int capacity;
+};
+
+class SnapshotArray;
+
+/**
+ * @class ArraySnapshot
+ * @brief Согласованный снимок SnapshotArray для чтения
+ *
+ * Пока снимок жив, его фигуры и буфер не освобождаются, даже если
+ * писатели уже удалили их из коллекции. Снимок не меняется:
+ * size() и get(i) дают одно и то же все время его жизни.
+ *
+ * Держать снимок долго нежелательно: удаленные фигуры копятся
+ * до его уничтожения.
+ */
+class ArraySnapshot {
+private:
+    const SnapshotArray* owner;
+    int slot;
+    const SnapshotVersion* version;
+
+    friend class SnapshotArray;
+    ArraySnapshot(const SnapshotArray* owner, int slot, const SnapshotVersion* version)
+        : owner(owner), slot(slot), version(version) {}
+
+public:
+    ~ArraySnapshot();
+
+    ArraySnapshot(const ArraySnapshot&) = delete;
+    ArraySnapshot& operator=(const ArraySnapshot&) = delete;
+
+    int size() const { return version->count; }
+
+    /**
+     * @brief Фигура по индексу или nullptr, если индекс неверный
+     */
+    const Figure* get(int index) const {
+        return index >= 0 && index < version->count ? version->items[index] : nullptr;
+    }
+
+    /**
+     * @brief Вызывает fn(const Figure&) для каждой фигуры снимка
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (int i = 0; i < version->count; i++) fn(*version->items[i]);
+    }
+
+    double totalArea() const;
+};
+
+/**
+ * @class SnapshotArray
+ * @brief Владеющая коллекция фигур: писатели меняют, читатели
+ *        работают со снимками без блокировок
+ *
+ * С Array единственный способ читать во время изменений - общий
+ * мьютекс, и долгий обход (площадь, вывод, запросы) блокирует запись.
+ *
+ * ПУБЛИКАЦИЯ (RCU - read-copy-update):
+ * - текущая версия (SnapshotVersion) - атомарный указатель;
+ * - писатель строит новую версию и подменяет указатель; старая
+ *   версия не меняется, читатели продолжают работать с ней;
+ * - push() в пределах вместимости копирует только заголовок версии,
+ *   remove() и рост буфера копируют массив указателей (O(n)).
+ * Писатели упорядочены мьютексом между собой; читатели его не берут.
+ *
+ * ОСВОБОЖДЕНИЕ ПО ЭПОХАМ (epoch-based reclamation):
+ * - глобальный счетчик эпох; читатель, открывая снимок, записывает
+ *   текущую эпоху в свободный слот таблицы читателей;
+ * - вытесненные версии, буферы и удаленные фигуры писатель кладет
+ *   в список отложенного освобождения с номером эпохи и сдвигает эпоху;
+ * - объект освобождается, когда все активные читатели открыли снимки
+ *   в более поздних эпохах - они уже не могут его видеть.
+ *
+ * @code
+ * SnapshotArray figures;
+ * figures.push(new Square(p));          // поток-писатель
+ * {
+ *     ArraySnapshot snap = figures.snapshot();   // поток-читатель
+ *     double area = snap.totalArea();            // без блокировок
+ * }
+ * @endcode
+ */
+class SnapshotArray {
+private:
+    /**
+     * @brief Объект, ожидающий освобождения
+     */
+    struct Retired {
+        void* block;             ///< Блок trackedAllocate() или nullptr
+        std::size_t bytes;       ///< Его размер
+        Figure* figure;          ///< Удаленная фигура или nullptr
+        unsigned long long epoch;
+    };
+
+    std::atomic<const SnapshotVersion*> current;
+    std::atomic<int> currentCount;   ///< count текущей версии: size() без снимка
+    std::atomic<unsigned long long> epoch;
+    mutable std::atomic<unsigned long long> readers[SNAPSHOT_READERS];
+
+    std::mutex writeLock;
+    SmallArray<Retired, 0> retired;  ///< Только под writeLock
+
+    friend class ArraySnapshot;
+
+    /**
+     * @brief Публикует новую версию, старую отправляет в retired
+     * @param oldBuffer true - буфер старой версии больше не используется
+     * @param removed Удаленная фигура или nullptr
+     */
+    void publish(SnapshotVersion* next, bool oldBuffer, Figure* removed);
+
+    /**
+     * @brief Освобождает объекты, которые не может видеть ни один читатель
+     */
+    void reclaimLocked();
+
+public:
+    SnapshotArray();
+    ~SnapshotArray();
+
+    SnapshotArray(const SnapshotArray&) = delete;
+    SnapshotArray& operator=(const SnapshotArray&) = delete;
+
+    /**
+     * @brief Добавляет фигуру (коллекция берет владение)
+     */
+    void push(Figure* fig);
+
+    /**
+     * @brief Удаляет фигуру по индексу
+     *
+     * Фигура освобождается, когда ее не видит ни один снимок.
+     * Некорректный индекс игнорируется.
+     */
+    void remove(int index);
+
+    /**
+     * @brief Количество фигур в текущей версии
+     *
+     * Читает отдельный атомарный счетчик, а не current->count: версия
+     * без занятого слота читателя может быть уже освобождена писателем.
+     */
+    int size() const;
+
+    /**
+     * @brief Открывает снимок текущей версии (без блокировок)
+     */
+    ArraySnapshot snapshot() const;
+
+    /**
+     * @brief Пытается освободить отложенные объекты
+     * @return Сколько объектов еще ждут освобождения
+     *
+     * Вызывается и автоматически при каждом изменении.
+     */
+    int reclaim();
+
+    /**
+     * @brief Отчет о памяти текущей версии и отложенных объектов
+     *
+     * Отложенные (удаленные, но не освобожденные) фигуры и буферы
+     * учитываются в allocations и bufferUnused.
+     */
+    MemoryReport memoryReport();
+};
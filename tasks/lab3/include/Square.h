@@ -15,11 +15,11 @@
  * - 4 прямыми углами (90°)
  * 
  * НАСЛЕДОВАНИЕ:
- * class Square : public Figure
+ * class Square : public FigureAdapter<Square>
  *        ^         ^       ^
  *        |         |       |
- *     имя класса  тип    базовый класс
- *                наслед.
+ *     имя класса  тип    базовый класс (Figure + общие
+ *                наслед.  center()/area(), см. Figure.h)
  * 
  * PUBLIC наследование означает:
  * - public методы Figure остаются public в Square
@@ -30,12 +30,17 @@
  * ПОЛИМОРФИЗМ В ДЕЙСТВИИ:
  * @code
  * Figure* fig = new Square();   // Указатель на базовый класс
- * fig->area();                  // Вызовется Square::area(), а не Figure::area()
- * fig->center();                // Вызовется Square::center()
+ * fig->area();                  // Вызовется реализация для Square, а не Figure::area()
+ * fig->center();                // Вызовется реализация для Square
  * @endcode
  */
-class Square : public Figure {
+class Square : public FigureAdapter<Square> {
 public:
+    /**
+     * @brief Название типа (getType())
+     */
+    static constexpr const char* TYPE_NAME = "Square";
+    
     // ===================================================================
     // КОНСТРУКТОРЫ
     // ===================================================================
@@ -113,22 +118,8 @@ public:
     // РЕАЛИЗАЦИЯ ВИРТУАЛЬНЫХ МЕТОДОВ
     // ===================================================================
     
-    /**
-     * @brief Вычисляет центр квадрата
-     * @return Точка - центр квадрата
-     * 
-     * Для квадрата центр = среднее арифметическое всех вершин.
-     */
-    Point center() const override;
-    
-    /**
-     * @brief Вычисляет площадь квадрата
-     * @return Площадь в квадратных единицах
-     * 
-     * Использует формулу Гаусса (Shoelace):
-     * S = 1/2 * |sum(xi * yi+1 - xi+1 * yi)|
-     */
-    double area() const override;
+    // center() и area() - общие для всех фигур, в FigureAdapter
+    // (формула Гаусса и среднее вершин, см. FigureKernels.h)
     
     /**
      * @brief Выводит информацию о квадрате
@@ -146,10 +137,4 @@ public:
      * Автоматически упорядочивает точки.
      */
     void read(std::istream& is) override;
-    
-    /**
-     * @brief Возвращает тип фигуры
-     * @return "Square"
-     */
-    const char* getType() const override { return "Square"; }
 };
\ No newline at end of file
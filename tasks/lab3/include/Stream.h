@@ -0,0 +1,108 @@
+#pragma once
+#include "Array.h"
+#include "BoundingBox.h"
+#include "Classifier.h"
+#include <cstdio>
+#include <ostream>
+
+/**
+ * @file Stream.h
+ * @brief Статистика по файлам фигур, не помещающимся в память:
+ *        чтение блоками фиксированного размера без Array
+ */
+
+/**
+ * @brief Формат файла
+ */
+enum class StreamFormat : unsigned char {
+    Text,   ///< Строки "Type x1 y1 ... x4 y4", как у ingestFigures()
+    Codec   ///< Кадры appendCodecFrame(): длина (4 байта) и код encodeFigures()
+};
+
+/**
+ * @brief Корзин гистограммы площадей
+ *
+ * Корзина b - площади из [2^(b - 32), 2^(b - 31)); меньшие площади
+ * (и нулевые) попадают в корзину 0, большие - в последнюю.
+ */
+const int STREAM_AREA_BINS = 64;
+
+/**
+ * @brief Параметры чтения
+ */
+struct StreamOptions {
+    /**
+     * @brief Размер блока чтения; в памяти два блока
+     */
+    int chunkBytes = 1 << 20;
+
+    /**
+     * @brief Читать следующий блок в отдельном потоке, пока обрабатывается
+     *        текущий (false - чтение и обработка по очереди, для сравнения)
+     */
+    bool doubleBuffer = true;
+};
+
+/**
+ * @brief Статистика коллекции и замеры чтения
+ */
+struct StreamStats {
+    long long figures = 0;
+    long long kinds[FIGURE_KIND_COUNT] = {0};   ///< Индекс - (int)FigureKind
+    long long malformed = 0;     ///< Text: непустые строки, которые не разобрались
+    double totalArea = 0;
+    BoundingBox bounds;          ///< Вершины всех фигур (при figures > 0)
+    long long histogram[STREAM_AREA_BINS] = {0};
+
+    long long bytes = 0;         ///< Прочитано байт
+    long long chunks = 0;        ///< Прочитано блоков
+    long long computeNs = 0;     ///< Разбор и подсчет
+    long long waitNs = 0;        ///< Ожидание очередного блока от чтения
+    long long wallNs = 0;
+
+    long long count(FigureKind kind) const { return kinds[(int)kind]; }
+
+    /**
+     * @brief Нижняя граница площадей корзины bin
+     */
+    static double binLowerBound(int bin);
+
+    /**
+     * @brief Выводит счетчики, границы, непустые корзины и замеры
+     */
+    void print(std::ostream& os) const;
+};
+
+/**
+ * @brief Считает статистику фигур файла за один проход
+ * @param path Путь к файлу
+ * @param format Формат файла
+ * @param stats Результат (перезаписывается)
+ * @param options Размер блока и режим чтения
+ * @return false, если файл не открывается, не читается
+ *         или кадр Codec поврежден/оборван
+ *
+ * Память постоянна: два блока по chunkBytes, перенос неполной строки
+ * (кадра) между блоками и буфер записей одного кадра - независимо
+ * от размера файла. Фигуры не создаются: площадь считается по
+ * вершинам, упорядоченным как в конструкторе (Quad).
+ *
+ * ДВОЙНАЯ БУФЕРИЗАЦИЯ: поток чтения заполняет свободный блок,
+ * пока вызывающий поток разбирает заполненный; блоки передаются
+ * через две BoundedQueue (заполненные и свободные). waitNs > 0
+ * значит, что обработка быстрее диска.
+ *
+ * Text: тип берется из строки (без классификации), пустые строки
+ * пропускаются, неразобранные считаются в malformed.
+ */
+bool streamStats(const char* path, StreamFormat format, StreamStats& stats,
+                 const StreamOptions& options = StreamOptions());
+
+/**
+ * @brief Дописывает коллекцию в файл одним кадром формата Codec
+ * @return false при ошибке записи
+ *
+ * Большой файл пишется кадрами по нескольку тысяч фигур: кадр
+ * декодируется целиком, и его размер определяет память streamStats().
+ */
+bool appendCodecFrame(std::FILE* file, const Array& figures);
@@ -0,0 +1,208 @@
+#pragma once
+#include "SmallArray.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/**
+ * @file ThreadPool.h
+ * @brief Пул потоков с перехватом задач (work stealing) для массовых операций
+ */
+
+/**
+ * @class ThreadPool
+ * @brief Постоянные потоки-исполнители и примитивы parallelFor / parallelReduce
+ *        над диапазонами индексов
+ *
+ * Раньше каждая параллельная операция (transformFigures, collectionHull, ...)
+ * запускала свои std::thread и ждала их: на коллекциях в тысячи фигур
+ * создание потоков сравнимо с самой работой, а куски фиксированного
+ * размера плохо делятся, если фигуры обрабатываются за разное время.
+ *
+ * УСТРОЙСТВО:
+ * - у каждого исполнителя своя очередь задач-диапазонов [begin, end);
+ * - исполнитель делит свой диапазон пополам, пока он больше зерна
+ *   (grain): правую половину кладет в конец своей очереди, левую
+ *   выполняет сам (рекурсивное деление);
+ * - свою очередь исполнитель разбирает с конца (последние, самые
+ *   мелкие и "горячие" в кэше куски), а простаивающий поток
+ *   перехватывает задачи с начала чужой очереди - самые крупные
+ *   неразобранные половины, так что одна кража дает много работы;
+ * - поток, вызвавший parallelFor(), тоже исполняет задачи, пока
+ *   операция не закончится; поэтому вложенные вызовы из задач
+ *   не приводят к взаимной блокировке.
+ *
+ * АДАПТИВНОЕ ЗЕРНО: n / (8 * потоков), но не меньше minGrain - порядка
+ * восьми кусков на поток хватает, чтобы выровнять нагрузку перехватом,
+ * а minGrain не дает дробить дешевую работу (например, 10 нс на фигуру)
+ * мельче накладных расходов на задачу.
+ *
+ * Задачи не должны бросать исключения.
+ *
+ * @code
+ * ThreadPool pool(4);                  // 4 потока, включая вызывающий
+ * pool.parallelFor(0, figures.size(), [&](int begin, int end) {
+ *     for (int i = begin; i < end; i++) figures.get(i)->transform(m);
+ * });
+ * double area = pool.parallelReduce(0, figures.size(), 0.0,
+ *     [&](int begin, int end) { ... return sum; },
+ *     [](double a, double b) { return a + b; });
+ * @endcode
+ */
+class ThreadPool {
+private:
+    /**
+     * @brief Одна операция parallelFor: функция и счетчик незавершенных задач
+     */
+    struct Job {
+        void (*invoke)(const void* fn, int begin, int end);
+        const void* fn;
+        int grain;
+        std::atomic<int> pending;
+    };
+
+    /**
+     * @brief Задача: диапазон индексов операции
+     */
+    struct RangeTask {
+        Job* job;
+        int begin;
+        int end;
+    };
+
+    /**
+     * @brief Очередь задач исполнителя; отдельная кэш-линия на очередь
+     */
+    struct alignas(64) TaskQueue {
+        std::mutex lock;
+        SmallArray<RangeTask, 16> tasks;
+    };
+
+    int threadCount;
+    int workerCount;
+    std::thread* workers;
+    TaskQueue* queues;   ///< workerCount очередей исполнителей + общая для внешних потоков
+
+    std::atomic<int> queued;     ///< Задач во всех очередях
+    std::atomic<int> sleeping;   ///< Исполнителей, ждущих работы
+    std::atomic<bool> stopping;
+    std::mutex sleepLock;
+    std::condition_variable wakeUp;
+
+    void workerLoop(int index);
+    int currentQueue() const;
+
+    void pushTask(int queue, const RangeTask& task);
+    bool popTask(int queue, RangeTask& task);
+    bool stealTask(int thief, RangeTask& task);
+    bool findTask(int queue, RangeTask& task);
+
+    /**
+     * @brief Выполняет задачу, по пути отдавая половины в очередь queue
+     */
+    void runTask(int queue, RangeTask task);
+
+    /**
+     * @brief Общая часть parallelFor(): fn уже приведена к invoke
+     */
+    void run(int begin, int end, int grain, void (*invoke)(const void*, int, int), const void* fn);
+
+public:
+    /**
+     * @brief Создает пул
+     * @param threadCount Сколько потоков выполняют задачи, включая
+     *        вызывающий (0 - по числу ядер; 1 - все выполняется
+     *        в вызывающем потоке, дополнительных потоков нет)
+     */
+    explicit ThreadPool(int threadCount = 0);
+
+    /**
+     * @brief Дожидается выхода исполнителей (операций в этот момент
+     *        быть не должно)
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Общий пул по числу ядер (создается при первом обращении)
+     *
+     * Его используют массовые операции, если пул не передан явно.
+     */
+    static ThreadPool& shared();
+
+    /**
+     * @brief Сколько потоков выполняют задачи, включая вызывающий
+     */
+    int getThreadCount() const { return threadCount; }
+
+    /**
+     * @brief Размер зерна для n индексов (см. описание класса)
+     */
+    int grainFor(int n, int minGrain) const;
+
+    /**
+     * @brief Вызывает fn(begin, end) для кусков [begin, end), покрывающих
+     *        диапазон; возвращается, когда все куски выполнены
+     * @param minGrain Минимальный размер куска
+     *
+     * Куски выполняются параллельно в произвольном порядке;
+     * fn вызывается из разных потоков одновременно.
+     */
+    template <typename Fn>
+    void parallelFor(int begin, int end, Fn fn, int minGrain = 1);
+
+    /**
+     * @brief Параллельная свертка диапазона
+     * @param identity Нейтральный элемент combine
+     * @param map map(begin, end) -> T для куска
+     * @param combine combine(T, T) -> T
+     * @param minGrain Минимальный размер куска
+     *
+     * Разбиение на куски зависит только от n и числа потоков,
+     * а результаты кусков сворачиваются по порядку: при тех же
+     * входных данных сумма double получается одной и той же
+     * от запуска к запуску.
+     */
+    template <typename T, typename Map, typename Combine>
+    T parallelReduce(int begin, int end, T identity, Map map, Combine combine, int minGrain = 1);
+};
+
+// ===================================================================
+// РЕАЛИЗАЦИЯ ШАБЛОНОВ
+// ===================================================================
+
+template <typename Fn>
+void ThreadPool::parallelFor(int begin, int end, Fn fn, int minGrain) {
+    if (end <= begin) return;
+    int grain = grainFor(end - begin, minGrain);
+    if (threadCount <= 1 || end - begin <= grain) {
+        fn(begin, end);
+        return;
+    }
+    run(begin, end, grain, [](const void* f, int b, int e) { (*static_cast<const Fn*>(f))(b, e); }, &fn);
+}
+
+template <typename T, typename Map, typename Combine>
+T ThreadPool::parallelReduce(int begin, int end, T identity, Map map, Combine combine, int minGrain) {
+    if (end <= begin) return identity;
+    int grain = grainFor(end - begin, minGrain);
+    int chunks = (end - begin + grain - 1) / grain;
+    if (chunks == 1) return combine(identity, map(begin, end));
+
+    T* partial = new T[chunks];
+    parallelFor(0, chunks, [&](int first, int last) {
+        for (int c = first; c < last; c++) {
+            int b = begin + c * grain;
+            int e = end - b > grain ? b + grain : end;
+            partial[c] = map(b, e);
+        }
+    });
+
+    T result = identity;
+    for (int c = 0; c < chunks; c++) result = combine(result, partial[c]);
+    delete[] partial;
+    return result;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "Point.h"
+
+class Array;
+class ThreadPool;
+
+/**
+ * @file Transform.h
+ * @brief Аффинные преобразования плоскости и их пакетное применение
+ */
+
+/**
+ * @brief Аффинное преобразование - матрица 2x3
+ *
+ * x' = a * x + b * y + tx
+ * y' = c * x + d * y + ty
+ *
+ * Определитель ad - bc показывает, что происходит с ориентацией:
+ * - > 0: сдвиг, поворот, масштаб - обход против часовой стрелки сохраняется;
+ * - < 0: отражение - обход меняется на противоположный;
+ * - = 0: вырождение (фигура сплющивается в отрезок или точку).
+ *
+ * @code
+ * AffineTransform m = AffineTransform::rotation(angle)
+ *                         .then(AffineTransform::translation(10, 0));
+ * transformFigures(figures, m);
+ * @endcode
+ */
+struct AffineTransform {
+    double a, b, tx;  ///< Первая строка матрицы
+    double c, d, ty;  ///< Вторая строка матрицы
+
+    /**
+     * @brief По умолчанию - тождественное преобразование
+     */
+    AffineTransform(double a = 1, double b = 0, double tx = 0,
+                    double c = 0, double d = 1, double ty = 0)
+        : a(a), b(b), tx(tx), c(c), d(d), ty(ty) {}
+
+    /**
+     * @brief Сдвиг на (dx, dy)
+     */
+    static AffineTransform translation(double dx, double dy);
+
+    /**
+     * @brief Поворот на angle радиан против часовой стрелки вокруг center
+     */
+    static AffineTransform rotation(double angle, const Point& center = Point());
+
+    /**
+     * @brief Масштабирование с коэффициентами (sx, sy) относительно center
+     *
+     * Отрицательный коэффициент по одной оси - отражение.
+     */
+    static AffineTransform scaling(double sx, double sy, const Point& center = Point());
+
+    /**
+     * @brief Композиция: сначала *this, затем next
+     */
+    AffineTransform then(const AffineTransform& next) const;
+
+    /**
+     * @brief Определитель линейной части (ad - bc)
+     */
+    double determinant() const { return a * d - b * c; }
+
+    /**
+     * @brief Применяет преобразование к одной точке
+     */
+    Point apply(const Point& p) const {
+        return Point(a * p.x + b * p.y + tx, c * p.x + d * p.y + ty);
+    }
+};
+
+/**
+ * @brief Применяет преобразование к массиву точек на месте
+ * @param points Точки (формат x, y, x, y, ... - как у Point[])
+ * @param n Количество точек
+ *
+ * Векторное ядро: одна точка на регистр SSE2 или две на регистр AVX.
+ */
+void transformPoints(Point* points, int n, const AffineTransform& m);
+
+/**
+ * @brief Применяет преобразование к координатам в колоночном формате
+ * @param xs Массив X-координат
+ * @param ys Массив Y-координат
+ * @param n Количество точек
+ *
+ * Для хранилищ, которые держат координаты отдельными столбцами (SoA):
+ * здесь каждая векторная операция обрабатывает 2 (SSE2) или 4 (AVX)
+ * точки сразу.
+ */
+void transformColumns(double* xs, double* ys, int n, const AffineTransform& m);
+
+/**
+ * @brief Применяет преобразование ко всем фигурам коллекции на месте
+ * @param figures Коллекция фигур
+ * @param m Преобразование
+ * @param pool Пул потоков (nullptr - ThreadPool::shared())
+ *
+ * В отличие от пересборки через setPoints(), повторная сортировка
+ * вершин не выполняется (см. Figure::transform()). Коллекция делится
+ * на куски не мельче 4096 фигур; маленькие коллекции обрабатываются
+ * в вызывающем потоке.
+ */
+void transformFigures(Array& figures, const AffineTransform& m, ThreadPool* pool = nullptr);
@@ -14,8 +14,10 @@
  * - Хотя бы одна пара параллельных сторон (основания)
  * - Другие стороны (боковые) могут быть не параллельны
  */
-class Trapezoid : public Figure {
+class Trapezoid : public FigureAdapter<Trapezoid> {
 public:
+    static constexpr const char* TYPE_NAME = "Trapezoid";
+    
     /**
      * @brief Конструктор по умолчанию
      * 
@@ -39,9 +41,6 @@ public:
     Trapezoid& operator=(Trapezoid&& other) noexcept;
     
     // Виртуальные методы
-    Point center() const override;
-    double area() const override;
     void print(std::ostream& os) const override;
     void read(std::istream& is) override;
-    const char* getType() const override { return "Trapezoid"; }
 };
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include "Array.h"
+
+class ThreadPool;
+
+/**
+ * @file UnionArea.h
+ * @brief Площадь объединения фигур коллекции (без двойного учета перекрытий)
+ */
+
+/**
+ * @brief Вычисляет площадь, покрытую хотя бы одной фигурой коллекции
+ * @param figures Коллекция фигур
+ * @return Площадь объединения
+ *
+ * Array::totalArea() складывает площади, поэтому перекрывающиеся части
+ * учитываются несколько раз. Здесь каждая точка плоскости считается
+ * не более одного раза.
+ *
+ * АЛГОРИТМ (интеграл по границе объединения):
+ * Площадь многоугольника - это 1/2 * sum(cross(A, B)) по его сторонам AB
+ * (формула Гаусса). Граница объединения состоит из тех частей сторон
+ * фигур, которые не покрыты другими фигурами. Поэтому для каждой стороны:
+ * 1. Находим отрезки параметра t in [0, 1], покрытые другими фигурами
+ *    (точки входа/выхода стороны в фигуру-соседа).
+ * 2. Сортируем события и берем долю непокрытой длины.
+ * 3. Прибавляем cross(A, B) * доля.
+ * Совпадающие стороны одного направления (например, одинаковые фигуры)
+ * учитываются один раз - за фигурой с меньшим индексом.
+ *
+ * Соседи отбираются через FigureIndex, поэтому для типичных данных
+ * (у фигуры O(1) соседей) сложность O(n log n), в худшем случае O(n²).
+ */
+double unionArea(const Array& figures);
+
+/**
+ * @brief Параллельный вариант unionArea()
+ * @param figures Коллекция фигур
+ * @param pool Пул потоков (nullptr - ThreadPool::shared())
+ * @return Площадь объединения
+ *
+ * Плоскость делится на вертикальные полосы с равным числом фигур
+ * (по X-координате центра). Каждая задача пула считает вклад сторон
+ * фигур своей полосы; соседи из других полос только читаются, поэтому
+ * синхронизация не нужна. Результат совпадает с unionArea() с точностью
+ * до порядка суммирования.
+ */
+double unionAreaParallel(const Array& figures, ThreadPool* pool = nullptr);
@@ -3,6 +3,9 @@
 #include "Rectangle.h"
 #include "Trapezoid.h"
 #include "Array.h"
+#include "Instrumentation.h"
+#include "QueryLanguage.h"
+#include <string>
 
 /**
  * @file main.cpp
@@ -21,6 +24,8 @@ using namespace std;
  * - Удаление фигуры по индексу
  * - Сравнение фигур (оператор ==)
  * - Демонстрация копирования и перемещения
+ * - Статистика задержек операций (при сборке с инструментированием)
+ * - Запросы SELECT ... WHERE ... (см. QueryLanguage.h)
  */
 void printMenu() {
     cout << "\n========== МЕНЮ ==========" << endl;
@@ -32,6 +37,8 @@ void printMenu() {
     cout << "6. Удалить фигуру по индексу" << endl;
     cout << "7. Сравнить две фигуры" << endl;
     cout << "8. Демонстрация копирования/перемещения" << endl;
+    cout << "9. Статистика производительности" << endl;
+    cout << "10. Запрос (SELECT ...)" << endl;
     cout << "0. Выход" << endl;
     cout << "==========================" << endl;
     cout << "Выберите действие: ";
@@ -51,7 +58,10 @@ int main() {
     // Создаем динамический массив для хранения фигур
     // Array хранит указатели Figure*, что позволяет использовать полиморфизм
     Array figures;
-    
+
+    // Индекс для запросов: строится при первом запросе, которому он
+    // нужен, и сбрасывается при любом изменении коллекции
+    FigureIndex* queryIndex = nullptr;
 
     cout << "=============================================" << endl;
     cout << "=============================================" << endl;
@@ -98,6 +108,8 @@ int main() {
                 // ВАЖНО: массив берет владение указателем!
                 // Не нужно вызывать delete вручную
                 figures.push(sq);
+                delete queryIndex;
+                queryIndex = nullptr;
                 
                 cout << "Квадрат добавлен! Площадь: " << sq->area() << endl;
                 break;
@@ -117,6 +129,8 @@ int main() {
                 cin >> *rect;
                 
                 figures.push(rect);
+                delete queryIndex;
+                queryIndex = nullptr;
                 cout << "Прямоугольник добавлен! Площадь: " << rect->area() << endl;
                 break;
             }
@@ -135,6 +149,8 @@ int main() {
                 cin >> *trap;
                 
                 figures.push(trap);
+                delete queryIndex;
+                queryIndex = nullptr;
                 cout << "Трапеция добавлена! Площадь: " << trap->area() << endl;
                 break;
             }
@@ -201,6 +217,8 @@ int main() {
                     // Удаляем фигуру
                     // Array::remove() освобождает память и сдвигает элементы
                     figures.remove(index);
+                    delete queryIndex;
+                    queryIndex = nullptr;
                     
                     cout << "Фигура удалена!" << endl;
                 } else {
@@ -314,6 +332,51 @@ int main() {
                 break;
             }
             
+            // ===============================================================
+            // СЛУЧАЙ 9: СТАТИСТИКА ПРОИЗВОДИТЕЛЬНОСТИ
+            // ===============================================================
+            // Количество вызовов и перцентили задержек горячих операций
+            // (только если программа собрана с -DGEOMETRY_INSTRUMENTATION=ON)
+            case 9: {
+                cout << "\n=== Статистика производительности ===" << endl;
+                dumpInstrumentation(cout);
+                break;
+            }
+            
+            // ===============================================================
+            // СЛУЧАЙ 10: ЗАПРОС
+            // ===============================================================
+            // Запрос компилируется в план: области и точка из WHERE
+            // сужают перебор через FigureIndex, большая коллекция без
+            // них просматривается параллельно
+            case 10: {
+                cout << "\n=== Запрос ===" << endl;
+                cout << "Пример: SELECT COUNT, SUM(area) WHERE type=Square AND area>4"
+                        " AND center IN box(0, 0, 10, 10)" << endl;
+                cout << "EXPLAIN SELECT ... - показать план" << endl;
+                cout << "> ";
+
+                cin.ignore(10000, '\n');
+                string text;
+                getline(cin, text);
+
+                QueryPlan plan;
+                string error;
+                if (!compileQuery(text.c_str(), plan, &error)) {
+                    cout << "Ошибка: " << error << endl;
+                    break;
+                }
+
+                // Индекс строится, только если план может им воспользоваться
+                if (!queryIndex && plan.wantsIndex()) queryIndex = new FigureIndex(figures);
+                if (plan.explain) {
+                    plan.describe(cout, figures.size(), queryIndex);
+                    break;
+                }
+                runQuery(plan, figures, queryIndex).print(cout, plan);
+                break;
+            }
+
             // ===============================================================
             // СЛУЧАЙ 0: ВЫХОД
             // ===============================================================
@@ -321,6 +384,7 @@ int main() {
                 cout << "\nПрограмма завершена." << endl;
                 // При выходе из main автоматически вызовется ~Array()
                 // который удалит все фигуры и освободит память
+                delete queryIndex;
                 return 0;
             
             // ===============================================================
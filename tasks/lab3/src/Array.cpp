@@ -1,4 +1,9 @@
 #include "Array.h"
+#include "UnionArea.h"
+#include "ThreadPool.h"
+#include "Instrumentation.h"
+#include "Trace.h"
+#include "MemoryTracking.h"
 #include <iostream>
 
 /**
@@ -13,39 +18,29 @@
 /**
  * @brief Конструктор - создает пустой массив
  * 
- * Выделяет память для 4 указателей.
- * Это начальная вместимость, которая будет увеличиваться по мере надобности.
+ * Ничего не выделяет: первые INLINE_CAPACITY указателей поместятся
+ * во встроенный буфер items. Массив из нескольких фигур обходится
+ * без кучи, кроме самих фигур.
  */
-Array::Array() {
-    count = 0;        // Изначально массив пуст
-    capacity = 4;     // Начальная вместимость = 4
-    
-    // Выделяем память для массива указателей
-    // new Figure*[4] создает массив из 4 указателей на Figure
-    data = new Figure*[capacity];
-}
+Array::Array() {}
 
 /**
  * @brief Деструктор - освобождает всю память
  * 
  * КРИТИЧЕСКИ ВАЖНО: два шага освобождения памяти!
  * 
- * 1. Удалить все фигуры (delete data[i])
+ * 1. Удалить все фигуры (delete items[i])
  *    Иначе: утечка памяти, фигуры останутся в памяти
  * 
- * 2. Удалить массив указателей (delete[] data)
- *    Иначе: утечка памяти, массив указателей останется
+ * 2. Удалить буфер указателей
+ *    Это делает деструктор SmallArray (если буфер в куче)
  */
 Array::~Array() {
-    // Шаг 1: Удаляем все фигуры
-    for (int i = 0; i < count; i++) {
-        delete data[i];  // Освобождаем память каждой фигуры
+    // Удаляем все фигуры
+    for (int i = 0; i < items.size(); i++) {
+        delete items[i];  // Освобождаем память каждой фигуры
         // Вызовется виртуальный деструктор: ~Square(), ~Rectangle() и т.д.
     }
-    
-    // Шаг 2: Удаляем массив указателей
-    // delete[] используется для массивов (в отличие от delete для одного объекта)
-    delete[] data;
 }
 
 // ===================================================================
@@ -55,17 +50,14 @@ Array::~Array() {
 /**
  * @brief Увеличивает вместимость массива в 2 раза
  * 
- * АЛГОРИТМ:
- * 1. Вычисляем новую вместимость (capacity * 2)
- * 2. Выделяем новый массив большего размера
- * 3. Копируем все указатели из старого в новый
- * 4. Удаляем старый массив (НЕ сами фигуры!)
- * 5. Переключаемся на новый массив
+ * Перенос указателей делает SmallArray::reserve(): новый буфер
+ * в куче, копирование указателей, освобождение старого буфера
+ * (встроенный буфер освобождать не нужно).
  * 
  * ВАЖНО: копируем только УКАЗАТЕЛИ, а не сами фигуры!
  * Фигуры остаются в той же памяти, меняется только массив указателей.
  * 
- * СЛОЖНОСТЬ: O(n), где n = count
+ * СЛОЖНОСТЬ: O(n), где n = size()
  * АМОРТИЗИРОВАННАЯ: O(1) на одно добавление
  * 
  * Почему удваиваем?
@@ -74,23 +66,8 @@ Array::~Array() {
  * сложность будет O(n).
  */
 void Array::resize() {
-    // Новая вместимость в 2 раза больше
-    capacity *= 2;
-    
-    // Выделяем новый массив указателей
-    Figure** newData = new Figure*[capacity];
-    
-    // Копируем все указатели из старого массива в новый
-    for (int i = 0; i < count; i++) {
-        newData[i] = data[i];  // Копируем указатель, а не фигуру!
-    }
-    
-    // Удаляем старый массив указателей
-    // НЕ удаляем сами фигуры! Они все еще нужны.
-    delete[] data;
-    
-    // Переключаемся на новый массив
-    data = newData;
+    GEOMETRY_PROBE(Probe::ArrayResize);
+    items.reserve(items.getCapacity() * 2);
 }
 
 // ===================================================================
@@ -104,7 +81,7 @@ void Array::resize() {
  * ВАЖНО: массив берет владение указателем!
  * После вызова push() НЕ удаляйте фигуру вручную.
  * 
- * Если массив заполнен (count == capacity),
+ * Если массив заполнен (size() == вместимость),
  * автоматически увеличиваем размер через resize().
  * 
  * СЛОЖНОСТЬ:
@@ -113,19 +90,20 @@ void Array::resize() {
  * - Амортизированная: O(1)
  */
 void Array::push(Figure* fig) {
+    GEOMETRY_PROBE(Probe::ArrayPush);
+
     // Проверка на nullptr (пустой указатель)
     if (fig == nullptr) {
         return;  // Игнорируем пустые указатели
     }
     
     // Если массив заполнен - увеличиваем его
-    if (count >= capacity) {
+    if (items.size() >= items.getCapacity()) {
         resize();
     }
     
     // Добавляем фигуру в конец
-    data[count] = fig;
-    count++;  // Увеличиваем счетчик
+    items.push(fig);
 }
 
 /**
@@ -134,36 +112,32 @@ void Array::push(Figure* fig) {
  * 
  * АЛГОРИТМ:
  * 1. Проверяем корректность индекса
- * 2. Удаляем фигуру (delete data[index])
+ * 2. Удаляем фигуру (delete items[index])
  * 3. Сдвигаем все последующие элементы влево на 1 позицию
- * 4. Уменьшаем count на 1
+ * 4. Уменьшаем размер на 1
  * 
- * СЛОЖНОСТЬ: O(n - index), где n = count
+ * СЛОЖНОСТЬ: O(n - index), где n = size()
  * В худшем случае (удаление первого): O(n)
  * 
  * Почему не делаем "дырку"?
  * Чтобы массив всегда был компактным и можно было
- * проходить по нему от 0 до count-1 без пропусков.
+ * проходить по нему от 0 до size()-1 без пропусков.
  */
 void Array::remove(int index) {
+    GEOMETRY_PROBE(Probe::ArrayRemove);
+
     // Проверка корректности индекса
-    if (index < 0 || index >= count) {
+    if (index < 0 || index >= items.size()) {
         return;  // Некорректный индекс - ничего не делаем
     }
     
     // Удаляем фигуру (освобождаем память)
-    delete data[index];
+    delete items[index];
     
     // Сдвигаем все последующие элементы влево
     // Пример: удаляем index=1 из [A, B, C, D]
-    // После сдвига: [A, C, D, D]
-    // После уменьшения count: [A, C, D]
-    for (int i = index; i < count - 1; i++) {
-        data[i] = data[i + 1];  // Копируем указатель влево
-    }
-    
-    // Уменьшаем количество элементов
-    count--;
+    // После сдвига и уменьшения размера: [A, C, D]
+    items.remove(index);
 }
 
 /**
@@ -177,12 +151,12 @@ void Array::remove(int index) {
  */
 Figure* Array::get(int index) const {
     // Проверка корректности индекса
-    if (index < 0 || index >= count) {
+    if (index < 0 || index >= items.size()) {
         return nullptr;  // Некорректный индекс
     }
     
     // Возвращаем указатель на фигуру
-    return data[index];
+    return items[index];
 }
 
 /**
@@ -192,29 +166,83 @@ Figure* Array::get(int index) const {
  * Проходит по всем фигурам и суммирует их площади.
  * 
  * ПОЛИМОРФИЗМ В ДЕЙСТВИИ:
- * data[i]->area() вызовет правильный метод для каждой фигуры:
+ * items[i]->area() вызовет правильный метод для каждой фигуры:
  * - Square::area() для квадрата
  * - Rectangle::area() для прямоугольника
  * - Trapezoid::area() для трапеции
  * 
  * Это работает благодаря виртуальным методам!
  * 
- * СЛОЖНОСТЬ: O(n), где n = count
+ * СЛОЖНОСТЬ: O(n), где n = size()
  */
 double Array::totalArea() const {
+    GEOMETRY_PROBE(Probe::TotalArea);
+    GEOMETRY_TRACE_SCOPE("Array::totalArea", items.size());
+
     double total = 0;  // Накопитель суммы
     
     // Проходим по всем фигурам
-    for (int i = 0; i < count; i++) {
+    for (int i = 0; i < items.size(); i++) {
         // Вызываем виртуальный метод area()
         // Компилятор во время выполнения определит тип фигуры
         // и вызовет соответствующую версию метода
-        total += data[i]->area();
+        total += items[i]->area();
     }
     
     return total;
 }
 
+/**
+ * @brief Параллельная общая площадь
+ * 
+ * Площадь фигуры - несколько нс, поэтому куски не мельче 4096 фигур.
+ */
+double Array::totalArea(ThreadPool& pool) const {
+    GEOMETRY_TRACE_SCOPE("Array::totalArea", items.size());
+    return pool.parallelReduce(0, items.size(), 0.0, [this](int begin, int end) {
+        double sum = 0;
+        for (int i = begin; i < end; i++) sum += items[i]->area();
+        return sum;
+    }, [](double a, double b) { return a + b; }, 4096);
+}
+
+/**
+ * @brief Вычисляет площадь объединения всех фигур
+ * 
+ * Вся работа - в ::unionArea() (UnionArea.cpp), здесь только
+ * удобная точка входа рядом с totalArea().
+ */
+double Array::unionArea() const {
+    return ::unionArea(*this);
+}
+
+/**
+ * @brief Отчет о памяти массива
+ * 
+ * Каждая фигура - отдельный блок в куче: для каждого учитывается
+ * округление аллокатора и заголовок. Буфер указателей - тоже блок,
+ * если он уже вынесен в кучу; встроенный буфер входит в sizeof(Array).
+ * 
+ * СЛОЖНОСТЬ: O(n) - обходит все фигуры (виртуальные вызовы
+ * getType() и objectSize()).
+ */
+MemoryReport Array::memoryReport() const {
+    MemoryReport report;
+    report.containerBytes = sizeof(Array);
+    if (!items.isInline()) {
+        report.bufferUsed = (long long)items.size() * sizeof(Figure*);
+        report.bufferUnused = (long long)(items.getCapacity() - items.size()) * sizeof(Figure*);
+        report.addBlock(items.heapBlock(), items.heapBytes());
+    }
+    
+    for (int i = 0; i < items.size(); i++) {
+        std::size_t size = items[i]->objectSize();
+        report.addObject(items[i]->getType(), size);
+        report.addBlock(items[i], size);
+    }
+    return report;
+}
+
 /**
  * @brief Выводит информацию обо всех фигурах
  * 
@@ -229,28 +257,28 @@ double Array::totalArea() const {
  * 2. Rectangle: ...
  * 
  * ПОЛИМОРФИЗМ:
- * *data[i] разыменовывает указатель, получая ссылку на Figure&
- * std::cout << *data[i] вызывает operator<<(ostream&, Figure&)
+ * *items[i] разыменовывает указатель, получая ссылку на Figure&
+ * std::cout << *items[i] вызывает operator<<(ostream&, Figure&)
  * Внутри вызывается виртуальный метод print()
  * Благодаря полиморфизму вызовется правильная версия:
  * Square::print(), Rectangle::print() и т.д.
  */
 void Array::printAll() const {
     // Проходим по всем фигурам
-    for (int i = 0; i < count; i++) {
+    for (int i = 0; i < items.size(); i++) {
         // Номер фигуры (с 1, а не с 0)
         std::cout << i + 1 << ". ";
         
         // Выводим фигуру через оператор <<
         // Это вызовет виртуальный метод print()
-        std::cout << *data[i];
+        std::cout << *items[i];
         
         // Получаем центр (вызовет виртуальный метод center())
-        Point c = data[i]->center();
+        Point c = items[i]->center();
         std::cout << " | Center: (" << c.x << "," << c.y << ")";
         
         // Выводим площадь (вызовет виртуальный метод area())
-        std::cout << " | Area: " << data[i]->area();
+        std::cout << " | Area: " << items[i]->area();
         
         std::cout << std::endl;
     }
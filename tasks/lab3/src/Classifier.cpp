@@ -0,0 +1,248 @@
+#include "Classifier.h"
+#include "Square.h"
+#include "Rectangle.h"
+#include "Trapezoid.h"
+#include "Trace.h"
+#include <cmath>
+#include <cstring>
+
+/**
+ * @file Classifier.cpp
+ * @brief Векторизуемая классификация четырехугольников по блокам записей
+ */
+
+const char* kindName(FigureKind kind) {
+    switch (kind) {
+        case FigureKind::Square: return "Square";
+        case FigureKind::Rectangle: return "Rectangle";
+        case FigureKind::Trapezoid: return "Trapezoid";
+        default: return "Rejected";
+    }
+}
+
+Figure* createFigure(FigureKind kind, const Point p[4]) {
+    switch (kind) {
+        case FigureKind::Square: return new Square(p);
+        case FigureKind::Rectangle: return new Rectangle(p);
+        case FigureKind::Trapezoid: return new Trapezoid(p);
+        default: return nullptr;
+    }
+}
+
+FigureKind figureKind(const Figure& fig) {
+    // Обычно getType() возвращает сам TYPE_NAME класса - сравнение указателей
+    const char* type = fig.getType();
+    if (type == Square::TYPE_NAME) return FigureKind::Square;
+    if (type == Rectangle::TYPE_NAME) return FigureKind::Rectangle;
+    if (type == Trapezoid::TYPE_NAME) return FigureKind::Trapezoid;
+    for (int k = 0; k < (int)FigureKind::Rejected; k++) {
+        if (std::strcmp(type, kindName((FigureKind)k)) == 0) return (FigureKind)k;
+    }
+    return FigureKind::Rejected;
+}
+
+const char* reasonName(RejectReason reason) {
+    switch (reason) {
+        case RejectReason::None: return "None";
+        case RejectReason::NonFinite: return "NonFinite";
+        case RejectReason::Degenerate: return "Degenerate";
+        case RejectReason::NonConvex: return "NonConvex";
+        default: return "NoParallelSides";
+    }
+}
+
+void ClassifyStats::print(std::ostream& os) const {
+    for (int k = 0; k < FIGURE_KIND_COUNT; k++) {
+        os << kindName((FigureKind)k) << ": " << kinds[k] << std::endl;
+    }
+    for (int r = 1; r < REJECT_REASON_COUNT; r++) {
+        os << "  " << reasonName((RejectReason)r) << ": " << reasons[r] << std::endl;
+    }
+}
+
+// ===================================================================
+// ЯДРО КЛАССИФИКАЦИИ
+// ===================================================================
+
+const int CLASSIFY_BLOCK = 64;
+
+/*
+  Тройки и пары точек для проверок.
+
+  Ориентации троек (удвоенные площади треугольников):
+    t0 = orient(1,2,3), t1 = orient(0,2,3), t2 = orient(0,1,3), t3 = orient(0,1,2).
+  Коэффициенты аффинной зависимости 4 точек: l = (t0, -t1, t2, -t3), сумма = 0.
+  Разбиение Радона делит точки по знаку l:
+  - 2 + 2: отрезки между точками одного знака пересекаются - это диагонали,
+    четырехугольник выпуклый;
+  - 1 + 3: одна точка внутри треугольника остальных - невыпуклый.
+
+  Три способа разбить 4 точки на два отрезка:
+    X = (01, 23), Y = (02, 13), Z = (03, 12).
+  Одно из разбиений - диагонали, два других - пары противоположных сторон.
+*/
+static inline double orient(double ax, double ay, double bx, double by, double cx, double cy) {
+    return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+/*
+  Классифицирует count <= CLASSIFY_BLOCK записей.
+
+  Цикл по записям состоит только из арифметики и выборов (?:) над double -
+  без вызовов и побочных эффектов, поэтому компилятор превращает выборы
+  в маски и векторизует цикл по записям (2 записи на регистр SSE2, 4 - на
+  AVX; флаги компиляции - в CMakeLists.txt). Результат - коды в double,
+  которые в конце переводятся в enum отдельным коротким циклом.
+*/
+static void classifyBlock(const double* records, int count, double tol,
+                          FigureKind* kinds, RejectReason* reasons) {
+    double x[4][CLASSIFY_BLOCK], y[4][CLASSIFY_BLOCK];
+    double kindCode[CLASSIFY_BLOCK], reasonCode[CLASSIFY_BLOCK];
+
+    // Транспонирование: записи (AoS) -> столбцы координат (SoA)
+    for (int j = 0; j < count; j++) {
+        for (int k = 0; k < 4; k++) {
+            x[k][j] = records[8 * j + 2 * k];
+            y[k][j] = records[8 * j + 2 * k + 1];
+        }
+    }
+
+    const double tol2 = tol * tol;
+    for (int j = 0; j < count; j++) {
+        double x0 = x[0][j], y0 = y[0][j], x1 = x[1][j], y1 = y[1][j];
+        double x2 = x[2][j], y2 = y[2][j], x3 = x[3][j], y3 = y[3][j];
+
+        // x - x == 0 ложно только для NaN и бесконечностей
+        double probe = (x0 - x0) + (y0 - y0) + (x1 - x1) + (y1 - y1) +
+                       (x2 - x2) + (y2 - y2) + (x3 - x3) + (y3 - y3);
+        double finite = (double)(probe == 0);
+
+        // Векторы трех разбиений на пары отрезков
+        double uXx = x1 - x0, uXy = y1 - y0, vXx = x3 - x2, vXy = y3 - y2;  // 01, 23
+        double uYx = x2 - x0, uYy = y2 - y0, vYx = x3 - x1, vYy = y3 - y1;  // 02, 13
+        double uZx = x3 - x0, uZy = y3 - y0, vZx = x2 - x1, vZy = y2 - y1;  // 03, 12
+
+        double luX = uXx * uXx + uXy * uXy, lvX = vXx * vXx + vXy * vXy;
+        double luY = uYx * uYx + uYy * uYy, lvY = vYx * vYx + vYy * vYy;
+        double luZ = uZx * uZx + uZy * uZy, lvZ = vZx * vZx + vZy * vZy;
+
+        double crX = uXx * vXy - uXy * vXx, dtX = uXx * vXx + uXy * vXy;
+        double crY = uYx * vYy - uYy * vYx, dtY = uYx * vYx + uYy * vYy;
+        double crZ = uZx * vZy - uZy * vZx, dtZ = uZx * vZx + uZy * vZy;
+
+        // Квадрат диаметра - масштаб для допуска вырождения
+        double s = luX > lvX ? luX : lvX;
+        s = luY > s ? luY : s;
+        s = lvY > s ? lvY : s;
+        s = luZ > s ? luZ : s;
+        s = lvZ > s ? lvZ : s;
+
+        double t0 = orient(x1, y1, x2, y2, x3, y3);
+        double t1 = orient(x0, y0, x2, y2, x3, y3);
+        double t2 = orient(x0, y0, x1, y1, x3, y3);
+        double t3 = orient(x0, y0, x1, y1, x2, y2);
+        double minT = std::fabs(t0);
+        minT = std::fabs(t1) < minT ? std::fabs(t1) : minT;
+        minT = std::fabs(t2) < minT ? std::fabs(t2) : minT;
+        minT = std::fabs(t3) < minT ? std::fabs(t3) : minT;
+        // s > 0 ложно и для s == 0 (все точки совпали), и для NaN
+        double degenerate = ((s > 0) & (minT > tol * s)) ? 0.0 : 1.0;
+
+        // Знаки коэффициентов Радона как 0/1
+        double p0 = (double)(t0 > 0);
+        double p1 = (double)(t1 < 0);
+        double p2 = (double)(t2 > 0);
+        double p3 = (double)(t3 < 0);
+        double convex = (double)(p0 + p1 + p2 + p3 == 2.0);
+
+        // Какое разбиение - диагонали: X, если 0 и 1 одного знака, иначе Y или Z
+        double diagX = (double)(p0 == p1);
+        double diagY = (double)(p0 == p2);
+
+        double parX = (double)(crX * crX <= tol2 * luX * lvX);
+        double parY = (double)(crY * crY <= tol2 * luY * lvY);
+        double parZ = (double)(crZ * crZ <= tol2 * luZ * lvZ);
+
+        // Выбор разбиения-диагоналей; остальные два - пары сторон
+        double parallelSides = diagX == 1 ? parY + parZ : (diagY == 1 ? parX + parZ : parX + parY);
+        double dLu = diagX == 1 ? luX : (diagY == 1 ? luY : luZ);
+        double dLv = diagX == 1 ? lvX : (diagY == 1 ? lvY : lvZ);
+        double dDot = diagX == 1 ? dtX : (diagY == 1 ? dtY : dtZ);
+        double diagEqual = (double)(std::fabs(dLu - dLv) <= tol * (dLu + dLv));
+        double diagPerp = (double)(dDot * dDot <= tol2 * dLu * dLv);
+
+        // Коды: 0 - Square, 1 - Rectangle, 2 - Trapezoid, 3 - Rejected
+        double rectangle = parallelSides == 2 ? diagEqual : 0.0;
+        double kind = rectangle == 1 ? 1 - diagPerp : (parallelSides > 0 ? 2.0 : 3.0);
+
+        // Причины по приоритету: NonFinite > Degenerate > NonConvex > NoParallelSides
+        double reason = kind == 3 ? 4.0 : 0.0;
+        reason = convex == 1 ? reason : 3.0;
+        reason = degenerate == 1 ? 2.0 : reason;
+        reason = finite == 1 ? reason : 1.0;
+        // Флаги - точные 0/1 (результаты сравнений), поэтому смешивание
+        // умножением безопасно даже для записей с NaN
+        double accepted = finite * (1 - degenerate) * convex;
+        kindCode[j] = accepted * kind + (1 - accepted) * 3.0;
+        reasonCode[j] = reason;
+    }
+
+    for (int j = 0; j < count; j++) {
+        kinds[j] = (FigureKind)(int)kindCode[j];
+        reasons[j] = (RejectReason)(int)reasonCode[j];
+    }
+}
+
+// ===================================================================
+// ПУБЛИЧНЫЙ ИНТЕРФЕЙС
+// ===================================================================
+
+void classifyRecords(const double* records, int n, FigureKind* kinds,
+                     RejectReason* reasons, ClassifyStats* stats, double tolerance) {
+    GEOMETRY_TRACE_SCOPE("classifyRecords", n);
+    RejectReason blockReasons[CLASSIFY_BLOCK];
+    for (int begin = 0; begin < n; begin += CLASSIFY_BLOCK) {
+        int count = n - begin < CLASSIFY_BLOCK ? n - begin : CLASSIFY_BLOCK;
+        RejectReason* reasonOut = reasons ? reasons + begin : blockReasons;
+        classifyBlock(records + 8 * begin, count, tolerance, kinds + begin, reasonOut);
+        if (stats) {
+            for (int j = 0; j < count; j++) {
+                stats->kinds[(int)kinds[begin + j]]++;
+                stats->reasons[(int)reasonOut[j]]++;
+            }
+        }
+    }
+}
+
+FigureKind classifyPoints(const Point p[4], RejectReason* reason, double tolerance) {
+    double record[8];
+    for (int k = 0; k < 4; k++) {
+        record[2 * k] = p[k].x;
+        record[2 * k + 1] = p[k].y;
+    }
+    FigureKind kind;
+    RejectReason why;
+    classifyBlock(record, 1, tolerance, &kind, &why);
+    if (reason) *reason = why;
+    return kind;
+}
+
+int loadClassified(const double* records, int n, Array& out,
+                   ClassifyStats* stats, double tolerance) {
+    GEOMETRY_TRACE_SCOPE("loadClassified", n);
+    FigureKind kinds[CLASSIFY_BLOCK];
+    int loaded = 0;
+    for (int begin = 0; begin < n; begin += CLASSIFY_BLOCK) {
+        int count = n - begin < CLASSIFY_BLOCK ? n - begin : CLASSIFY_BLOCK;
+        classifyRecords(records + 8 * begin, count, kinds, nullptr, stats, tolerance);
+
+        for (int j = 0; j < count; j++) {
+            if (kinds[j] == FigureKind::Rejected) continue;
+            const double* r = records + 8 * (begin + j);
+            Point p[4] = {Point(r[0], r[1]), Point(r[2], r[3]), Point(r[4], r[5]), Point(r[6], r[7])};
+            out.push(createFigure(kinds[j], p));
+            loaded++;
+        }
+    }
+    return loaded;
+}
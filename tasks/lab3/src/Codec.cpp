@@ -0,0 +1,263 @@
+#include "Codec.h"
+#include "Trace.h"
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @file Codec.cpp
+ * @brief Серии тегов, XOR-сжатие координат, выведение четвертой вершины
+ */
+
+// ===================================================================
+// ПРИМИТИВЫ
+// ===================================================================
+
+static const unsigned char TAG_DERIVED = 4;   ///< Флаг тега: вершина 3 не хранится
+
+static unsigned char* putVarint(unsigned char* p, std::uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char)v;
+    return p;
+}
+
+static const unsigned char* getVarint(const unsigned char* p, const unsigned char* end, std::uint32_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        unsigned char b = *p++;
+        v |= (std::uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return p;
+    }
+    return nullptr;
+}
+
+/*
+  Нулевые байты справа и слева у ненулевого x.
+*/
+static int lowZeroBytes(std::uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x) / 8;
+#else
+    int n = 0;
+    while (!(x & 0xFF)) { x >>= 8; n++; }
+    return n;
+#endif
+}
+
+static int highZeroBytes(std::uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_clzll(x) / 8;
+#else
+    int n = 0;
+    while (!(x >> 56)) { x <<= 8; n++; }
+    return n;
+#endif
+}
+
+static std::uint64_t bitsOf(double v) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static double valueOf(std::uint64_t bits) {
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+/*
+  Значение потока: XOR с предыдущим, управляющий байт (нулевые байты
+  справа << 4 | значащие байты) и значащие байты. Пишутся сразу
+  8 байт - буфер имеет запас (encodedSizeBound), указатель
+  сдвигается на значащие.
+*/
+static unsigned char* putXor(unsigned char* p, double value, std::uint64_t& prev) {
+    std::uint64_t bits = bitsOf(value);
+    std::uint64_t x = bits ^ prev;
+    prev = bits;
+    if (x == 0) {
+        *p++ = 0;
+        return p;
+    }
+    int trail = lowZeroBytes(x);
+    int len = 8 - trail - highZeroBytes(x);
+    *p++ = (unsigned char)(trail << 4 | len);
+    std::uint64_t meaningful = x >> (8 * trail);
+    std::memcpy(p, &meaningful, 8);
+    return p + len;
+}
+
+static const unsigned char* getXor(const unsigned char* p, const unsigned char* end, double& value,
+                                   std::uint64_t& prev) {
+    if (p >= end) return nullptr;
+    unsigned char control = *p++;
+    int trail = control >> 4;
+    int len = control & 15;
+    if (len == 0) {
+        if (control != 0) return nullptr;
+        value = valueOf(prev);
+        return p;
+    }
+    if (trail + len > 8 || end - p < len) return nullptr;
+
+    std::uint64_t meaningful = 0;
+    if (end - p >= 8) {
+        std::memcpy(&meaningful, p, 8);
+        if (len < 8) meaningful &= ((std::uint64_t)1 << (8 * len)) - 1;
+    } else {
+        std::memcpy(&meaningful, p, len);
+    }
+    prev ^= meaningful << (8 * trail);
+    value = valueOf(prev);
+    return p + len;
+}
+
+/*
+  Четвертая вершина параллелограмма p0 p1 p2 p3: p0 + p2 - p1.
+  Выражение одно и то же при кодировании и декодировании.
+*/
+static Point derivedVertex(const Point& p0, const Point& p1, const Point& p2) {
+    return Point(p0.x + p2.x - p1.x, p0.y + p2.y - p1.y);
+}
+
+// ===================================================================
+// КОДИРОВАНИЕ
+// ===================================================================
+
+long long encodedSizeBound(int n) {
+    // заголовок + на фигуру: серия тегов (до 6 байт) и 8 значений по 9 байт
+    // + запас 8 байт для записи значений целыми словами
+    return 4 + 5 + (long long)n * (6 + 8 * 9) + 8;
+}
+
+long long encodeFigures(const Array& figures, unsigned char* out, const CodecOptions& options) {
+    GEOMETRY_TRACE_SCOPE("encodeFigures", figures.size());
+    int n = figures.size();
+    unsigned char* p = out;
+    std::memcpy(p, "GFC1", 4);
+    p = putVarint(p + 4, (std::uint32_t)n);
+
+    // 1. Теги и серии
+    unsigned char* tags = new unsigned char[n > 0 ? n : 1];
+    for (int i = 0; i < n; i++) {
+        const Figure* fig = figures.get(i);
+        FigureKind kind = figureKind(*fig);
+        unsigned char tag = (unsigned char)kind;
+        if (options.elideDerived && kind != FigureKind::Trapezoid) {
+            const Point* v = fig->getPoints();
+            Point d = derivedVertex(v[0], v[1], v[2]);
+            if (d.x == v[3].x && d.y == v[3].y) tag |= TAG_DERIVED;
+        }
+        tags[i] = tag;
+    }
+    for (int i = 0; i < n;) {
+        int run = 1;
+        while (i + run < n && tags[i + run] == tags[i]) run++;
+        p = putVarint(p, (std::uint32_t)run);
+        *p++ = tags[i];
+        i += run;
+    }
+
+    // 2. Координаты
+    std::uint64_t prevX = 0, prevY = 0;
+    for (int i = 0; i < n; i++) {
+        const Point* v = figures.get(i)->getPoints();
+        int stored = (tags[i] & TAG_DERIVED) ? 3 : 4;
+        for (int k = 0; k < stored; k++) {
+            p = putXor(p, v[k].x, prevX);
+            p = putXor(p, v[k].y, prevY);
+        }
+    }
+
+    delete[] tags;
+    return p - out;
+}
+
+// ===================================================================
+// ДЕКОДИРОВАНИЕ
+// ===================================================================
+
+int encodedCount(const unsigned char* data, long long size) {
+    if (size < 5 || std::memcmp(data, "GFC1", 4) != 0) return -1;
+    std::uint32_t n = 0;
+    if (!getVarint(data + 4, data + size, n) || n > 0x7FFFFFFF) return -1;
+    return (int)n;
+}
+
+/*
+  Серии тегов проходятся дважды: сначала проверка и поиск начала
+  координат, затем - одновременно с координатами.
+*/
+int decodeRecords(const unsigned char* data, long long size, double* records, FigureKind* kinds) {
+    GEOMETRY_TRACE_SCOPE("decodeRecords");
+    int n = encodedCount(data, size);
+    if (n < 0) return -1;
+    const unsigned char* end = data + size;
+    std::uint32_t count = 0;
+    const unsigned char* runs = getVarint(data + 4, end, count);
+
+    const unsigned char* p = runs;
+    for (long long total = 0; total < n;) {
+        std::uint32_t run = 0;
+        p = getVarint(p, end, run);
+        if (!p || p >= end || run == 0 || total + run > (long long)n) return -1;
+        unsigned char tag = *p++;
+        unsigned char kind = tag & ~TAG_DERIVED;
+        if (kind > (unsigned char)FigureKind::Trapezoid) return -1;
+        if ((tag & TAG_DERIVED) && kind == (unsigned char)FigureKind::Trapezoid) return -1;
+        total += run;
+    }
+
+    const unsigned char* tagCursor = runs;
+    std::uint32_t left = 0;
+    unsigned char tag = 0;
+    std::uint64_t prevX = 0, prevY = 0;
+    for (int i = 0; i < n; i++) {
+        if (left == 0) {
+            tagCursor = getVarint(tagCursor, end, left);
+            tag = *tagCursor++;
+        }
+        left--;
+
+        double* r = records + 8 * i;
+        int stored = (tag & TAG_DERIVED) ? 3 : 4;
+        for (int k = 0; k < stored; k++) {
+            p = getXor(p, end, r[2 * k], prevX);
+            if (!p) return -1;
+            p = getXor(p, end, r[2 * k + 1], prevY);
+            if (!p) return -1;
+        }
+        if (stored == 3) {
+            Point d = derivedVertex(Point(r[0], r[1]), Point(r[2], r[3]), Point(r[4], r[5]));
+            r[6] = d.x;
+            r[7] = d.y;
+        }
+        kinds[i] = (FigureKind)(tag & ~TAG_DERIVED);
+    }
+    return p == end ? n : -1;
+}
+
+int decodeFigures(const unsigned char* data, long long size, Array& out) {
+    GEOMETRY_TRACE_SCOPE("decodeFigures");
+    int n = encodedCount(data, size);
+    if (n < 0) return -1;
+
+    // Каждая фигура занимает в коде не меньше 6 байт: n из заголовка
+    // не может заставить выделить больше памяти, чем оправдывает размер
+    if ((long long)n * 6 > size) return -1;
+
+    double* records = new double[8 * (long long)(n > 0 ? n : 1)];
+    FigureKind* kinds = new FigureKind[n > 0 ? n : 1];
+    int decoded = decodeRecords(data, size, records, kinds);
+    for (int i = 0; i < decoded; i++) {
+        const double* r = records + 8 * i;
+        Point p[4] = {Point(r[0], r[1]), Point(r[2], r[3]), Point(r[4], r[5]), Point(r[6], r[7])};
+        out.push(createFigure(kinds[i], p));
+    }
+    delete[] kinds;
+    delete[] records;
+    return decoded;
+}
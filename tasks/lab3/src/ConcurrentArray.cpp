@@ -0,0 +1,176 @@
+#include "ConcurrentArray.h"
+#include "Trace.h"
+#include <climits>
+#include <new>
+
+/**
+ * @file ConcurrentArray.cpp
+ * @brief Добавление из многих потоков: сегменты, резервирование, публикация
+ */
+
+// ===================================================================
+// СЕГМЕНТЫ
+// ===================================================================
+
+static_assert((long long)CONCURRENT_FIRST_SEGMENT * ((1LL << CONCURRENT_SEGMENTS) - 1) > INT_MAX,
+              "сегменты должны вмещать любой неотрицательный индекс int");
+
+static int highestBit(unsigned value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 31 - __builtin_clz(value);
+#else
+    int bit = 0;
+    while (value >>= 1) bit++;
+    return bit;
+#endif
+}
+
+/*
+  Сегмент k начинается с индекса FIRST * (2^k - 1). Для v = index + FIRST
+  номер сегмента - позиция старшего бита v минус log2(FIRST), смещение -
+  v без этого бита.
+*/
+static int segmentOf(int index, int& offset) {
+    unsigned v = (unsigned)index + CONCURRENT_FIRST_SEGMENT;
+    int high = highestBit(v);
+    offset = (int)(v - (1u << high));
+    return high - highestBit((unsigned)CONCURRENT_FIRST_SEGMENT);
+}
+
+// В size_t: последний сегмент - 2^31 слотов, в int не помещается
+static std::size_t segmentSlots(int k) {
+    return (std::size_t)CONCURRENT_FIRST_SEGMENT << k;
+}
+
+static std::size_t segmentBytes(int k) {
+    return segmentSlots(k) * sizeof(std::atomic<Figure*>);
+}
+
+ConcurrentArray::ConcurrentArray() : reserved(0), published(0) {
+    for (int k = 0; k < CONCURRENT_SEGMENTS; k++) segments[k].store(nullptr, std::memory_order_relaxed);
+}
+
+/*
+  Деструктор не потокобезопасен (как и у любого объекта): к этому
+  моменту производители и читатели должны завершиться.
+*/
+ConcurrentArray::~ConcurrentArray() {
+    int n = reserved.load(std::memory_order_acquire);
+    for (int i = 0; i < n; i++) delete existingSlot(i)->load(std::memory_order_relaxed);
+
+    for (int k = 0; k < CONCURRENT_SEGMENTS; k++) {
+        std::atomic<Figure*>* seg = segments[k].load(std::memory_order_relaxed);
+        if (seg) trackedFree(seg, segmentBytes(k));
+    }
+}
+
+/*
+  Сегмент создает первый поток, которому он понадобился. Если два потока
+  создали его одновременно, CAS выигрывает один; второй освобождает свой
+  экземпляр и пишет в сегмент победителя.
+*/
+std::atomic<Figure*>& ConcurrentArray::slot(int index) {
+    int offset;
+    int k = segmentOf(index, offset);
+    std::atomic<Figure*>* seg = segments[k].load(std::memory_order_acquire);
+    if (!seg) {
+        std::size_t count = segmentSlots(k);
+        std::atomic<Figure*>* created =
+            static_cast<std::atomic<Figure*>*>(trackedAllocate(segmentBytes(k)));
+        for (std::size_t i = 0; i < count; i++) new (&created[i]) std::atomic<Figure*>(nullptr);
+
+        if (segments[k].compare_exchange_strong(seg, created, std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+            seg = created;
+        } else {
+            trackedFree(created, segmentBytes(k));
+        }
+    }
+    return seg[offset];
+}
+
+std::atomic<Figure*>* ConcurrentArray::existingSlot(int index) const {
+    int offset;
+    int k = segmentOf(index, offset);
+    return segments[k].load(std::memory_order_acquire) + offset;
+}
+
+// ===================================================================
+// ДОБАВЛЕНИЕ И ПУБЛИКАЦИЯ
+// ===================================================================
+
+int ConcurrentArray::push(Figure* fig) {
+    if (fig == nullptr) return -1;
+
+    int index = reserved.fetch_add(1, std::memory_order_relaxed);
+    slot(index).store(fig, std::memory_order_seq_cst);
+    advancePublished();
+    return index;
+}
+
+/*
+  Каждый производитель после записи своего слота пытается сдвинуть
+  границу префикса вперед, пока следующий слот заполнен. Если слот
+  еще пуст, его производитель сам продвинет границу после записи -
+  поэтому ни одна фигура не останется неопубликованной.
+
+  Слот проверяется, только пока index < reserved: сегмент для него
+  уже существует или создается его производителем - тогда слот пуст.
+
+  Запись слота, чтение границы и проверка слота - seq_cst. Иначе
+  возможна гонка "store-load": производитель слота i не видит, что
+  граница уже дошла до i, а продвинувший ее поток не видит запись
+  в слот i, - и оба останавливаются.
+*/
+void ConcurrentArray::advancePublished() {
+    int p = published.load(std::memory_order_seq_cst);
+    while (p < reserved.load(std::memory_order_acquire)) {
+        int offset;
+        int k = segmentOf(p, offset);
+        std::atomic<Figure*>* seg = segments[k].load(std::memory_order_acquire);
+        if (!seg || !seg[offset].load(std::memory_order_seq_cst)) return;
+
+        // Неудачный CAS обновляет p - продолжаем с новой границы
+        if (published.compare_exchange_weak(p, p + 1, std::memory_order_seq_cst)) {
+            p++;
+        }
+    }
+}
+
+// ===================================================================
+// ЧТЕНИЕ
+// ===================================================================
+
+const Figure* ConcurrentArray::get(int index) const {
+    if (index < 0 || index >= size()) return nullptr;
+    return existingSlot(index)->load(std::memory_order_relaxed);
+}
+
+double ConcurrentArray::totalArea() const {
+    GEOMETRY_TRACE_SCOPE("ConcurrentArray::totalArea", size());
+    double total = 0;
+    forEach([&](int, const Figure& fig) { total += fig.area(); });
+    return total;
+}
+
+MemoryReport ConcurrentArray::memoryReport() const {
+    MemoryReport report;
+    report.containerBytes = sizeof(ConcurrentArray);
+
+    long long slots = 0;
+    for (int k = 0; k < CONCURRENT_SEGMENTS; k++) {
+        std::atomic<Figure*>* seg = segments[k].load(std::memory_order_acquire);
+        if (!seg) continue;
+        slots += (long long)segmentSlots(k);
+        report.addBlock(seg, segmentBytes(k));
+    }
+
+    int n = forEach([&](int, const Figure& fig) {
+        std::size_t size = fig.objectSize();
+        report.addObject(fig.getType(), size);
+        report.addBlock(&fig, size);
+    });
+    report.bufferUsed = (long long)n * sizeof(std::atomic<Figure*>);
+    report.bufferUnused = (slots - n) * (long long)sizeof(std::atomic<Figure*>);
+    return report;
+}
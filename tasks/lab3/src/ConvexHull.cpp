@@ -0,0 +1,157 @@
+#include "ConvexHull.h"
+#include "Orientation.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <algorithm>
+
+/**
+ * @file ConvexHull.cpp
+ * @brief Алгоритм Эндрю, параллельная сборка и потоковая оболочка
+ */
+
+// ===================================================================
+// АЛГОРИТМ ЭНДРЮ (MONOTONE CHAIN)
+// ===================================================================
+
+/*
+  После сортировки по (x, y):
+  - нижняя цепочка: идем слева направо, удаляя последнюю точку, пока
+    поворот не станет строго левым (orientation() > 0, знак точный);
+  - верхняя цепочка: то же самое справа налево.
+
+  Обе цепочки строятся как стек во временном буфере (верхняя
+  дописывается за нижней), затем результат копируется в points.
+*/
+int convexHull(Point* points, int n) {
+    GEOMETRY_TRACE_SCOPE("convexHull", n);
+    if (n < 3) {
+        // 0-2 точки: оболочка - они сами (без дубликатов)
+        if (n == 2 && points[0].x == points[1].x && points[0].y == points[1].y) return 1;
+        return n;
+    }
+
+    std::sort(points, points + n, [](const Point& a, const Point& b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+
+    Point* stack = new Point[2 * n];
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        while (k >= 2 && orientation(stack[k - 2], stack[k - 1], points[i]) <= 0) k--;
+        stack[k++] = points[i];
+    }
+    for (int i = n - 2, lower = k + 1; i >= 0; i--) {
+        while (k >= lower && orientation(stack[k - 2], stack[k - 1], points[i]) <= 0) k--;
+        stack[k++] = points[i];
+    }
+    k--;  // последняя точка совпадает с первой
+
+    // Все точки совпали: оболочка - одна точка
+    if (k == 2 && stack[0].x == stack[1].x && stack[0].y == stack[1].y) k = 1;
+    for (int i = 0; i < k; i++) points[i] = stack[i];
+    delete[] stack;
+    return k;
+}
+
+// ===================================================================
+// ОБОЛОЧКА КОЛЛЕКЦИИ
+// ===================================================================
+
+/*
+  Оболочка вершин фигур [begin, end) - записывается в out, возвращает размер.
+*/
+static int chunkHull(const Array& figures, int begin, int end, Point* out) {
+    int n = 0;
+    for (int i = begin; i < end; i++) {
+        const Point* p = figures.get(i)->getPoints();
+        for (int k = 0; k < 4; k++) out[n++] = p[k];
+    }
+    return convexHull(out, n);
+}
+
+int collectionHull(const Array& figures, Point* out, ThreadPool* pool) {
+    GEOMETRY_TRACE_SCOPE("collectionHull", figures.size());
+    if (pool == nullptr) pool = &ThreadPool::shared();
+    int n = figures.size();
+    int threadCount = pool->getThreadCount();
+    if (threadCount <= 1 || n < 2 * threadCount) return chunkHull(figures, 0, n, out);
+
+    // Каждая задача пишет вершины своего куска в свою часть out
+    // (куски не пересекаются), там же строит частичную оболочку
+    int* starts = new int[threadCount + 1];
+    int* sizes = new int[threadCount];
+    for (int t = 0; t <= threadCount; t++) starts[t] = (int)((long long)n * t / threadCount);
+
+    pool->parallelFor(0, threadCount, [&](int first, int last) {
+        for (int t = first; t < last; t++) {
+            sizes[t] = chunkHull(figures, starts[t], starts[t + 1], out + 4 * starts[t]);
+        }
+    });
+
+    // Шаг слияния: сдвигаем частичные оболочки в начало out и строим
+    // оболочку их объединения
+    int merged = 0;
+    for (int t = 0; t < threadCount; t++) {
+        const Point* part = out + 4 * starts[t];
+        for (int i = 0; i < sizes[t]; i++) out[merged++] = part[i];
+    }
+
+    delete[] sizes;
+    delete[] starts;
+    return convexHull(out, merged);
+}
+
+// ===================================================================
+// ПОТОКОВАЯ ОБОЛОЧКА
+// ===================================================================
+
+StreamingHull::StreamingHull() {
+    count = 0;
+    capacity = 16;
+    hull = new Point[capacity];
+}
+
+StreamingHull::~StreamingHull() {
+    delete[] hull;
+}
+
+/*
+  Точка внутри выпуклого многоугольника (против часовой стрелки):
+  бинарным поиском находим сектор "веера" из hull[0], в который она
+  попадает, затем проверяем сторону этого сектора. O(log h).
+*/
+bool StreamingHull::insideHull(const Point& p) const {
+    if (count < 3) return false;
+    const Point& o = hull[0];
+    if (orientation(o, hull[1], p) < 0 || orientation(o, hull[count - 1], p) > 0) return false;
+
+    int lo = 1, hi = count - 1;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (orientation(o, hull[mid], p) >= 0) lo = mid;
+        else hi = mid;
+    }
+    return orientation(hull[lo], hull[lo + 1], p) >= 0;
+}
+
+void StreamingHull::push(const Figure& fig) {
+    const Point* p = fig.getPoints();
+    bool changed = false;
+    for (int k = 0; k < 4 && !changed; k++) changed = !insideHull(p[k]);
+    if (!changed) return;
+
+    // Оболочка увеличивается не более чем на 4 вершины
+    if (count + 4 > capacity) {
+        while (count + 4 > capacity) capacity *= 2;
+        Point* grown = new Point[capacity];
+        for (int i = 0; i < count; i++) grown[i] = hull[i];
+        delete[] hull;
+        hull = grown;
+    }
+    for (int k = 0; k < 4; k++) hull[count + k] = p[k];
+    count = convexHull(hull, count + 4);
+}
+
+void StreamingHull::pushAll(const Array& figures) {
+    for (int i = 0; i < figures.size(); i++) push(*figures.get(i));
+}
@@ -1,4 +1,7 @@
 #include "Figure.h"
+#include "Intersection.h"
+#include "MemoryTracking.h"
+#include "Instrumentation.h"
 #include <cmath>
 #include <algorithm>
 
@@ -18,9 +21,11 @@
   по контуру; если вершины заданы в произвольном порядке, результат
   будет некорректен.
 
-  Алгоритм:
+  Алгоритм (orderCounterClockwise(), FigureKernels.h):
   1) Находим центр масс (среднее всех точек).
-  2) Для каждой точки вычисляем угол относительно центра: atan2(y - cy, x - cx).
+  2) Сравниваем направления из центра на точки по углу - в том же порядке,
+     что дал бы atan2(y - cy, x - cx), но через векторное произведение:
+     без тригонометрии и вычислимо при компиляции (constexpr).
   3) Сортируем точки по углу (возрастание) — получаем обход против часовой.
 
   Для n=4 используется простой O(n^2) обменный метод — читабельно и быстро.
@@ -28,38 +33,8 @@
   при валидации входных данных.
 */
 void Figure::sortPoints() {
-    // Шаг 1: центр масс (среднее)
-    double cx = 0, cy = 0;
-    for (int i = 0; i < 4; i++) {
-        cx += points[i].x;
-        cy += points[i].y;
-    }
-    cx /= 4;
-    cy /= 4;
-
-    struct PointAngle {
-        Point p;
-        double angle; // угол в радианах (-π..π)
-    };
-    PointAngle pa[4];
-
-    // Шаг 2: вычисляем углы относительно центра
-    for (int i = 0; i < 4; i++) {
-        pa[i].p = points[i];
-        pa[i].angle = atan2(points[i].y - cy, points[i].x - cx);
-    }
-
-    // Шаг 3: простая сортировка по углу (для 4 элементов приемлемо)
-    for (int i = 0; i < 4; i++) {
-        for (int j = i + 1; j < 4; j++) {
-            if (pa[i].angle > pa[j].angle) {
-                std::swap(pa[i], pa[j]);
-            }
-        }
-    }
-
-    // Копируем отсортированные точки обратно
-    for (int i = 0; i < 4; i++) points[i] = pa[i].p;
+    GEOMETRY_PROBE(Probe::SortPoints);
+    orderCounterClockwise(points);
 }
 
 // ===================================================================
@@ -75,6 +50,15 @@ void Figure::setPoints(const Point p[4]) {
     sortPoints();
 }
 
+void Figure::transform(const AffineTransform& m) {
+    transformPoints(points, 4, m);
+    if (m.determinant() < 0) {
+        // Отражение: CW -> CCW разворотом порядка
+        std::swap(points[0], points[3]);
+        std::swap(points[1], points[2]);
+    }
+}
+
 // ===================================================================
 // ПРАВИЛО ПЯТИ (конструкторы/операторы)
 // ===================================================================
@@ -124,4 +108,57 @@ bool Figure::operator==(const Figure& other) const {
         if (!found) return false;
     }
     return true;
-}
\ No newline at end of file
+}
+
+// ===================================================================
+// ГЕОМЕТРИЧЕСКИЕ ЗАПРОСЫ
+// ===================================================================
+
+BoundingBox Figure::bounds() const {
+    return vertexBounds(points, 4);
+}
+
+/*
+  Точка внутри выпуклого многоугольника с обходом против часовой стрелки,
+  если она не лежит правее ни одной из сторон. Считаем относительно
+  начала стороны (p - a), а не в абсолютных координатах: так меньше
+  потеря точности для фигур далеко от начала координат.
+*/
+bool Figure::contains(const Point& p) const {
+    for (int i = 0; i < 4; i++) {
+        const Point& a = points[i];
+        const Point& b = points[(i + 1) % 4];
+        double cross = (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+        if (cross < 0) return false;
+    }
+    return true;
+}
+
+double Figure::intersectionArea(const Figure& other) const {
+    return convexIntersectionArea(points, 4, other.points, 4);
+}
+
+// ===================================================================
+// ФОРМУЛА ГАУССА
+// ===================================================================
+
+/*
+  Для каждой пары соседних вершин (i, i+1) слагаемое xi * yi+1 - xi+1 * yi -
+  удвоенная ориентированная площадь треугольника (0, pi, pi+1).
+  Модуль суммы, деленный на 2, - площадь многоугольника.
+*/
+double Figure::polygonArea(const Point* p, int n) {
+    return shoelaceArea(p, n);
+}
+
+// ===================================================================
+// ВЫДЕЛЕНИЕ ПАМЯТИ
+// ===================================================================
+
+void* Figure::operator new(std::size_t size) {
+    return trackedAllocate(size);
+}
+
+void Figure::operator delete(void* p, std::size_t size) {
+    trackedFree(p, size);
+}
@@ -0,0 +1,249 @@
+#include "FigureIndex.h"
+#include "Trace.h"
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @file FigureIndex.cpp
+ * @brief Реализация пространственного индекса и массовых запросов точек
+ */
+
+// ===================================================================
+// ВЕКТОРНАЯ ПРОВЕРКА ТОЧКИ
+// ===================================================================
+
+/*
+  Точка p внутри выпуклой фигуры (обход против часовой стрелки), если для
+  каждой стороны cross(d, p - a) = dx * (py - ay) - dy * (px - ax) >= 0.
+
+  Все 4 стороны считаются одновременно:
+  - AVX: одна операция над 4 double;
+  - SSE2: две операции над парами double;
+  - иначе - обычный цикл.
+
+  Сравнение "не больше либо равно" (NGE) истинно и для NaN, поэтому
+  точка с NaN-координатами никогда не считается попавшей внутрь.
+*/
+template <typename Block>
+static inline bool insideEdges(const Block& e, double px, double py) {
+#if defined(__AVX__)
+    __m256d vx = _mm256_set1_pd(px);
+    __m256d vy = _mm256_set1_pd(py);
+    __m256d cross = _mm256_sub_pd(
+        _mm256_mul_pd(_mm256_load_pd(e.dx), _mm256_sub_pd(vy, _mm256_load_pd(e.ay))),
+        _mm256_mul_pd(_mm256_load_pd(e.dy), _mm256_sub_pd(vx, _mm256_load_pd(e.ax))));
+    __m256d outside = _mm256_cmp_pd(cross, _mm256_setzero_pd(), _CMP_NGE_UQ);
+    return _mm256_movemask_pd(outside) == 0;
+#elif defined(__SSE2__) || defined(_M_X64)
+    __m128d vx = _mm_set1_pd(px);
+    __m128d vy = _mm_set1_pd(py);
+    __m128d zero = _mm_setzero_pd();
+    __m128d c01 = _mm_sub_pd(
+        _mm_mul_pd(_mm_load_pd(e.dx), _mm_sub_pd(vy, _mm_load_pd(e.ay))),
+        _mm_mul_pd(_mm_load_pd(e.dy), _mm_sub_pd(vx, _mm_load_pd(e.ax))));
+    __m128d c23 = _mm_sub_pd(
+        _mm_mul_pd(_mm_load_pd(e.dx + 2), _mm_sub_pd(vy, _mm_load_pd(e.ay + 2))),
+        _mm_mul_pd(_mm_load_pd(e.dy + 2), _mm_sub_pd(vx, _mm_load_pd(e.ax + 2))));
+    __m128d outside = _mm_or_pd(_mm_cmpnge_pd(c01, zero), _mm_cmpnge_pd(c23, zero));
+    return _mm_movemask_pd(outside) == 0;
+#else
+    for (int i = 0; i < 4; i++) {
+        double cross = e.dx[i] * (py - e.ay[i]) - e.dy[i] * (px - e.ax[i]);
+        if (!(cross >= 0)) return false;
+    }
+    return true;
+#endif
+}
+
+// ===================================================================
+// ПОСТРОЕНИЕ ИНДЕКСА
+// ===================================================================
+
+FigureIndex::FigureIndex(const Array& figures) {
+    GEOMETRY_TRACE_SCOPE("FigureIndex::build", figures.size());
+    count = figures.size();
+    boxes = new BoundingBox[count > 0 ? count : 1];
+    edges = new EdgeBlock[count > 0 ? count : 1];
+    cellStart = nullptr;
+    cellItems = nullptr;
+
+    // Копируем геометрию из фигур в плоские массивы - дальше запросы
+    // не трогают объекты Figure и не делают виртуальных вызовов
+    for (int i = 0; i < count; i++) {
+        const Figure* fig = figures.get(i);
+        const Point* p = fig->getPoints();
+        boxes[i] = fig->bounds();
+        for (int k = 0; k < 4; k++) {
+            const Point& a = p[k];
+            const Point& b = p[(k + 1) % 4];
+            edges[i].ax[k] = a.x;
+            edges[i].ay[k] = a.y;
+            edges[i].dx[k] = b.x - a.x;
+            edges[i].dy[k] = b.y - a.y;
+        }
+    }
+
+    buildGrid();
+}
+
+FigureIndex::~FigureIndex() {
+    delete[] boxes;
+    delete[] edges;
+    delete[] cellStart;
+    delete[] cellItems;
+}
+
+/*
+  Равномерная сетка примерно из count ячеек с пропорциями как у extent.
+  Заполняется в два прохода (подсчет + раскладка), как сортировка
+  подсчетом: никаких перевыделений памяти.
+*/
+void FigureIndex::buildGrid() {
+    if (count == 0) {
+        extent = BoundingBox();
+        cellsX = cellsY = 1;
+        invCellW = invCellH = 1;
+        cellStart = new int[2]();
+        cellItems = new int[1];
+        return;
+    }
+
+    extent = boxes[0];
+    for (int i = 1; i < count; i++) {
+        extent.minX = std::min(extent.minX, boxes[i].minX);
+        extent.minY = std::min(extent.minY, boxes[i].minY);
+        extent.maxX = std::max(extent.maxX, boxes[i].maxX);
+        extent.maxY = std::max(extent.maxY, boxes[i].maxY);
+    }
+
+    double w = extent.maxX - extent.minX;
+    double h = extent.maxY - extent.minY;
+    if (!(w > 0)) w = 1;
+    if (!(h > 0)) h = 1;
+
+    const int maxCellsPerAxis = 4096;
+    cellsX = (int)std::sqrt((double)count * w / h);
+    cellsX = std::max(1, std::min(cellsX, maxCellsPerAxis));
+    cellsY = std::max(1, std::min(count / cellsX, maxCellsPerAxis));
+    invCellW = cellsX / w;
+    invCellH = cellsY / h;
+
+    int cells = cellsX * cellsY;
+    cellStart = new int[cells + 1]();
+
+    // Проход 1: сколько фигур попадает в каждую ячейку
+    for (int i = 0; i < count; i++) {
+        int x0 = cellX(boxes[i].minX), x1 = cellX(boxes[i].maxX);
+        int y0 = cellY(boxes[i].minY), y1 = cellY(boxes[i].maxY);
+        for (int cy = y0; cy <= y1; cy++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                cellStart[cy * cellsX + cx + 1]++;
+            }
+        }
+    }
+    for (int c = 0; c < cells; c++) cellStart[c + 1] += cellStart[c];
+
+    // Проход 2: раскладываем индексы; внутри ячейки они идут по возрастанию
+    cellItems = new int[cellStart[cells] > 0 ? cellStart[cells] : 1];
+    int* fill = new int[cells];
+    for (int c = 0; c < cells; c++) fill[c] = cellStart[c];
+    for (int i = 0; i < count; i++) {
+        int x0 = cellX(boxes[i].minX), x1 = cellX(boxes[i].maxX);
+        int y0 = cellY(boxes[i].minY), y1 = cellY(boxes[i].maxY);
+        for (int cy = y0; cy <= y1; cy++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                cellItems[fill[cy * cellsX + cx]++] = i;
+            }
+        }
+    }
+    delete[] fill;
+}
+
+/*
+  Ячейки строки сетки идут подряд, поэтому записи отрезка строки -
+  разность двух префиксных сумм cellStart.
+*/
+long long FigureIndex::cellEntriesIn(const BoundingBox& box) const {
+    if (count == 0 || !extent.intersects(box)) return 0;
+    int x0 = cellX(box.minX), x1 = cellX(box.maxX);
+    int y0 = cellY(box.minY), y1 = cellY(box.maxY);
+    long long entries = 0;
+    for (int cy = y0; cy <= y1; cy++) {
+        entries += cellStart[cy * cellsX + x1 + 1] - cellStart[cy * cellsX + x0];
+    }
+    return entries;
+}
+
+// ===================================================================
+// ЗАПРОСЫ ТОЧЕК
+// ===================================================================
+
+bool FigureIndex::contains(int figure, const Point& p) const {
+    return insideEdges(edges[figure], p.x, p.y);
+}
+
+int FigureIndex::locate(const Point& p) const {
+    if (count == 0 || !extent.contains(p)) return -1;
+    int cell = cellY(p.y) * cellsX + cellX(p.x);
+    for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+        int f = cellItems[k];
+        // Сначала дешевое отсечение по AABB, затем точная проверка
+        if (boxes[f].contains(p) && insideEdges(edges[f], p.x, p.y)) return f;
+    }
+    return -1;
+}
+
+void FigureIndex::locateAll(const Point* queries, int n, int* out) const {
+    GEOMETRY_TRACE_SCOPE("FigureIndex::locateAll", n);
+    for (int i = 0; i < n; i++) out[i] = locate(queries[i]);
+}
+
+void FigureIndex::countAll(const Point* queries, int n, int* counts) const {
+    GEOMETRY_TRACE_SCOPE("FigureIndex::countAll", n);
+    for (int i = 0; i < n; i++) {
+        const Point& p = queries[i];
+        int hits = 0;
+        if (count > 0 && extent.contains(p)) {
+            int cell = cellY(p.y) * cellsX + cellX(p.x);
+            for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                int f = cellItems[k];
+                if (boxes[f].contains(p) && insideEdges(edges[f], p.x, p.y)) hits++;
+            }
+        }
+        counts[i] = hits;
+    }
+}
+
+void FigureIndex::queryAll(const Point* queries, int n, PointHits& out) const {
+    GEOMETRY_TRACE_SCOPE("FigureIndex::queryAll", n);
+    delete[] out.offsets;
+    delete[] out.hitData;
+    out.pointTotal = n;
+    out.offsets = new int[n + 1];
+
+    // Проход 1: подсчет попаданий (сразу пишем в offsets со сдвигом на 1)
+    out.offsets[0] = 0;
+    countAll(queries, n, out.offsets + 1);
+    for (int i = 0; i < n; i++) out.offsets[i + 1] += out.offsets[i];
+
+    // Проход 2: заполнение
+    out.hitData = new int[out.offsets[n] > 0 ? out.offsets[n] : 1];
+    for (int i = 0; i < n; i++) {
+        const Point& p = queries[i];
+        if (out.offsets[i + 1] == out.offsets[i]) continue;
+        int pos = out.offsets[i];
+        int cell = cellY(p.y) * cellsX + cellX(p.x);
+        for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+            int f = cellItems[k];
+            if (boxes[f].contains(p) && insideEdges(edges[f], p.x, p.y)) {
+                out.hitData[pos++] = f;
+            }
+        }
+    }
+}
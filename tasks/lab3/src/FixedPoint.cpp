@@ -0,0 +1,244 @@
+#include "FixedPoint.h"
+#include "Trace.h"
+#include <cmath>
+#include <cstring>
+
+/**
+ * @file FixedPoint.cpp
+ * @brief Канонический вид FixedQuad, точная площадь, столбцовый набор
+ */
+
+// ===================================================================
+// ПРЕОБРАЗОВАНИЕ
+// ===================================================================
+
+/*
+  Векторное произведение (a - o) x (b - o) без переполнения:
+  разности до 2^54, произведения до 2^108.
+*/
+static FixedArea cross(long long ox, long long oy, long long ax, long long ay, long long bx, long long by) {
+    return (FixedArea)(ax - ox) * (by - oy) - (FixedArea)(ay - oy) * (bx - ox);
+}
+
+static bool toUnits(double value, double scale, long long& out) {
+    double v = value * scale;
+    if (!std::isfinite(v) || std::fabs(v) > (double)FIXED_COORD_LIMIT) return false;
+    out = std::llround(v);
+    return true;
+}
+
+/*
+  Канонический порядок:
+  1) Первая вершина - с наименьшим y (при равенстве - с наименьшим x).
+     Остальные лежат в полуплоскости над ней (угол от 0 до pi).
+  2) Остальные три сортируются по знаку векторного произведения
+     относительно первой: b раньше c, если поворот от b к c - против
+     часовой стрелки. В полуплоскости это полный порядок по углу;
+     коллинеарные (вырожденная фигура) - по расстоянию.
+  Все сравнения - точные целые, поэтому один и тот же набор вершин
+  дает один и тот же FixedQuad при любом входном порядке.
+*/
+bool toFixed(const Point p[4], double scale, FixedQuad& out) {
+    long long x[4], y[4];
+    for (int i = 0; i < 4; i++) {
+        if (!toUnits(p[i].x, scale, x[i]) || !toUnits(p[i].y, scale, y[i])) return false;
+    }
+
+    int first = 0;
+    for (int i = 1; i < 4; i++) {
+        if (y[i] < y[first] || (y[i] == y[first] && x[i] < x[first])) first = i;
+    }
+    long long ox = x[first], oy = y[first];
+
+    int rest[3];
+    int n = 0;
+    for (int i = 0; i < 4; i++) {
+        if (i != first) rest[n++] = i;
+    }
+    auto before = [&](int b, int c) {
+        FixedArea turn = cross(ox, oy, x[b], y[b], x[c], y[c]);
+        if (turn != 0) return turn > 0;
+        long long db = (x[b] - ox > 0 ? x[b] - ox : ox - x[b]) + (y[b] - oy);
+        long long dc = (x[c] - ox > 0 ? x[c] - ox : ox - x[c]) + (y[c] - oy);
+        return db < dc;
+    };
+    for (int i = 0; i < 3; i++) {
+        for (int j = i + 1; j < 3; j++) {
+            if (before(rest[j], rest[i])) {
+                int t = rest[i]; rest[i] = rest[j]; rest[j] = t;
+            }
+        }
+    }
+
+    out.x[0] = ox;
+    out.y[0] = oy;
+    for (int k = 0; k < 3; k++) {
+        out.x[k + 1] = x[rest[k]];
+        out.y[k + 1] = y[rest[k]];
+    }
+    return true;
+}
+
+bool toFixed(const Figure& fig, double scale, FixedQuad& out) {
+    return toFixed(fig.getPoints(), scale, out);
+}
+
+// ===================================================================
+// FixedQuad
+// ===================================================================
+
+/*
+  Формула Гаусса относительно первой вершины: слагаемые - векторные
+  произведения разностей, без огромных x[i] * y[i + 1].
+*/
+FixedArea FixedQuad::doubledArea() const {
+    return cross(x[0], y[0], x[1], y[1], x[2], y[2]) + cross(x[0], y[0], x[2], y[2], x[3], y[3]);
+}
+
+double FixedQuad::area(double scale) const {
+    return (double)doubledArea() / (2 * scale * scale);
+}
+
+/*
+  Перемешивание 8 координат (шаг SplitMix64 после каждой).
+*/
+static unsigned long long mix(unsigned long long h, long long v) {
+    h ^= (unsigned long long)v + 0x9E3779B97F4A7C15ull;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+unsigned long long FixedQuad::hash() const {
+    unsigned long long h = 0;
+    for (int i = 0; i < 4; i++) {
+        h = mix(h, x[i]);
+        h = mix(h, y[i]);
+    }
+    return h;
+}
+
+// ===================================================================
+// FixedQuadArray
+// ===================================================================
+
+FixedQuadArray::FixedQuadArray(double scale) : scale(scale), hashes(nullptr), kinds(nullptr), count(0), capacity(0) {
+    for (int c = 0; c < 8; c++) columns[c] = nullptr;
+}
+
+FixedQuadArray::~FixedQuadArray() {
+    for (int c = 0; c < 8; c++) delete[] columns[c];
+    delete[] hashes;
+    delete[] kinds;
+}
+
+void FixedQuadArray::grow() {
+    int next = capacity > 0 ? capacity * 2 : 64;
+    for (int c = 0; c < 8; c++) {
+        long long* column = new long long[next];
+        if (count > 0) std::memcpy(column, columns[c], count * sizeof(long long));
+        delete[] columns[c];
+        columns[c] = column;
+    }
+    unsigned long long* grownHashes = new unsigned long long[next];
+    if (count > 0) std::memcpy(grownHashes, hashes, count * sizeof(unsigned long long));
+    delete[] hashes;
+    hashes = grownHashes;
+    FigureKind* grownKinds = new FigureKind[next];
+    if (count > 0) std::memcpy(grownKinds, kinds, count * sizeof(FigureKind));
+    delete[] kinds;
+    kinds = grownKinds;
+    capacity = next;
+}
+
+bool FixedQuadArray::push(const Figure& fig) {
+    FixedQuad q;
+    if (!toFixed(fig, scale, q)) return false;
+    if (count == capacity) grow();
+    for (int i = 0; i < 4; i++) {
+        columns[i][count] = q.x[i];
+        columns[4 + i][count] = q.y[i];
+    }
+    hashes[count] = q.hash();
+    kinds[count] = figureKind(fig);
+    count++;
+    return true;
+}
+
+int FixedQuadArray::append(const Array& figures) {
+    GEOMETRY_TRACE_SCOPE("FixedQuadArray::append", figures.size());
+    int added = 0;
+    for (int i = 0; i < figures.size(); i++) added += push(*figures.get(i));
+    return added;
+}
+
+FixedQuad FixedQuadArray::get(int index) const {
+    FixedQuad q;
+    for (int i = 0; i < 4; i++) {
+        q.x[i] = columns[i][index];
+        q.y[i] = columns[4 + i][index];
+    }
+    return q;
+}
+
+/*
+  Первый проход - только столбец хешей (8 байт на фигуру вместо 64):
+  сравнение без ветвлений, цикл векторизуется. Совпавшие хеши
+  (ключ и редкие коллизии) проверяются по всем 8 координатам.
+*/
+int FixedQuadArray::findEqual(const FixedQuad& key, unsigned char* equal) const {
+    const unsigned long long* hash = hashes;
+    unsigned long long h = key.hash();
+    int candidates = 0;
+    for (int i = 0; i < count; i++) {
+        int same = hash[i] == h;
+        equal[i] = (unsigned char)same;
+        candidates += same;
+    }
+    if (candidates == 0) return 0;
+
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        if (equal[i]) {
+            equal[i] = get(i) == key;
+            found += equal[i];
+        }
+    }
+    return found;
+}
+
+int FixedQuadArray::markDuplicates(bool* duplicate) const {
+    GEOMETRY_TRACE_SCOPE("FixedQuadArray::markDuplicates", count);
+    int slots = 16;
+    while (slots < 2 * count) slots *= 2;
+    int* table = new int[slots];   // номер фигуры + 1; 0 - свободно
+    std::memset(table, 0, slots * sizeof(int));
+
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        FixedQuad q = get(i);
+        int slot = (int)(hashes[i] & (unsigned long long)(slots - 1));
+        duplicate[i] = false;
+        while (table[slot] != 0) {
+            int other = table[slot] - 1;
+            if (hashes[other] == hashes[i] && get(other) == q) {
+                duplicate[i] = true;
+                break;
+            }
+            slot = (slot + 1) & (slots - 1);
+        }
+        if (duplicate[i]) {
+            found++;
+        } else {
+            table[slot] = i + 1;
+        }
+    }
+    delete[] table;
+    return found;
+}
+
+double FixedQuadArray::totalArea() const {
+    FixedArea sum = 0;
+    for (int i = 0; i < count; i++) sum += get(i).doubledArea();
+    return (double)sum / (2 * scale * scale);
+}
@@ -0,0 +1,236 @@
+#include "Generator.h"
+#include "Codec.h"
+#include "Trace.h"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * @file Generator.cpp
+ * @brief Генератор на счетчике (фигура = функция от номера), параллельное
+ *        форматирование блоков, запись по порядку
+ */
+
+// ===================================================================
+// СЛУЧАЙНЫЕ ЧИСЛА
+// ===================================================================
+
+/*
+  SplitMix64: состояние - один счетчик, поэтому генератор для фигуры
+  с номером index создается сразу, без прогона предыдущих чисел.
+*/
+struct SplitMix {
+    std::uint64_t state;
+
+    SplitMix(std::uint64_t seed, std::uint64_t index, std::uint64_t stream)
+        : state(seed ^ (index + 1) * 0x9E3779B97F4A7C15ull ^ stream * 0xD1B54A32D192ED03ull) {
+        next();
+    }
+
+    std::uint64_t next() {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    /*
+      Равномерно в [0, 1)
+    */
+    double uniform() { return (double)(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    double uniform(double lo, double hi) { return lo + (hi - lo) * uniform(); }
+};
+
+static const std::uint64_t STREAM_SHAPE = 1;
+static const std::uint64_t STREAM_ORDER = 2;
+
+// ===================================================================
+// ФИГУРЫ
+// ===================================================================
+
+/*
+  Фигура source без перестановки вершин: вершины по порядку обхода.
+*/
+static void shapeOf(long long source, long long count, const GeneratorOptions& options,
+                    FigureKind& kind, Point p[4]) {
+    SplitMix rng(options.seed, source, STREAM_SHAPE);
+    rng.next();   // решение о повторе (см. generateRecord)
+    rng.next();
+
+    kind = (FigureKind)(rng.next() % 3);
+    double cx = rng.uniform(-options.scale, options.scale);
+    double cy = rng.uniform(-options.scale, options.scale);
+
+    double field = 4 * options.scale * options.scale;
+    double meanArea = options.overlap * field / (double)(count > 0 ? count : 1);
+    double size = std::sqrt(meanArea) * rng.uniform(0.5, 1.5);
+    double aspect = std::exp(rng.uniform(-std::log(4.0), std::log(4.0)));
+
+    double local[4][2];
+    if (kind == FigureKind::Square) {
+        double h = size / 2;
+        double sq[4][2] = {{-h, -h}, {h, -h}, {h, h}, {-h, h}};
+        std::memcpy(local, sq, sizeof(local));
+    } else if (kind == FigureKind::Rectangle) {
+        double w = size * std::sqrt(aspect) / 2, h = size / std::sqrt(aspect) / 2;
+        double rc[4][2] = {{-w, -h}, {w, -h}, {w, h}, {-w, h}};
+        std::memcpy(local, rc, sizeof(local));
+    } else {
+        // Верхнее основание короче нижнего: не параллелограмм
+        double b = size * std::sqrt(aspect) / 2, h = size / std::sqrt(aspect) / 2;
+        double t = b * rng.uniform(0.2, 0.8);
+        double shift = (b - t) * rng.uniform(-0.5, 0.5);
+        double tr[4][2] = {{-b, -h}, {b, -h}, {shift + t, h}, {shift - t, h}};
+        std::memcpy(local, tr, sizeof(local));
+    }
+
+    double cs = 1, sn = 0;
+    if (options.rotate) {
+        double a = rng.uniform(0, 6.283185307179586);
+        cs = std::cos(a);
+        sn = std::sin(a);
+    }
+    for (int k = 0; k < 4; k++) {
+        p[k] = Point(cx + cs * local[k][0] - sn * local[k][1], cy + sn * local[k][0] + cs * local[k][1]);
+    }
+}
+
+void generateRecord(long long index, long long count, const GeneratorOptions& options,
+                    FigureKind& kind, double* record) {
+    // Повтор ссылается на фигуру с меньшим номером; если и она
+    // повтор - дальше по цепочке (в среднем 1 / (1 - duplicateRatio) шагов)
+    long long source = index;
+    while (source > 0) {
+        SplitMix rng(options.seed, source, STREAM_SHAPE);
+        if (rng.uniform() >= options.duplicateRatio) break;
+        source = (long long)(rng.next() % (std::uint64_t)source);
+    }
+
+    Point p[4];
+    shapeOf(source, count, options, kind, p);
+
+    // Порядок вершин - свой у каждой фигуры, в том числе у повтора
+    SplitMix order(options.seed, index, STREAM_ORDER);
+    for (int k = 3; k > 0; k--) {
+        int j = (int)(order.next() % (std::uint64_t)(k + 1));
+        Point t = p[k];
+        p[k] = p[j];
+        p[j] = t;
+    }
+    for (int k = 0; k < 4; k++) {
+        record[2 * k] = p[k].x;
+        record[2 * k + 1] = p[k].y;
+    }
+}
+
+// ===================================================================
+// БЛОКИ
+// ===================================================================
+
+/*
+  Выходные байты одного блока; буфер переиспользуется между волнами.
+*/
+struct GeneratorBlock {
+    char* data = nullptr;
+    long long bytes = 0;
+    long long capacity = 0;
+
+    void reserve(long long n) {
+        if (n <= capacity) return;
+        long long grown = capacity > 0 ? capacity : 1 << 16;
+        while (grown < n) grown *= 2;
+        char* next = new char[grown];
+        if (bytes > 0) std::memcpy(next, data, bytes);
+        delete[] data;
+        data = next;
+        capacity = grown;
+    }
+};
+
+static void renderText(GeneratorBlock& block, long long first, int n, long long count,
+                       const GeneratorOptions& options) {
+    // Тип + 8 чисел по 24 символа максимум + пробелы и '\n'
+    const int maxLine = 16 + 8 * 25 + 1;
+    double r[8];
+    FigureKind kind;
+    for (int i = 0; i < n; i++) {
+        block.reserve(block.bytes + maxLine);
+        generateRecord(first + i, count, options, kind, r);
+        char* p = block.data + block.bytes;
+        char* end = block.data + block.capacity;
+        const char* name = kindName(kind);
+        int len = (int)std::strlen(name);
+        std::memcpy(p, name, len);
+        p += len;
+        for (int k = 0; k < 8; k++) {
+            *p++ = ' ';
+            p = std::to_chars(p, end, r[k]).ptr;
+        }
+        *p++ = '\n';
+        block.bytes = p - block.data;
+    }
+}
+
+static void renderCodec(GeneratorBlock& block, long long first, int n, long long count,
+                        const GeneratorOptions& options) {
+    Array figures;
+    double r[8];
+    FigureKind kind;
+    for (int i = 0; i < n; i++) {
+        generateRecord(first + i, count, options, kind, r);
+        Point p[4] = {Point(r[0], r[1]), Point(r[2], r[3]), Point(r[4], r[5]), Point(r[6], r[7])};
+        figures.push(createFigure(kind, p));
+    }
+    block.reserve(4 + encodedSizeBound(n));
+    std::uint32_t size = (std::uint32_t)encodeFigures(figures, (unsigned char*)block.data + 4);
+    std::memcpy(block.data, &size, 4);
+    block.bytes = 4 + size;
+}
+
+// ===================================================================
+// ЗАПИСЬ
+// ===================================================================
+
+long long generateFigures(const char* path, StreamFormat format, long long count,
+                          const GeneratorOptions& options, ThreadPool* pool) {
+    GEOMETRY_TRACE_SCOPE("generateFigures", (int)(count < 0x7FFFFFFF ? count : 0x7FFFFFFF));
+    ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+    std::FILE* file = std::fopen(path, "wb");
+    if (!file) return -1;
+
+    // Волна - по 4 блока на поток: параллельно генерируются, затем
+    // пишутся по порядку. Память - wave буферов, а не весь файл
+    long long blocks = (count + GENERATOR_BLOCK - 1) / GENERATOR_BLOCK;
+    int wave = 4 * workers.getThreadCount();
+    GeneratorBlock* buffers = new GeneratorBlock[wave];
+    long long written = 0;
+    bool ok = true;
+
+    for (long long base = 0; base < blocks && ok; base += wave) {
+        int inWave = (int)(blocks - base < wave ? blocks - base : wave);
+        workers.parallelFor(0, inWave, [&](int begin, int end) {
+            for (int b = begin; b < end; b++) {
+                long long first = (base + b) * GENERATOR_BLOCK;
+                int n = (int)(count - first < GENERATOR_BLOCK ? count - first : GENERATOR_BLOCK);
+                buffers[b].bytes = 0;
+                if (format == StreamFormat::Text) {
+                    renderText(buffers[b], first, n, count, options);
+                } else {
+                    renderCodec(buffers[b], first, n, count, options);
+                }
+            }
+        });
+        for (int b = 0; b < inWave && ok; b++) {
+            ok = std::fwrite(buffers[b].data, 1, buffers[b].bytes, file) == (std::size_t)buffers[b].bytes;
+            written += buffers[b].bytes;
+        }
+    }
+
+    for (int b = 0; b < wave; b++) delete[] buffers[b].data;
+    delete[] buffers;
+    ok = std::fclose(file) == 0 && ok;
+    return ok ? written : -1;
+}
@@ -0,0 +1,376 @@
+#include "Ingest.h"
+#include "BoundedQueue.h"
+#include "Trace.h"
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @file Ingest.cpp
+ * @brief Стадии конвейера загрузки, очереди пакетов и отчет
+ */
+
+// ===================================================================
+// ПАКЕТЫ И ЗАМЕРЫ
+// ===================================================================
+
+/*
+  Пакет проходит все стадии целиком; каждая стадия заполняет свои поля.
+*/
+struct IngestBatch {
+    long long sequence;                       ///< Номер пакета во входе
+    int count;
+    double records[8 * INGEST_BATCH_SIZE];    ///< Parse: 8 чисел на запись
+    FigureKind declared[INGEST_BATCH_SIZE];   ///< Parse: тип из строки
+    FigureKind kinds[INGEST_BATCH_SIZE];      ///< Validate: Rejected - запись отброшена
+    Figure* figures[INGEST_BATCH_SIZE];       ///< Order: nullptr для отброшенных
+};
+
+typedef BoundedQueue<IngestBatch*> BatchQueue;
+
+static long long nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+  Обертки очередей: время внутри push()/pop() - ожидание стадии.
+*/
+static bool timedPop(BatchQueue& queue, IngestBatch*& batch, IngestStageStats& stats) {
+    long long start = nowNs();
+    bool ok = queue.pop(batch);
+    stats.waitInNs += nowNs() - start;
+    return ok;
+}
+
+static void timedPush(BatchQueue& queue, IngestBatch* batch, IngestStageStats& stats) {
+    long long start = nowNs();
+    queue.push(batch);
+    stats.waitOutNs += nowNs() - start;
+}
+
+const char* stageName(IngestStage stage) {
+    switch (stage) {
+        case IngestStage::Parse: return "parse";
+        case IngestStage::Validate: return "validate";
+        case IngestStage::Order: return "order";
+        default: return "store";
+    }
+}
+
+double IngestStageStats::itemsPerSecond() const {
+    if (busyNs <= 0) return 0;
+    return (double)items * threads / (busyNs * 1e-9);
+}
+
+// ===================================================================
+// СТАДИЯ PARSE
+// ===================================================================
+
+bool parseFigureLine(const char* s, FigureKind& kind, double* record) {
+    while (std::isspace((unsigned char)*s)) s++;
+    const char* nameEnd = s;
+    while (*nameEnd && !std::isspace((unsigned char)*nameEnd)) nameEnd++;
+
+    int k = 0;
+    for (; k < (int)FigureKind::Rejected; k++) {
+        const char* name = kindName((FigureKind)k);
+        int len = (int)std::char_traits<char>::length(name);
+        if (nameEnd - s == len && std::char_traits<char>::compare(s, name, len) == 0) break;
+    }
+    if (k == (int)FigureKind::Rejected) return false;
+    kind = (FigureKind)k;
+
+    s = nameEnd;
+    for (int i = 0; i < 8; i++) {
+        char* end = nullptr;
+        record[i] = std::strtod(s, &end);
+        if (end == s) return false;
+        s = end;
+    }
+    while (std::isspace((unsigned char)*s)) s++;
+    return *s == '\0';
+}
+
+static bool isBlank(const std::string& line) {
+    for (char c : line) {
+        if (!std::isspace((unsigned char)c)) return false;
+    }
+    return true;
+}
+
+static void parseStage(std::istream& in, BatchQueue& output, IngestStageStats& stats,
+                       int& lines, int& malformed) {
+    GEOMETRY_TRACE_SCOPE("ingest.parse");
+    stats.threads = 1;
+    std::string line;
+    long long sequence = 0;
+    bool more = true;
+
+    while (more) {
+        long long start = nowNs();
+        IngestBatch* batch = new IngestBatch;
+        batch->sequence = sequence++;
+        batch->count = 0;
+        while (batch->count < INGEST_BATCH_SIZE) {
+            if (!std::getline(in, line)) {
+                more = false;
+                break;
+            }
+            if (isBlank(line)) continue;
+            lines++;
+            int j = batch->count;
+            if (parseFigureLine(line.c_str(), batch->declared[j], batch->records + 8 * j)) batch->count++;
+            else malformed++;
+        }
+        stats.items += batch->count;
+        stats.busyNs += nowNs() - start;
+
+        if (batch->count == 0) delete batch;
+        else timedPush(output, batch, stats);
+    }
+    output.close();
+}
+
+// ===================================================================
+// СТАДИЯ VALIDATE
+// ===================================================================
+
+/*
+  Заявленный тип должен быть не строже найденного: порядок FigureKind -
+  от частного к общему (Square -> Rectangle -> Trapezoid).
+*/
+static void validateStage(BatchQueue& input, BatchQueue& output, IngestStageStats& stats,
+                          ClassifyStats& classify, int& mismatched, double tolerance) {
+    GEOMETRY_TRACE_SCOPE("ingest.validate");
+    stats.threads = 1;
+    IngestBatch* batch = nullptr;
+    while (timedPop(input, batch, stats)) {
+        long long start = nowNs();
+        classifyRecords(batch->records, batch->count, batch->kinds, nullptr, &classify, tolerance);
+        for (int j = 0; j < batch->count; j++) {
+            if (batch->kinds[j] == FigureKind::Rejected) continue;
+            if ((int)batch->kinds[j] > (int)batch->declared[j]) {
+                batch->kinds[j] = FigureKind::Rejected;
+                mismatched++;
+            }
+        }
+        stats.items += batch->count;
+        stats.busyNs += nowNs() - start;
+        timedPush(output, batch, stats);
+    }
+    output.close();
+}
+
+// ===================================================================
+// ОКНО ПОРЯДКА
+// ===================================================================
+
+/*
+  Окно номеров пакетов, которые Store может принять: [next, next + size).
+  Поток Order с пакетом за окном ждет, пока Store не продвинет next, -
+  иначе один медленный поток Order дал бы остальным уйти вперед без
+  ограничения, а Store копил бы их пакеты.
+
+  Взаимоблокировки нет: Validate и Order забирают пакеты из очередей
+  по порядку, поэтому пакет next уже у какого-то потока Order, и он
+  в окне - этот поток не ждет.
+*/
+struct ReorderWindow {
+    std::mutex lock;
+    std::condition_variable advanced;
+    long long next;
+    int size;
+
+    explicit ReorderWindow(int size) : next(0), size(size) {}
+
+    void waitFor(long long sequence) {
+        std::unique_lock<std::mutex> guard(lock);
+        while (sequence >= next + size) advanced.wait(guard);
+    }
+
+    void advance(long long to) {
+        std::lock_guard<std::mutex> guard(lock);
+        next = to;
+        advanced.notify_all();
+    }
+};
+
+// ===================================================================
+// СТАДИЯ ORDER
+// ===================================================================
+
+/*
+  Фигура создается заявленного типа; конструктор упорядочивает вершины.
+  Ожидание окна учитывается как ожидание выхода (обратное давление Store).
+*/
+static void orderStage(BatchQueue& input, BatchQueue& output, ReorderWindow& window,
+                       void (*hook)(long long), IngestStageStats& stats) {
+    GEOMETRY_TRACE_SCOPE("ingest.order");
+    IngestBatch* batch = nullptr;
+    while (timedPop(input, batch, stats)) {
+        if (hook) hook(batch->sequence);
+        long long start = nowNs();
+        for (int j = 0; j < batch->count; j++) {
+            batch->figures[j] = nullptr;
+            if (batch->kinds[j] == FigureKind::Rejected) continue;
+            const double* r = batch->records + 8 * j;
+            Point p[4] = {Point(r[0], r[1]), Point(r[2], r[3]), Point(r[4], r[5]), Point(r[6], r[7])};
+            batch->figures[j] = createFigure(batch->declared[j], p);
+        }
+        stats.items += batch->count;
+        stats.busyNs += nowNs() - start;
+
+        long long waitStart = nowNs();
+        window.waitFor(batch->sequence);
+        stats.waitOutNs += nowNs() - waitStart;
+        timedPush(output, batch, stats);
+    }
+}
+
+// ===================================================================
+// СТАДИЯ STORE
+// ===================================================================
+
+/*
+  При нескольких потоках Order пакеты приходят не по порядку:
+  пришедшие раньше времени ждут в кольце waiting на месте
+  sequence % window.size, пока не придет пакет с номером next.
+  Номера пришедших лежат в [next, next + window.size) (их держит
+  ReorderWindow), поэтому места не пересекаются и поиск не нужен.
+*/
+static int storeStage(BatchQueue& input, Array& out, ReorderWindow& window, IngestStageStats& stats,
+                      int& maxReordered) {
+    GEOMETRY_TRACE_SCOPE("ingest.store");
+    stats.threads = 1;
+    IngestBatch** waiting = new IngestBatch*[window.size]();
+    int waitingCount = 0;
+    long long next = 0;
+    int stored = 0;
+
+    IngestBatch* batch = nullptr;
+    while (timedPop(input, batch, stats)) {
+        long long start = nowNs();
+        waiting[batch->sequence % window.size] = batch;
+        waitingCount++;
+        if (waitingCount > maxReordered) maxReordered = waitingCount;
+
+        long long before = next;
+        int slot = (int)(next % window.size);
+        while (waiting[slot] != nullptr) {
+            IngestBatch* ready = waiting[slot];
+            for (int j = 0; j < ready->count; j++) {
+                if (ready->figures[j] == nullptr) continue;
+                out.push(ready->figures[j]);
+                stored++;
+            }
+            stats.items += ready->count;
+            waiting[slot] = nullptr;
+            waitingCount--;
+            delete ready;
+            next++;
+            slot = (int)(next % window.size);
+        }
+        if (next != before) window.advance(next);
+        stats.busyNs += nowNs() - start;
+    }
+    delete[] waiting;
+    return stored;
+}
+
+// ===================================================================
+// КОНВЕЙЕР
+// ===================================================================
+
+int ingestFigures(std::istream& in, Array& out, IngestReport* report, const IngestOptions& options) {
+    GEOMETRY_TRACE_SCOPE("ingestFigures");
+    long long start = nowNs();
+    int orderThreads = options.orderThreads > 0 ? options.orderThreads : 1;
+
+    BatchQueue parsed(options.queueCapacity);
+    BatchQueue validated(options.queueCapacity);
+    BatchQueue ordered(options.queueCapacity);
+    ReorderWindow window(ordered.getCapacity() + orderThreads);
+
+    IngestReport local;
+    IngestReport& r = report ? *report : local;
+    r = IngestReport();
+
+    std::thread parser([&]() {
+        parseStage(in, parsed, r.stages[(int)IngestStage::Parse], r.lines, r.malformed);
+    });
+    std::thread validator([&]() {
+        validateStage(parsed, validated, r.stages[(int)IngestStage::Validate],
+                      r.classify, r.mismatched, options.tolerance);
+    });
+
+    // Выходную очередь закрывает последний завершившийся поток Order
+    IngestStageStats* orderStats = new IngestStageStats[orderThreads];
+    std::atomic<int> running(orderThreads);
+    std::thread* orderers = new std::thread[orderThreads];
+    for (int t = 0; t < orderThreads; t++) {
+        orderers[t] = std::thread([&, t]() {
+            orderStage(validated, ordered, window, options.orderHook, orderStats[t]);
+            if (running.fetch_sub(1) == 1) ordered.close();
+        });
+    }
+
+    r.stored = storeStage(ordered, out, window, r.stages[(int)IngestStage::Store], r.maxReordered);
+
+    parser.join();
+    validator.join();
+    IngestStageStats& order = r.stages[(int)IngestStage::Order];
+    order.threads = orderThreads;
+    for (int t = 0; t < orderThreads; t++) {
+        orderers[t].join();
+        order.items += orderStats[t].items;
+        order.busyNs += orderStats[t].busyNs;
+        order.waitInNs += orderStats[t].waitInNs;
+        order.waitOutNs += orderStats[t].waitOutNs;
+    }
+    delete[] orderers;
+    delete[] orderStats;
+
+    r.wallNs = nowNs() - start;
+    return r.stored;
+}
+
+// ===================================================================
+// ОТЧЕТ
+// ===================================================================
+
+IngestStage IngestReport::bottleneck() const {
+    int slowest = 0;
+    for (int s = 1; s < INGEST_STAGE_COUNT; s++) {
+        if (stages[s].itemsPerSecond() < stages[slowest].itemsPerSecond()) slowest = s;
+    }
+    return (IngestStage)slowest;
+}
+
+void IngestReport::print(std::ostream& os) const {
+    os << std::left << std::setw(10) << "stage" << std::right
+       << std::setw(8) << "threads" << std::setw(10) << "items"
+       << std::setw(12) << "busy ms" << std::setw(12) << "wait in ms"
+       << std::setw(13) << "wait out ms" << std::setw(14) << "items/s" << std::endl;
+    for (int s = 0; s < INGEST_STAGE_COUNT; s++) {
+        const IngestStageStats& st = stages[s];
+        os << std::left << std::setw(10) << stageName((IngestStage)s) << std::right
+           << std::setw(8) << st.threads << std::setw(10) << st.items
+           << std::fixed << std::setprecision(2)
+           << std::setw(12) << st.busyNs * 1e-6 << std::setw(12) << st.waitInNs * 1e-6
+           << std::setw(13) << st.waitOutNs * 1e-6
+           << std::setprecision(0) << std::setw(14) << st.itemsPerSecond()
+           << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+    os << "bottleneck: " << stageName(bottleneck()) << std::endl;
+    os << "lines: " << lines << ", malformed: " << malformed
+       << ", mismatched: " << mismatched << ", stored: " << stored
+       << ", max reordered: " << maxReordered << std::endl;
+    classify.print(os);
+}
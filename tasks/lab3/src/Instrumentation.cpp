@@ -0,0 +1,147 @@
+#include "Instrumentation.h"
+#include <cstdio>
+
+/**
+ * @file Instrumentation.cpp
+ * @brief Гистограммы задержек и отчет по ним
+ */
+
+const char* probeName(Probe probe) {
+    switch (probe) {
+        case Probe::ArrayPush: return "Array::push";
+        case Probe::ArrayRemove: return "Array::remove";
+        case Probe::ArrayResize: return "Array::resize";
+        case Probe::TotalArea: return "Array::totalArea";
+        case Probe::SortPoints: return "Figure::sortPoints";
+        case Probe::Read: return "Figure::read";
+        default: return "Figure::print";
+    }
+}
+
+// ===================================================================
+// ГИСТОГРАММА
+// ===================================================================
+
+static int highestBit(unsigned long long value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) bit++;
+    return bit;
+#endif
+}
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+/*
+  Значение v >= 32 со старшим битом m записывается как sub * 2^(m-4),
+  где sub = v >> (m-4) - старшие 5 бит, от 16 до 31. Номер корзины
+  (m-4) * 16 + sub: степени двойки идут подряд по 16 корзин,
+  и значения 0..31 попадают в корзины 0..31 без округления.
+*/
+int LatencyHistogram::bucketOf(unsigned long long value) {
+    if (value < 2 * SUB_BUCKETS) return (int)value;
+    int shift = highestBit(value) - 4;
+    return shift * SUB_BUCKETS + (int)(value >> shift);
+}
+
+unsigned long long LatencyHistogram::bucketUpper(int bucket) {
+    if (bucket < 2 * SUB_BUCKETS) return (unsigned long long)bucket;
+    int shift = bucket / SUB_BUCKETS - 1;
+    unsigned long long sub = (unsigned long long)(bucket % SUB_BUCKETS + SUB_BUCKETS);
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(unsigned long long value) {
+    buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    unsigned long long seen = minValue.load(std::memory_order_relaxed);
+    while (value < seen && !minValue.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    seen = maxValue.load(std::memory_order_relaxed);
+    while (value > seen && !maxValue.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset() {
+    for (int i = 0; i < BUCKET_COUNT; i++) buckets[i].store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    minValue.store(~0ULL, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+unsigned long long LatencyHistogram::min() const {
+    return count() == 0 ? 0 : minValue.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    unsigned long long n = count();
+    return n == 0 ? 0.0 : (double)totalValue() / (double)n;
+}
+
+unsigned long long LatencyHistogram::percentile(double q) const {
+    unsigned long long n = count();
+    if (n == 0) return 0;
+    if (q < 0) q = 0;
+    if (q > 1) q = 1;
+
+    // Ранг искомого значения (1..n)
+    unsigned long long rank = (unsigned long long)(q * (double)n + 0.5);
+    if (rank < 1) rank = 1;
+
+    unsigned long long seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            unsigned long long upper = bucketUpper(i);
+            return upper < max() ? upper : max();
+        }
+    }
+    return max();
+}
+
+// ===================================================================
+// ГИСТОГРАММЫ ОПЕРАЦИЙ
+// ===================================================================
+
+/*
+  Статический массив внутри функции: инициализируется при первом
+  обращении, поэтому замеры корректны и в конструкторах глобальных
+  объектов других единиц трансляции.
+*/
+LatencyHistogram& probeHistogram(Probe probe) {
+    static LatencyHistogram histograms[PROBE_COUNT];
+    return histograms[(int)probe];
+}
+
+void resetInstrumentation() {
+    for (int p = 0; p < PROBE_COUNT; p++) probeHistogram((Probe)p).reset();
+}
+
+void dumpInstrumentation(std::ostream& os) {
+    if (!instrumentationEnabled()) {
+        os << "Инструментирование отключено. Соберите с -DGEOMETRY_INSTRUMENTATION=ON" << std::endl;
+        return;
+    }
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-20s %10s %10s %10s %10s %10s %10s\n",
+                  "operation", "count", "mean ns", "p50 ns", "p90 ns", "p99 ns", "max ns");
+    os << line;
+
+    bool any = false;
+    for (int p = 0; p < PROBE_COUNT; p++) {
+        const LatencyHistogram& h = probeHistogram((Probe)p);
+        if (h.count() == 0) continue;
+        any = true;
+        std::snprintf(line, sizeof(line), "%-20s %10llu %10.1f %10llu %10llu %10llu %10llu\n",
+                      probeName((Probe)p), h.count(), h.mean(), h.percentile(0.5),
+                      h.percentile(0.9), h.percentile(0.99), h.max());
+        os << line;
+    }
+    if (!any) os << "(замеров пока нет)" << std::endl;
+}
@@ -0,0 +1,116 @@
+#include "Intersection.h"
+#include "FigureIndex.h"
+#include "Trace.h"
+#include <algorithm>
+
+/**
+ * @file Intersection.cpp
+ * @brief Отсечение выпуклых многоугольников и поиск пересекающихся пар
+ */
+
+// ===================================================================
+// ОТСЕЧЕНИЕ (SUTHERLAND-HODGMAN)
+// ===================================================================
+
+/*
+  Для каждой стороны (c, d) многоугольника clip оставляем часть текущего
+  многоугольника, лежащую слева от прямой cd (cross >= 0).
+
+  Проходим по сторонам (P, Q) текущего многоугольника:
+  - P внутри          -> P остается;
+  - P и Q по разные стороны -> добавляем точку пересечения PQ с прямой.
+
+  Промежуточные многоугольники хранятся в двух буферах на стеке,
+  которые меняются ролями после каждой стороны.
+*/
+int clipConvexPolygon(const Point* subject, int n, const Point* clip, int m, Point* out) {
+    Point bufA[MAX_CLIP_VERTICES];
+    Point bufB[MAX_CLIP_VERTICES];
+    Point* cur = bufA;
+    Point* next = bufB;
+    int curCount = n;
+    for (int i = 0; i < n; i++) cur[i] = subject[i];
+
+    for (int e = 0; e < m && curCount >= 3; e++) {
+        const Point& c = clip[e];
+        const Point& d = clip[(e + 1) % m];
+        double ex = d.x - c.x, ey = d.y - c.y;
+
+        int nextCount = 0;
+        for (int i = 0; i < curCount; i++) {
+            const Point& P = cur[i];
+            const Point& Q = cur[(i + 1) % curCount];
+            double sp = ex * (P.y - c.y) - ey * (P.x - c.x);
+            double sq = ex * (Q.y - c.y) - ey * (Q.x - c.x);
+
+            if (sp >= 0) next[nextCount++] = P;
+            if ((sp >= 0) != (sq >= 0)) {
+                double t = sp / (sp - sq);
+                next[nextCount++] = Point(P.x + (Q.x - P.x) * t, P.y + (Q.y - P.y) * t);
+            }
+        }
+        std::swap(cur, next);
+        curCount = nextCount;
+    }
+
+    if (curCount < 3) return 0;
+    for (int i = 0; i < curCount; i++) out[i] = cur[i];
+    return curCount;
+}
+
+/*
+  Вычисляет AABB многоугольника (для быстрого отказа).
+*/
+static BoundingBox polygonBounds(const Point* p, int n) {
+    BoundingBox box(p[0].x, p[0].y, p[0].x, p[0].y);
+    for (int i = 1; i < n; i++) {
+        box.minX = std::min(box.minX, p[i].x);
+        box.minY = std::min(box.minY, p[i].y);
+        box.maxX = std::max(box.maxX, p[i].x);
+        box.maxY = std::max(box.maxY, p[i].y);
+    }
+    return box;
+}
+
+double convexIntersectionArea(const Point* a, int na, const Point* b, int nb) {
+    if (!polygonBounds(a, na).intersects(polygonBounds(b, nb))) return 0;
+
+    Point poly[MAX_CLIP_VERTICES];
+    int count = clipConvexPolygon(a, na, b, nb, poly);
+    if (count < 3) return 0;
+    return Figure::polygonArea(poly, count);
+}
+
+// ===================================================================
+// ПАКЕТНЫЙ РАСЧЕТ
+// ===================================================================
+
+void intersectionAreas(const Array& figures, const int* first, const int* second,
+                       int n, double* out) {
+    GEOMETRY_TRACE_SCOPE("intersectionAreas", n);
+    for (int i = 0; i < n; i++) {
+        const Figure* a = figures.get(first[i]);
+        const Figure* b = figures.get(second[i]);
+        out[i] = (a && b) ? a->intersectionArea(*b) : 0;
+    }
+}
+
+// ===================================================================
+// ВСЕ ПАРЫ
+// ===================================================================
+
+void findOverlaps(const Array& figures, OverlapList& out) {
+    GEOMETRY_TRACE_SCOPE("findOverlaps", figures.size());
+    out.clear();
+    FigureIndex index(figures);
+
+    for (int i = 0; i < index.size(); i++) {
+        const Point* a = figures.get(i)->getPoints();
+        index.forEachCandidate(index.bounds(i), [&](int j) {
+            // Каждая пара рассматривается один раз: со стороны меньшего индекса
+            if (j <= i) return;
+            double area = convexIntersectionArea(a, 4, figures.get(j)->getPoints(), 4);
+            if (area > 0) out.push(Overlap{i, j, area});
+        });
+    }
+}
@@ -0,0 +1,471 @@
+#include "Journal.h"
+#include "Classifier.h"
+#include "Trace.h"
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @file Journal.cpp
+ * @brief Формат снимка и журнала, групповая фиксация, восстановление
+ */
+
+// ===================================================================
+// ФОРМАТ ФАЙЛОВ
+// ===================================================================
+
+/*
+  Снимок:  "GSNP" | u32 версия | u64 поколение | u32 фигур
+           | фигуры (u8 тип, 8 double) | u32 CRC всего предыдущего
+  Журнал:  "GWAL" | u32 версия | u64 поколение | u32 CRC заголовка
+           | записи: u8 операция | данные | u32 CRC операции и данных
+*/
+static const std::uint32_t FORMAT_VERSION = 1;
+static const int SNAPSHOT_HEADER = 20;
+static const int JOURNAL_HEADER = 20;
+static const int FIGURE_RECORD = 1 + 8 * sizeof(double);
+
+static const unsigned char OP_PUSH = 1;
+static const unsigned char OP_REMOVE = 2;
+
+static std::uint32_t crc32(const unsigned char* data, std::size_t n) {
+    static std::uint32_t table[256];
+    static bool ready = [] {
+        for (std::uint32_t i = 0; i < 256; i++) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)ready;
+
+    std::uint32_t crc = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < n; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template <typename T>
+static void put(unsigned char* out, T value) {
+    std::memcpy(out, &value, sizeof(T));
+}
+
+template <typename T>
+static T get(const unsigned char* in) {
+    T value;
+    std::memcpy(&value, in, sizeof(T));
+    return value;
+}
+
+/*
+  Фигура как запись: тип и вершины в порядке getPoints(). При загрузке
+  конструктор упорядочивает их заново и получает тот же порядок.
+*/
+static void putFigure(unsigned char* out, FigureKind kind, const Figure& fig) {
+    out[0] = (unsigned char)kind;
+    const Point* p = fig.getPoints();
+    for (int k = 0; k < 4; k++) {
+        put<double>(out + 1 + 16 * k, p[k].x);
+        put<double>(out + 9 + 16 * k, p[k].y);
+    }
+}
+
+static Figure* getFigure(const unsigned char* in) {
+    Point p[4];
+    for (int k = 0; k < 4; k++) p[k] = Point(get<double>(in + 1 + 16 * k), get<double>(in + 9 + 16 * k));
+    return createFigure((FigureKind)in[0], p);
+}
+
+// ===================================================================
+// ФАЙЛЫ
+// ===================================================================
+
+static bool syncFile(std::FILE* f) {
+    if (std::fflush(f) != 0) return false;
+#if defined(_WIN32)
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+/*
+  После rename() запись каталога тоже должна попасть на диск,
+  иначе после сбоя может остаться старое имя.
+*/
+static void syncDirectoryOf(const std::string& path) {
+#if !defined(_WIN32)
+    std::string::size_type slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : path.substr(0, slash == 0 ? 1 : slash);
+    int fd = ::open(dir.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#else
+    (void)path;
+#endif
+}
+
+/*
+  Читает файл целиком. false - файла нет (exists = false) или ошибка чтения.
+*/
+static bool readFile(const std::string& path, unsigned char*& data, long long& size, bool& exists) {
+    data = nullptr;
+    size = 0;
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    exists = f != nullptr;
+    if (!f) return false;
+
+    bool ok = std::fseek(f, 0, SEEK_END) == 0;
+    long length = ok ? std::ftell(f) : -1;
+    ok = ok && length >= 0 && std::fseek(f, 0, SEEK_SET) == 0;
+    if (ok) {
+        data = new unsigned char[length > 0 ? length : 1];
+        ok = std::fread(data, 1, (std::size_t)length, f) == (std::size_t)length;
+        size = length;
+    }
+    std::fclose(f);
+    if (!ok) {
+        delete[] data;
+        data = nullptr;
+    }
+    return ok;
+}
+
+// ===================================================================
+// СОЗДАНИЕ И ВОССТАНОВЛЕНИЕ
+// ===================================================================
+
+JournaledArray::JournaledArray(const JournalOptions& options)
+    : options(options), journal(nullptr), generation(0),
+      pending(new unsigned char[4096]), pendingBytes(0), pendingCapacity(4096),
+      writing(new unsigned char[4096]), writingCapacity(4096),
+      appendedOps(0), durableOps(0), flushing(false), failed(false) {
+    if (this->options.groupCommit < 1) this->options.groupCommit = 1;
+}
+
+JournaledArray::~JournaledArray() {
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        if (journal) commitLocked(guard, appendedOps);
+        closeJournal();
+    }
+    delete[] pending;
+    delete[] writing;
+}
+
+bool JournaledArray::open(const char* base) {
+    GEOMETRY_TRACE_SCOPE("JournaledArray::open");
+    std::unique_lock<std::mutex> guard(lock);
+    basePath = base;
+    generation = 0;
+    stats = JournalStats();
+
+    if (!loadSnapshot()) return false;
+    stats.snapshotFigures = figures.size();
+
+    bool torn = false;
+    if (!replayJournal(torn)) return false;
+    appendedOps = durableOps = 0;
+
+    // Оборванный хвост нельзя оставлять: новые записи встали бы за ним
+    if (torn) return compactLocked(guard);
+    return journal != nullptr || openJournal(true);
+}
+
+/*
+  Нет снимка - пустая коллекция поколения 0.
+*/
+bool JournaledArray::loadSnapshot() {
+    unsigned char* data = nullptr;
+    long long size = 0;
+    bool exists = false;
+    if (!readFile(basePath + ".snapshot", data, size, exists)) return !exists;
+
+    bool ok = size >= SNAPSHOT_HEADER + 4 && std::memcmp(data, "GSNP", 4) == 0 &&
+              get<std::uint32_t>(data + 4) == FORMAT_VERSION &&
+              get<std::uint32_t>(data + size - 4) == crc32(data, (std::size_t)(size - 4));
+    if (ok) {
+        std::uint32_t count = get<std::uint32_t>(data + 16);
+        ok = size == SNAPSHOT_HEADER + (long long)count * FIGURE_RECORD + 4;
+        for (std::uint32_t i = 0; ok && i < count; i++) {
+            Figure* fig = getFigure(data + SNAPSHOT_HEADER + (long long)i * FIGURE_RECORD);
+            if (fig) figures.push(fig);
+        }
+        generation = get<std::uint64_t>(data + 8);
+    }
+    delete[] data;
+    return ok;
+}
+
+/*
+  Применяет записи журнала текущего поколения; при успехе журнал
+  остается открытым на дозапись. Журнал другого поколения или
+  с поврежденным заголовком не применяется (будет создан заново).
+*/
+bool JournaledArray::replayJournal(bool& torn) {
+    unsigned char* data = nullptr;
+    long long size = 0;
+    bool exists = false;
+    if (!readFile(basePath + ".journal", data, size, exists)) return !exists;
+
+    bool usable = size >= JOURNAL_HEADER && std::memcmp(data, "GWAL", 4) == 0 &&
+                  get<std::uint32_t>(data + 4) == FORMAT_VERSION &&
+                  get<std::uint64_t>(data + 8) == generation &&
+                  get<std::uint32_t>(data + 16) == crc32(data, 16);
+    if (!usable) {
+        delete[] data;
+        return true;
+    }
+
+    long long offset = JOURNAL_HEADER;
+    while (offset < size) {
+        unsigned char op = data[offset];
+        long long payload = op == OP_PUSH ? FIGURE_RECORD : op == OP_REMOVE ? 4 : -1;
+        if (payload < 0 || offset + 1 + payload + 4 > size) break;
+        if (get<std::uint32_t>(data + offset + 1 + payload) != crc32(data + offset, (std::size_t)(1 + payload))) break;
+
+        if (op == OP_PUSH) {
+            Figure* fig = getFigure(data + offset + 1);
+            if (fig) figures.push(fig);
+        } else {
+            figures.remove(get<std::int32_t>(data + offset + 1));
+        }
+        stats.replayed++;
+        offset += 1 + payload + 4;
+    }
+    delete[] data;
+
+    torn = offset < size;
+    stats.tornBytes = size - offset;
+    stats.journalBytes = offset;
+    return torn || openJournal(false);
+}
+
+/*
+  create - новый журнал с заголовком текущего поколения,
+  иначе - дозапись в существующий.
+*/
+bool JournaledArray::openJournal(bool create) {
+    closeJournal();
+    std::string path = basePath + ".journal";
+    journal = std::fopen(path.c_str(), create ? "wb" : "ab");
+    if (!journal) return false;
+    if (!create) return true;
+
+    unsigned char header[JOURNAL_HEADER];
+    std::memcpy(header, "GWAL", 4);
+    put<std::uint32_t>(header + 4, FORMAT_VERSION);
+    put<std::uint64_t>(header + 8, generation);
+    put<std::uint32_t>(header + 16, crc32(header, 16));
+    if (std::fwrite(header, 1, JOURNAL_HEADER, journal) != JOURNAL_HEADER || !syncFile(journal)) {
+        closeJournal();
+        return false;
+    }
+    syncDirectoryOf(path);
+    stats.journalBytes = JOURNAL_HEADER;
+    return true;
+}
+
+void JournaledArray::closeJournal() {
+    if (journal) std::fclose(journal);
+    journal = nullptr;
+}
+
+// ===================================================================
+// ЗАПИСЬ ОПЕРАЦИЙ
+// ===================================================================
+
+void JournaledArray::append(const unsigned char* bytes, int n) {
+    if (pendingBytes + n > pendingCapacity) {
+        int capacity = pendingCapacity * 2;
+        while (capacity < pendingBytes + n) capacity *= 2;
+        unsigned char* grown = new unsigned char[capacity];
+        std::memcpy(grown, pending, pendingBytes);
+        delete[] pending;
+        pending = grown;
+        pendingCapacity = capacity;
+    }
+    std::memcpy(pending + pendingBytes, bytes, n);
+    pendingBytes += n;
+}
+
+void JournaledArray::logRecord(unsigned char op, const unsigned char* payload, int n) {
+    if (!journal) return;   // open() не вызывался - коллекция только в памяти
+    unsigned char record[1 + FIGURE_RECORD + 4];
+    record[0] = op;
+    std::memcpy(record + 1, payload, n);
+    put<std::uint32_t>(record + 1 + n, crc32(record, 1 + n));
+    append(record, 1 + n + 4);
+    appendedOps++;
+    stats.records++;
+}
+
+void JournaledArray::afterChange(std::unique_lock<std::mutex>& guard) {
+    if (!journal) return;
+    if (appendedOps - durableOps >= options.groupCommit) commitLocked(guard, appendedOps);
+    if (options.compactBytes > 0 && stats.journalBytes >= options.compactBytes) compactLocked(guard);
+}
+
+void JournaledArray::push(Figure* fig) {
+    if (fig == nullptr) return;
+    FigureKind kind = figureKind(*fig);
+    if (kind == FigureKind::Rejected) {
+        delete fig;
+        return;
+    }
+
+    unsigned char payload[FIGURE_RECORD];
+    putFigure(payload, kind, *fig);
+
+    std::unique_lock<std::mutex> guard(lock);
+    figures.push(fig);
+    logRecord(OP_PUSH, payload, FIGURE_RECORD);
+    afterChange(guard);
+}
+
+bool JournaledArray::remove(int index) {
+    std::unique_lock<std::mutex> guard(lock);
+    if (index < 0 || index >= figures.size()) return false;
+
+    unsigned char payload[4];
+    put<std::int32_t>(payload, index);
+    figures.remove(index);
+    logRecord(OP_REMOVE, payload, 4);
+    afterChange(guard);
+    return true;
+}
+
+// ===================================================================
+// ГРУППОВАЯ ФИКСАЦИЯ
+// ===================================================================
+
+/*
+  Лидер забирает весь накопленный буфер и пишет его без мьютекса:
+  остальные потоки тем временем добавляют операции в новый буфер
+  или ждут flushed. Проснувшись, поток проверяет, вошла ли его
+  операция в записанное; если нет - сам становится лидером.
+*/
+bool JournaledArray::commitLocked(std::unique_lock<std::mutex>& guard, long long upTo) {
+    while (durableOps < upTo && !failed) {
+        if (flushing) {
+            flushed.wait(guard);
+            continue;
+        }
+
+        flushing = true;
+        std::swap(pending, writing);
+        std::swap(pendingCapacity, writingCapacity);
+        unsigned char* buffer = writing;
+        int bytes = pendingBytes;
+        pendingBytes = 0;
+        long long target = appendedOps;
+        std::FILE* f = journal;
+
+        guard.unlock();
+        bool ok;
+        {
+            GEOMETRY_TRACE_SCOPE("JournaledArray::commit", bytes);
+            ok = std::fwrite(buffer, 1, (std::size_t)bytes, f) == (std::size_t)bytes && syncFile(f);
+        }
+        guard.lock();
+
+        flushing = false;
+        if (ok) {
+            durableOps = target;
+            stats.syncs++;
+            stats.journalBytes += bytes;
+        } else {
+            failed = true;
+        }
+        flushed.notify_all();
+    }
+    return !failed;
+}
+
+bool JournaledArray::commit() {
+    std::unique_lock<std::mutex> guard(lock);
+    if (!journal) return !failed;
+    return commitLocked(guard, appendedOps);
+}
+
+// ===================================================================
+// СВОРАЧИВАНИЕ
+// ===================================================================
+
+/*
+  Снимок включает и незафиксированные операции, поэтому после
+  него буфер журнала просто очищается.
+*/
+bool JournaledArray::compactLocked(std::unique_lock<std::mutex>& guard) {
+    GEOMETRY_TRACE_SCOPE("JournaledArray::compact", figures.size());
+    while (flushing) flushed.wait(guard);
+
+    int n = figures.size();
+    long long size = SNAPSHOT_HEADER + (long long)n * FIGURE_RECORD + 4;
+    unsigned char* data = new unsigned char[size];
+    std::memcpy(data, "GSNP", 4);
+    put<std::uint32_t>(data + 4, FORMAT_VERSION);
+    put<std::uint64_t>(data + 8, generation + 1);
+    put<std::uint32_t>(data + 16, (std::uint32_t)n);
+    for (int i = 0; i < n; i++) {
+        const Figure* fig = figures.get(i);
+        putFigure(data + SNAPSHOT_HEADER + (long long)i * FIGURE_RECORD, figureKind(*fig), *fig);
+    }
+    put<std::uint32_t>(data + size - 4, crc32(data, (std::size_t)(size - 4)));
+
+    std::string path = basePath + ".snapshot";
+    std::string temp = path + ".tmp";
+    std::FILE* f = std::fopen(temp.c_str(), "wb");
+    bool ok = f != nullptr && std::fwrite(data, 1, (std::size_t)size, f) == (std::size_t)size && syncFile(f);
+    if (f) std::fclose(f);
+    delete[] data;
+#if defined(_WIN32)
+    if (ok) std::remove(path.c_str());
+#endif
+    ok = ok && std::rename(temp.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        failed = true;
+        return false;
+    }
+    syncDirectoryOf(path);
+
+    // Снимок нового поколения уже на месте: старый журнал больше не нужен
+    generation++;
+    pendingBytes = 0;
+    durableOps = appendedOps;
+    stats.compactions++;
+    if (!openJournal(true)) {
+        failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool JournaledArray::compact() {
+    std::unique_lock<std::mutex> guard(lock);
+    if (basePath.empty()) return false;
+    return compactLocked(guard);
+}
+
+// ===================================================================
+// ЧТЕНИЕ
+// ===================================================================
+
+int JournaledArray::size() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return figures.size();
+}
+
+JournalStats JournaledArray::getStats() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return stats;
+}
@@ -0,0 +1,162 @@
+#include "MemoryTracking.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+/**
+ * @file MemoryTracking.cpp
+ * @brief Перехватчик выделений и отчет о памяти
+ */
+
+// ===================================================================
+// ВЫДЕЛЕНИЕ ПАМЯТИ
+// ===================================================================
+
+static std::atomic<AllocationHook*> currentHook(nullptr);
+
+AllocationHook* setAllocationHook(AllocationHook* hook) {
+    return currentHook.exchange(hook, std::memory_order_acq_rel);
+}
+
+void* trackedAllocate(std::size_t bytes) {
+    void* p = std::malloc(bytes ? bytes : 1);
+    if (!p) throw std::bad_alloc();
+    AllocationHook* hook = currentHook.load(std::memory_order_acquire);
+    if (hook) hook->allocated(p, bytes);
+    return p;
+}
+
+void trackedFree(void* p, std::size_t bytes) {
+    if (!p) return;
+    AllocationHook* hook = currentHook.load(std::memory_order_acquire);
+    if (hook) hook->freed(p, bytes);
+    std::free(p);
+}
+
+std::size_t allocationFootprint(const void* p, std::size_t requested) {
+#if defined(__GLIBC__)
+    (void)requested;
+    return p ? malloc_usable_size(const_cast<void*>(p)) : 0;
+#else
+    (void)p;
+    return (requested + 15) / 16 * 16;
+#endif
+}
+
+/*
+  glibc хранит перед блоком его размер (одно слово); у большинства
+  других аллокаторов общего назначения порядок тот же.
+*/
+std::size_t allocationHeaderBytes() {
+    return sizeof(std::size_t);
+}
+
+// ===================================================================
+// СЧЕТЧИК
+// ===================================================================
+
+AllocationCounter::AllocationCounter()
+    : allocCount(0), freeCount(0), allocBytes(0), freeBytes(0) {}
+
+void AllocationCounter::allocated(void*, std::size_t bytes) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add((long long)bytes, std::memory_order_relaxed);
+}
+
+void AllocationCounter::freed(void*, std::size_t bytes) {
+    freeCount.fetch_add(1, std::memory_order_relaxed);
+    freeBytes.fetch_add((long long)bytes, std::memory_order_relaxed);
+}
+
+void AllocationCounter::reset() {
+    allocCount.store(0, std::memory_order_relaxed);
+    freeCount.store(0, std::memory_order_relaxed);
+    allocBytes.store(0, std::memory_order_relaxed);
+    freeBytes.store(0, std::memory_order_relaxed);
+}
+
+// ===================================================================
+// ОТЧЕТ
+// ===================================================================
+
+void MemoryReport::addBlock(const void* p, std::size_t requested) {
+    std::size_t footprint = allocationFootprint(p, requested);
+    if (footprint > requested) allocatorSlack += (long long)(footprint - requested);
+    allocatorHeaders += (long long)allocationHeaderBytes();
+    allocations++;
+}
+
+/*
+  Типов единицы - линейный поиск; сверх MEMORY_REPORT_TYPES типы
+  копятся в последней строке "Other".
+*/
+TypeMemory& MemoryReport::typeSlot(const char* type) {
+    for (int i = 0; i < typeCount; i++) {
+        if (std::strcmp(types[i].type, type) == 0) return types[i];
+    }
+    if (typeCount == MEMORY_REPORT_TYPES) {
+        types[MEMORY_REPORT_TYPES - 1].type = "Other";
+        return types[MEMORY_REPORT_TYPES - 1];
+    }
+    types[typeCount].type = type;
+    return types[typeCount++];
+}
+
+void MemoryReport::addObject(const char* type, std::size_t bytes) {
+    objectBytes += (long long)bytes;
+    vptrBytes += (long long)sizeof(void*);
+    TypeMemory& slot = typeSlot(type);
+    slot.count++;
+    slot.bytes += (long long)bytes;
+}
+
+long long MemoryReport::total() const {
+    return containerBytes + bufferUsed + bufferUnused + objectBytes + allocatorSlack + allocatorHeaders;
+}
+
+void MemoryReport::merge(const MemoryReport& other) {
+    containerBytes += other.containerBytes;
+    bufferUsed += other.bufferUsed;
+    bufferUnused += other.bufferUnused;
+    objectBytes += other.objectBytes;
+    vptrBytes += other.vptrBytes;
+    allocatorSlack += other.allocatorSlack;
+    allocatorHeaders += other.allocatorHeaders;
+    allocations += other.allocations;
+
+    for (int i = 0; i < other.typeCount; i++) {
+        TypeMemory& slot = typeSlot(other.types[i].type);
+        slot.count += other.types[i].count;
+        slot.bytes += other.types[i].bytes;
+    }
+}
+
+void MemoryReport::print(std::ostream& os) const {
+    char line[128];
+    long long all = total();
+    auto row = [&](const char* name, long long bytes) {
+        std::snprintf(line, sizeof(line), "  %12lld  %5.1f%%  %s\n",
+                      bytes, all > 0 ? 100.0 * bytes / all : 0.0, name);
+        os << line;
+    };
+
+    os << "Память коллекции: " << all << " байт, блоков в куче: " << allocations << std::endl;
+    row("контейнер", containerBytes);
+    row("буфер: занято", bufferUsed);
+    row("буфер: запас", bufferUnused);
+    row("объекты фигур", objectBytes);
+    row("  из них vptr", vptrBytes);
+    row("округление аллокатора", allocatorSlack);
+    row("заголовки блоков", allocatorHeaders);
+
+    for (int i = 0; i < typeCount; i++) {
+        std::snprintf(line, sizeof(line), "  %12lld  x%-6d %s\n",
+                      types[i].bytes, types[i].count, types[i].type);
+        os << line;
+    }
+}
@@ -0,0 +1,21 @@
+#include "Orientation.h"
+#include <atomic>
+
+/**
+ * @file Orientation.cpp
+ * @brief Счетчик точных ступеней предикатов ориентации
+ */
+
+static std::atomic<long long> fallbacks(0);
+
+void noteOrientationFallback() {
+    fallbacks.fetch_add(1, std::memory_order_relaxed);
+}
+
+long long orientationFallbacks() {
+    return fallbacks.load(std::memory_order_relaxed);
+}
+
+void resetOrientationFallbacks() {
+    fallbacks.store(0, std::memory_order_relaxed);
+}
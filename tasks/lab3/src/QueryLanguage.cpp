@@ -0,0 +1,463 @@
+#include "QueryLanguage.h"
+#include "Classifier.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * @file QueryLanguage.cpp
+ * @brief Разбор запроса, слияние условий в план, выполнение плана
+ */
+
+// ===================================================================
+// ЛЕКСЕР
+// ===================================================================
+
+enum class TokenKind : unsigned char { Word, Number, Symbol, End, Bad };
+
+struct Token {
+    TokenKind kind = TokenKind::End;
+    const char* start = nullptr;
+    int length = 0;
+    double number = 0;
+};
+
+static bool isWordChar(char c) {
+    return std::isalnum((unsigned char)c) || c == '_';
+}
+
+/*
+  Разбор рекурсивным спуском по одному токену вперед. Первая ошибка
+  запоминается, дальнейший разбор прекращается.
+*/
+class QueryParser {
+private:
+    const char* s;
+    Token current;
+    std::string error;
+
+    void advance() {
+        while (std::isspace((unsigned char)*s)) s++;
+        current = Token();
+        current.start = s;
+        if (*s == '\0') return;
+
+        if (std::isdigit((unsigned char)*s) || *s == '.' ||
+            ((*s == '-' || *s == '+') && (std::isdigit((unsigned char)s[1]) || s[1] == '.'))) {
+            char* end = nullptr;
+            current.number = std::strtod(s, &end);
+            current.kind = end == s ? TokenKind::Bad : TokenKind::Number;
+            s = end == s ? s + 1 : end;
+        } else if (std::isalpha((unsigned char)*s) || *s == '_') {
+            current.kind = TokenKind::Word;
+            while (isWordChar(*s)) s++;
+        } else if ((*s == '<' || *s == '>' || *s == '!') && s[1] == '=') {
+            current.kind = TokenKind::Symbol;
+            s += 2;
+        } else if (std::strchr("(),=<>", *s)) {
+            current.kind = TokenKind::Symbol;
+            s++;
+        } else {
+            current.kind = TokenKind::Bad;
+            s++;
+        }
+        current.length = (int)(s - current.start);
+    }
+
+    bool fail(const char* message) {
+        if (error.empty()) {
+            error = message;
+            if (current.kind == TokenKind::End) {
+                error += " (конец запроса)";
+            } else {
+                error += " (у \"";
+                error.append(current.start, current.length);
+                error += "\")";
+            }
+        }
+        return false;
+    }
+
+    /*
+      Текущий токен - слово word (без учета регистра)
+    */
+    bool isWord(const char* word) const {
+        if (current.kind != TokenKind::Word || (int)std::strlen(word) != current.length) return false;
+        for (int i = 0; i < current.length; i++) {
+            if (std::tolower((unsigned char)current.start[i]) != std::tolower((unsigned char)word[i])) return false;
+        }
+        return true;
+    }
+
+    bool isSymbol(const char* symbol) const {
+        return current.kind == TokenKind::Symbol && (int)std::strlen(symbol) == current.length &&
+               std::strncmp(current.start, symbol, current.length) == 0;
+    }
+
+    bool acceptWord(const char* word) {
+        if (!isWord(word)) return false;
+        advance();
+        return true;
+    }
+
+    bool acceptSymbol(const char* symbol) {
+        if (!isSymbol(symbol)) return false;
+        advance();
+        return true;
+    }
+
+    bool expectWord(const char* word, const char* message) {
+        return acceptWord(word) || fail(message);
+    }
+
+    bool expectSymbol(const char* symbol, const char* message) {
+        return acceptSymbol(symbol) || fail(message);
+    }
+
+    bool number(double& value) {
+        if (current.kind != TokenKind::Number) return fail("ожидалось число");
+        value = current.number;
+        advance();
+        return true;
+    }
+
+    /*
+      "(" число {"," число} ")" - ровно n чисел
+    */
+    bool numbers(double* values, int n) {
+        if (!expectSymbol("(", "ожидалась \"(\"")) return false;
+        for (int i = 0; i < n; i++) {
+            if (i > 0 && !expectSymbol(",", "ожидалась \",\"")) return false;
+            if (!number(values[i])) return false;
+        }
+        return expectSymbol(")", "ожидалась \")\"");
+    }
+
+    bool box(BoundingBox& b) {
+        double v[4];
+        if (!expectWord("box", "ожидалось box(x1, y1, x2, y2)") || !numbers(v, 4)) return false;
+        b = BoundingBox(v[0] < v[2] ? v[0] : v[2], v[1] < v[3] ? v[1] : v[3],
+                        v[0] < v[2] ? v[2] : v[0], v[1] < v[3] ? v[3] : v[1]);
+        return true;
+    }
+
+    bool aggregate(QueryPlan& plan) {
+        static const char* const NAMES[] = {"COUNT", "SUM", "AVG", "MIN", "MAX"};
+        int which = -1;
+        for (int a = 0; a < 5 && which < 0; a++) {
+            if (isWord(NAMES[a])) which = a;
+        }
+        if (which < 0) return fail("ожидался агрегат COUNT, SUM, AVG, MIN или MAX");
+        if (plan.aggregateCount == QUERY_MAX_AGGREGATES) return fail("слишком много агрегатов");
+        advance();
+        if (which > 0) {
+            if (!expectSymbol("(", "ожидалась \"(\"") || !expectWord("area", "ожидалось area") ||
+                !expectSymbol(")", "ожидалась \")\"")) {
+                return false;
+            }
+        }
+        plan.aggregates[plan.aggregateCount++] = (QueryAggregate)which;
+        return true;
+    }
+
+    bool typeCondition(QueryPlan& plan) {
+        bool negate = false;
+        if (acceptSymbol("!=")) {
+            negate = true;
+        } else if (!expectSymbol("=", "ожидалось = или !=")) {
+            return false;
+        }
+        int kind = -1;
+        for (int k = 0; k < (int)FigureKind::Rejected && kind < 0; k++) {
+            if (isWord(kindName((FigureKind)k))) kind = k;
+        }
+        if (kind < 0) return fail("ожидался тип Square, Rectangle или Trapezoid");
+        advance();
+        int bit = 1 << kind;
+        plan.kindMask &= negate ? ~bit : bit;
+        return true;
+    }
+
+    bool areaCondition(QueryPlan& plan) {
+        const char* ops[] = {"<=", ">=", "<", ">", "="};
+        int op = -1;
+        for (int i = 0; i < 5 && op < 0; i++) {
+            if (isSymbol(ops[i])) op = i;
+        }
+        if (op < 0) return fail("ожидалось сравнение <, <=, >, >= или =");
+        advance();
+        double v;
+        if (!number(v)) return false;
+
+        // Граница сужает интервал, только если она строже текущей
+        bool upper = op == 0 || op == 2 || op == 4;
+        bool lower = op == 1 || op == 3 || op == 4;
+        bool strict = op == 2 || op == 3;
+        if (upper && (v < plan.areaMax || (v == plan.areaMax && strict))) {
+            plan.areaMax = v;
+            plan.areaMaxStrict = strict;
+        }
+        if (lower && (v > plan.areaMin || (v == plan.areaMin && strict))) {
+            plan.areaMin = v;
+            plan.areaMinStrict = strict;
+        }
+        return true;
+    }
+
+    static void intersect(BoundingBox& a, const BoundingBox& b) {
+        if (b.minX > a.minX) a.minX = b.minX;
+        if (b.minY > a.minY) a.minY = b.minY;
+        if (b.maxX < a.maxX) a.maxX = b.maxX;
+        if (b.maxY < a.maxY) a.maxY = b.maxY;
+    }
+
+    bool condition(QueryPlan& plan) {
+        if (acceptWord("type")) return typeCondition(plan);
+        if (acceptWord("area")) return areaCondition(plan);
+        if (acceptWord("center")) {
+            BoundingBox b;
+            if (!expectWord("IN", "ожидалось IN") || !box(b)) return false;
+            if (plan.hasCenterBox) {
+                intersect(plan.centerBox, b);
+            } else {
+                plan.centerBox = b;
+                plan.hasCenterBox = true;
+            }
+            return true;
+        }
+        if (acceptWord("bounds")) {
+            // Два INTERSECTS не сводятся к одной области: ограничение языка
+            if (plan.hasBoundsBox) return fail("bounds INTERSECTS допускается один раз");
+            if (!expectWord("INTERSECTS", "ожидалось INTERSECTS") || !box(plan.boundsBox)) return false;
+            plan.hasBoundsBox = true;
+            return true;
+        }
+        if (acceptWord("CONTAINS")) {
+            if (plan.hasPoint) return fail("CONTAINS допускается один раз");
+            double v[2];
+            if (!expectWord("point", "ожидалось point(x, y)") || !numbers(v, 2)) return false;
+            plan.point = Point(v[0], v[1]);
+            plan.hasPoint = true;
+            return true;
+        }
+        return fail("ожидалось условие type, area, center, bounds или CONTAINS");
+    }
+
+public:
+    explicit QueryParser(const char* text) : s(text) { advance(); }
+
+    bool parse(QueryPlan& plan) {
+        plan = QueryPlan();
+        plan.explain = acceptWord("EXPLAIN");
+        if (!expectWord("SELECT", "ожидалось SELECT")) return false;
+        do {
+            if (!aggregate(plan)) return false;
+        } while (acceptSymbol(","));
+
+        if (acceptWord("WHERE")) {
+            do {
+                if (!condition(plan)) return false;
+            } while (acceptWord("AND"));
+        }
+        if (current.kind != TokenKind::End) return fail("лишний текст после запроса");
+
+        plan.empty = plan.kindMask == 0 ||
+                     plan.areaMin > plan.areaMax ||
+                     (plan.areaMin == plan.areaMax && (plan.areaMinStrict || plan.areaMaxStrict)) ||
+                     (plan.hasCenterBox && (plan.centerBox.minX > plan.centerBox.maxX ||
+                                            plan.centerBox.minY > plan.centerBox.maxY));
+        return true;
+    }
+
+    const std::string& getError() const { return error; }
+};
+
+bool compileQuery(const char* text, QueryPlan& plan, std::string* error) {
+    QueryParser parser(text);
+    bool ok = parser.parse(plan);
+    if (error) *error = ok ? std::string() : parser.getError();
+    return ok;
+}
+
+// ===================================================================
+// ПЛАН
+// ===================================================================
+
+static double boxArea(const BoundingBox& b) {
+    return (b.maxX - b.minX) * (b.maxY - b.minY);
+}
+
+/*
+  Область для кандидатов IndexBox: у фигуры с центром в области
+  AABB эту область задевает, поэтому подходит и center IN box.
+  Из двух областей берется меньшая - кандидатов меньше. Область
+  обрезается по AABB коллекции: за ним фигур нет, а оценка
+  cellEntriesIn и перебор работают с конечными координатами ячеек.
+*/
+static BoundingBox candidateBox(const QueryPlan& plan, const FigureIndex& index) {
+    BoundingBox box = plan.hasCenterBox ? plan.centerBox : plan.boundsBox;
+    if (plan.hasCenterBox && plan.hasBoundsBox && boxArea(plan.boundsBox) < boxArea(plan.centerBox)) {
+        box = plan.boundsBox;
+    }
+    const BoundingBox& extent = index.getExtent();
+    if (!box.intersects(extent)) return box;
+    return BoundingBox(std::max(box.minX, extent.minX), std::max(box.minY, extent.minY),
+                       std::min(box.maxX, extent.maxX), std::min(box.maxY, extent.maxY));
+}
+
+QueryAccess QueryPlan::access(int n, const FigureIndex* index) const {
+    if (empty) return QueryAccess::Empty;
+    if (index && hasPoint) return QueryAccess::IndexPoint;
+    // Запись ячейки проверяется дешевле фигуры при просмотре (там
+    // виртуальные вызовы), так что при равенстве индекс не хуже
+    if (index && (hasCenterBox || hasBoundsBox) && index->cellEntriesIn(candidateBox(*this, *index)) <= n) {
+        return QueryAccess::IndexBox;
+    }
+    return n >= QUERY_PARALLEL_MIN ? QueryAccess::ParallelScan : QueryAccess::Scan;
+}
+
+void QueryPlan::describe(std::ostream& os, int n, const FigureIndex* index) const {
+    QueryAccess a = access(n, index);
+    switch (a) {
+        case QueryAccess::Empty:
+            os << "empty: условия противоречат друг другу" << std::endl;
+            return;
+        case QueryAccess::Scan:
+            os << "scan: " << n << " фигур" << std::endl;
+            break;
+        case QueryAccess::ParallelScan:
+            os << "parallel scan: " << n << " фигур" << std::endl;
+            break;
+        case QueryAccess::IndexBox: {
+            BoundingBox b = candidateBox(*this, *index);
+            os << "index box: [" << b.minX << ", " << b.maxX << "] x [" << b.minY << ", " << b.maxY << "], "
+               << index->cellEntriesIn(b) << " записей ячеек" << std::endl;
+            break;
+        }
+        case QueryAccess::IndexPoint:
+            os << "index point: (" << point.x << ", " << point.y << ")" << std::endl;
+            break;
+    }
+    if (kindMask != 7) {
+        os << "  filter type in {";
+        const char* sep = "";
+        for (int k = 0; k < 3; k++) {
+            if (kindMask & (1 << k)) {
+                os << sep << kindName((FigureKind)k);
+                sep = ", ";
+            }
+        }
+        os << "}" << std::endl;
+    }
+    if (hasBoundsBox) os << "  filter bounds intersects box" << std::endl;
+    if (hasCenterBox) os << "  filter center in box" << std::endl;
+    if (areaMin > -1 || areaMax < 1e308) {
+        os << "  filter area " << (areaMinStrict ? "(" : "[") << areaMin << ", " << areaMax
+           << (areaMaxStrict ? ")" : "]") << std::endl;
+    }
+    if (hasPoint && a != QueryAccess::IndexPoint) os << "  filter contains point" << std::endl;
+}
+
+// ===================================================================
+// ВЫПОЛНЕНИЕ
+// ===================================================================
+
+/*
+  Проверки плана от дешевых к дорогим; площадь считается один раз
+  и идет и в интервал, и в агрегаты.
+*/
+static bool matches(const QueryPlan& plan, const Figure& fig, bool checkPoint, double& area) {
+    if (plan.kindMask != 7 && !(plan.kindMask & (1 << (int)figureKind(fig)))) return false;
+    if (plan.hasBoundsBox && !plan.boundsBox.intersects(fig.bounds())) return false;
+    if (plan.hasCenterBox && !plan.centerBox.contains(fig.center())) return false;
+    area = fig.area();
+    if (plan.areaMinStrict ? !(area > plan.areaMin) : !(area >= plan.areaMin)) return false;
+    if (plan.areaMaxStrict ? !(area < plan.areaMax) : !(area <= plan.areaMax)) return false;
+    return !checkPoint || fig.contains(plan.point);
+}
+
+static void add(QueryResult& r, double area) {
+    if (r.count == 0 || area < r.min) r.min = area;
+    if (r.count == 0 || area > r.max) r.max = area;
+    r.count++;
+    r.sum += area;
+}
+
+static QueryResult merge(QueryResult a, const QueryResult& b) {
+    if (b.count == 0) return a;
+    if (a.count == 0) return b;
+    a.count += b.count;
+    a.sum += b.sum;
+    if (b.min < a.min) a.min = b.min;
+    if (b.max > a.max) a.max = b.max;
+    return a;
+}
+
+QueryResult runQuery(const QueryPlan& plan, const Array& figures, const FigureIndex* index, ThreadPool* pool) {
+    GEOMETRY_TRACE_SCOPE("runQuery", figures.size());
+    QueryAccess access = plan.access(figures.size(), index);
+    QueryResult result;
+    double area = 0;
+
+    switch (access) {
+        case QueryAccess::Empty:
+            break;
+        case QueryAccess::Scan:
+            for (int i = 0; i < figures.size(); i++) {
+                if (matches(plan, *figures.get(i), plan.hasPoint, area)) add(result, area);
+            }
+            break;
+        case QueryAccess::ParallelScan: {
+            ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+            result = workers.parallelReduce(0, figures.size(), QueryResult(), [&](int begin, int end) {
+                QueryResult part;
+                double a = 0;
+                for (int i = begin; i < end; i++) {
+                    if (matches(plan, *figures.get(i), plan.hasPoint, a)) add(part, a);
+                }
+                return part;
+            }, merge, QUERY_PARALLEL_MIN / 4);
+            break;
+        }
+        case QueryAccess::IndexBox:
+            index->forEachCandidate(candidateBox(plan, *index), [&](int f) {
+                if (matches(plan, *figures.get(f), plan.hasPoint, area)) add(result, area);
+            });
+            break;
+        case QueryAccess::IndexPoint:
+            index->forEachCandidate(BoundingBox(plan.point.x, plan.point.y, plan.point.x, plan.point.y),
+                                    [&](int f) {
+                if (index->contains(f, plan.point) && matches(plan, *figures.get(f), false, area)) {
+                    add(result, area);
+                }
+            });
+            break;
+    }
+    result.access = access;
+    return result;
+}
+
+// ===================================================================
+// РЕЗУЛЬТАТ
+// ===================================================================
+
+double QueryResult::value(QueryAggregate aggregate) const {
+    switch (aggregate) {
+        case QueryAggregate::Count: return count;
+        case QueryAggregate::Sum: return sum;
+        case QueryAggregate::Avg: return count > 0 ? sum / count : 0;
+        case QueryAggregate::Min: return count > 0 ? min : 0;
+        default: return count > 0 ? max : 0;
+    }
+}
+
+void QueryResult::print(std::ostream& os, const QueryPlan& plan) const {
+    static const char* const NAMES[] = {"COUNT", "SUM(area)", "AVG(area)", "MIN(area)", "MAX(area)"};
+    for (int a = 0; a < plan.aggregateCount; a++) {
+        if (a > 0) os << ", ";
+        os << NAMES[(int)plan.aggregates[a]] << " = " << value(plan.aggregates[a]);
+    }
+    os << std::endl;
+}
@@ -1,4 +1,6 @@
 #include "Rectangle.h"
+#include "Instrumentation.h"
+#include "Trace.h"
 #include <iostream>
 #include <cmath>
 
@@ -44,26 +46,9 @@ Rectangle& Rectangle::operator=(Rectangle&& other) noexcept {
     return *this;
 }
 
-Point Rectangle::center() const {
-    double cx = 0, cy = 0;
-    for (int i = 0; i < 4; i++) {
-        cx += points[i].x;
-        cy += points[i].y;
-    }
-    return Point(cx / 4, cy / 4);
-}
-
-double Rectangle::area() const {
-    double sum = 0;
-    for (int i = 0; i < 4; i++) {
-        int j = (i + 1) % 4;
-        sum += points[i].x * points[j].y;
-        sum -= points[j].x * points[i].y;
-    }
-    return fabs(sum) / 2.0;
-}
-
 void Rectangle::print(std::ostream& os) const {
+    GEOMETRY_PROBE(Probe::Print);
+
     os << "Rectangle: ";
     for (int i = 0; i < 4; i++) {
         os << "(" << points[i].x << "," << points[i].y << ")";
@@ -72,6 +57,9 @@ void Rectangle::print(std::ostream& os) const {
 }
 
 void Rectangle::read(std::istream& is) {
+    GEOMETRY_PROBE(Probe::Read);
+    GEOMETRY_TRACE_SCOPE("Figure::read");
+
     Point temp[4];
     for (int i = 0; i < 4; i++) {
         is >> temp[i].x >> temp[i].y;
@@ -0,0 +1,264 @@
+#include "ShardedStore.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @file ShardedStore.cpp
+ * @brief Шарды, изменения под мьютексом шарда, параллельные операции
+ */
+
+// ===================================================================
+// ШАРДЫ
+// ===================================================================
+
+ShardedStore::ShardedStore(int shardCount)
+    : shards(new Shard[shardCount > 0 ? shardCount : 1]),
+      shardCount(shardCount > 0 ? shardCount : 1),
+      nextHandle(0) {}
+
+ShardedStore::~ShardedStore() {
+    delete[] shards;
+}
+
+/*
+  Идентификаторы идут подряд, поэтому их перемешиваем (умножение
+  на нечетную константу золотого сечения) и берем старшие биты:
+  соседние идентификаторы попадают в разные шарды.
+*/
+int ShardedStore::shardOf(FigureHandle handle) const {
+    unsigned long long mixed = (unsigned long long)handle * 0x9E3779B97F4A7C15ULL;
+    return (int)((mixed >> 32) % (unsigned long long)shardCount);
+}
+
+/*
+  Вызывает fn(s) для всех шардов задачами пула: шард - единица работы.
+*/
+template <typename Fn>
+static void forShards(int shardCount, ThreadPool* pool, Fn fn) {
+    if (pool == nullptr) pool = &ThreadPool::shared();
+    pool->parallelFor(0, shardCount, [&fn](int begin, int end) {
+        for (int s = begin; s < end; s++) fn(s);
+    });
+}
+
+// ===================================================================
+// ИЗМЕНЕНИЯ
+// ===================================================================
+
+FigureHandle ShardedStore::push(Figure* fig) {
+    if (fig == nullptr) return -1;
+
+    FigureHandle handle = nextHandle.fetch_add(1, std::memory_order_relaxed);
+    Shard& shard = shards[shardOf(handle)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    shard.figures.push(fig);
+    shard.handles.push(handle);
+    return handle;
+}
+
+bool ShardedStore::remove(FigureHandle handle) {
+    if (handle < 0) return false;
+
+    Shard& shard = shards[shardOf(handle)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    for (int i = 0; i < shard.handles.size(); i++) {
+        if (shard.handles[i] == handle) {
+            shard.figures.remove(i);
+            shard.handles.remove(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ShardedStore::contains(FigureHandle handle) const {
+    if (handle < 0) return false;
+
+    Shard& shard = shards[shardOf(handle)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    for (int i = 0; i < shard.handles.size(); i++) {
+        if (shard.handles[i] == handle) return true;
+    }
+    return false;
+}
+
+// ===================================================================
+// ЧТЕНИЕ
+// ===================================================================
+
+int ShardedStore::size() const {
+    int total = 0;
+    for (int s = 0; s < shardCount; s++) total += shardSize(s);
+    return total;
+}
+
+int ShardedStore::shardSize(int shard) const {
+    if (shard < 0 || shard >= shardCount) return 0;
+    std::lock_guard<std::mutex> guard(shards[shard].lock);
+    return shards[shard].figures.size();
+}
+
+/*
+  Суммы шардов складываются в порядке номеров шардов - результат
+  не зависит от числа потоков.
+*/
+double ShardedStore::totalArea(ThreadPool* pool) const {
+    GEOMETRY_TRACE_SCOPE("ShardedStore::totalArea", shardCount);
+    double* sums = new double[shardCount];
+    forShards(shardCount, pool, [this, sums](int s) {
+        std::lock_guard<std::mutex> guard(shards[s].lock);
+        sums[s] = shards[s].figures.totalArea();
+    });
+
+    double total = 0;
+    for (int s = 0; s < shardCount; s++) total += sums[s];
+    delete[] sums;
+    return total;
+}
+
+// ===================================================================
+// УДАЛЕНИЕ ДУБЛИКАТОВ
+// ===================================================================
+
+/*
+  Фигура в общем списке кандидатов: левая граница AABB - ключ сортировки,
+  нижняя - ключ внутри участка с близкими левыми границами.
+*/
+struct DedupEntry {
+    double minX;
+    double minY;
+    FigureHandle handle;
+    const Figure* figure;
+    int shard;
+    int index;
+    bool duplicate;
+
+    bool operator<(const DedupEntry& other) const { return minX < other.minX; }
+};
+
+/*
+  Участок списка, где левые границы идут без разрывов >= eps. Равные
+  фигуры лежат в одном участке, а их нижние границы тоже отличаются
+  меньше чем на eps: участок сортируется по нижней границе, и пары
+  проверяются только в окне по ней. Столбец фигур с общей левой
+  границей (данные на сетке) - O(k log k), а не O(k^2).
+*/
+static int markDuplicateRun(DedupEntry* run, int n, double eps) {
+    if (n < 2) return 0;
+    std::sort(run, run + n, [](const DedupEntry& a, const DedupEntry& b) { return a.minY < b.minY; });
+    int removed = 0;
+    for (int i = 0; i < n; i++) {
+        if (run[i].duplicate) continue;
+        for (int j = i + 1; j < n && run[j].minY - run[i].minY < eps; j++) {
+            if (run[j].duplicate || std::fabs(run[j].minX - run[i].minX) >= eps) continue;
+            if (!(*run[i].figure == *run[j].figure)) continue;
+            DedupEntry& later = run[j].handle > run[i].handle ? run[j] : run[i];
+            later.duplicate = true;
+            removed++;
+            if (&later == &run[i]) break;
+        }
+    }
+    return removed;
+}
+
+int ShardedStore::removeDuplicates(ThreadPool* pool) {
+    GEOMETRY_TRACE_SCOPE("ShardedStore::removeDuplicates", shardCount);
+
+    // Все шарды под блокировкой: дубликаты ищутся в согласованном
+    // состоянии. Порядок захвата - по номеру шарда, как и везде
+    for (int s = 0; s < shardCount; s++) shards[s].lock.lock();
+
+    int* offsets = new int[shardCount + 1];
+    offsets[0] = 0;
+    for (int s = 0; s < shardCount; s++) offsets[s + 1] = offsets[s] + shards[s].figures.size();
+    int n = offsets[shardCount];
+    DedupEntry* entries = new DedupEntry[n > 0 ? n : 1];
+
+    // 1. Шарды параллельно выписывают и сортируют свои фигуры
+    forShards(shardCount, pool, [this, offsets, entries](int s) {
+        const Shard& shard = shards[s];
+        DedupEntry* out = entries + offsets[s];
+        for (int i = 0; i < shard.figures.size(); i++) {
+            const Figure* fig = shard.figures.get(i);
+            BoundingBox box = fig->bounds();
+            out[i] = DedupEntry{box.minX, box.minY, shard.handles[i], fig, s, i, false};
+        }
+        std::sort(out, out + shard.figures.size());
+    });
+
+    // 2. Слияние упорядоченных списков шардов
+    for (int width = 1; width < shardCount; width *= 2) {
+        for (int s = 0; s + width < shardCount; s += 2 * width) {
+            int end = std::min(s + 2 * width, shardCount);
+            std::inplace_merge(entries + offsets[s], entries + offsets[s + width], entries + offsets[end]);
+        }
+    }
+
+    // 3. Равные фигуры - только среди соседей с близкой левой границей
+    //    (точность operator== - 1e-4). Разрыв >= eps делит список на
+    //    независимые участки, они проверяются параллельно
+    const double eps = 1e-4;
+    int* runs = new int[n + 1];
+    int runCount = 0;
+    for (int i = 0; i < n; i++) {
+        if (i == 0 || entries[i].minX - entries[i - 1].minX >= eps) runs[runCount++] = i;
+    }
+    runs[runCount] = n;
+    if (pool == nullptr) pool = &ThreadPool::shared();
+    int removed = pool->parallelReduce(0, runCount, 0, [entries, runs, eps](int begin, int end) {
+        int found = 0;
+        for (int r = begin; r < end; r++) found += markDuplicateRun(entries + runs[r], runs[r + 1] - runs[r], eps);
+        return found;
+    }, [](int a, int b) { return a + b; });
+    delete[] runs;
+
+    // 4. Шарды параллельно удаляют свои дубликаты: пометки по индексам,
+    //    удаление с конца - без лишних сдвигов уже проверенных элементов
+    bool* marks = new bool[n > 0 ? n : 1];
+    for (int k = 0; k < n; k++) marks[offsets[entries[k].shard] + entries[k].index] = entries[k].duplicate;
+    forShards(shardCount, pool, [this, offsets, marks](int s) {
+        Shard& shard = shards[s];
+        for (int i = shard.figures.size() - 1; i >= 0; i--) {
+            if (!marks[offsets[s] + i]) continue;
+            shard.figures.remove(i);
+            shard.handles.remove(i);
+        }
+    });
+
+    delete[] marks;
+    delete[] entries;
+    delete[] offsets;
+    for (int s = shardCount - 1; s >= 0; s--) shards[s].lock.unlock();
+    return removed;
+}
+
+// ===================================================================
+// ОТЧЕТ О ПАМЯТИ
+// ===================================================================
+
+MemoryReport ShardedStore::memoryReport() const {
+    MemoryReport report;
+    // Массив шардов учтен только в containerBytes: Shard выровнен на 64,
+    // и new[] возвращает адрес после служебного заголовка массива -
+    // не начало блока malloc, для addBlock() он непригоден
+    report.containerBytes = sizeof(ShardedStore) + (long long)shardCount * sizeof(Shard);
+
+    for (int s = 0; s < shardCount; s++) {
+        const Shard& shard = shards[s];
+        std::lock_guard<std::mutex> guard(shards[s].lock);
+
+        // Сам Array уже учтен в sizeof(Shard)
+        MemoryReport part = shard.figures.memoryReport();
+        part.containerBytes = 0;
+        report.merge(part);
+
+        if (!shard.handles.isInline()) {
+            report.bufferUsed += (long long)shard.handles.size() * sizeof(FigureHandle);
+            report.bufferUnused += (long long)(shard.handles.getCapacity() - shard.handles.size()) * sizeof(FigureHandle);
+            report.addBlock(shard.handles.heapBlock(), shard.handles.heapBytes());
+        }
+    }
+    return report;
+}
@@ -0,0 +1,211 @@
+#include "SnapshotArray.h"
+#include "Trace.h"
+#include <thread>
+
+/**
+ * @file SnapshotArray.cpp
+ * @brief Версии коллекции, снимки читателей и освобождение по эпохам
+ */
+
+// ===================================================================
+// ВЕРСИИ
+// ===================================================================
+
+static SnapshotVersion* newVersion(Figure** items, int count, int capacity) {
+    SnapshotVersion* v = static_cast<SnapshotVersion*>(trackedAllocate(sizeof(SnapshotVersion)));
+    v->items = items;
+    v->count = count;
+    v->capacity = capacity;
+    return v;
+}
+
+static Figure** newBuffer(int capacity) {
+    return static_cast<Figure**>(trackedAllocate(capacity * sizeof(Figure*)));
+}
+
+SnapshotArray::SnapshotArray() : currentCount(0), epoch(1) {
+    current.store(newVersion(newBuffer(4), 0, 4), std::memory_order_relaxed);
+    for (int i = 0; i < SNAPSHOT_READERS; i++) readers[i].store(0, std::memory_order_relaxed);
+}
+
+/*
+  К моменту уничтожения снимков быть не должно: освобождаем все сразу.
+*/
+SnapshotArray::~SnapshotArray() {
+    for (int i = 0; i < retired.size(); i++) {
+        delete retired[i].figure;
+        trackedFree(retired[i].block, retired[i].bytes);
+    }
+
+    const SnapshotVersion* v = current.load(std::memory_order_relaxed);
+    for (int i = 0; i < v->count; i++) delete v->items[i];
+    trackedFree(v->items, v->capacity * sizeof(Figure*));
+    trackedFree(const_cast<SnapshotVersion*>(v), sizeof(SnapshotVersion));
+}
+
+// ===================================================================
+// ЗАПИСЬ
+// ===================================================================
+
+/*
+  Порядок важен: сначала новая версия становится текущей, затем
+  старые объекты получают номер эпохи e и эпоха сдвигается на e + 1.
+  Читатель, записавший эпоху > e, открыл снимок уже после подмены
+  и не может увидеть старые объекты.
+*/
+void SnapshotArray::publish(SnapshotVersion* next, bool oldBuffer, Figure* removed) {
+    const SnapshotVersion* old = current.exchange(next, std::memory_order_seq_cst);
+    currentCount.store(next->count, std::memory_order_release);
+    unsigned long long e = epoch.fetch_add(1, std::memory_order_seq_cst);
+
+    retired.push(Retired{const_cast<SnapshotVersion*>(old), sizeof(SnapshotVersion), nullptr, e});
+    if (oldBuffer) {
+        retired.push(Retired{old->items, old->capacity * sizeof(Figure*), nullptr, e});
+    }
+    if (removed) retired.push(Retired{nullptr, 0, removed, e});
+    reclaimLocked();
+}
+
+void SnapshotArray::push(Figure* fig) {
+    if (fig == nullptr) return;
+    std::lock_guard<std::mutex> lock(writeLock);
+
+    const SnapshotVersion* cur = current.load(std::memory_order_relaxed);
+    if (cur->count < cur->capacity) {
+        // Слот за count не виден ни одной версии - пишем на месте
+        cur->items[cur->count] = fig;
+        publish(newVersion(cur->items, cur->count + 1, cur->capacity), false, nullptr);
+        return;
+    }
+
+    int capacity = cur->capacity * 2;
+    Figure** items = newBuffer(capacity);
+    for (int i = 0; i < cur->count; i++) items[i] = cur->items[i];
+    items[cur->count] = fig;
+    publish(newVersion(items, cur->count + 1, capacity), true, nullptr);
+}
+
+void SnapshotArray::remove(int index) {
+    std::lock_guard<std::mutex> lock(writeLock);
+
+    const SnapshotVersion* cur = current.load(std::memory_order_relaxed);
+    if (index < 0 || index >= cur->count) return;
+
+    // Старый буфер еще читают снимки - сдвигать в нем нельзя
+    Figure* removed = cur->items[index];
+    Figure** items = newBuffer(cur->capacity);
+    int n = 0;
+    for (int i = 0; i < cur->count; i++) {
+        if (i != index) items[n++] = cur->items[i];
+    }
+    publish(newVersion(items, n, cur->capacity), true, removed);
+}
+
+// ===================================================================
+// ОСВОБОЖДЕНИЕ
+// ===================================================================
+
+/*
+  Минимальная эпоха среди активных читателей; объекты эпохи e
+  освобождаются, если e меньше ее. Порядок освобождения не важен,
+  поэтому освобожденный элемент заменяется последним.
+*/
+void SnapshotArray::reclaimLocked() {
+    unsigned long long oldest = epoch.load(std::memory_order_seq_cst);
+    for (int i = 0; i < SNAPSHOT_READERS; i++) {
+        unsigned long long r = readers[i].load(std::memory_order_seq_cst);
+        if (r != 0 && r < oldest) oldest = r;
+    }
+
+    int i = 0;
+    while (i < retired.size()) {
+        Retired& item = retired[i];
+        if (item.epoch >= oldest) {
+            i++;
+            continue;
+        }
+        delete item.figure;
+        trackedFree(item.block, item.bytes);
+        item = retired[retired.size() - 1];
+        retired.remove(retired.size() - 1);
+    }
+}
+
+int SnapshotArray::reclaim() {
+    std::lock_guard<std::mutex> lock(writeLock);
+    reclaimLocked();
+    return retired.size();
+}
+
+// ===================================================================
+// ЧТЕНИЕ
+// ===================================================================
+
+int SnapshotArray::size() const {
+    return currentCount.load(std::memory_order_acquire);
+}
+
+/*
+  Читатель занимает свободный слот, записав туда текущую эпоху,
+  и только затем читает указатель на версию. Если эпоха успела
+  сдвинуться между чтением и записью в слот, в слоте окажется
+  меньшее значение - это лишь задержит освобождение.
+*/
+ArraySnapshot SnapshotArray::snapshot() const {
+    while (true) {
+        for (int i = 0; i < SNAPSHOT_READERS; i++) {
+            unsigned long long free = 0;
+            unsigned long long e = epoch.load(std::memory_order_seq_cst);
+            if (readers[i].compare_exchange_strong(free, e, std::memory_order_seq_cst)) {
+                return ArraySnapshot(this, i, current.load(std::memory_order_seq_cst));
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+ArraySnapshot::~ArraySnapshot() {
+    owner->readers[slot].store(0, std::memory_order_release);
+}
+
+double ArraySnapshot::totalArea() const {
+    GEOMETRY_TRACE_SCOPE("ArraySnapshot::totalArea", version->count);
+    double total = 0;
+    for (int i = 0; i < version->count; i++) total += version->items[i]->area();
+    return total;
+}
+
+// ===================================================================
+// ОТЧЕТ О ПАМЯТИ
+// ===================================================================
+
+MemoryReport SnapshotArray::memoryReport() {
+    std::lock_guard<std::mutex> lock(writeLock);
+    const SnapshotVersion* v = current.load(std::memory_order_relaxed);
+
+    MemoryReport report;
+    report.containerBytes = sizeof(SnapshotArray) + sizeof(SnapshotVersion);
+    report.bufferUsed = (long long)v->count * sizeof(Figure*);
+    report.bufferUnused = (long long)(v->capacity - v->count) * sizeof(Figure*);
+    report.addBlock(v, sizeof(SnapshotVersion));
+    report.addBlock(v->items, v->capacity * sizeof(Figure*));
+    if (retired.heapBytes() > 0) report.addBlock(retired.heapBlock(), retired.heapBytes());
+
+    for (int i = 0; i < v->count; i++) {
+        std::size_t size = v->items[i]->objectSize();
+        report.addObject(v->items[i]->getType(), size);
+        report.addBlock(v->items[i], size);
+    }
+    for (int i = 0; i < retired.size(); i++) {
+        const Retired& item = retired[i];
+        if (item.figure) {
+            std::size_t size = item.figure->objectSize();
+            report.addObject(item.figure->getType(), size);
+            report.addBlock(item.figure, size);
+        } else {
+            report.bufferUnused += (long long)item.bytes;
+            report.addBlock(item.block, item.bytes);
+        }
+    }
+    return report;
+}
@@ -1,4 +1,6 @@
 #include "Square.h"
+#include "Instrumentation.h"
+#include "Trace.h"
 #include <iostream>
 #include <cmath>
 
@@ -118,68 +120,6 @@ Square& Square::operator=(Square&& other) noexcept {
 // ВИРТУАЛЬНЫЕ МЕТОДЫ
 // ===================================================================
 
-/**
- * @brief Вычисляет геометрический центр квадрата
- * @return Точка - центр квадрата
- * 
- * Для квадрата центр = среднее арифметическое всех вершин.
- * 
- * Формула:
- * Cx = (x1 + x2 + x3 + x4) / 4
- * Cy = (y1 + y2 + y3 + y4) / 4
- */
-Point Square::center() const {
-    double cx = 0, cy = 0;  // Координаты центра
-    
-    // Суммируем координаты всех вершин
-    for (int i = 0; i < 4; i++) {
-        cx += points[i].x;
-        cy += points[i].y;
-    }
-    
-    // Делим на количество вершин (среднее арифметическое)
-    return Point(cx / 4, cy / 4);
-}
-
-/**
- * @brief Вычисляет площадь квадрата
- * @return Площадь в квадратных единицах
- * 
- * Использует формулу Гаусса (Shoelace formula):
- * S = 1/2 * |sum(xi * yi+1 - xi+1 * yi)|
- * 
- * ЭТА ФОРМУЛА РАБОТАЕТ ДЛЯ ЛЮБОГО ПРОСТОГО МНОГОУГОЛЬНИКА!
- * 
- * Как работает:
- * 1. Для каждой пары соседних вершин (i, i+1) вычисляем:
- *    xi * yi+1 - xi+1 * yi (это удвоенная площадь треугольника)
- * 2. Суммируем все такие значения
- * 3. Берем модуль и делим на 2
- * 
- * Почему это работает?
- * Формула основана на интеграле для площади многоугольника.
- * Каждое слагаемое - это площадь трапеции между стороной
- * многоугольника и осью X.
- */
-double Square::area() const {
-    double sum = 0;  // Сумма для формулы
-    
-    // Проходим по всем вершинам
-    for (int i = 0; i < 4; i++) {
-        // j - индекс следующей вершины
-        // (i + 1) % 4 обеспечивает замыкание: 0→1→2→3→0
-        int j = (i + 1) % 4;
-        
-        // Применяем формулу Гаусса
-        sum += points[i].x * points[j].y;  // xi * yi+1
-        sum -= points[j].x * points[i].y;  // - xi+1 * yi
-    }
-    
-    // Берем модуль (площадь всегда положительна) и делим на 2
-    // fabs() - функция для модуля числа типа double
-    return fabs(sum) / 2.0;
-}
-
 /**
  * @brief Выводит информацию о квадрате в поток
  * @param os Выходной поток (например, std::cout)
@@ -190,6 +130,8 @@ double Square::area() const {
  * Этот метод вызывается оператором <<.
  */
 void Square::print(std::ostream& os) const {
+    GEOMETRY_PROBE(Probe::Print);
+
     os << "Square: ";
     
     // Выводим каждую вершину
@@ -219,6 +161,9 @@ void Square::print(std::ostream& os) const {
  * Этот метод вызывается оператором >>.
  */
 void Square::read(std::istream& is) {
+    GEOMETRY_PROBE(Probe::Read);
+    GEOMETRY_TRACE_SCOPE("Figure::read");
+
     Point temp[4];  // Временный массив для чтения
     
     // Читаем координаты 4 точек
@@ -0,0 +1,395 @@
+#include "Stream.h"
+#include "BoundedQueue.h"
+#include "Codec.h"
+#include "FigureKernels.h"
+#include "Ingest.h"
+#include "Trace.h"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <thread>
+
+/**
+ * @file Stream.cpp
+ * @brief Чтение блоками с двойной буферизацией, разбор строк и кадров
+ *        через границы блоков, накопление статистики
+ */
+
+static long long nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ===================================================================
+// СТАТИСТИКА
+// ===================================================================
+
+/*
+  Номер корзины по двоичному порядку площади: frexp дает area = m * 2^e,
+  m из [0.5, 1), то есть area из [2^(e - 1), 2^e).
+*/
+static int areaBin(double area) {
+    if (!(area > 0)) return 0;
+    int e = 0;
+    std::frexp(area, &e);
+    int bin = e - 1 + STREAM_AREA_BINS / 2;
+    if (bin < 0) return 0;
+    if (bin >= STREAM_AREA_BINS) return STREAM_AREA_BINS - 1;
+    return bin;
+}
+
+double StreamStats::binLowerBound(int bin) {
+    return std::ldexp(1.0, bin - STREAM_AREA_BINS / 2);
+}
+
+/*
+  Записи из 8 чисел и их типы - в статистику. Вершины упорядочиваются
+  так же, как в конструкторе фигуры, иначе формула площади неверна
+  для вершин в произвольном порядке.
+*/
+static void accumulate(StreamStats& stats, const double* records, const FigureKind* kinds, int n) {
+    for (int i = 0; i < n; i++) {
+        const double* r = records + 8 * i;
+        Point p[4] = {Point(r[0], r[1]), Point(r[2], r[3]), Point(r[4], r[5]), Point(r[6], r[7])};
+        orderCounterClockwise(p);
+        double area = shoelaceArea(p, 4);
+        BoundingBox box = vertexBounds(p, 4);
+
+        if (stats.figures == 0) {
+            stats.bounds = box;
+        } else {
+            if (box.minX < stats.bounds.minX) stats.bounds.minX = box.minX;
+            if (box.minY < stats.bounds.minY) stats.bounds.minY = box.minY;
+            if (box.maxX > stats.bounds.maxX) stats.bounds.maxX = box.maxX;
+            if (box.maxY > stats.bounds.maxY) stats.bounds.maxY = box.maxY;
+        }
+        stats.figures++;
+        stats.kinds[(int)kinds[i]]++;
+        stats.totalArea += area;
+        stats.histogram[areaBin(area)]++;
+    }
+}
+
+// ===================================================================
+// РАЗБОР БЛОКОВ
+// ===================================================================
+
+/*
+  Разбор блоков по порядку. Строка или кадр, разрезанные границей
+  блока, копируются в carry и дополняются из следующего блока;
+  остальное разбирается прямо в блоке.
+*/
+class ChunkParser {
+private:
+    StreamFormat format;
+    StreamStats& stats;
+
+    char* carry;
+    int carryBytes;
+    int carryCapacity;
+
+    double* records;        ///< Text: пакет строк; Codec: записи кадра
+    FigureKind* kinds;
+    int recordCapacity;
+    int pendingRecords;     ///< Text: разобрано строк в пакете
+
+    bool corrupt;
+
+    static const int TEXT_BATCH = 256;
+    static const std::uint32_t MAX_FRAME_BYTES = 1u << 30;
+
+    void reserveCarry(int n) {
+        if (n <= carryCapacity) return;
+        int capacity = carryCapacity > 0 ? carryCapacity : 256;
+        while (capacity < n) capacity *= 2;
+        char* grown = new char[capacity];
+        std::memcpy(grown, carry, carryBytes);
+        delete[] carry;
+        carry = grown;
+        carryCapacity = capacity;
+    }
+
+    void appendCarry(const char* p, int n) {
+        reserveCarry(carryBytes + n);
+        std::memcpy(carry + carryBytes, p, n);
+        carryBytes += n;
+    }
+
+    void reserveRecords(int n) {
+        if (n <= recordCapacity) return;
+        int capacity = recordCapacity;
+        while (capacity < n) capacity *= 2;
+        delete[] records;
+        delete[] kinds;
+        records = new double[8 * (long long)capacity];
+        kinds = new FigureKind[capacity];
+        recordCapacity = capacity;
+    }
+
+    void flushText() {
+        accumulate(stats, records, kinds, pendingRecords);
+        pendingRecords = 0;
+    }
+
+    /*
+      Строка без '\n', завершенная нулем.
+    */
+    void textLine(const char* s) {
+        const char* t = s;
+        while (*t == ' ' || *t == '\t' || *t == '\r') t++;
+        if (*t == '\0') return;
+        if (!parseFigureLine(s, kinds[pendingRecords], records + 8 * pendingRecords)) {
+            stats.malformed++;
+            return;
+        }
+        if (++pendingRecords == TEXT_BATCH) flushText();
+    }
+
+    void textChunk(char* p, char* end) {
+        if (carryBytes > 0) {
+            char* nl = (char*)std::memchr(p, '\n', end - p);
+            if (!nl) {
+                appendCarry(p, (int)(end - p));
+                return;
+            }
+            appendCarry(p, (int)(nl - p));
+            appendCarry("", 1);
+            textLine(carry);
+            carryBytes = 0;
+            p = nl + 1;
+        }
+        while (p < end) {
+            char* nl = (char*)std::memchr(p, '\n', end - p);
+            if (!nl) {
+                appendCarry(p, (int)(end - p));
+                return;
+            }
+            *nl = '\0';
+            textLine(p);
+            p = nl + 1;
+        }
+    }
+
+    void frame(const unsigned char* data, std::uint32_t size) {
+        int n = encodedCount(data, size);
+        // Кадр из n фигур занимает не меньше 6n байт (см. decodeFigures)
+        if (n < 0 || (long long)n * 6 > size) {
+            corrupt = true;
+            return;
+        }
+        reserveRecords(n);
+        if (decodeRecords(data, size, records, kinds) != n) {
+            corrupt = true;
+            return;
+        }
+        accumulate(stats, records, kinds, n);
+    }
+
+    /*
+      Дополняет carry из [p, end) до want байт.
+    */
+    const char* fillCarry(const char* p, const char* end, int want) {
+        int take = want - carryBytes;
+        if (take > end - p) take = (int)(end - p);
+        if (take > 0) appendCarry(p, take);
+        return p + (take > 0 ? take : 0);
+    }
+
+    void codecChunk(const char* p, const char* end) {
+        while (!corrupt && (p < end || carryBytes > 0)) {
+            std::uint32_t size = 0;
+            if (carryBytes == 0 && end - p >= 4) {
+                std::memcpy(&size, p, 4);
+                if (size <= MAX_FRAME_BYTES && end - p - 4 >= (long long)size) {
+                    frame((const unsigned char*)p + 4, size);
+                    p += 4 + size;
+                    continue;
+                }
+            }
+
+            p = fillCarry(p, end, 4);
+            if (carryBytes < 4) return;
+            std::memcpy(&size, carry, 4);
+            if (size > MAX_FRAME_BYTES) {
+                corrupt = true;
+                return;
+            }
+            p = fillCarry(p, end, 4 + (int)size);
+            if (carryBytes < 4 + (int)size) return;
+            frame((const unsigned char*)carry + 4, size);
+            carryBytes = 0;
+        }
+    }
+
+public:
+    ChunkParser(StreamFormat format, StreamStats& stats)
+        : format(format), stats(stats), carry(nullptr), carryBytes(0), carryCapacity(0),
+          records(new double[8 * TEXT_BATCH]), kinds(new FigureKind[TEXT_BATCH]),
+          recordCapacity(TEXT_BATCH), pendingRecords(0), corrupt(false) {}
+
+    ~ChunkParser() {
+        delete[] carry;
+        delete[] records;
+        delete[] kinds;
+    }
+
+    ChunkParser(const ChunkParser&) = delete;
+    ChunkParser& operator=(const ChunkParser&) = delete;
+
+    /*
+      Блок можно менять: '\n' заменяются нулями на месте.
+    */
+    void chunk(char* p, int n) {
+        if (format == StreamFormat::Text) {
+            textChunk(p, p + n);
+        } else {
+            codecChunk(p, p + n);
+        }
+    }
+
+    /*
+      Конец файла: последняя строка без '\n' разбирается, неполный
+      кадр - повреждение.
+    */
+    bool finish() {
+        if (format == StreamFormat::Text) {
+            if (carryBytes > 0) {
+                appendCarry("", 1);
+                textLine(carry);
+                carryBytes = 0;
+            }
+            flushText();
+            return true;
+        }
+        return !corrupt && carryBytes == 0;
+    }
+
+    bool failed() const { return corrupt; }
+};
+
+// ===================================================================
+// ЧТЕНИЕ
+// ===================================================================
+
+struct StreamChunk {
+    char* data;
+    int bytes;
+};
+
+typedef BoundedQueue<StreamChunk*> ChunkQueue;
+
+bool streamStats(const char* path, StreamFormat format, StreamStats& stats, const StreamOptions& options) {
+    GEOMETRY_TRACE_SCOPE("streamStats");
+    long long start = nowNs();
+    stats = StreamStats();
+    std::FILE* file = std::fopen(path, "rb");
+    if (!file) return false;
+
+    int chunkBytes = options.chunkBytes > 0 ? options.chunkBytes : 1 << 20;
+    StreamChunk blocks[2];
+    for (int b = 0; b < 2; b++) blocks[b].data = new char[chunkBytes];
+
+    ChunkParser parser(format, stats);
+    bool readError = false;
+
+    if (options.doubleBuffer) {
+        // full: прочитанные блоки по порядку; empty: свободные.
+        // Оба блока в обороте - чтение опережает разбор на один блок
+        ChunkQueue full(2);
+        ChunkQueue empty(2);
+        empty.push(&blocks[0]);
+        empty.push(&blocks[1]);
+
+        std::thread reader([&]() {
+            GEOMETRY_TRACE_SCOPE("stream.read");
+            StreamChunk* block = nullptr;
+            while (empty.pop(block)) {
+                block->bytes = (int)std::fread(block->data, 1, chunkBytes, file);
+                if (block->bytes == 0) {
+                    readError = std::ferror(file) != 0;
+                    break;
+                }
+                full.push(block);
+            }
+            full.close();
+        });
+
+        StreamChunk* block = nullptr;
+        while (true) {
+            long long waitStart = nowNs();
+            if (!full.pop(block)) break;
+            long long computeStart = nowNs();
+            stats.waitNs += computeStart - waitStart;
+
+            stats.bytes += block->bytes;
+            stats.chunks++;
+            if (!parser.failed()) parser.chunk(block->data, block->bytes);
+            stats.computeNs += nowNs() - computeStart;
+            empty.push(block);
+        }
+        empty.close();
+        reader.join();
+    } else {
+        while (true) {
+            long long waitStart = nowNs();
+            int n = (int)std::fread(blocks[0].data, 1, chunkBytes, file);
+            long long computeStart = nowNs();
+            stats.waitNs += computeStart - waitStart;
+            if (n == 0) {
+                readError = std::ferror(file) != 0;
+                break;
+            }
+            stats.bytes += n;
+            stats.chunks++;
+            if (!parser.failed()) parser.chunk(blocks[0].data, n);
+            stats.computeNs += nowNs() - computeStart;
+        }
+    }
+
+    bool ok = parser.finish() && !readError;
+    std::fclose(file);
+    for (int b = 0; b < 2; b++) delete[] blocks[b].data;
+    stats.wallNs = nowNs() - start;
+    return ok;
+}
+
+// ===================================================================
+// ЗАПИСЬ КАДРОВ
+// ===================================================================
+
+bool appendCodecFrame(std::FILE* file, const Array& figures) {
+    unsigned char* code = new unsigned char[encodedSizeBound(figures.size())];
+    long long size = encodeFigures(figures, code);
+    std::uint32_t header = (std::uint32_t)size;
+    bool ok = std::fwrite(&header, 4, 1, file) == 1 &&
+              std::fwrite(code, 1, size, file) == (std::size_t)size;
+    delete[] code;
+    return ok;
+}
+
+// ===================================================================
+// ОТЧЕТ
+// ===================================================================
+
+void StreamStats::print(std::ostream& os) const {
+    os << "figures: " << figures;
+    for (int k = 0; k < (int)FigureKind::Rejected; k++) {
+        os << ", " << kindName((FigureKind)k) << ": " << kinds[k];
+    }
+    os << ", malformed: " << malformed << std::endl;
+    os << "total area: " << totalArea << std::endl;
+    if (figures > 0) {
+        os << "bounds: [" << bounds.minX << ", " << bounds.maxX << "] x ["
+           << bounds.minY << ", " << bounds.maxY << "]" << std::endl;
+    }
+    for (int b = 0; b < STREAM_AREA_BINS; b++) {
+        if (histogram[b] == 0) continue;
+        os << "  area >= " << std::setw(12) << binLowerBound(b) << ": " << histogram[b] << std::endl;
+    }
+    os << std::fixed << std::setprecision(2)
+       << "read: " << bytes / 1048576.0 << " MB in " << chunks << " chunks, wall "
+       << wallNs * 1e-6 << " ms, compute " << computeNs * 1e-6 << " ms, wait "
+       << waitNs * 1e-6 << " ms" << std::defaultfloat << std::setprecision(6) << std::endl;
+}
@@ -0,0 +1,178 @@
+#include "ThreadPool.h"
+#include "Trace.h"
+
+/**
+ * @file ThreadPool.cpp
+ * @brief Исполнители, очереди задач, перехват и ожидание операций
+ */
+
+// Пул и очередь текущего потока-исполнителя (у внешних потоков - nullptr)
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local int currentIndex = 0;
+
+// ===================================================================
+// ИСПОЛНИТЕЛИ
+// ===================================================================
+
+ThreadPool::ThreadPool(int threadCount) : queued(0), sleeping(0), stopping(false) {
+    if (threadCount <= 0) threadCount = (int)std::thread::hardware_concurrency();
+    if (threadCount <= 0) threadCount = 1;
+    this->threadCount = threadCount;
+    workerCount = threadCount - 1;
+
+    queues = new TaskQueue[workerCount + 1];
+    workers = new std::thread[workerCount > 0 ? workerCount : 1];
+    for (int i = 0; i < workerCount; i++) {
+        workers[i] = std::thread([this, i]() { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepLock);
+        stopping.store(true);
+    }
+    wakeUp.notify_all();
+    for (int i = 0; i < workerCount; i++) workers[i].join();
+    delete[] workers;
+    delete[] queues;
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+/*
+  Исполнитель засыпает, только убедившись под sleepLock, что задач
+  нет. pushTask() увеличивает queued до проверки sleeping, а здесь
+  sleeping увеличивается до проверки queued (обе операции seq_cst):
+  хотя бы одна сторона видит другую, и пробуждение не теряется.
+*/
+void ThreadPool::workerLoop(int index) {
+    currentPool = this;
+    currentIndex = index;
+
+    RangeTask task;
+    while (true) {
+        if (findTask(index, task)) {
+            runTask(index, task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepLock);
+        sleeping.fetch_add(1, std::memory_order_seq_cst);
+        while (queued.load(std::memory_order_seq_cst) == 0 && !stopping.load()) wakeUp.wait(lock);
+        sleeping.fetch_sub(1, std::memory_order_seq_cst);
+        if (stopping.load() && queued.load() == 0) return;
+    }
+}
+
+int ThreadPool::currentQueue() const {
+    return currentPool == this ? currentIndex : workerCount;
+}
+
+int ThreadPool::grainFor(int n, int minGrain) const {
+    int grain = n / (8 * threadCount);
+    if (grain < minGrain) grain = minGrain;
+    return grain > 0 ? grain : 1;
+}
+
+// ===================================================================
+// ОЧЕРЕДИ
+// ===================================================================
+
+/*
+  queued меняется под замком очереди: задачу нельзя забрать раньше,
+  чем она учтена, и счетчик не уходит в минус.
+*/
+void ThreadPool::pushTask(int queue, const RangeTask& task) {
+    {
+        std::lock_guard<std::mutex> lock(queues[queue].lock);
+        queues[queue].tasks.push(task);
+        queued.fetch_add(1, std::memory_order_seq_cst);
+    }
+    if (sleeping.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(sleepLock);
+        wakeUp.notify_one();
+    }
+}
+
+bool ThreadPool::popTask(int queue, RangeTask& task) {
+    TaskQueue& q = queues[queue];
+    std::lock_guard<std::mutex> lock(q.lock);
+    int n = q.tasks.size();
+    if (n == 0) return false;
+    task = q.tasks[n - 1];
+    q.tasks.remove(n - 1);
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+/*
+  Чужие очереди обходятся начиная со следующей за своей, чтобы воры
+  не толпились у очереди 0. Забирается первая (самая крупная) задача.
+*/
+bool ThreadPool::stealTask(int thief, RangeTask& task) {
+    int total = workerCount + 1;
+    for (int k = 1; k < total; k++) {
+        if (queued.load(std::memory_order_relaxed) == 0) return false;
+
+        TaskQueue& q = queues[(thief + k) % total];
+        std::lock_guard<std::mutex> lock(q.lock);
+        if (q.tasks.size() == 0) continue;
+        task = q.tasks[0];
+        q.tasks.remove(0);
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::findTask(int queue, RangeTask& task) {
+    return popTask(queue, task) || stealTask(queue, task);
+}
+
+// ===================================================================
+// ВЫПОЛНЕНИЕ
+// ===================================================================
+
+/*
+  Счетчик pending увеличивается до публикации половины: пока
+  выполняется текущая задача, он не меньше 1 и не может обнулиться
+  раньше времени. Уменьшение - последнее обращение к Job: после него
+  вызывающий поток может вернуться и уничтожить Job.
+*/
+void ThreadPool::runTask(int queue, RangeTask task) {
+    Job* job = task.job;
+    while (task.end - task.begin > job->grain) {
+        int mid = task.begin + (task.end - task.begin) / 2;
+        job->pending.fetch_add(1, std::memory_order_relaxed);
+        pushTask(queue, RangeTask{job, mid, task.end});
+        task.end = mid;
+    }
+    job->invoke(job->fn, task.begin, task.end);
+    job->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+/*
+  Вызывающий поток сам начинает деление диапазона, а затем, пока
+  операция не завершена, выполняет любые задачи - свои или чужие.
+*/
+void ThreadPool::run(int begin, int end, int grain, void (*invoke)(const void*, int, int), const void* fn) {
+    GEOMETRY_TRACE_SCOPE("ThreadPool::parallelFor", end - begin);
+    Job job;
+    job.invoke = invoke;
+    job.fn = fn;
+    job.grain = grain;
+    job.pending.store(1, std::memory_order_relaxed);
+
+    int queue = currentQueue();
+    runTask(queue, RangeTask{&job, begin, end});
+
+    RangeTask task;
+    while (job.pending.load(std::memory_order_acquire) > 0) {
+        if (findTask(queue, task)) runTask(queue, task);
+        else std::this_thread::yield();
+    }
+}
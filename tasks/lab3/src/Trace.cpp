@@ -0,0 +1,184 @@
+#include "Trace.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+/**
+ * @file Trace.cpp
+ * @brief Буферы событий по потокам и экспорт в trace-event JSON
+ */
+
+// ===================================================================
+// БУФЕРЫ ПОТОКОВ
+// ===================================================================
+
+const int TRACE_CHUNK_EVENTS = 4096;
+
+struct TraceEvent {
+    const char* name;
+    long long timestamp;  // нс от начала отсчета
+    long long items;      // < 0 - без аргумента
+    char phase;           // 'B' или 'E'
+};
+
+/*
+  Блок событий. Пишет только поток-владелец: сначала слот events[n],
+  затем count = n + 1 с release. Читатель загружает count с acquire
+  и видит все слоты до него полностью записанными.
+*/
+struct TraceChunk {
+    TraceEvent events[TRACE_CHUNK_EVENTS];
+    std::atomic<int> count;
+    std::atomic<TraceChunk*> next;
+
+    TraceChunk() : count(0), next(nullptr) {}
+};
+
+struct ThreadTrace {
+    int tid;
+    TraceChunk* first;
+    TraceChunk* current;         // только для потока-владельца
+    ThreadTrace* nextThread;     // неизменен после публикации
+
+    ThreadTrace(int tid) : tid(tid), first(new TraceChunk()), current(first), nextThread(nullptr) {}
+};
+
+static std::atomic<bool> traceActive(false);
+static std::atomic<ThreadTrace*> traceThreads(nullptr);
+static std::atomic<int> traceNextTid(1);
+
+/*
+  Начало отсчета - первое обращение к трассировке
+*/
+static long long traceNow() {
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count();
+}
+
+/*
+  Буфер текущего потока; при первом событии в потоке создается и
+  добавляется в голову общего списка через CAS. Буферы не удаляются
+  при завершении потока - события нужны и после него, а writeTrace()
+  может читать их без блокировок в этот момент. Это осознанная утечка:
+  заголовок и первый блок на каждый поток (см. Trace.h, ПАМЯТЬ).
+*/
+static ThreadTrace* threadTrace() {
+    thread_local ThreadTrace* mine = nullptr;
+    if (mine) return mine;
+
+    mine = new ThreadTrace(traceNextTid.fetch_add(1, std::memory_order_relaxed));
+    ThreadTrace* head = traceThreads.load(std::memory_order_relaxed);
+    do {
+        mine->nextThread = head;
+    } while (!traceThreads.compare_exchange_weak(head, mine, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+    return mine;
+}
+
+static void traceEmit(const char* name, char phase, long long items) {
+    long long now = traceNow();
+    ThreadTrace* t = threadTrace();
+    TraceChunk* chunk = t->current;
+    int n = chunk->count.load(std::memory_order_relaxed);
+    if (n == TRACE_CHUNK_EVENTS) {
+        TraceChunk* grown = new TraceChunk();
+        chunk->next.store(grown, std::memory_order_release);
+        t->current = chunk = grown;
+        n = 0;
+    }
+    TraceEvent& e = chunk->events[n];
+    e.name = name;
+    e.timestamp = now;
+    e.items = items;
+    e.phase = phase;
+    chunk->count.store(n + 1, std::memory_order_release);
+}
+
+// ===================================================================
+// ПУБЛИЧНЫЙ ИНТЕРФЕЙС
+// ===================================================================
+
+void traceStart() {
+    traceNow();  // фиксируем начало отсчета
+    traceActive.store(true, std::memory_order_relaxed);
+}
+
+void traceStop() {
+    traceActive.store(false, std::memory_order_relaxed);
+}
+
+bool traceEnabled() {
+    return traceActive.load(std::memory_order_relaxed);
+}
+
+bool traceBegin(const char* name, long long items) {
+    if (!traceActive.load(std::memory_order_relaxed)) return false;
+    traceEmit(name, 'B', items);
+    return true;
+}
+
+void traceEnd(const char* name) {
+    traceEmit(name, 'E', -1);
+}
+
+long long traceEventCount() {
+    long long total = 0;
+    for (ThreadTrace* t = traceThreads.load(std::memory_order_acquire); t; t = t->nextThread) {
+        for (TraceChunk* c = t->first; c; c = c->next.load(std::memory_order_acquire)) {
+            total += c->count.load(std::memory_order_acquire);
+        }
+    }
+    return total;
+}
+
+void traceClear() {
+    for (ThreadTrace* t = traceThreads.load(std::memory_order_acquire); t; t = t->nextThread) {
+        TraceChunk* c = t->first->next.load(std::memory_order_relaxed);
+        while (c) {
+            TraceChunk* next = c->next.load(std::memory_order_relaxed);
+            delete c;
+            c = next;
+        }
+        t->first->next.store(nullptr, std::memory_order_relaxed);
+        t->first->count.store(0, std::memory_order_release);
+        t->current = t->first;
+    }
+}
+
+/*
+  Формат: {"traceEvents": [...]}; время ts - в микросекундах (дробное),
+  pid один на процесс, tid - номер буфера потока. Для каждого потока
+  добавляется событие-метаданные с именем потока.
+*/
+bool writeTrace(std::ostream& os) {
+    char line[256];
+    bool first = true;
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+    for (ThreadTrace* t = traceThreads.load(std::memory_order_acquire); t; t = t->nextThread) {
+        std::snprintf(line, sizeof(line),
+                      "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                      "\"args\":{\"name\":\"thread %d\"}}",
+                      first ? "" : ",\n", t->tid, t->tid);
+        os << line;
+        first = false;
+
+        for (TraceChunk* c = t->first; c; c = c->next.load(std::memory_order_acquire)) {
+            int n = c->count.load(std::memory_order_acquire);
+            for (int i = 0; i < n; i++) {
+                const TraceEvent& e = c->events[i];
+                int len = std::snprintf(line, sizeof(line),
+                                        ",\n{\"name\":\"%s\",\"cat\":\"geometry\",\"ph\":\"%c\","
+                                        "\"ts\":%lld.%03lld,\"pid\":1,\"tid\":%d",
+                                        e.name, e.phase, e.timestamp / 1000, e.timestamp % 1000, t->tid);
+                if (e.items >= 0 && len > 0 && len < (int)sizeof(line)) {
+                    std::snprintf(line + len, sizeof(line) - len, ",\"args\":{\"items\":%lld}", e.items);
+                }
+                os << line << "}";
+            }
+        }
+    }
+    os << "\n]}\n";
+    return (bool)os;
+}
@@ -0,0 +1,137 @@
+#include "Transform.h"
+#include "Array.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @file Transform.cpp
+ * @brief Аффинные преобразования: конструкторы матриц и векторные ядра
+ */
+
+// Векторные ядра читают Point[] как плотный массив double: x0 y0 x1 y1 ...
+static_assert(sizeof(Point) == 2 * sizeof(double), "Point must be two packed doubles");
+
+// ===================================================================
+// КОНСТРУКТОРЫ МАТРИЦ
+// ===================================================================
+
+AffineTransform AffineTransform::translation(double dx, double dy) {
+    return AffineTransform(1, 0, dx, 0, 1, dy);
+}
+
+/*
+  Поворот вокруг center = сдвиг center в начало, поворот, сдвиг обратно.
+  Свободный член: center - R * center.
+*/
+AffineTransform AffineTransform::rotation(double angle, const Point& center) {
+    double cs = cos(angle), sn = sin(angle);
+    return AffineTransform(cs, -sn, center.x - (cs * center.x - sn * center.y),
+                           sn, cs, center.y - (sn * center.x + cs * center.y));
+}
+
+AffineTransform AffineTransform::scaling(double sx, double sy, const Point& center) {
+    return AffineTransform(sx, 0, center.x - sx * center.x,
+                           0, sy, center.y - sy * center.y);
+}
+
+/*
+  next(this(p)) = N * (M * p + t) + tn = (N * M) * p + (N * t + tn)
+*/
+AffineTransform AffineTransform::then(const AffineTransform& next) const {
+    return AffineTransform(
+        next.a * a + next.b * c, next.a * b + next.b * d, next.a * tx + next.b * ty + next.tx,
+        next.c * a + next.d * c, next.c * b + next.d * d, next.c * tx + next.d * ty + next.ty);
+}
+
+// ===================================================================
+// ВЕКТОРНЫЕ ЯДРА
+// ===================================================================
+
+/*
+  Точка (x, y) лежит в регистре как [x, y]. Тогда
+  [x', y'] = [x, x] * [a, c] + [y, y] * [b, d] + [tx, ty]
+  - то есть два умножения и два сложения на точку без перестановок
+  данных в памяти. AVX обрабатывает две точки за раз.
+*/
+void transformPoints(Point* points, int n, const AffineTransform& m) {
+    double* p = &points[0].x;
+    int i = 0;
+#if defined(__AVX__)
+    __m256d col0 = _mm256_setr_pd(m.a, m.c, m.a, m.c);
+    __m256d col1 = _mm256_setr_pd(m.b, m.d, m.b, m.d);
+    __m256d shift = _mm256_setr_pd(m.tx, m.ty, m.tx, m.ty);
+    for (; i + 2 <= n; i += 2) {
+        __m256d v = _mm256_loadu_pd(p + 2 * i);
+        __m256d xx = _mm256_unpacklo_pd(v, v);
+        __m256d yy = _mm256_unpackhi_pd(v, v);
+        __m256d r = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(xx, col0),
+                                                _mm256_mul_pd(yy, col1)), shift);
+        _mm256_storeu_pd(p + 2 * i, r);
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    __m128d c0 = _mm_setr_pd(m.a, m.c);
+    __m128d c1 = _mm_setr_pd(m.b, m.d);
+    __m128d t = _mm_setr_pd(m.tx, m.ty);
+    for (; i < n; i++) {
+        __m128d v = _mm_loadu_pd(p + 2 * i);
+        __m128d xx = _mm_unpacklo_pd(v, v);
+        __m128d yy = _mm_unpackhi_pd(v, v);
+        _mm_storeu_pd(p + 2 * i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(xx, c0),
+                                                       _mm_mul_pd(yy, c1)), t));
+    }
+#endif
+    for (; i < n; i++) points[i] = m.apply(points[i]);
+}
+
+void transformColumns(double* xs, double* ys, int n, const AffineTransform& m) {
+    int i = 0;
+#if defined(__AVX__)
+    __m256d a = _mm256_set1_pd(m.a), b = _mm256_set1_pd(m.b), tx = _mm256_set1_pd(m.tx);
+    __m256d c = _mm256_set1_pd(m.c), d = _mm256_set1_pd(m.d), ty = _mm256_set1_pd(m.ty);
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(xs + i);
+        __m256d y = _mm256_loadu_pd(ys + i);
+        _mm256_storeu_pd(xs + i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(a, x), _mm256_mul_pd(b, y)), tx));
+        _mm256_storeu_pd(ys + i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(c, x), _mm256_mul_pd(d, y)), ty));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    __m128d a = _mm_set1_pd(m.a), b = _mm_set1_pd(m.b), tx = _mm_set1_pd(m.tx);
+    __m128d c = _mm_set1_pd(m.c), d = _mm_set1_pd(m.d), ty = _mm_set1_pd(m.ty);
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = _mm_loadu_pd(xs + i);
+        __m128d y = _mm_loadu_pd(ys + i);
+        _mm_storeu_pd(xs + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(a, x), _mm_mul_pd(b, y)), tx));
+        _mm_storeu_pd(ys + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(c, x), _mm_mul_pd(d, y)), ty));
+    }
+#endif
+    for (; i < n; i++) {
+        double x = xs[i], y = ys[i];
+        xs[i] = m.a * x + m.b * y + m.tx;
+        ys[i] = m.c * x + m.d * y + m.ty;
+    }
+}
+
+// ===================================================================
+// ПРЕОБРАЗОВАНИЕ КОЛЛЕКЦИИ
+// ===================================================================
+
+void transformFigures(Array& figures, const AffineTransform& m, ThreadPool* pool) {
+    GEOMETRY_TRACE_SCOPE("transformFigures", figures.size());
+    if (pool == nullptr) pool = &ThreadPool::shared();
+
+    // На одну фигуру приходится ~10 нс работы: задачу имеет смысл
+    // выделять только на тысячи фигур
+    const int minFiguresPerTask = 4096;
+    pool->parallelFor(0, figures.size(), [&figures, &m](int begin, int end) {
+        GEOMETRY_TRACE_SCOPE("transformFigures.chunk", end - begin);
+        for (int i = begin; i < end; i++) figures.get(i)->transform(m);
+    }, minFiguresPerTask);
+}
@@ -0,0 +1,177 @@
+#include "UnionArea.h"
+#include "FigureIndex.h"
+#include "Trace.h"
+#include "SmallArray.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+/**
+ * @file UnionArea.cpp
+ * @brief Площадь объединения: вклад непокрытых частей сторон
+ */
+
+// ===================================================================
+// ВСПОМОГАТЕЛЬНЫЕ СТРУКТУРЫ
+// ===================================================================
+
+/*
+  Событие на стороне AB: в точке A + t * (B - A) покрытие меняется на delta
+  (+1 - сторона входит в соседнюю фигуру, -1 - выходит).
+*/
+struct CoverEvent {
+    double t;
+    int delta;
+
+    bool operator<(const CoverEvent& other) const {
+        return t < other.t || (t == other.t && delta < other.delta);
+    }
+};
+
+/*
+  Рабочие буферы одного потока: соседи текущей фигуры и события текущей
+  стороны. Типичные количества помещаются во встроенные буферы SmallArray;
+  большие растут удвоением и переиспользуются между фигурами, поэтому
+  после разгона выделений памяти нет.
+*/
+struct UnionScratch {
+    SmallArray<int, 16> neighbours;
+    SmallArray<CoverEvent, 16> events;
+};
+
+static int sign(double v) {
+    return (v > 0) - (v < 0);
+}
+
+static double cross(const Point& o, const Point& a, const Point& b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// ===================================================================
+// ВКЛАД ОДНОЙ ФИГУРЫ
+// ===================================================================
+
+/*
+  Возвращает удвоенный вклад сторон фигуры i в площадь объединения.
+
+  Для стороны AB фигуры i и стороны CD соседа j:
+  - C и D по разные стороны от AB: AB пересекает границу j в точке
+    t = sa / (sa - sb); знак sc - sd говорит, входим мы в j или выходим;
+  - CD лежит на прямой AB и направлена так же: если j < i, отрезок
+    CD считается покрытым (совпадающие стороны учитываются один раз);
+    стороны противоположного направления взаимно сокращаются сами.
+*/
+static double figureContribution(const Array& figures, const FigureIndex& index,
+                                 int i, UnionScratch& scratch) {
+    const Point* poly = figures.get(i)->getPoints();
+
+    scratch.neighbours.clear();
+    index.forEachCandidate(index.bounds(i), [&](int j) {
+        if (j != i) scratch.neighbours.push(j);
+    });
+
+    double sum = 0;
+    for (int v = 0; v < 4; v++) {
+        const Point& A = poly[v];
+        const Point& B = poly[(v + 1) % 4];
+        BoundingBox edgeBox(std::min(A.x, B.x), std::min(A.y, B.y),
+                            std::max(A.x, B.x), std::max(A.y, B.y));
+
+        scratch.events.clear();
+        scratch.events.push(CoverEvent{0, 0});
+        scratch.events.push(CoverEvent{1, 0});
+
+        for (int n = 0; n < scratch.neighbours.size(); n++) {
+            int j = scratch.neighbours[n];
+            if (!index.bounds(j).intersects(edgeBox)) continue;
+            const Point* other = figures.get(j)->getPoints();
+
+            for (int u = 0; u < 4; u++) {
+                const Point& C = other[u];
+                const Point& D = other[(u + 1) % 4];
+                int sc = sign(cross(A, B, C));
+                int sd = sign(cross(A, B, D));
+                if (sc != sd) {
+                    if (std::min(sc, sd) < 0) {
+                        double sa = cross(C, D, A);
+                        double sb = cross(C, D, B);
+                        scratch.events.push(CoverEvent{sa / (sa - sb), sign((double)(sc - sd))});
+                    }
+                } else if (sc == 0 && j < i) {
+                    double dx = B.x - A.x, dy = B.y - A.y;
+                    if ((D.x - C.x) * dx + (D.y - C.y) * dy > 0) {
+                        double len2 = dx * dx + dy * dy;
+                        scratch.events.push(CoverEvent{((C.x - A.x) * dx + (C.y - A.y) * dy) / len2, 1});
+                        scratch.events.push(CoverEvent{((D.x - A.x) * dx + (D.y - A.y) * dy) / len2, -1});
+                    }
+                }
+            }
+        }
+
+        CoverEvent* ev = scratch.events.begin();
+        int evCount = scratch.events.size();
+        std::sort(ev, ev + evCount);
+        for (int k = 0; k < evCount; k++) ev[k].t = std::min(std::max(ev[k].t, 0.0), 1.0);
+
+        // Доля стороны, где покрытие равно нулю
+        double uncovered = 0;
+        int cover = ev[0].delta;
+        for (int k = 1; k < evCount; k++) {
+            if (cover == 0) uncovered += ev[k].t - ev[k - 1].t;
+            cover += ev[k].delta;
+        }
+        sum += (A.x * B.y - A.y * B.x) * uncovered;
+    }
+    return sum;
+}
+
+// ===================================================================
+// ПОСЛЕДОВАТЕЛЬНЫЙ И ПАРАЛЛЕЛЬНЫЙ ВАРИАНТЫ
+// ===================================================================
+
+double unionArea(const Array& figures) {
+    GEOMETRY_TRACE_SCOPE("unionArea", figures.size());
+    FigureIndex index(figures);
+    UnionScratch scratch;
+    double sum = 0;
+    for (int i = 0; i < figures.size(); i++) {
+        sum += figureContribution(figures, index, i, scratch);
+    }
+    return sum / 2;
+}
+
+double unionAreaParallel(const Array& figures, ThreadPool* pool) {
+    GEOMETRY_TRACE_SCOPE("unionAreaParallel", figures.size());
+    if (pool == nullptr) pool = &ThreadPool::shared();
+    int n = figures.size();
+    if (pool->getThreadCount() <= 1 || n < 2 * pool->getThreadCount()) return unionArea(figures);
+
+    FigureIndex index(figures);
+
+    // Упорядочиваем фигуры по X центра AABB: соседние куски массива order -
+    // вертикальные полосы плоскости с равным числом фигур
+    int* order = new int[n];
+    for (int i = 0; i < n; i++) order[i] = i;
+    {
+        GEOMETRY_TRACE_SCOPE("unionArea.sort", n);
+        std::sort(order, order + n, [&](int a, int b) {
+            const BoundingBox& ba = index.bounds(a);
+            const BoundingBox& bb = index.bounds(b);
+            return ba.minX + ba.maxX < bb.minX + bb.maxX;
+        });
+    }
+
+    // Полосы - куски свертки: у фигур разное число соседей, и неровную
+    // нагрузку выравнивает перехват задач
+    double total = pool->parallelReduce(0, n, 0.0, [&](int begin, int end) {
+        GEOMETRY_TRACE_SCOPE("unionArea.strip", end - begin);
+        UnionScratch scratch;
+        double sum = 0;
+        for (int k = begin; k < end; k++) {
+            sum += figureContribution(figures, index, order[k], scratch);
+        }
+        return sum;
+    }, [](double a, double b) { return a + b; });
+
+    delete[] order;
+    return total / 2;
+}
@@ -0,0 +1,434 @@
+#include <gtest/gtest.h>
+#include "Square.h"
+#include "Rectangle.h"
+#include "Trapezoid.h"
+#include "Array.h"
+#include "Transform.h"
+#include "ThreadPool.h"
+#include "Classifier.h"
+#include "Ingest.h"
+#include "BoundedQueue.h"
+#include "Generator.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+/**
+ * @file test_bulk.cpp
+ *
+ * Тесты массовых операций над коллекциями фигур:
+ * аффинные преобразования, классификация сырых записей,
+ * конвейерная загрузка, генерация наборов.
+ */
+
+/**
+ * @brief Удвоенная ориентированная площадь (> 0 для обхода против часовой)
+ */
+static double signedArea2(const Figure& fig) {
+    const Point* p = fig.getPoints();
+    double sum = 0;
+    for (int i = 0; i < 4; i++) {
+        int j = (i + 1) % 4;
+        sum += p[i].x * p[j].y - p[j].x * p[i].y;
+    }
+    return sum;
+}
+
+// ===================================================================
+// ГРУППА 1: АФФИННЫЕ ПРЕОБРАЗОВАНИЯ
+// ===================================================================
+
+/**
+ * Сдвиг: площадь сохраняется, центр смещается
+ */
+TEST(TransformTest, Translation) {
+    Point p[4] = {Point(0, 0), Point(4, 0), Point(4, 2), Point(0, 2)};
+    Rectangle rect(p);
+    rect.transform(AffineTransform::translation(10, -5));
+    EXPECT_DOUBLE_EQ(rect.area(), 8.0);
+    EXPECT_DOUBLE_EQ(rect.center().x, 12.0);
+    EXPECT_DOUBLE_EQ(rect.center().y, -4.0);
+}
+
+/**
+ * Поворот и масштаб: обход остается против часовой стрелки без sortPoints()
+ */
+TEST(TransformTest, RotationAndScaleKeepOrientation) {
+    Point p[4] = {Point(0, 0), Point(4, 0), Point(3, 2), Point(1, 2)};
+    Trapezoid trap(p);
+    AffineTransform m = AffineTransform::rotation(1.0, Point(2, 1))
+                            .then(AffineTransform::scaling(2, 3));
+    trap.transform(m);
+    EXPECT_GT(signedArea2(trap), 0);
+    EXPECT_NEAR(trap.area(), 6.0 * 6.0, 1e-9);
+    EXPECT_TRUE(trap.contains(m.apply(Point(2, 1))));
+}
+
+/**
+ * Отражение: вершины переупорядочиваются разворотом, ориентация сохраняется
+ */
+TEST(TransformTest, MirrorReversesOrder) {
+    Point p[4] = {Point(0, 0), Point(4, 0), Point(3, 2), Point(1, 2)};
+    Trapezoid trap(p);
+    trap.transform(AffineTransform::scaling(-1, 1));
+    EXPECT_GT(signedArea2(trap), 0);
+    EXPECT_NEAR(trap.area(), 6.0, 1e-12);
+    EXPECT_TRUE(trap.contains(Point(-2, 1)));
+    EXPECT_FALSE(trap.contains(Point(2, 1)));
+}
+
+/**
+ * Колоночное ядро совпадает с поточечным применением
+ */
+TEST(TransformTest, ColumnsMatchPointwise) {
+    const int n = 11;  // не кратно ширине вектора - проверяем хвост
+    double xs[n], ys[n];
+    Point pts[n];
+    for (int i = 0; i < n; i++) {
+        xs[i] = i * 0.5;
+        ys[i] = 3 - i;
+        pts[i] = Point(xs[i], ys[i]);
+    }
+    AffineTransform m(0.3, -1.2, 5, 2.0, 0.7, -1);
+    transformColumns(xs, ys, n, m);
+    transformPoints(pts, n, m);
+    for (int i = 0; i < n; i++) {
+        Point expected = m.apply(Point(i * 0.5, 3 - i));
+        EXPECT_DOUBLE_EQ(xs[i], expected.x);
+        EXPECT_DOUBLE_EQ(ys[i], expected.y);
+        EXPECT_DOUBLE_EQ(pts[i].x, expected.x);
+        EXPECT_DOUBLE_EQ(pts[i].y, expected.y);
+    }
+}
+
+/**
+ * Коллекция: многопоточный вариант дает тот же результат, что и поштучный
+ */
+TEST(TransformTest, CollectionMatchesPerFigure) {
+    Array arr;
+    Array expected;
+    for (int i = 0; i < 10000; i++) {
+        Point p[4] = {Point(i, 0), Point(i + 2, 0), Point(i + 2, 1), Point(i, 1)};
+        arr.push(new Rectangle(p));
+        expected.push(new Rectangle(p));
+    }
+    AffineTransform m = AffineTransform::rotation(0.25).then(AffineTransform::scaling(1, -2));
+    ThreadPool pool(4);
+    transformFigures(arr, m, &pool);
+    for (int i = 0; i < expected.size(); i++) expected.get(i)->transform(m);
+
+    for (int i = 0; i < arr.size(); i++) {
+        ASSERT_TRUE(*arr.get(i) == *expected.get(i));
+        ASSERT_GT(signedArea2(*arr.get(i)), 0);
+    }
+    EXPECT_NEAR(arr.totalArea(), 2 * 2.0 * 10000, 1e-6);
+}
+
+// ===================================================================
+// ГРУППА 2: КЛАССИФИКАЦИЯ
+// ===================================================================
+
+/**
+ * Типы определяются при любом порядке вершин
+ */
+TEST(ClassifierTest, KindsIgnoreVertexOrder) {
+    Point square[4] = {Point(0, 0), Point(2, 2), Point(2, 0), Point(0, 2)};
+    Point rect[4] = {Point(0, 0), Point(4, 1), Point(0, 1), Point(4, 0)};
+    Point trap[4] = {Point(1, 2), Point(0, 0), Point(3, 2), Point(5, 0)};
+
+    EXPECT_EQ(classifyPoints(square), FigureKind::Square);
+    EXPECT_EQ(classifyPoints(rect), FigureKind::Rectangle);
+    EXPECT_EQ(classifyPoints(trap), FigureKind::Trapezoid);
+
+    // Повернутый квадрат со стороной не по осям
+    double c = cos(0.3), s = sin(0.3);
+    Point rotated[4] = {Point(0, 0), Point(c - s, s + c), Point(c, s), Point(-s, c)};
+    EXPECT_EQ(classifyPoints(rotated), FigureKind::Square);
+
+    // Параллелограмм с неравными диагоналями - не прямоугольник, но трапеция
+    Point parallelogram[4] = {Point(0, 0), Point(3, 0), Point(4, 1), Point(1, 1)};
+    EXPECT_EQ(classifyPoints(parallelogram), FigureKind::Trapezoid);
+}
+
+/**
+ * Причины отказа
+ */
+TEST(ClassifierTest, RejectReasons) {
+    RejectReason reason;
+
+    Point nan[4] = {Point(0, 0), Point(1, 0), Point(1, NAN), Point(0, 1)};
+    EXPECT_EQ(classifyPoints(nan, &reason), FigureKind::Rejected);
+    EXPECT_EQ(reason, RejectReason::NonFinite);
+
+    Point inf[4] = {Point(0, 0), Point(INFINITY, 0), Point(1, 1), Point(0, 1)};
+    EXPECT_EQ(classifyPoints(inf, &reason), FigureKind::Rejected);
+    EXPECT_EQ(reason, RejectReason::NonFinite);
+
+    Point duplicate[4] = {Point(0, 0), Point(0, 0), Point(1, 1), Point(0, 1)};
+    EXPECT_EQ(classifyPoints(duplicate, &reason), FigureKind::Rejected);
+    EXPECT_EQ(reason, RejectReason::Degenerate);
+
+    Point collinear[4] = {Point(0, 0), Point(1, 0), Point(2, 0), Point(0, 1)};
+    EXPECT_EQ(classifyPoints(collinear, &reason), FigureKind::Rejected);
+    EXPECT_EQ(reason, RejectReason::Degenerate);
+
+    Point dart[4] = {Point(0, 0), Point(4, 0), Point(0, 4), Point(1, 1)};
+    EXPECT_EQ(classifyPoints(dart, &reason), FigureKind::Rejected);
+    EXPECT_EQ(reason, RejectReason::NonConvex);
+
+    Point general[4] = {Point(0, 0), Point(4, 0), Point(5, 3), Point(1, 2)};
+    EXPECT_EQ(classifyPoints(general, &reason), FigureKind::Rejected);
+    EXPECT_EQ(reason, RejectReason::NoParallelSides);
+
+    Point ok[4] = {Point(0, 0), Point(1, 0), Point(1, 1), Point(0, 1)};
+    classifyPoints(ok, &reason);
+    EXPECT_EQ(reason, RejectReason::None);
+}
+
+/**
+ * Пакет: блоки по 64 с хвостом, счетчики и массовая загрузка
+ */
+TEST(ClassifierTest, BatchStatsAndLoad) {
+    const int n = 150;
+    double* records = new double[8 * n];
+    for (int i = 0; i < n; i++) {
+        double* r = records + 8 * i;
+        double x = i * 10;
+        switch (i % 3) {
+            case 0: {  // квадрат, вершины вперемешку
+                double q[8] = {x, 0, x + 1, 1, x + 1, 0, x, 1};
+                for (int k = 0; k < 8; k++) r[k] = q[k];
+                break;
+            }
+            case 1: {  // трапеция
+                double q[8] = {x, 0, x + 4, 0, x + 3, 2, x + 1, 2};
+                for (int k = 0; k < 8; k++) r[k] = q[k];
+                break;
+            }
+            default: {  // вырожденная запись
+                double q[8] = {x, 0, x + 1, 0, x + 2, 0, x + 3, 0};
+                for (int k = 0; k < 8; k++) r[k] = q[k];
+                break;
+            }
+        }
+    }
+
+    FigureKind* kinds = new FigureKind[n];
+    RejectReason* reasons = new RejectReason[n];
+    ClassifyStats stats;
+    classifyRecords(records, n, kinds, reasons, &stats);
+    for (int i = 0; i < n; i++) {
+        FigureKind expected = i % 3 == 0 ? FigureKind::Square
+                            : i % 3 == 1 ? FigureKind::Trapezoid : FigureKind::Rejected;
+        ASSERT_EQ(kinds[i], expected) << i;
+    }
+    EXPECT_EQ(stats.count(FigureKind::Square), 50);
+    EXPECT_EQ(stats.count(FigureKind::Trapezoid), 50);
+    EXPECT_EQ(stats.count(FigureKind::Rejected), 50);
+    EXPECT_EQ(stats.count(RejectReason::Degenerate), 50);
+
+    Array arr;
+    EXPECT_EQ(loadClassified(records, n, arr), 100);
+    ASSERT_EQ(arr.size(), 100);
+    EXPECT_STREQ(arr.get(0)->getType(), "Square");
+    EXPECT_STREQ(arr.get(1)->getType(), "Trapezoid");
+    EXPECT_NEAR(arr.totalArea(), 50 * 1.0 + 50 * 6.0, 1e-9);
+
+    delete[] reasons;
+    delete[] kinds;
+    delete[] records;
+}
+
+// ===================================================================
+// ГРУППА 3: КОНВЕЙЕРНАЯ ЗАГРУЗКА
+// ===================================================================
+
+/**
+ * Закрытая очередь отдает оставшееся, затем pop() - false;
+ * производитель ждет место в полной очереди
+ */
+TEST(IngestTest, BoundedQueueCloseAndBackpressure) {
+    BoundedQueue<int> queue(2);
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+
+    std::thread producer([&queue]() {
+        for (int i = 3; i <= 100; i++) queue.push(i);
+        queue.close();
+    });
+    int value = 0, expected = 1;
+    while (queue.pop(value)) {
+        ASSERT_EQ(value, expected++);
+        ASSERT_LE(queue.size(), 2);
+    }
+    producer.join();
+    EXPECT_EQ(expected, 101);
+    EXPECT_FALSE(queue.push(7));
+}
+
+/**
+ * Порядок строк сохраняется при нескольких потоках Order;
+ * ошибки разбора и несовпадения типа отбрасываются и считаются
+ */
+TEST(IngestTest, PipelineKeepsOrderAndRejects) {
+    std::ostringstream text;
+    const int n = 3000;
+    for (int i = 0; i < n; i++) {
+        double x = i * 3;
+        if (i % 10 == 3) text << "Square " << x << " 0 " << x + 2 << " 0 " << x + 2 << " 1 " << x << " 1\n";
+        else if (i % 10 == 7) text << "Hexagon 0 0 1 0 1 1 0 1\n";
+        else if (i % 2 == 0) text << "Trapezoid " << x << " 0 " << x + 2 << " 0 " << x + 1 << " 1 " << x << " 1\n";
+        else text << "  Rectangle " << x + 2 << " 1 " << x << " 0 " << x + 2 << " 0 " << x << " 1  \n\n";
+    }
+    text << "Square 0 0 1\n";
+
+    std::istringstream in(text.str());
+    Array arr;
+    IngestReport report;
+    IngestOptions options;
+    options.queueCapacity = 1;
+    options.orderThreads = 3;
+    int stored = ingestFigures(in, arr, &report, options);
+
+    EXPECT_EQ(report.lines, n + 1);
+    EXPECT_EQ(report.malformed, n / 10 + 1);
+    EXPECT_EQ(report.mismatched, n / 10);
+    EXPECT_EQ(stored, n - 2 * (n / 10));
+    ASSERT_EQ(arr.size(), stored);
+    EXPECT_EQ(report.stored, stored);
+
+    // Фигуры идут в порядке строк: левый край растет
+    for (int i = 1; i < arr.size(); i++) {
+        ASSERT_LT(arr.get(i - 1)->bounds().minX, arr.get(i)->bounds().minX);
+    }
+    EXPECT_STREQ(arr.get(0)->getType(), "Trapezoid");
+    EXPECT_STREQ(arr.get(1)->getType(), "Rectangle");
+
+    for (int s = 1; s < INGEST_STAGE_COUNT; s++) {
+        EXPECT_EQ(report.stages[s].items, n - n / 10);
+    }
+    EXPECT_EQ(report.stage(IngestStage::Order).threads, 3);
+
+    std::ostringstream printed;
+    report.print(printed);
+    EXPECT_NE(printed.str().find("bottleneck"), std::string::npos);
+}
+
+static void slowFirstBatches(long long sequence) {
+    if (sequence % 16 == 1) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+/**
+ * Медленный пакет в одном потоке Order не дает остальным уйти вперед:
+ * Store держит не больше queueCapacity + orderThreads пакетов
+ */
+TEST(IngestTest, SlowOrderStepIsBounded) {
+    std::ostringstream text;
+    const int n = 64 * INGEST_BATCH_SIZE;
+    for (int i = 0; i < n; i++) {
+        double x = i * 3;
+        text << "Square " << x << " 0 " << x + 1 << " 0 " << x + 1 << " 1 " << x << " 1\n";
+    }
+
+    std::istringstream in(text.str());
+    Array arr;
+    IngestReport report;
+    IngestOptions options;
+    options.queueCapacity = 2;
+    options.orderThreads = 4;
+    options.orderHook = slowFirstBatches;
+    EXPECT_EQ(ingestFigures(in, arr, &report, options), n);
+
+    EXPECT_GT(report.maxReordered, 1);
+    EXPECT_LE(report.maxReordered, options.queueCapacity + options.orderThreads);
+    ASSERT_EQ(arr.size(), n);
+    for (int i = 1; i < arr.size(); i++) {
+        ASSERT_LT(arr.get(i - 1)->bounds().minX, arr.get(i)->bounds().minX);
+    }
+}
+
+// ===================================================================
+// ГРУППА 4: ГЕНЕРАТОР НАБОРОВ
+// ===================================================================
+
+static std::string readWhole(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream data;
+    data << in.rdbuf();
+    return data.str();
+}
+
+/**
+ * Файл зависит только от параметров, а не от числа потоков
+ */
+TEST(GeneratorTest, SameFileForAnyThreadCount) {
+    std::string a = ::testing::TempDir() + "gen_a", b = ::testing::TempDir() + "gen_b";
+    GeneratorOptions options;
+    options.seed = 7;
+    options.duplicateRatio = 0.2;
+    ThreadPool single(1), several(3);
+    const int n = 3 * GENERATOR_BLOCK + 17;
+
+    StreamFormat formats[2] = {StreamFormat::Text, StreamFormat::Codec};
+    for (int f = 0; f < 2; f++) {
+        long long bytes = generateFigures(a.c_str(), formats[f], n, options, &single);
+        ASSERT_GT(bytes, 0);
+        ASSERT_EQ(generateFigures(b.c_str(), formats[f], n, options, &several), bytes);
+        EXPECT_TRUE(readWhole(a) == readWhole(b));
+    }
+
+    options.seed = 8;
+    generateFigures(b.c_str(), StreamFormat::Codec, n, options, &several);
+    EXPECT_FALSE(readWhole(a) == readWhole(b));
+    std::remove(a.c_str());
+    std::remove(b.c_str());
+}
+
+/**
+ * Все фигуры проходят проверку типа при загрузке; повторы равны
+ * оригиналам; суммарная площадь соответствует плотности перекрытий
+ */
+TEST(GeneratorTest, FiguresMatchOptionsAndLoad) {
+    GeneratorOptions options;
+    options.duplicateRatio = 0.3;
+    options.overlap = 2;
+    options.scale = 100;
+    const int n = 5000;
+
+    std::string text = ::testing::TempDir() + "gen_text";
+    ASSERT_GT(generateFigures(text.c_str(), StreamFormat::Text, n, options), 0);
+    std::ifstream in(text);
+    Array arr;
+    IngestReport report;
+    EXPECT_EQ(ingestFigures(in, arr, &report), n);
+    EXPECT_EQ(report.malformed, 0);
+    EXPECT_EQ(report.mismatched, 0);
+
+    // Первые 400 фигур: доля равных одной из предыдущих - около 0.3
+    int repeats = 0;
+    for (int i = 1; i < 400; i++) {
+        for (int j = 0; j < i; j++) {
+            if (*arr.get(i) == *arr.get(j)) {
+                repeats++;
+                break;
+            }
+        }
+    }
+    EXPECT_GT(repeats, 80);
+    EXPECT_LT(repeats, 160);
+
+    std::string binary = ::testing::TempDir() + "gen_binary";
+    ASSERT_GT(generateFigures(binary.c_str(), StreamFormat::Codec, n, options), 0);
+    StreamStats stats;
+    ASSERT_TRUE(streamStats(binary.c_str(), StreamFormat::Codec, stats));
+    EXPECT_EQ(stats.figures, n);
+    EXPECT_NEAR(stats.totalArea, arr.totalArea(), 1e-9 * stats.totalArea);
+    double field = 4 * options.scale * options.scale;
+    EXPECT_NEAR(stats.totalArea / field, options.overlap, 0.5);
+
+    std::remove(text.c_str());
+    std::remove(binary.c_str());
+}
@@ -0,0 +1,387 @@
+#include <gtest/gtest.h>
+#include "Square.h"
+#include "Rectangle.h"
+#include "ConcurrentArray.h"
+#include "SnapshotArray.h"
+#include "ShardedStore.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <thread>
+
+/**
+ * @file test_concurrency.cpp
+ *
+ * Тесты потокобезопасных коллекций: добавление из многих потоков,
+ * согласованность того, что видят читатели.
+ */
+
+// ===================================================================
+// ГРУППА 1: ДОБАВЛЕНИЕ БЕЗ БЛОКИРОВОК
+// ===================================================================
+
+/**
+ * Квадрат со стороной side в точке (x, 0)
+ */
+static Square* makeSquare(double x, double side) {
+    Point p[4] = {Point(x, 0), Point(x + side, 0), Point(x + side, side), Point(x, side)};
+    return new Square(p);
+}
+
+/**
+ * Последовательное добавление: индексы, сегменты, отчет о памяти
+ */
+TEST(ConcurrentArrayTest, SequentialPush) {
+    ConcurrentArray arr;
+    EXPECT_EQ(arr.size(), 0);
+    EXPECT_EQ(arr.get(0), nullptr);
+    EXPECT_EQ(arr.push(nullptr), -1);
+
+    // 64 + 128 + 8: три сегмента
+    for (int i = 0; i < 200; i++) EXPECT_EQ(arr.push(makeSquare(i, 1)), i);
+    EXPECT_EQ(arr.size(), 200);
+    EXPECT_DOUBLE_EQ(arr.totalArea(), 200);
+    EXPECT_DOUBLE_EQ(arr.get(199)->getPoints()[0].x, 199);
+
+    MemoryReport report = arr.memoryReport();
+    EXPECT_EQ(report.allocations, 3 + 200);
+    EXPECT_EQ(report.bufferUsed + report.bufferUnused,
+              (long long)((64 + 128 + 256) * sizeof(std::atomic<Figure*>)));
+    EXPECT_EQ(report.types[0].count, 200);
+}
+
+/**
+ * Несколько производителей и читатель во время добавления:
+ * читатель всегда видит полностью построенный префикс
+ */
+TEST(ConcurrentArrayTest, ProducersAndReader) {
+    const int THREADS = 4;
+    const int PER_THREAD = 5000;
+    ConcurrentArray arr;
+    std::atomic<bool> done(false);
+    std::atomic<int> badReads(0);
+
+    std::thread reader([&]() {
+        int lastSize = 0;
+        while (!done.load()) {
+            int seen = arr.forEach([&](int, const Figure& fig) {
+                if (fig.area() != 1 && fig.area() != 2) badReads++;
+            });
+            if (seen < lastSize) badReads++;  // префикс только растет
+            lastSize = seen;
+        }
+    });
+
+    std::thread producers[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        producers[t] = std::thread([&arr, t]() {
+            for (int i = 0; i < PER_THREAD; i++) {
+                Point p[4] = {Point(0, 0), Point(t % 2 + 1, 0), Point(t % 2 + 1, 1), Point(0, 1)};
+                arr.push(new Rectangle(p));
+            }
+        });
+    }
+    for (int t = 0; t < THREADS; t++) producers[t].join();
+    done = true;
+    reader.join();
+
+    EXPECT_EQ(badReads.load(), 0);
+    ASSERT_EQ(arr.size(), THREADS * PER_THREAD);
+    EXPECT_DOUBLE_EQ(arr.totalArea(), (1 + 2 + 1 + 2) * (double)PER_THREAD);
+}
+
+// ===================================================================
+// ГРУППА 2: СНИМКИ ДЛЯ ЧИТАТЕЛЕЙ
+// ===================================================================
+
+/**
+ * Снимок не меняется, удаленная фигура живет, пока жив снимок
+ */
+TEST(SnapshotArrayTest, SnapshotKeepsRemovedFigures) {
+    AllocationCounter counter;
+    ScopedAllocationHook hook(counter);
+    {
+        SnapshotArray arr;
+        for (int i = 0; i < 3; i++) arr.push(makeSquare(i, i + 1));  // площади 1, 4, 9
+
+        {
+            ArraySnapshot snap = arr.snapshot();
+            arr.remove(0);
+            arr.push(makeSquare(10, 2));
+            EXPECT_EQ(arr.size(), 3);
+
+            // Снимок видит состояние на момент открытия
+            ASSERT_EQ(snap.size(), 3);
+            EXPECT_DOUBLE_EQ(snap.totalArea(), 14);
+            EXPECT_DOUBLE_EQ(snap.get(0)->area(), 1);
+            EXPECT_GT(arr.reclaim(), 0);  // удаленный квадрат еще виден снимку
+        }
+        EXPECT_EQ(arr.reclaim(), 0);
+
+        ArraySnapshot after = arr.snapshot();
+        EXPECT_DOUBLE_EQ(after.totalArea(), 4 + 9 + 4);
+        EXPECT_EQ(after.get(3), nullptr);
+
+        MemoryReport report = arr.memoryReport();
+        EXPECT_EQ(report.types[0].count, 3);
+    }
+    EXPECT_EQ(counter.liveBytes(), 0);
+}
+
+/**
+ * Писатели добавляют и удаляют, читатели обходят снимки:
+ * каждый снимок согласован (все фигуры целы, площадь сходится)
+ */
+TEST(SnapshotArrayTest, ReadersDuringMutation) {
+    SnapshotArray arr;
+    std::atomic<bool> done(false);
+    std::atomic<int> badReads(0);
+    std::atomic<long long> snapshots(0);
+
+    std::thread readers[3];
+    for (int r = 0; r < 3; r++) {
+        readers[r] = std::thread([&]() {
+            while (!done.load()) {
+                ArraySnapshot snap = arr.snapshot();
+                double sum = 0;
+                snap.forEach([&](const Figure& fig) { sum += fig.area(); });
+                if (sum != snap.size()) badReads++;  // все квадраты единичные
+                snapshots++;
+            }
+        });
+    }
+
+    std::thread writers[2];
+    for (int w = 0; w < 2; w++) {
+        writers[w] = std::thread([&arr]() {
+            for (int i = 0; i < 3000; i++) {
+                arr.push(makeSquare(i, 1));
+                if (i % 3 == 2) arr.remove(0);
+            }
+        });
+    }
+    for (int w = 0; w < 2; w++) writers[w].join();
+    done = true;
+    for (int r = 0; r < 3; r++) readers[r].join();
+
+    EXPECT_EQ(badReads.load(), 0);
+    EXPECT_GT(snapshots.load(), 0);
+    EXPECT_EQ(arr.size(), 2 * 2000);
+    EXPECT_EQ(arr.reclaim(), 0);
+}
+
+/**
+ * size() без снимка во время push/remove: читает только допустимые
+ * значения и не обращается к освобожденным версиям (ASan/TSan)
+ */
+TEST(SnapshotArrayTest, SizeDuringMutation) {
+    SnapshotArray arr;
+    std::atomic<bool> done(false);
+    std::atomic<int> badSizes(0);
+
+    std::thread readers[3];
+    for (int r = 0; r < 3; r++) {
+        readers[r] = std::thread([&]() {
+            while (!done.load()) {
+                int n = arr.size();
+                if (n < 0 || n > 2 * 3000) badSizes++;
+            }
+        });
+    }
+
+    std::thread writers[2];
+    for (int w = 0; w < 2; w++) {
+        writers[w] = std::thread([&arr]() {
+            for (int i = 0; i < 3000; i++) {
+                arr.push(makeSquare(i, 1));
+                if (i % 2 == 1) arr.remove(0);
+            }
+        });
+    }
+    for (int w = 0; w < 2; w++) writers[w].join();
+    done = true;
+    for (int r = 0; r < 3; r++) readers[r].join();
+
+    EXPECT_EQ(badSizes.load(), 0);
+    EXPECT_EQ(arr.size(), 2 * 1500);
+}
+
+// ===================================================================
+// ГРУППА 3: ШАРДЫ
+// ===================================================================
+
+/**
+ * Идентификаторы, распределение по шардам, удаление
+ */
+TEST(ShardedStoreTest, HandlesAndShards) {
+    ShardedStore store(8);
+    EXPECT_EQ(store.push(nullptr), -1);
+
+    FigureHandle handles[400];
+    for (int i = 0; i < 400; i++) handles[i] = store.push(makeSquare(i, 1));
+    EXPECT_EQ(store.size(), 400);
+    for (int s = 0; s < store.getShardCount(); s++) {
+        EXPECT_GT(store.shardSize(s), 20);  // в среднем 50
+    }
+
+    EXPECT_TRUE(store.remove(handles[10]));
+    EXPECT_FALSE(store.remove(handles[10]));
+    EXPECT_FALSE(store.contains(handles[10]));
+    EXPECT_TRUE(store.contains(handles[11]));
+    EXPECT_EQ(store.size(), 399);
+    ThreadPool single(1), pool(4);
+    EXPECT_DOUBLE_EQ(store.totalArea(&single), 399);
+    EXPECT_DOUBLE_EQ(store.totalArea(&pool), 399);
+
+    long long handleSum = 0;
+    store.forEach([&](FigureHandle h, const Figure&) { handleSum += h; });
+    EXPECT_EQ(handleSum, 399LL * 400 / 2 - 10);
+
+    MemoryReport report = store.memoryReport();
+    EXPECT_EQ(report.types[0].count, 399);
+
+    // Массив шардов выделен new[]: его адрес - не начало блока malloc
+    ShardedStore empty(1);
+    EXPECT_GE(empty.memoryReport().allocatorSlack, 0);
+}
+
+/**
+ * Изменения из многих потоков
+ */
+TEST(ShardedStoreTest, ConcurrentMutation) {
+    ShardedStore store;
+    std::thread workers[4];
+    for (int t = 0; t < 4; t++) {
+        workers[t] = std::thread([&store]() {
+            for (int i = 0; i < 2000; i++) {
+                FigureHandle h = store.push(makeSquare(i, 1));
+                if (i % 2 == 0) store.remove(h);
+            }
+        });
+    }
+    for (int t = 0; t < 4; t++) workers[t].join();
+
+    EXPECT_EQ(store.size(), 4 * 1000);
+    EXPECT_DOUBLE_EQ(store.totalArea(), 4 * 1000);
+}
+
+/**
+ * Дубликаты в разных шардах: остается добавленный раньше
+ */
+TEST(ShardedStoreTest, RemoveDuplicates) {
+    ShardedStore store(4);
+    FigureHandle first[50];
+    for (int i = 0; i < 50; i++) first[i] = store.push(makeSquare(i * 2, 1));
+    for (int i = 0; i < 50; i += 2) store.push(makeSquare(i * 2, 1));   // 25 копий
+    store.push(makeSquare(0, 1));                                       // третья копия
+    store.push(makeSquare(0.5, 1));                                     // пересекается, но не равна
+
+    ThreadPool pool(2);
+    EXPECT_EQ(store.removeDuplicates(&pool), 26);
+    EXPECT_EQ(store.size(), 51);
+    for (int i = 0; i < 50; i++) EXPECT_TRUE(store.contains(first[i]));
+    EXPECT_EQ(store.removeDuplicates(), 0);
+}
+
+static Square* squareAt(double x, double y) {
+    Point p[4] = {Point(x, y), Point(x + 1, y), Point(x + 1, y + 1), Point(x, y + 1)};
+    return new Square(p);
+}
+
+/**
+ * Фигуры на сетке: столбцы с общей левой границей, копии в пределах
+ * точности и почти-копии за ее пределами
+ */
+TEST(ShardedStoreTest, RemoveDuplicatesOnGrid) {
+    ShardedStore store(8);
+    const int columns = 4, rows = 3000;
+    for (int c = 0; c < columns; c++) {
+        for (int r = 0; r < rows; r++) store.push(squareAt(c * 2, r * 2));
+    }
+    int copies = 0;
+    for (int c = 0; c < columns; c++) {
+        for (int r = 0; r < rows; r += 3) {
+            store.push(squareAt(c * 2 + 3e-5, r * 2 - 3e-5));
+            copies++;
+        }
+        for (int r = 0; r < rows; r += 5) store.push(squareAt(c * 2, r * 2 + 2e-4));
+    }
+
+    ThreadPool pool(4);
+    int before = store.size();
+    EXPECT_EQ(store.removeDuplicates(&pool), copies);
+    EXPECT_EQ(store.size(), before - copies);
+    EXPECT_EQ(store.removeDuplicates(&pool), 0);
+}
+
+// ===================================================================
+// ГРУППА 4: ПУЛ ПОТОКОВ
+// ===================================================================
+
+/**
+ * Каждый индекс обрабатывается ровно один раз, в том числе при
+ * неровной нагрузке (последние индексы дороже - их перехватывают)
+ */
+TEST(ThreadPoolTest, ParallelForCoversRange) {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.getThreadCount(), 4);
+
+    const int n = 20000;
+    std::atomic<int>* hits = new std::atomic<int>[n];
+    for (int i = 0; i < n; i++) hits[i].store(0);
+
+    pool.parallelFor(0, n, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            volatile double work = 0;
+            for (int k = 0; k < i / 1000; k++) work = work + k;
+            hits[i].fetch_add(1);
+        }
+    });
+    for (int i = 0; i < n; i++) ASSERT_EQ(hits[i].load(), 1);
+    delete[] hits;
+
+    int calls = 0;
+    pool.parallelFor(5, 5, [&](int, int) { calls++; });
+    EXPECT_EQ(calls, 0);
+}
+
+/**
+ * Свертка не зависит от планирования: сумма double повторяется
+ * бит в бит и совпадает для пула из одного потока
+ */
+TEST(ThreadPoolTest, ReduceIsDeterministic) {
+    Array arr;
+    for (int i = 0; i < 50000; i++) arr.push(makeSquare(i, 1.0 + (i % 7) * 0.1));
+
+    ThreadPool pool(4), single(1);
+    double first = arr.totalArea(pool);
+    for (int r = 0; r < 5; r++) EXPECT_EQ(arr.totalArea(pool), first);
+    EXPECT_NEAR(first, arr.totalArea(), 1e-6);
+    EXPECT_NEAR(arr.totalArea(single), arr.totalArea(), 1e-6);
+
+    long long count = pool.parallelReduce(0, 1000, 0LL,
+        [](int begin, int end) { return (long long)(end - begin); },
+        [](long long a, long long b) { return a + b; });
+    EXPECT_EQ(count, 1000);
+}
+
+/**
+ * Вложенный parallelFor из задачи и вызовы из нескольких внешних
+ * потоков одновременно не блокируют друг друга
+ */
+TEST(ThreadPoolTest, NestedAndConcurrentCallers) {
+    ThreadPool pool(3);
+    std::atomic<long long> total(0);
+
+    std::thread callers[3];
+    for (int t = 0; t < 3; t++) {
+        callers[t] = std::thread([&]() {
+            pool.parallelFor(0, 64, [&](int begin, int end) {
+                for (int i = begin; i < end; i++) {
+                    pool.parallelFor(0, 100, [&](int b, int e) { total.fetch_add(e - b); });
+                }
+            });
+        });
+    }
+    for (int t = 0; t < 3; t++) callers[t].join();
+    EXPECT_EQ(total.load(), 3LL * 64 * 100);
+}
@@ -0,0 +1,289 @@
+#include <gtest/gtest.h>
+#include "Square.h"
+#include "Array.h"
+#include "Instrumentation.h"
+#include "Trace.h"
+#include "MemoryTracking.h"
+#include "SmallArray.h"
+#include "Rectangle.h"
+#include "Trapezoid.h"
+#include <sstream>
+#include <thread>
+
+/**
+ * @file test_diagnostics.cpp
+ *
+ * Тесты средств диагностики: гистограммы задержек и замеры операций,
+ * трассировка, учет памяти.
+ */
+
+// ===================================================================
+// ГРУППА 1: ИНСТРУМЕНТИРОВАНИЕ
+// ===================================================================
+
+/**
+ * Корзины: малые значения точные, большие - с погрешностью не больше 1/16
+ */
+TEST(InstrumentationTest, HistogramBuckets) {
+    for (unsigned long long v = 0; v < 32; v++) {
+        EXPECT_EQ(LatencyHistogram::bucketUpper(LatencyHistogram::bucketOf(v)), v);
+    }
+
+    unsigned long long values[] = {32, 33, 100, 1000, 123456, 1ULL << 40, ~0ULL};
+    for (unsigned long long v : values) {
+        int bucket = LatencyHistogram::bucketOf(v);
+        ASSERT_LT(bucket, LatencyHistogram::BUCKET_COUNT);
+        unsigned long long upper = LatencyHistogram::bucketUpper(bucket);
+        EXPECT_GE(upper, v);
+        EXPECT_LE((double)(upper - v), (double)v / 16);
+        // Корзины идут по возрастанию
+        EXPECT_LT(LatencyHistogram::bucketUpper(bucket - 1), v);
+    }
+}
+
+/**
+ * Перцентили равномерного распределения 1..1000
+ */
+TEST(InstrumentationTest, HistogramPercentiles) {
+    LatencyHistogram h;
+    EXPECT_EQ(h.percentile(0.5), 0u);
+    for (unsigned long long v = 1; v <= 1000; v++) h.record(v);
+
+    EXPECT_EQ(h.count(), 1000u);
+    EXPECT_EQ(h.min(), 1u);
+    EXPECT_EQ(h.max(), 1000u);
+    EXPECT_DOUBLE_EQ(h.mean(), 500.5);
+    EXPECT_NEAR((double)h.percentile(0.5), 500, 500 / 16.0);
+    EXPECT_NEAR((double)h.percentile(0.99), 990, 990 / 16.0);
+    EXPECT_EQ(h.percentile(1.0), 1000u);
+
+    h.reset();
+    EXPECT_EQ(h.count(), 0u);
+    EXPECT_EQ(h.min(), 0u);
+}
+
+/**
+ * Замеры операций Array и Figure (только в сборке с инструментированием)
+ */
+TEST(InstrumentationTest, ProbesCountCalls) {
+    resetInstrumentation();
+    {
+        Array arr;
+        Point p[4] = {Point(0, 0), Point(1, 0), Point(1, 1), Point(0, 1)};
+        for (int i = 0; i < 10; i++) arr.push(new Square(p));
+        arr.totalArea();
+        arr.remove(0);
+    }
+
+    std::ostringstream out;
+    dumpInstrumentation(out);
+
+    if (!instrumentationEnabled()) {
+        EXPECT_EQ(probeHistogram(Probe::ArrayPush).count(), 0u);
+        EXPECT_NE(out.str().find("GEOMETRY_INSTRUMENTATION"), std::string::npos);
+        return;
+    }
+    EXPECT_EQ(probeHistogram(Probe::ArrayPush).count(), 10u);
+    EXPECT_EQ(probeHistogram(Probe::ArrayResize).count(), 2u);  // 4 -> 8 -> 16
+    EXPECT_EQ(probeHistogram(Probe::ArrayRemove).count(), 1u);
+    EXPECT_EQ(probeHistogram(Probe::TotalArea).count(), 1u);
+    EXPECT_EQ(probeHistogram(Probe::SortPoints).count(), 10u);
+    EXPECT_NE(out.str().find("Array::push"), std::string::npos);
+    EXPECT_EQ(out.str().find("Figure::read"), std::string::npos);
+}
+
+// ===================================================================
+// ГРУППА 2: ТРАССИРОВКА
+// ===================================================================
+
+/**
+ * Подсчет событий "ph":"X" в JSON-тексте
+ */
+static int countPhase(const std::string& json, char phase) {
+    std::string key = std::string("\"ph\":\"") + phase + "\"";
+    int n = 0;
+    for (size_t pos = json.find(key); pos != std::string::npos; pos = json.find(key, pos + 1)) n++;
+    return n;
+}
+
+/**
+ * Выключенная трассировка ничего не записывает
+ */
+TEST(TraceTest, DisabledRecordsNothing) {
+    traceStop();
+    traceClear();
+    {
+        GEOMETRY_TRACE_SCOPE("idle");
+    }
+    EXPECT_EQ(traceEventCount(), 0);
+}
+
+/**
+ * Пары B/E из нескольких потоков, включая операции библиотеки
+ */
+TEST(TraceTest, ScopesFromSeveralThreads) {
+    traceClear();
+    traceStart();
+
+    Array arr;
+    Point p[4] = {Point(0, 0), Point(1, 0), Point(1, 1), Point(0, 1)};
+    arr.push(new Square(p));
+    arr.totalArea();
+
+    std::thread workers[3];
+    for (int t = 0; t < 3; t++) {
+        workers[t] = std::thread([]() {
+            // Больше блока буфера (4096 событий), чтобы проверить его рост
+            for (int i = 0; i < 3000; i++) {
+                GEOMETRY_TRACE_SCOPE("worker", i);
+            }
+        });
+    }
+    for (int t = 0; t < 3; t++) workers[t].join();
+    traceStop();
+
+    EXPECT_EQ(traceEventCount(), 2 + 3 * 6000);
+
+    std::ostringstream out;
+    ASSERT_TRUE(writeTrace(out));
+    std::string json = out.str();
+    EXPECT_EQ(countPhase(json, 'B'), 1 + 3 * 3000);
+    EXPECT_EQ(countPhase(json, 'E'), 1 + 3 * 3000);
+    EXPECT_NE(json.find("\"name\":\"Array::totalArea\""), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"items\":2999}"), std::string::npos);
+    EXPECT_EQ(json.front(), '{');
+
+    traceClear();
+    EXPECT_EQ(traceEventCount(), 0);
+}
+
+// ===================================================================
+// ГРУППА 3: УЧЕТ ПАМЯТИ
+// ===================================================================
+
+/**
+ * Точное число выделений массовой вставки и удаления
+ */
+TEST(MemoryTest, CountsBulkAllocations) {
+    Point p[4] = {Point(0, 0), Point(1, 0), Point(1, 1), Point(0, 1)};
+    AllocationCounter counter;
+    {
+        ScopedAllocationHook hook(counter);
+        Array arr;                                         // встроенный буфер на 4
+        EXPECT_EQ(counter.allocations(), 0);
+        for (int i = 0; i < 100; i++) arr.push(new Square(p));
+        EXPECT_EQ(counter.allocations(), 100 + 5);         // 8 -> 16 -> ... -> 128
+        EXPECT_EQ(counter.frees(), 4);                     // старые буферы в куче
+        EXPECT_EQ(counter.liveBytes(), (long long)(128 * sizeof(Figure*) + 100 * sizeof(Square)));
+
+        arr.remove(0);
+        EXPECT_EQ(counter.frees(), 5);
+    }
+    EXPECT_EQ(counter.frees(), counter.allocations());
+    EXPECT_EQ(counter.liveBytes(), 0);
+
+    // Перехватчик снят: выделения больше не считаются
+    Square* outside = new Square(p);
+    delete outside;
+    EXPECT_EQ(counter.allocations(), 105);
+}
+
+/**
+ * Разбивка памяти по категориям и типам
+ */
+TEST(MemoryTest, ArrayReport) {
+    Point p[4] = {Point(0, 0), Point(2, 0), Point(2, 1), Point(0, 1)};
+    Point t[4] = {Point(0, 0), Point(4, 0), Point(3, 2), Point(1, 2)};
+    Array arr;
+    for (int i = 0; i < 3; i++) arr.push(new Square(p));
+    for (int i = 0; i < 2; i++) arr.push(new Trapezoid(t));
+
+    MemoryReport report = arr.memoryReport();
+    EXPECT_EQ(report.containerBytes, (long long)sizeof(Array));
+    EXPECT_EQ(report.bufferUsed, (long long)(5 * sizeof(Figure*)));
+    EXPECT_EQ(report.bufferUnused, (long long)(3 * sizeof(Figure*)));
+    EXPECT_EQ(report.objectBytes, (long long)(3 * sizeof(Square) + 2 * sizeof(Trapezoid)));
+    EXPECT_EQ(report.vptrBytes, (long long)(5 * sizeof(void*)));
+    EXPECT_EQ(report.allocations, 6);
+    EXPECT_GE(report.allocatorSlack, 0);
+    EXPECT_GT(report.total(), report.objectBytes + report.bufferUsed);
+
+    ASSERT_EQ(report.typeCount, 2);
+    EXPECT_STREQ(report.types[0].type, "Square");
+    EXPECT_EQ(report.types[0].count, 3);
+    EXPECT_STREQ(report.types[1].type, "Trapezoid");
+    EXPECT_EQ(report.types[1].bytes, (long long)(2 * sizeof(Trapezoid)));
+
+    MemoryReport twice = report;
+    twice.merge(report);
+    EXPECT_EQ(twice.total(), 2 * report.total());
+    EXPECT_EQ(twice.types[0].count, 6);
+
+    std::ostringstream out;
+    report.print(out);
+    EXPECT_NE(out.str().find("Trapezoid"), std::string::npos);
+}
+
+/**
+ * Небольшой массив: в куче только сами фигуры
+ */
+TEST(MemoryTest, SmallArrayNeedsNoBuffer) {
+    Point p[4] = {Point(0, 0), Point(1, 0), Point(1, 1), Point(0, 1)};
+    AllocationCounter counter;
+    {
+        ScopedAllocationHook hook(counter);
+        Array arr;
+        for (int i = 0; i < Array::INLINE_CAPACITY; i++) arr.push(new Square(p));
+        EXPECT_EQ(counter.allocations(), Array::INLINE_CAPACITY);
+
+        MemoryReport report = arr.memoryReport();
+        EXPECT_EQ(report.allocations, Array::INLINE_CAPACITY);
+        EXPECT_EQ(report.bufferUsed, 0);
+        EXPECT_EQ(report.bufferUnused, 0);
+        EXPECT_EQ(report.containerBytes, (long long)sizeof(Array));
+        EXPECT_DOUBLE_EQ(arr.totalArea(), Array::INLINE_CAPACITY);
+    }
+    EXPECT_EQ(counter.frees(), Array::INLINE_CAPACITY);
+}
+
+/**
+ * SmallArray: встроенный буфер, переезд в кучу, удаление со сдвигом
+ */
+TEST(MemoryTest, SmallArrayGrowth) {
+    AllocationCounter counter;
+    {
+        ScopedAllocationHook hook(counter);
+        SmallArray<int, 4> small;
+        for (int i = 0; i < 4; i++) small.push(i);
+        EXPECT_TRUE(small.isInline());
+        EXPECT_EQ(small.heapBytes(), 0u);
+        EXPECT_EQ(counter.allocations(), 0);
+
+        small.push(4);
+        EXPECT_FALSE(small.isInline());
+        EXPECT_EQ(small.getCapacity(), 8);
+        EXPECT_EQ(counter.allocations(), 1);
+        EXPECT_EQ(counter.frees(), 0);  // встроенный буфер не освобождается
+
+        small.remove(0);
+        small.remove(10);
+        ASSERT_EQ(small.size(), 4);
+        int sum = 0;
+        for (int v : small) sum += v;
+        EXPECT_EQ(sum, 1 + 2 + 3 + 4);
+        EXPECT_EQ(small[0], 1);
+
+        small.clear();
+        EXPECT_EQ(small.size(), 0);
+        EXPECT_EQ(small.getCapacity(), 8);
+
+        // Без встроенного буфера первое добавление сразу выделяет 4 элемента
+        SmallArray<double, 0> heapOnly;
+        EXPECT_EQ(heapOnly.getCapacity(), 0);
+        heapOnly.push(1.5);
+        EXPECT_EQ(heapOnly.getCapacity(), 4);
+        EXPECT_EQ(counter.allocations(), 2);
+    }
+    EXPECT_EQ(counter.frees(), 2);
+    EXPECT_EQ(counter.liveBytes(), 0);
+}
@@ -0,0 +1,339 @@
+#include <gtest/gtest.h>
+#include "Square.h"
+#include "Rectangle.h"
+#include "Trapezoid.h"
+#include "FigureKernels.h"
+#ifdef GEOMETRY_HAS_INT128
+#include "FixedPoint.h"
+#endif
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+/**
+ * @file test_kernels.cpp
+ *
+ * Тесты общих вычислительных ядер фигур (FigureKernels.h):
+ * вычисление при компиляции, совпадение с виртуальным интерфейсом;
+ * целые координаты с фиксированной точкой (FixedPoint.h);
+ * точные предикаты ориентации (Orientation.h).
+ */
+
+// ===================================================================
+// ГРУППА 1: CONSTEXPR-ЯДРА
+// ===================================================================
+
+// Вершины в перепутанном порядке: конструктор Quad упорядочивает их
+// во время компиляции
+constexpr Quad<Trapezoid> CONST_TRAPEZOID({Point(3, 2), Point(0, 0), Point(1, 2), Point(4, 0)});
+static_assert(CONST_TRAPEZOID.area() == 6, "площадь при компиляции");
+static_assert(CONST_TRAPEZOID.center().x == 2 && CONST_TRAPEZOID.center().y == 1, "центр");
+static_assert(CONST_TRAPEZOID.bounds().maxX == 4, "AABB");
+static_assert(CONST_TRAPEZOID.vertices()[0].x == 0 && CONST_TRAPEZOID.vertices()[0].y == 0,
+              "обход начинается с нижней полуплоскости");
+
+constexpr Quad<Square> CONST_SQUARES[2] = {Quad<Square>(), Quad<Square>({Point(2, 2), Point(0, 0), Point(0, 2), Point(2, 0)})};
+static_assert(sumAreas(CONST_SQUARES, 2) == 5, "сумма площадей");
+
+/**
+ * Quad<Kind> и класс фигуры дают одинаковые вершины, площадь и центр
+ */
+TEST(KernelTest, QuadMatchesFigure) {
+    Point p[4] = {Point(3, 2), Point(0, 0), Point(1, 2), Point(4, 0)};
+    Trapezoid fig(p);
+    const Point* v = CONST_TRAPEZOID.vertices();
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(fig.getPoints()[i].x, v[i].x);
+        EXPECT_EQ(fig.getPoints()[i].y, v[i].y);
+    }
+    const Figure& base = fig;
+    EXPECT_DOUBLE_EQ(base.area(), CONST_TRAPEZOID.area());
+    EXPECT_DOUBLE_EQ(base.center().x, CONST_TRAPEZOID.center().x);
+    EXPECT_STREQ(base.getType(), Quad<Trapezoid>::type());
+    EXPECT_EQ(base.objectSize(), sizeof(Trapezoid));
+    EXPECT_STREQ(Rectangle().getType(), "Rectangle");
+}
+
+/**
+ * Порядок angleBefore() совпадает с сортировкой по atan2
+ */
+TEST(KernelTest, OrderMatchesAtan2) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> coord(-100, 100);
+    for (int n = 0; n < 1000; n++) {
+        Point p[4];
+        for (int i = 0; i < 4; i++) p[i] = Point(coord(rng), coord(rng));
+
+        Point ordered[4] = {p[0], p[1], p[2], p[3]};
+        orderCounterClockwise(ordered);
+
+        Point c = vertexCentroid(p, 4);
+        for (int i = 0; i + 1 < 4; i++) {
+            EXPECT_LE(std::atan2(ordered[i].y - c.y, ordered[i].x - c.x),
+                      std::atan2(ordered[i + 1].y - c.y, ordered[i + 1].x - c.x));
+        }
+    }
+
+    // Граничные направления: углы 0 и pi, нулевой вектор
+    EXPECT_TRUE(angleBefore(Point(0, -1), Point(1, 0)));
+    EXPECT_TRUE(angleBefore(Point(1, 0), Point(-1, 0)));
+    EXPECT_FALSE(angleBefore(Point(-1, 0), Point(1, 0)));
+    EXPECT_TRUE(angleBefore(Point(0, 0), Point(0, 1)));
+    EXPECT_FALSE(angleBefore(Point(2, 0), Point(0, 0)));
+}
+
+/**
+ * sumAreas() над массивом объектов конкретного типа
+ */
+TEST(KernelTest, TypedSum) {
+    Square squares[3];
+    Point p[4] = {Point(0, 0), Point(3, 0), Point(3, 3), Point(0, 3)};
+    squares[2].setPoints(p);
+    EXPECT_DOUBLE_EQ(sumAreas(squares, 3), 1 + 1 + 9);
+    EXPECT_DOUBLE_EQ(shoelaceArea(p, 4), Figure::polygonArea(p, 4));
+}
+
+// ===================================================================
+// ГРУППА 2: ФИКСИРОВАННАЯ ТОЧКА
+// ===================================================================
+
+#ifdef GEOMETRY_HAS_INT128
+
+static Square shiftedSquare(double dx) {
+    Point p[4] = {Point(dx, 0), Point(1 + dx, 0), Point(1 + dx, 1), Point(dx, 1)};
+    return Square(p);
+}
+
+/**
+ * Канонический вид не зависит от порядка вершин
+ */
+TEST(FixedPointTest, CanonicalIgnoresOrder) {
+    Point p[4] = {Point(3, 2), Point(0, 0), Point(1, 2), Point(4, 0)};
+    FixedQuad base;
+    ASSERT_TRUE(toFixed(p, FIXED_DEFAULT_SCALE, base));
+    EXPECT_EQ(base.x[0], 0);
+    EXPECT_EQ(base.y[0], 0);
+    EXPECT_EQ(base.x[1], 40000);
+
+    int perm[4] = {0, 1, 2, 3};
+    do {
+        Point q[4] = {p[perm[0]], p[perm[1]], p[perm[2]], p[perm[3]]};
+        FixedQuad other;
+        ASSERT_TRUE(toFixed(q, FIXED_DEFAULT_SCALE, other));
+        EXPECT_TRUE(other == base);
+        EXPECT_EQ(other.hash(), base.hash());
+    } while (std::next_permutation(perm, perm + 4));
+}
+
+/**
+ * Сравнение с допуском не транзитивно, целое - транзитивно
+ */
+TEST(FixedPointTest, EqualityIsTransitive) {
+    Square a = shiftedSquare(0), b = shiftedSquare(0.6e-4), c = shiftedSquare(1.2e-4);
+    EXPECT_TRUE(a == b);
+    EXPECT_TRUE(b == c);
+    EXPECT_FALSE(a == c);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> shift(0, 5e-4);
+    const int n = 64;
+    FixedQuad q[n];
+    for (int i = 0; i < n; i++) ASSERT_TRUE(toFixed(shiftedSquare(shift(rng)), FIXED_DEFAULT_SCALE, q[i]));
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            for (int k = 0; k < n; k++) {
+                if (q[i] == q[j] && q[j] == q[k]) {
+                    EXPECT_TRUE(q[i] == q[k]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Площадь точна там, где double теряет младшие разряды
+ */
+TEST(FixedPointTest, ExactAreaAtLargeCoordinates) {
+    // Прямоугольник 1 x 3 единицы (1e-4 x 3e-4) далеко от начала координат
+    double far = 4e11;
+    Point p[4] = {Point(far, far), Point(far + 1e-4, far), Point(far + 1e-4, far + 3e-4),
+                  Point(far, far + 3e-4)};
+    FixedQuad q;
+    ASSERT_TRUE(toFixed(p, FIXED_DEFAULT_SCALE, q));
+    EXPECT_TRUE(q.doubledArea() == 6);
+
+    Point r[4] = {Point(0, 0), Point(2.5, 0), Point(2.5, 4), Point(0, 4)};
+    ASSERT_TRUE(toFixed(r, FIXED_DEFAULT_SCALE, q));
+    EXPECT_EQ(q.area(FIXED_DEFAULT_SCALE), 10);
+
+    Point bad[4] = {Point(1e13, 0), Point(1, 0), Point(1, 1), Point(0, 1)};
+    EXPECT_FALSE(toFixed(bad, FIXED_DEFAULT_SCALE, q));
+    bad[0] = Point(std::nan(""), 0);
+    EXPECT_FALSE(toFixed(bad, FIXED_DEFAULT_SCALE, q));
+}
+
+/**
+ * Пакетные findEqual и markDuplicates совпадают с попарным сравнением
+ */
+TEST(FixedPointTest, BulkMatchesPairwise) {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> pick(0, 49);
+    Array figures;
+    for (int i = 0; i < 500; i++) {
+        Point p[4] = {Point(0, 0), Point(1, 0), Point(1, 1), Point(0, 1)};
+        double dx = pick(rng);
+        for (int k = 0; k < 4; k++) p[k].x += dx;
+        std::shuffle(p, p + 4, rng);
+        figures.push(new Square(p));
+    }
+    FixedQuadArray set;
+    ASSERT_EQ(set.append(figures), 500);
+
+    bool* duplicate = new bool[set.size()];
+    int dup = set.markDuplicates(duplicate);
+    unsigned char* equal = new unsigned char[set.size()];
+    int expected = 0;
+    for (int i = 0; i < set.size(); i++) {
+        bool seen = false;
+        for (int j = 0; j < i && !seen; j++) seen = set.get(j) == set.get(i);
+        EXPECT_EQ(duplicate[i], seen);
+        expected += seen;
+    }
+    EXPECT_EQ(dup, expected);
+
+    int found = set.findEqual(set.get(0), equal);
+    int pairwise = 0;
+    for (int i = 0; i < set.size(); i++) {
+        EXPECT_EQ(equal[i] != 0, set.get(i) == set.get(0));
+        pairwise += set.get(i) == set.get(0);
+    }
+    EXPECT_EQ(found, pairwise);
+    EXPECT_DOUBLE_EQ(set.totalArea(), 500);
+    EXPECT_EQ(set.kind(0), FigureKind::Square);
+    delete[] duplicate;
+    delete[] equal;
+}
+
+#endif  // GEOMETRY_HAS_INT128
+
+// ===================================================================
+// ГРУППА 3: ТОЧНЫЕ ПРЕДИКАТЫ ОРИЕНТАЦИИ
+// ===================================================================
+
+// Фильтр и точная ступень вычислимы при компиляции
+static_assert(orientation(Point(0, 0), Point(1, 0), Point(0, 1)) == 1, "левый поворот");
+static_assert(orientation(Point(0, 0), Point(0, 1), Point(1, 0)) == -1, "правый поворот");
+static_assert(orientation(Point(0.5, 0.5), Point(12, 12), Point(24, 24)) == 0, "коллинеарны");
+static_assert(orientation(Point(0.5 + 0x1p-53, 0.5), Point(12, 12), Point(24, 24)) == -1,
+              "сдвиг на ulp вправо от прямой - точная ступень при компиляции");
+
+#ifdef GEOMETRY_HAS_INT128
+
+/*
+  Точки вида 0.5 + k * 2^-53 и до 32: все координаты - целые в единицах
+  2^-53 (до 2^58), векторное произведение разностей - точно в __int128.
+*/
+static long long units(double v) {
+    return (long long)(v * 0x1p53);
+}
+
+static int referenceOrientation(const Point& o, const Point& a, const Point& b) {
+    __int128 ax = units(a.x) - units(o.x), ay = units(a.y) - units(o.y);
+    __int128 bx = units(b.x) - units(o.x), by = units(b.y) - units(o.y);
+    __int128 det = ax * by - ay * bx;
+    return det > 0 ? 1 : (det < 0 ? -1 : 0);
+}
+
+/**
+ * Почти коллинеарные тройки: знак double-формулы бывает неверным,
+ * orientation() совпадает с точным целочисленным
+ */
+TEST(OrientationTest, MatchesExactNearDegenerate) {
+    resetOrientationFallbacks();
+    int naiveWrong = 0;
+    for (int i = 0; i < 32; i++) {
+        for (int j = 0; j < 32; j++) {
+            Point o(0.5 + i * 0x1p-53, 0.5 + j * 0x1p-53);
+            Point a(12, 12), b(24, 24);
+            int expected = referenceOrientation(o, a, b);
+            EXPECT_EQ(orientation(o, a, b), expected) << i << " " << j;
+            EXPECT_EQ(orientationExact(o, a, b), expected);
+            EXPECT_EQ(orientation(a, b, o), expected);
+
+            double naive = (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+            naiveWrong += (naive > 0 ? 1 : (naive < 0 ? -1 : 0)) != expected;
+        }
+    }
+    EXPECT_GT(naiveWrong, 0);
+    EXPECT_GT(orientationFallbacks(), 0);
+
+    // Обычные точки решает фильтр
+    resetOrientationFallbacks();
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> coord(-100, 100);
+    for (int n = 0; n < 10000; n++) {
+        Point o(coord(rng), coord(rng)), a(coord(rng), coord(rng)), b(coord(rng), coord(rng));
+        EXPECT_EQ(orientation(o, a, b), orientationExact(o, a, b));
+    }
+    EXPECT_EQ(orientationFallbacks(), 0);
+}
+
+/**
+ * Порядок почти коллинеарных вершин совпадает с точным порядком
+ * по углу вокруг центра
+ */
+TEST(OrientationTest, OrderIsExactNearDegenerate) {
+    for (int i = 0; i < 16; i++) {
+        for (int j = 0; j < 16; j++) {
+            Point p[4] = {Point(24, 24), Point(0.5 + i * 0x1p-53, 0.5 + j * 0x1p-53), Point(12, 12),
+                          Point(0.5 + j * 0x1p-52, 0.5 + i * 0x1p-52)};
+            Point c = vertexCentroid(p, 4);
+            orderCounterClockwise(p);
+            for (int k = 0; k + 1 < 4; k++) {
+                bool lowerA = p[k].y < c.y, lowerB = p[k + 1].y < c.y;
+                if (lowerA != lowerB) {
+                    EXPECT_TRUE(lowerA);
+                } else {
+                    EXPECT_GE(referenceOrientation(c, p[k], p[k + 1]), 0) << i << " " << j << " " << k;
+                }
+            }
+        }
+    }
+}
+
+#endif  // GEOMETRY_HAS_INT128
+
+/**
+ * Проверка выпуклости и обхода против часовой стрелки
+ */
+TEST(OrientationTest, ConvexCounterClockwise) {
+    Point square[4] = {Point(0, 0), Point(1, 0), Point(1, 1), Point(0, 1)};
+    EXPECT_TRUE(isConvexCounterClockwise(square, 4));
+
+    Point clockwise[4] = {Point(0, 0), Point(0, 1), Point(1, 1), Point(1, 0)};
+    EXPECT_FALSE(isConvexCounterClockwise(clockwise, 4));
+
+    Point bowtie[4] = {Point(0, 0), Point(1, 1), Point(1, 0), Point(0, 1)};
+    EXPECT_FALSE(isConvexCounterClockwise(bowtie, 4));
+
+    // Вершина на стороне - не строго выпуклый
+    Point flat[4] = {Point(0, 0), Point(1, 0), Point(2, 0), Point(1, 1)};
+    EXPECT_FALSE(isConvexCounterClockwise(flat, 4));
+
+    // Пентаграмма: все повороты левые, но контур обходит центр дважды
+    Point star[5];
+    for (int k = 0; k < 5; k++) {
+        double a = 2 * 3.141592653589793 * (2 * k) / 5;
+        star[k] = Point(std::cos(a), std::sin(a));
+    }
+    EXPECT_FALSE(isConvexCounterClockwise(star, 5));
+
+    // Любой порядок выпуклого четырехугольника после упорядочивания
+    std::mt19937 rng(9);
+    for (int n = 0; n < 100; n++) {
+        Point p[4] = {Point(3, 2), Point(0, 0), Point(1, 2), Point(4, 0)};
+        std::shuffle(p, p + 4, rng);
+        orderCounterClockwise(p);
+        EXPECT_TRUE(isConvexCounterClockwise(p, 4));
+    }
+}
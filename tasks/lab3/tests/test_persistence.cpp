@@ -0,0 +1,438 @@
+#include <gtest/gtest.h>
+#include "Square.h"
+#include "Rectangle.h"
+#include "Trapezoid.h"
+#include "Journal.h"
+#include "Codec.h"
+#include "Stream.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>
+
+/**
+ * @file test_persistence.cpp
+ *
+ * Тесты сохранения коллекций на диск: журнал операций, снимки,
+ * восстановление после сбоя, сжатое представление, потоковое чтение.
+ */
+
+static Figure* makeFigure(int i) {
+    double x = i * 3;
+    if (i % 3 == 0) {
+        double side = 1 + i % 5;
+        Point s[4] = {Point(x, 0), Point(x + side, 0), Point(x + side, side), Point(x, side)};
+        return new Square(s);
+    }
+    Point r[4] = {Point(x, 0), Point(x + 2, 0), Point(x + 2, 1), Point(x, 1)};
+    if (i % 3 == 1) return new Rectangle(r);
+    Point t[4] = {Point(x, 0), Point(x + 3, 0), Point(x + 2, 1), Point(x + 1, 1)};
+    return new Trapezoid(t);
+}
+
+/*
+  Пустой базовый путь во временном каталоге теста.
+*/
+static std::string freshBase(const char* name) {
+    std::string base = ::testing::TempDir() + name;
+    std::remove((base + ".snapshot").c_str());
+    std::remove((base + ".journal").c_str());
+    return base;
+}
+
+static long long fileSize(const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return -1;
+    std::fseek(f, 0, SEEK_END);
+    long long size = std::ftell(f);
+    std::fclose(f);
+    return size;
+}
+
+/*
+  Сбой посреди записи: файл обрезается до size байт.
+*/
+static void truncateFile(const std::string& path, long long size) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    ASSERT_NE(f, nullptr);
+    char* data = new char[size];
+    ASSERT_EQ(std::fread(data, 1, size, f), (std::size_t)size);
+    std::fclose(f);
+    f = std::fopen(path.c_str(), "wb");
+    std::fwrite(data, 1, size, f);
+    std::fclose(f);
+    delete[] data;
+}
+
+static void copyFile(const std::string& from, const std::string& to) {
+    long long size = fileSize(from);
+    ASSERT_GE(size, 0);
+    std::FILE* in = std::fopen(from.c_str(), "rb");
+    std::FILE* out = std::fopen(to.c_str(), "wb");
+    char* data = new char[size];
+    ASSERT_EQ(std::fread(data, 1, size, in), (std::size_t)size);
+    std::fwrite(data, 1, size, out);
+    std::fclose(in);
+    std::fclose(out);
+    delete[] data;
+}
+
+static void expectSameFigures(const Array& a, const Array& b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (int i = 0; i < a.size(); i++) {
+        EXPECT_STREQ(a.get(i)->getType(), b.get(i)->getType()) << i;
+        EXPECT_TRUE(*a.get(i) == *b.get(i)) << i;
+    }
+}
+
+// ===================================================================
+// ГРУППА 1: ЖУРНАЛ И ВОССТАНОВЛЕНИЕ
+// ===================================================================
+
+/**
+ * Операции после повторного открытия восстанавливаются из журнала
+ */
+TEST(JournalTest, ReplayAfterReopen) {
+    std::string base = freshBase("journal_replay");
+    Array expected;
+    {
+        JournaledArray figures;
+        ASSERT_TRUE(figures.open(base.c_str()));
+        for (int i = 0; i < 100; i++) {
+            figures.push(makeFigure(i));
+            expected.push(makeFigure(i));
+        }
+        EXPECT_TRUE(figures.remove(10));
+        EXPECT_FALSE(figures.remove(500));
+        expected.remove(10);
+        EXPECT_TRUE(figures.commit());
+        EXPECT_EQ(figures.getStats().records, 101);
+    }
+
+    JournaledArray restored;
+    ASSERT_TRUE(restored.open(base.c_str()));
+    expectSameFigures(restored.getFigures(), expected);
+    EXPECT_EQ(restored.getStats().replayed, 101);
+    EXPECT_EQ(restored.getStats().tornBytes, 0);
+}
+
+/**
+ * Одна синхронизация на groupCommit операций; несколько потоков,
+ * вызывающих commit(), делят синхронизации
+ */
+TEST(JournalTest, GroupCommit) {
+    std::string base = freshBase("journal_group");
+    JournalOptions options;
+    options.groupCommit = 16;
+    JournaledArray figures(options);
+    ASSERT_TRUE(figures.open(base.c_str()));
+
+    for (int i = 0; i < 100; i++) figures.push(makeFigure(i));
+    EXPECT_EQ(figures.getStats().syncs, 6);
+    EXPECT_TRUE(figures.commit());
+    EXPECT_EQ(figures.getStats().syncs, 7);
+    EXPECT_TRUE(figures.commit());
+    EXPECT_EQ(figures.getStats().syncs, 7);   // фиксировать нечего
+
+    std::thread writers[4];
+    for (int t = 0; t < 4; t++) {
+        writers[t] = std::thread([&figures]() {
+            for (int i = 0; i < 25; i++) {
+                figures.push(makeFigure(i));
+                figures.commit();
+            }
+        });
+    }
+    for (int t = 0; t < 4; t++) writers[t].join();
+    EXPECT_EQ(figures.size(), 200);
+    EXPECT_LE(figures.getStats().syncs, 7 + 100);
+    EXPECT_EQ(figures.getStats().journalBytes, fileSize(base + ".journal"));
+}
+
+/**
+ * Оборванная последняя запись отбрасывается, остальное восстанавливается
+ */
+TEST(JournalTest, TornTailIsDropped) {
+    std::string base = freshBase("journal_torn");
+    Array expected;
+    {
+        JournaledArray figures;
+        ASSERT_TRUE(figures.open(base.c_str()));
+        for (int i = 0; i < 20; i++) {
+            figures.push(makeFigure(i));
+            if (i < 19) expected.push(makeFigure(i));
+        }
+    }
+    std::string journal = base + ".journal";
+    truncateFile(journal, fileSize(journal) - 7);
+
+    {
+        JournaledArray restored;
+        ASSERT_TRUE(restored.open(base.c_str()));
+        expectSameFigures(restored.getFigures(), expected);
+        EXPECT_EQ(restored.getStats().replayed, 19);
+        EXPECT_GT(restored.getStats().tornBytes, 0);
+        EXPECT_EQ(restored.getStats().compactions, 1);
+        restored.push(makeFigure(100));
+        expected.push(makeFigure(100));
+    }
+
+    JournaledArray again;
+    ASSERT_TRUE(again.open(base.c_str()));
+    expectSameFigures(again.getFigures(), expected);
+    EXPECT_EQ(again.getStats().snapshotFigures, 19);
+    EXPECT_EQ(again.getStats().replayed, 1);
+}
+
+/**
+ * Журнал сворачивается в снимок по размеру; журнал старого поколения
+ * (сбой до создания нового журнала) не применяется повторно
+ */
+TEST(JournalTest, CompactionAndStaleJournal) {
+    std::string base = freshBase("journal_compact");
+    JournalOptions options;
+    options.compactBytes = 4096;
+    Array expected;
+    {
+        JournaledArray figures(options);
+        ASSERT_TRUE(figures.open(base.c_str()));
+        for (int i = 0; i < 200; i++) {
+            figures.push(makeFigure(i));
+            expected.push(makeFigure(i));
+        }
+        for (int i = 0; i < 50; i++) {
+            figures.remove(i * 2);
+            expected.remove(i * 2);
+        }
+        EXPECT_GT(figures.getStats().compactions, 0);
+        EXPECT_LT(figures.getStats().journalBytes, 4096 + 1024);
+    }
+    {
+        JournaledArray restored(options);
+        ASSERT_TRUE(restored.open(base.c_str()));
+        expectSameFigures(restored.getFigures(), expected);
+    }
+
+    // Сбой после замены снимка, но до создания нового журнала:
+    // на месте журнала остается журнал прошлого поколения
+    std::string journal = base + ".journal";
+    {
+        JournaledArray figures(options);
+        ASSERT_TRUE(figures.open(base.c_str()));
+        figures.push(makeFigure(1000));
+        expected.push(makeFigure(1000));
+        EXPECT_TRUE(figures.commit());
+        copyFile(journal, journal + ".old");
+        EXPECT_TRUE(figures.compact());
+    }
+    std::remove(journal.c_str());
+    std::rename((journal + ".old").c_str(), journal.c_str());
+
+    JournaledArray restored(options);
+    ASSERT_TRUE(restored.open(base.c_str()));
+    expectSameFigures(restored.getFigures(), expected);
+    EXPECT_EQ(restored.getStats().replayed, 0);
+}
+
+// ===================================================================
+// ГРУППА 2: СЖАТОЕ ПРЕДСТАВЛЕНИЕ
+// ===================================================================
+
+static bool sameBits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+/**
+ * Декодирование возвращает те же биты координат и типы,
+ * с выведением четвертой вершины и без него
+ */
+TEST(CodecTest, RoundTripIsBitExact) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> pos(-1000, 1000), angle(0, 6.28);
+    Array figures;
+    for (int i = 0; i < 300; i++) {
+        if (i % 4 == 3) {
+            // Повернутый прямоугольник: p0 + p2 - p1 может не совпасть бит в бит
+            double cx = pos(rng), cy = pos(rng), a = angle(rng);
+            double ux = std::cos(a), uy = std::sin(a);
+            Point p[4] = {Point(cx, cy), Point(cx + 3 * ux, cy + 3 * uy),
+                          Point(cx + 3 * ux - uy, cy + 3 * uy + ux), Point(cx - uy, cy + ux)};
+            figures.push(new Rectangle(p));
+        } else {
+            figures.push(makeFigure(i));
+        }
+    }
+
+    for (int elide = 0; elide < 2; elide++) {
+        CodecOptions options;
+        options.elideDerived = elide == 1;
+        unsigned char* code = new unsigned char[encodedSizeBound(figures.size())];
+        long long size = encodeFigures(figures, code, options);
+        ASSERT_LE(size, encodedSizeBound(figures.size()));
+        EXPECT_EQ(encodedCount(code, size), figures.size());
+
+        Array decoded;
+        ASSERT_EQ(decodeFigures(code, size, decoded), figures.size());
+        for (int i = 0; i < figures.size(); i++) {
+            ASSERT_STREQ(decoded.get(i)->getType(), figures.get(i)->getType());
+            for (int k = 0; k < 4; k++) {
+                ASSERT_TRUE(sameBits(decoded.get(i)->getPoints()[k].x, figures.get(i)->getPoints()[k].x)) << i;
+                ASSERT_TRUE(sameBits(decoded.get(i)->getPoints()[k].y, figures.get(i)->getPoints()[k].y)) << i;
+            }
+        }
+        delete[] code;
+    }
+}
+
+/**
+ * Сетка квадратов вдоль осей: общий тег, совпадающие координаты
+ * и выведенная вершина дают код в разы меньше 65 байт на фигуру
+ */
+TEST(CodecTest, CompressesAxisAlignedSets) {
+    Array grid;
+    for (int i = 0; i < 1000; i++) {
+        double x = i % 40, y = i / 40;
+        Point p[4] = {Point(x, y), Point(x + 1, y), Point(x + 1, y + 1), Point(x, y + 1)};
+        grid.push(new Square(p));
+    }
+    unsigned char* code = new unsigned char[encodedSizeBound(grid.size())];
+    long long plain = encodeFigures(grid, code, [] { CodecOptions o; o.elideDerived = false; return o; }());
+    long long elided = encodeFigures(grid, code);
+    EXPECT_LT(elided, plain);
+    EXPECT_LT(elided, grid.size() * CODEC_RAW_FIGURE_BYTES / 4);
+
+    double* records = new double[8 * grid.size()];
+    FigureKind* kinds = new FigureKind[grid.size()];
+    ASSERT_EQ(decodeRecords(code, elided, records, kinds), grid.size());
+    EXPECT_EQ(kinds[999], FigureKind::Square);
+    EXPECT_DOUBLE_EQ(records[8 * 999 + 6], grid.get(999)->getPoints()[3].x);
+    delete[] kinds;
+    delete[] records;
+    delete[] code;
+}
+
+/**
+ * Обрезанный или чужой код отвергается, коллекция не меняется
+ */
+TEST(CodecTest, RejectsCorruptInput) {
+    Array figures;
+    for (int i = 0; i < 50; i++) figures.push(makeFigure(i));
+    unsigned char* code = new unsigned char[encodedSizeBound(figures.size())];
+    long long size = encodeFigures(figures, code);
+
+    Array out;
+    EXPECT_EQ(decodeFigures(code, size - 1, out), -1);
+    EXPECT_EQ(decodeFigures(code, 3, out), -1);
+    code[0] = 'X';
+    EXPECT_EQ(decodeFigures(code, size, out), -1);
+    EXPECT_EQ(out.size(), 0);
+
+    Array empty;
+    size = encodeFigures(empty, code);
+    EXPECT_EQ(decodeFigures(code, size, out), 0);
+    delete[] code;
+}
+
+// ===================================================================
+// ГРУППА 3: ПОТОКОВАЯ СТАТИСТИКА
+// ===================================================================
+
+/*
+  Статистика streamStats() совпадает с посчитанной по Array.
+*/
+static void expectStatsOf(const Array& figures, const StreamStats& stats) {
+    EXPECT_EQ(stats.figures, figures.size());
+    double area = 0, maxX = 0, maxY = 0;
+    long long kinds[FIGURE_KIND_COUNT] = {0};
+    for (int i = 0; i < figures.size(); i++) {
+        area += figures.get(i)->area();
+        maxX = std::max(maxX, figures.get(i)->bounds().maxX);
+        maxY = std::max(maxY, figures.get(i)->bounds().maxY);
+        kinds[(int)figureKind(*figures.get(i))]++;
+    }
+    EXPECT_NEAR(stats.totalArea, area, 1e-9 * area);
+    for (int k = 0; k < FIGURE_KIND_COUNT; k++) EXPECT_EQ(stats.kinds[k], kinds[k]);
+
+    long long binned = 0;
+    for (int b = 0; b < STREAM_AREA_BINS; b++) binned += stats.histogram[b];
+    EXPECT_EQ(binned, stats.figures);
+
+    EXPECT_DOUBLE_EQ(stats.bounds.minX, 0);
+    EXPECT_DOUBLE_EQ(stats.bounds.minY, 0);
+    EXPECT_DOUBLE_EQ(stats.bounds.maxX, maxX);
+    EXPECT_DOUBLE_EQ(stats.bounds.maxY, maxY);
+}
+
+/**
+ * Строки режутся границами маленьких блоков; пустые строки пропускаются,
+ * испорченные считаются; последняя строка без перевода строки
+ */
+TEST(StreamTest, TextMatchesInMemoryStats) {
+    Array figures;
+    std::string path = ::testing::TempDir() + "stream_text.txt";
+    std::ofstream out(path);
+    out.precision(17);
+    for (int i = 0; i < 1000; i++) {
+        Figure* fig = makeFigure(i);
+        figures.push(fig);
+        out << fig->getType();
+        for (int k = 0; k < 4; k++) out << ' ' << fig->getPoints()[k].x << ' ' << fig->getPoints()[k].y;
+        if (i == 500) out << "\n\nSquare 1 2 3";
+        if (i < 999) out << '\n';
+    }
+    out.close();
+
+    int chunkSizes[3] = {7, 100, 1 << 16};
+    for (int c = 0; c < 3; c++) {
+        for (int mode = 0; mode < 2; mode++) {
+            StreamOptions options;
+            options.chunkBytes = chunkSizes[c];
+            options.doubleBuffer = mode == 1;
+            StreamStats stats;
+            ASSERT_TRUE(streamStats(path.c_str(), StreamFormat::Text, stats, options));
+            expectStatsOf(figures, stats);
+            EXPECT_EQ(stats.malformed, 1);
+            EXPECT_EQ(stats.bytes, fileSize(path));
+        }
+    }
+    std::remove(path.c_str());
+}
+
+/**
+ * Кадры Codec длиннее блока собираются из нескольких блоков;
+ * оборванный последний кадр - ошибка
+ */
+TEST(StreamTest, CodecFramesAcrossChunks) {
+    Array figures;
+    std::string path = ::testing::TempDir() + "stream_frames.bin";
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    for (int frame = 0; frame < 10; frame++) {
+        Array block;
+        for (int i = frame * 97; i < (frame + 1) * 97; i++) {
+            block.push(makeFigure(i));
+            figures.push(makeFigure(i));
+        }
+        ASSERT_TRUE(appendCodecFrame(file, block));
+    }
+    std::fclose(file);
+
+    int chunkSizes[3] = {5, 333, 1 << 16};
+    for (int c = 0; c < 3; c++) {
+        StreamOptions options;
+        options.chunkBytes = chunkSizes[c];
+        StreamStats stats;
+        ASSERT_TRUE(streamStats(path.c_str(), StreamFormat::Codec, stats, options));
+        expectStatsOf(figures, stats);
+    }
+
+    truncateFile(path, fileSize(path) - 3);
+    StreamStats stats;
+    EXPECT_FALSE(streamStats(path.c_str(), StreamFormat::Codec, stats));
+    EXPECT_FALSE(streamStats((path + ".missing").c_str(), StreamFormat::Codec, stats));
+    std::remove(path.c_str());
+}
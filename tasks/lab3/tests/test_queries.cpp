@@ -0,0 +1,681 @@
+#include <gtest/gtest.h>
+#include "Square.h"
+#include "Rectangle.h"
+#include "Trapezoid.h"
+#include "Array.h"
+#include "FigureIndex.h"
+#include "Intersection.h"
+#include "UnionArea.h"
+#include "ConvexHull.h"
+#include "ThreadPool.h"
+#include "Query.h"
+#include "QueryLanguage.h"
+#include <sstream>
+#include <cmath>
+#include <random>
+
+/**
+ * @file test_queries.cpp
+ *
+ * Тесты геометрических запросов над коллекциями фигур:
+ * принадлежность точки, пространственный индекс, пересечения,
+ * площадь объединения, выпуклая оболочка, составные запросы,
+ * язык запросов lab03.
+ */
+
+/**
+ * @brief Квадрат со стороной side, повернутый на angle вокруг (cx, cy)
+ */
+static Square* makeRotatedSquare(double cx, double cy, double side, double angle) {
+    Point p[4];
+    double h = side / 2;
+    double local[4][2] = {{-h, -h}, {h, -h}, {h, h}, {-h, h}};
+    for (int i = 0; i < 4; i++) {
+        double x = local[i][0], y = local[i][1];
+        p[i] = Point(cx + x * cos(angle) - y * sin(angle),
+                     cy + x * sin(angle) + y * cos(angle));
+    }
+    return new Square(p);
+}
+
+// ===================================================================
+// ГРУППА 1: ПРИНАДЛЕЖНОСТЬ ТОЧКИ ФИГУРЕ
+// ===================================================================
+
+/**
+ * Точка внутри, снаружи и на границе квадрата 2x2
+ */
+TEST(ContainsTest, SquareInsideOutsideBoundary) {
+    Point p[4] = {Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)};
+    Square sq(p);
+    EXPECT_TRUE(sq.contains(Point(1, 1)));
+    EXPECT_TRUE(sq.contains(Point(0, 1)));   // на стороне
+    EXPECT_TRUE(sq.contains(Point(2, 2)));   // в вершине
+    EXPECT_FALSE(sq.contains(Point(3, 1)));
+    EXPECT_FALSE(sq.contains(Point(-0.1, 1)));
+}
+
+/**
+ * Трапеция: точка внутри AABB, но вне самой фигуры
+ */
+TEST(ContainsTest, TrapezoidCornerOutside) {
+    Point p[4] = {Point(0, 0), Point(4, 0), Point(3, 2), Point(1, 2)};
+    Trapezoid trap(p);
+    EXPECT_TRUE(trap.bounds().contains(Point(0.2, 1.9)));
+    EXPECT_FALSE(trap.contains(Point(0.2, 1.9)));
+    EXPECT_TRUE(trap.contains(Point(2, 1)));
+}
+
+/**
+ * Ограничивающий прямоугольник
+ */
+TEST(ContainsTest, BoundingBox) {
+    Point p[4] = {Point(1, 1), Point(3, 1), Point(3, 4), Point(1, 4)};
+    Rectangle rect(p);
+    BoundingBox box = rect.bounds();
+    EXPECT_DOUBLE_EQ(box.minX, 1.0);
+    EXPECT_DOUBLE_EQ(box.minY, 1.0);
+    EXPECT_DOUBLE_EQ(box.maxX, 3.0);
+    EXPECT_DOUBLE_EQ(box.maxY, 4.0);
+}
+
+// ===================================================================
+// ГРУППА 2: ПРОСТРАНСТВЕННЫЙ ИНДЕКС
+// ===================================================================
+
+/**
+ * Пустая коллекция: ни одна точка не попадает
+ */
+TEST(FigureIndexTest, EmptyCollection) {
+    Array arr;
+    FigureIndex index(arr);
+    EXPECT_EQ(index.size(), 0);
+    EXPECT_EQ(index.locate(Point(0, 0)), -1);
+}
+
+/**
+ * Перекрывающиеся фигуры: locate() возвращает наименьший индекс,
+ * queryAll() - все фигуры по возрастанию
+ */
+TEST(FigureIndexTest, OverlappingFigures) {
+    Array arr;
+    Point p1[4] = {Point(0, 0), Point(4, 0), Point(4, 4), Point(0, 4)};
+    Point p2[4] = {Point(2, 2), Point(6, 2), Point(6, 4), Point(2, 4)};
+    arr.push(new Square(p1));
+    arr.push(new Rectangle(p2));
+    FigureIndex index(arr);
+
+    Point queries[3] = {Point(1, 1), Point(3, 3), Point(5, 3)};
+    int first[3];
+    index.locateAll(queries, 3, first);
+    EXPECT_EQ(first[0], 0);
+    EXPECT_EQ(first[1], 0);
+    EXPECT_EQ(first[2], 1);
+
+    PointHits hits;
+    index.queryAll(queries, 3, hits);
+    ASSERT_EQ(hits.pointCount(), 3);
+    EXPECT_EQ(hits.hitCount(0), 1);
+    ASSERT_EQ(hits.hitCount(1), 2);
+    EXPECT_EQ(hits.hits(1)[0], 0);
+    EXPECT_EQ(hits.hits(1)[1], 1);
+    EXPECT_EQ(hits.hitCount(2), 1);
+    EXPECT_EQ(hits.totalHits(), 4);
+}
+
+/**
+ * Случайные повернутые квадраты: индекс дает тот же ответ,
+ * что и перебор через Figure::contains()
+ */
+TEST(FigureIndexTest, MatchesBruteForce) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> pos(0, 100), size(0.5, 8), angle(0, 3.14);
+    Array arr;
+    for (int i = 0; i < 300; i++) {
+        arr.push(makeRotatedSquare(pos(rng), pos(rng), size(rng), angle(rng)));
+    }
+    FigureIndex index(arr);
+
+    const int n = 2000;
+    Point* queries = new Point[n];
+    for (int i = 0; i < n; i++) queries[i] = Point(pos(rng), pos(rng));
+    PointHits hits;
+    index.queryAll(queries, n, hits);
+
+    for (int i = 0; i < n; i++) {
+        int expected = 0;
+        for (int f = 0; f < arr.size(); f++) {
+            if (arr.get(f)->contains(queries[i])) {
+                ASSERT_LT(expected, hits.hitCount(i));
+                EXPECT_EQ(hits.hits(i)[expected], f);
+                expected++;
+            }
+        }
+        EXPECT_EQ(hits.hitCount(i), expected);
+    }
+    delete[] queries;
+}
+
+/**
+ * forEachCandidate сообщает каждую пересекающуюся фигуру ровно один раз,
+ * даже если она занимает несколько ячеек сетки
+ */
+TEST(FigureIndexTest, CandidatesReportedOnce) {
+    Array arr;
+    arr.push(makeRotatedSquare(50, 50, 60, 0.3));  // большая фигура на много ячеек
+    for (int i = 0; i < 100; i++) {
+        arr.push(makeRotatedSquare(i, i, 1, 0));
+    }
+    FigureIndex index(arr);
+
+    int seen[101] = {0};
+    index.forEachCandidate(BoundingBox(20, 20, 80, 80), [&](int f) { seen[f]++; });
+    EXPECT_EQ(seen[0], 1);
+    for (int f = 1; f <= 100; f++) {
+        bool overlaps = index.bounds(f).intersects(BoundingBox(20, 20, 80, 80));
+        EXPECT_EQ(seen[f], overlaps ? 1 : 0);
+    }
+}
+
+/**
+ * Область запроса далеко за границами коллекции (индекс ячейки вне
+ * диапазона int): кандидаты - все фигуры, а не только ячейка 0
+ */
+TEST(FigureIndexTest, BoxFarOutsideExtent) {
+    Array arr;
+    for (int i = 0; i < 100; i++) {
+        arr.push(makeRotatedSquare(i % 10 * 3, i / 10 * 3, 1, 0));
+    }
+    FigureIndex index(arr);
+
+    int seen = 0;
+    index.forEachCandidate(BoundingBox(-1e12, -1e12, 1e12, 1e12), [&](int) { seen++; });
+    EXPECT_EQ(seen, 100);
+    EXPECT_GE(index.cellEntriesIn(BoundingBox(-1e12, -1e12, 1e12, 1e12)), 100);
+
+    seen = 0;
+    index.forEachCandidate(BoundingBox(13.5, -1e300, 1e300, 1e300), [&](int) { seen++; });
+    EXPECT_EQ(seen, 50);
+}
+
+// ===================================================================
+// ГРУППА 3: ПЛОЩАДЬ ПЕРЕСЕЧЕНИЯ
+// ===================================================================
+
+/**
+ * Два квадрата 2x2 со сдвигом (1, 1): общая часть - квадрат 1x1
+ */
+TEST(IntersectionTest, ShiftedSquares) {
+    Point p1[4] = {Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)};
+    Point p2[4] = {Point(1, 1), Point(3, 1), Point(3, 3), Point(1, 3)};
+    Square a(p1), b(p2);
+    EXPECT_NEAR(a.intersectionArea(b), 1.0, 1e-12);
+    EXPECT_NEAR(b.intersectionArea(a), 1.0, 1e-12);
+}
+
+/**
+ * Вложенная фигура, касание по стороне и непересекающиеся фигуры
+ */
+TEST(IntersectionTest, ContainedTouchingDisjoint) {
+    Point outer[4] = {Point(0, 0), Point(4, 0), Point(4, 4), Point(0, 4)};
+    Point inner[4] = {Point(0, 0), Point(4, 0), Point(3, 2), Point(1, 2)};
+    Point touching[4] = {Point(4, 0), Point(6, 0), Point(6, 4), Point(4, 4)};
+    Point far[4] = {Point(10, 10), Point(11, 10), Point(11, 11), Point(10, 11)};
+    Square sq(outer);
+    Trapezoid trap(inner);
+    Rectangle side(touching);
+    Square away(far);
+    EXPECT_NEAR(sq.intersectionArea(trap), trap.area(), 1e-12);
+    EXPECT_NEAR(sq.intersectionArea(side), 0.0, 1e-12);
+    EXPECT_DOUBLE_EQ(sq.intersectionArea(away), 0.0);
+    EXPECT_NEAR(sq.intersectionArea(sq), sq.area(), 1e-12);
+}
+
+/**
+ * Квадрат, повернутый на 45° вокруг центра другого такого же квадрата:
+ * пересечение - правильный восьмиугольник
+ */
+TEST(IntersectionTest, RotatedSquareOctagon) {
+    Square* a = makeRotatedSquare(0, 0, 2, 0);
+    Square* b = makeRotatedSquare(0, 0, 2, atan(1.0));  // поворот на 45°
+    double expected = 8 * (sqrt(2.0) - 1);  // площадь восьмиугольника
+    EXPECT_NEAR(a->intersectionArea(*b), expected, 1e-9);
+    delete a;
+    delete b;
+}
+
+/**
+ * Пакетный вариант совпадает с попарным, неверные индексы дают 0
+ */
+TEST(IntersectionTest, BatchAreas) {
+    Array arr;
+    Point p1[4] = {Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)};
+    Point p2[4] = {Point(1, 0), Point(3, 0), Point(3, 1), Point(1, 1)};
+    arr.push(new Square(p1));
+    arr.push(new Rectangle(p2));
+    int first[3] = {0, 1, 0};
+    int second[3] = {1, 0, 5};
+    double out[3];
+    intersectionAreas(arr, first, second, 3, out);
+    EXPECT_NEAR(out[0], 1.0, 1e-12);
+    EXPECT_NEAR(out[1], 1.0, 1e-12);
+    EXPECT_DOUBLE_EQ(out[2], 0.0);
+}
+
+/**
+ * findOverlaps находит те же пары, что и полный перебор
+ */
+TEST(IntersectionTest, AllPairsMatchBruteForce) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> pos(0, 50), size(1, 6), angle(0, 3.14);
+    Array arr;
+    for (int i = 0; i < 200; i++) {
+        arr.push(makeRotatedSquare(pos(rng), pos(rng), size(rng), angle(rng)));
+    }
+
+    OverlapList overlaps;
+    findOverlaps(arr, overlaps);
+
+    int expectedPairs = 0;
+    for (int i = 0; i < arr.size(); i++) {
+        for (int j = i + 1; j < arr.size(); j++) {
+            if (arr.get(i)->intersectionArea(*arr.get(j)) > 0) expectedPairs++;
+        }
+    }
+    EXPECT_EQ(overlaps.size(), expectedPairs);
+    for (int k = 0; k < overlaps.size(); k++) {
+        const Overlap& o = overlaps[k];
+        EXPECT_LT(o.first, o.second);
+        EXPECT_DOUBLE_EQ(o.area, arr.get(o.first)->intersectionArea(*arr.get(o.second)));
+    }
+}
+
+// ===================================================================
+// ГРУППА 4: ПЛОЩАДЬ ОБЪЕДИНЕНИЯ
+// ===================================================================
+
+/**
+ * Без перекрытий площадь объединения равна totalArea()
+ */
+TEST(UnionAreaTest, DisjointEqualsTotal) {
+    Array arr;
+    Point p1[4] = {Point(0, 0), Point(1, 0), Point(1, 1), Point(0, 1)};
+    Point p2[4] = {Point(5, 0), Point(7, 0), Point(7, 1), Point(5, 1)};
+    Point p3[4] = {Point(0, 5), Point(4, 5), Point(3, 7), Point(1, 7)};
+    arr.push(new Square(p1));
+    arr.push(new Rectangle(p2));
+    arr.push(new Trapezoid(p3));
+    EXPECT_NEAR(arr.unionArea(), arr.totalArea(), 1e-9);
+}
+
+/**
+ * Два квадрата 2x2 с перекрытием 1x1: 4 + 4 - 1 = 7
+ */
+TEST(UnionAreaTest, OverlapCountedOnce) {
+    Array arr;
+    Point p1[4] = {Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)};
+    Point p2[4] = {Point(1, 1), Point(3, 1), Point(3, 3), Point(1, 3)};
+    arr.push(new Square(p1));
+    arr.push(new Square(p2));
+    EXPECT_DOUBLE_EQ(arr.totalArea(), 8.0);
+    EXPECT_NEAR(arr.unionArea(), 7.0, 1e-9);
+}
+
+/**
+ * Одинаковые фигуры и фигуры, касающиеся сторонами
+ */
+TEST(UnionAreaTest, DuplicatesAndSharedEdges) {
+    Array arr;
+    Point p1[4] = {Point(0, 0), Point(2, 0), Point(2, 2), Point(0, 2)};
+    Point p2[4] = {Point(2, 0), Point(4, 0), Point(4, 2), Point(2, 2)};
+    arr.push(new Square(p1));
+    arr.push(new Square(p1));
+    arr.push(new Square(p1));
+    arr.push(new Square(p2));
+    EXPECT_NEAR(arr.unionArea(), 8.0, 1e-9);
+}
+
+/**
+ * Пара фигур: union = a + b - intersection
+ */
+TEST(UnionAreaTest, InclusionExclusionForPairs) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> pos(0, 4), size(1, 5), angle(0, 3.14);
+    for (int trial = 0; trial < 50; trial++) {
+        Array arr;
+        arr.push(makeRotatedSquare(pos(rng), pos(rng), size(rng), angle(rng)));
+        arr.push(makeRotatedSquare(pos(rng), pos(rng), size(rng), angle(rng)));
+        double expected = arr.totalArea() - arr.get(0)->intersectionArea(*arr.get(1));
+        EXPECT_NEAR(arr.unionArea(), expected, 1e-9);
+    }
+}
+
+/**
+ * Параллельный вариант совпадает с последовательным
+ */
+TEST(UnionAreaTest, ParallelMatchesSequential) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> pos(0, 60), size(1, 8), angle(0, 3.14);
+    Array arr;
+    for (int i = 0; i < 400; i++) {
+        arr.push(makeRotatedSquare(pos(rng), pos(rng), size(rng), angle(rng)));
+    }
+    double sequential = unionArea(arr);
+    EXPECT_LT(sequential, arr.totalArea());
+    ThreadPool pool(4);
+    EXPECT_NEAR(unionAreaParallel(arr, &pool), sequential, 1e-7);
+}
+
+// ===================================================================
+// ГРУППА 5: ВЫПУКЛАЯ ОБОЛОЧКА
+// ===================================================================
+
+/**
+ * Оболочка квадрата с внутренними и коллинеарными точками - 4 вершины
+ * против часовой стрелки
+ */
+TEST(ConvexHullTest, SquareWithInnerPoints) {
+    Point p[7] = {Point(1, 1), Point(0, 0), Point(2, 2), Point(1, 0),
+                  Point(2, 0), Point(0, 2), Point(0.5, 1.5)};
+    int h = convexHull(p, 7);
+    ASSERT_EQ(h, 4);
+    EXPECT_DOUBLE_EQ(Figure::polygonArea(p, h), 4.0);
+    for (int i = 0; i < h; i++) {
+        const Point& a = p[i];
+        const Point& b = p[(i + 1) % h];
+        const Point& c = p[(i + 2) % h];
+        EXPECT_GT((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x), 0);
+    }
+}
+
+/**
+ * Вырожденные наборы: совпадающие точки
+ */
+TEST(ConvexHullTest, DegenerateInputs) {
+    Point same[3] = {Point(1, 1), Point(1, 1), Point(1, 1)};
+    EXPECT_EQ(convexHull(same, 3), 1);
+    Point two[2] = {Point(1, 1), Point(1, 1)};
+    EXPECT_EQ(convexHull(two, 2), 1);
+}
+
+/**
+ * Оболочка коллекции: параллельный вариант совпадает с последовательным,
+ * потоковый - тоже
+ */
+TEST(ConvexHullTest, ParallelAndStreamingMatch) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> pos(-100, 100), size(1, 10), angle(0, 3.14);
+    Array arr;
+    StreamingHull streaming;
+    for (int i = 0; i < 500; i++) {
+        Square* sq = makeRotatedSquare(pos(rng), pos(rng), size(rng), angle(rng));
+        arr.push(sq);
+        streaming.push(*sq);
+    }
+
+    Point* sequential = new Point[4 * arr.size()];
+    Point* parallel = new Point[4 * arr.size()];
+    ThreadPool single(1), pool(4);
+    int hs = collectionHull(arr, sequential, &single);
+    int hp = collectionHull(arr, parallel, &pool);
+    ASSERT_EQ(hs, hp);
+    ASSERT_EQ(hs, streaming.size());
+    for (int i = 0; i < hs; i++) {
+        EXPECT_DOUBLE_EQ(sequential[i].x, parallel[i].x);
+        EXPECT_DOUBLE_EQ(sequential[i].y, parallel[i].y);
+        EXPECT_DOUBLE_EQ(sequential[i].x, streaming.points()[i].x);
+        EXPECT_DOUBLE_EQ(sequential[i].y, streaming.points()[i].y);
+    }
+
+    // Все вершины всех фигур лежат внутри оболочки
+    Point* hull = sequential;
+    for (int f = 0; f < arr.size(); f++) {
+        const Point* p = arr.get(f)->getPoints();
+        for (int k = 0; k < 4; k++) {
+            for (int i = 0; i < hs; i++) {
+                const Point& a = hull[i];
+                const Point& b = hull[(i + 1) % hs];
+                EXPECT_GE((b.x - a.x) * (p[k].y - a.y) - (b.y - a.y) * (p[k].x - a.x), -1e-9);
+            }
+        }
+    }
+    delete[] sequential;
+    delete[] parallel;
+}
+
+// ===================================================================
+// ГРУППА 6: СОСТАВНЫЕ ЗАПРОСЫ
+// ===================================================================
+
+/*
+  Квадраты, прямоугольники и трапеции по очереди, центры на сетке
+*/
+static void fillMixed(Array& arr, int n) {
+    for (int i = 0; i < n; i++) {
+        double x = i % 100, y = i / 100;
+        if (i % 3 == 0) {
+            arr.push(makeRotatedSquare(x, y, 0.5 + (i % 7) * 0.1, i * 0.1));
+        } else if (i % 3 == 1) {
+            Point r[4] = {Point(x - 1, y), Point(x + 1, y), Point(x + 1, y + 0.5), Point(x - 1, y + 0.5)};
+            arr.push(new Rectangle(r));
+        } else {
+            Point t[4] = {Point(x - 1, y), Point(x + 1, y), Point(x + 0.5, y + 1), Point(x - 0.5, y + 1)};
+            arr.push(new Trapezoid(t));
+        }
+    }
+}
+
+/**
+ * Фильтры и map за один проход дают то же, что и ручной цикл
+ */
+TEST(QueryTest, FusedStepsMatchManualLoop) {
+    Array arr;
+    fillMixed(arr, 3000);
+    BoundingBox region(10, 5, 60, 20);
+
+    double expected = 0;
+    int squares = 0;
+    for (int i = 0; i < arr.size(); i++) {
+        const Figure* fig = arr.get(i);
+        if (figureKind(*fig) != FigureKind::Square) continue;
+        squares++;
+        if (region.contains(fig->center())) expected += fig->area();
+    }
+
+    double area = query(arr)
+        .filter(ofKind(FigureKind::Square))
+        .filter(centerIn(region))
+        .map([](const Figure& fig) { return fig.area(); })
+        .sum();
+    EXPECT_DOUBLE_EQ(area, expected);
+    EXPECT_EQ(query(arr).filter(ofKind(FigureKind::Square)).count(), squares);
+
+    // map меняет тип значения, фильтр после map работает с ним
+    int large = query(arr)
+        .map([](const Figure& fig) { return fig.area(); })
+        .filter([](double a) { return a > 1.5; })
+        .count();
+    int manual = 0;
+    for (int i = 0; i < arr.size(); i++) manual += arr.get(i)->area() > 1.5;
+    EXPECT_EQ(large, manual);
+
+    // forEach идет по порядку фигур
+    int next = 0;
+    bool ordered = true;
+    query(arr).filter(boundsIntersect(region)).forEach([&](const Figure& fig) {
+        while (next < arr.size() && arr.get(next) != &fig) next++;
+        ordered = ordered && next < arr.size();
+        next++;
+    });
+    EXPECT_TRUE(ordered);
+    EXPECT_GT(next, 0);
+    EXPECT_EQ(query(arr).filter(centerIn(BoundingBox(1000, 1000, 1001, 1001))).sum(), 0);
+}
+
+/**
+ * Параллельный проход совпадает с последовательным и не зависит
+ * от запуска (частичные суммы сливаются по порядку)
+ */
+TEST(QueryTest, ParallelMatchesSequential) {
+    Array arr;
+    fillMixed(arr, 50000);
+    ThreadPool pool(4);
+
+    auto areaOfRectangles = query(arr)
+        .filter(ofKind(FigureKind::Rectangle))
+        .map([](const Figure& fig) { return fig.area(); });
+    double sequential = areaOfRectangles.sum();
+    double parallel = areaOfRectangles.parallel(&pool).sum();
+    EXPECT_NEAR(parallel, sequential, 1e-9 * sequential);
+    for (int run = 0; run < 5; run++) EXPECT_EQ(areaOfRectangles.parallel(&pool).sum(), parallel);
+
+    EXPECT_EQ(query(arr).parallel(&pool).count(), arr.size());
+    double maxX = query(arr).parallel(&pool)
+        .map([](const Figure& fig) { return fig.bounds().maxX; })
+        .reduce(-1e300, [](double m, double x) { return x > m ? x : m; },
+                [](double a, double b) { return a > b ? a : b; });
+    EXPECT_DOUBLE_EQ(maxX, 100);
+}
+
+// ===================================================================
+// ГРУППА 7: ЯЗЫК ЗАПРОСОВ
+// ===================================================================
+
+/**
+ * Условия одного вида сливаются при компиляции, ошибки указывают место
+ */
+TEST(QueryLanguageTest, CompileMergesConditions) {
+    QueryPlan plan;
+    ASSERT_TRUE(compileQuery("select count, Sum(area) where TYPE != Trapezoid and area > 1 "
+                             "and area >= 4 and area < 10 and center in box(10, 10, 0, 0) "
+                             "and center IN box(5, -5, 20, 8)", plan));
+    EXPECT_EQ(plan.aggregateCount, 2);
+    EXPECT_EQ(plan.aggregates[1], QueryAggregate::Sum);
+    EXPECT_EQ(plan.kindMask, 3);
+    EXPECT_EQ(plan.areaMin, 4);
+    EXPECT_FALSE(plan.areaMinStrict);
+    EXPECT_EQ(plan.areaMax, 10);
+    EXPECT_TRUE(plan.areaMaxStrict);
+    EXPECT_EQ(plan.centerBox.minX, 5);
+    EXPECT_EQ(plan.centerBox.minY, 0);
+    EXPECT_EQ(plan.centerBox.maxX, 10);
+    EXPECT_EQ(plan.centerBox.maxY, 8);
+    EXPECT_FALSE(plan.empty);
+
+    ASSERT_TRUE(compileQuery("SELECT COUNT WHERE type=Square AND type=Rectangle", plan));
+    EXPECT_TRUE(plan.empty);
+    ASSERT_TRUE(compileQuery("SELECT COUNT WHERE area > 5 AND area < 5", plan));
+    EXPECT_EQ(plan.access(100, nullptr), QueryAccess::Empty);
+
+    std::string error;
+    EXPECT_FALSE(compileQuery("SELECT", plan, &error));
+    EXPECT_NE(error.find("конец запроса"), std::string::npos);
+    EXPECT_FALSE(compileQuery("SELECT SUM(perimeter)", plan, &error));
+    EXPECT_NE(error.find("perimeter"), std::string::npos);
+    EXPECT_FALSE(compileQuery("SELECT COUNT WHERE area ~ 3", plan, &error));
+    EXPECT_FALSE(compileQuery("SELECT COUNT WHERE center IN box(1, 2, 3)", plan, &error));
+    EXPECT_FALSE(compileQuery("SELECT COUNT extra", plan, &error));
+}
+
+/**
+ * Все пути доступа дают тот же результат, что и ручной перебор
+ */
+TEST(QueryLanguageTest, AccessPathsAgreeWithManualScan) {
+    Array arr;
+    fillMixed(arr, 20000);
+    FigureIndex index(arr);
+    ThreadPool pool(3);
+
+    const char* queries[] = {
+        "SELECT COUNT, SUM(area), MIN(area), MAX(area) WHERE type=Square AND area>0.5",
+        "SELECT COUNT, SUM(area) WHERE center IN box(10, 10, 40, 30) AND type != Rectangle",
+        "SELECT COUNT, AVG(area) WHERE bounds INTERSECTS box(0, 0, 5, 5) AND area <= 1.5",
+        "SELECT COUNT, SUM(area) WHERE CONTAINS point(20.1, 20.2)",
+    };
+    QueryAccess expectedAccess[] = {QueryAccess::ParallelScan, QueryAccess::IndexBox,
+                                    QueryAccess::IndexBox, QueryAccess::IndexPoint};
+    BoundingBox center(10, 10, 40, 30), bounds(0, 0, 5, 5);
+    Point point(20.1, 20.2);
+
+    for (int q = 0; q < 4; q++) {
+        QueryPlan plan;
+        ASSERT_TRUE(compileQuery(queries[q], plan));
+
+        int count = 0;
+        double sum = 0, minArea = 1e300;
+        for (int i = 0; i < arr.size(); i++) {
+            const Figure* fig = arr.get(i);
+            double a = fig->area();
+            bool ok = false;
+            switch (q) {
+                case 0: ok = figureKind(*fig) == FigureKind::Square && a > 0.5; break;
+                case 1: ok = center.contains(fig->center()) && figureKind(*fig) != FigureKind::Rectangle; break;
+                case 2: ok = bounds.intersects(fig->bounds()) && a <= 1.5; break;
+                default: ok = fig->contains(point); break;
+            }
+            if (!ok) continue;
+            count++;
+            sum += a;
+            if (a < minArea) minArea = a;
+        }
+        ASSERT_GT(count, 0) << queries[q];
+
+        QueryResult indexed = runQuery(plan, arr, &index, &pool);
+        QueryResult scanned = runQuery(plan, arr, nullptr, &pool);
+        EXPECT_EQ(indexed.access, expectedAccess[q]) << queries[q];
+        EXPECT_EQ(scanned.access, QueryAccess::ParallelScan);
+        for (QueryResult* r : {&indexed, &scanned}) {
+            EXPECT_EQ(r->count, count) << queries[q];
+            EXPECT_NEAR(r->sum, sum, 1e-9 * sum) << queries[q];
+            if (q == 0) {
+                EXPECT_EQ(r->value(QueryAggregate::Min), minArea);
+            }
+        }
+    }
+
+    // Область на всю коллекцию: кандидатов индекса больше, чем фигур
+    QueryPlan wide;
+    ASSERT_TRUE(compileQuery("SELECT COUNT WHERE center IN box(-1000, -1000, 1000, 1000)", wide));
+    QueryResult all = runQuery(wide, arr, &index, &pool);
+    EXPECT_EQ(all.access, QueryAccess::ParallelScan);
+    EXPECT_EQ(all.count, arr.size());
+
+    // Области далеко за границами коллекции: индекс и просмотр совпадают
+    Array unit;
+    for (int i = 0; i < 100; i++) {
+        Point p[4] = {Point(3 * i, 0), Point(3 * i + 1, 0), Point(3 * i + 1, 1), Point(3 * i, 1)};
+        unit.push(new Square(p));
+    }
+    FigureIndex unitIndex(unit);
+    const char* huge[] = {
+        "SELECT COUNT, SUM(area) WHERE center IN box(-1e12, -1e12, 1e12, 1e12)",
+        "SELECT COUNT, SUM(area) WHERE bounds INTERSECTS box(-1e300, -1e300, 1e300, 1e300)",
+        "SELECT COUNT, SUM(area) WHERE center IN box(149.9, -1e12, 1e12, 1e12)",
+    };
+    for (const char* text : huge) {
+        QueryPlan plan;
+        ASSERT_TRUE(compileQuery(text, plan));
+        QueryResult indexed = runQuery(plan, unit, &unitIndex);
+        QueryResult scanned = runQuery(plan, unit);
+        EXPECT_EQ(indexed.count, scanned.count) << text;
+        EXPECT_EQ(indexed.sum, scanned.sum) << text;
+    }
+    // Правая половина: план выбирает индекс по обрезанной области
+    QueryPlan half;
+    ASSERT_TRUE(compileQuery(huge[2], half));
+    QueryResult halfIndexed = runQuery(half, unit, &unitIndex);
+    EXPECT_EQ(halfIndexed.access, QueryAccess::IndexBox);
+    EXPECT_EQ(halfIndexed.count, 50);
+
+    // Маленькая коллекция без индекса - последовательный просмотр
+    Array few;
+    fillMixed(few, 10);
+    QueryPlan plan;
+    ASSERT_TRUE(compileQuery("EXPLAIN SELECT COUNT WHERE area > 0", plan));
+    EXPECT_TRUE(plan.explain);
+    EXPECT_EQ(runQuery(plan, few).access, QueryAccess::Scan);
+    EXPECT_EQ(runQuery(plan, few).count, 10);
+    std::ostringstream os;
+    plan.describe(os, few.size(), nullptr);
+    EXPECT_EQ(os.str().find("scan"), 0u);
+}
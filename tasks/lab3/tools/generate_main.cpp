@@ -0,0 +1,77 @@
+#include "Generator.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+/**
+ * @file generate_main.cpp
+ * @brief Генератор синтетических наборов фигур для нагрузочных тестов
+ *
+ * Запуск: ./generate 100000000 figures.txt [--binary] [--seed 1]
+ *         [--scale 1000] [--overlap 1] [--duplicates 0] [--no-rotate]
+ *         [--threads 0]
+ *
+ * Text читают ingestFigures() и streamStats(StreamFormat::Text),
+ * --binary - streamStats(StreamFormat::Codec) и decodeFigures() по кадрам.
+ * Одинаковые параметры дают побайтно одинаковый файл.
+ */
+
+static void usage() {
+    std::cerr << "Использование: generate N файл [--binary] [--seed S] [--scale X]"
+                 " [--overlap D] [--duplicates R] [--no-rotate] [--threads T]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        usage();
+        return 2;
+    }
+    long long count = std::atoll(argv[1]);
+    const char* path = argv[2];
+    StreamFormat format = StreamFormat::Text;
+    GeneratorOptions options;
+    int threads = 0;
+
+    for (int i = 3; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--binary") == 0) {
+            format = StreamFormat::Codec;
+        } else if (std::strcmp(argv[i], "--no-rotate") == 0) {
+            options.rotate = false;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--scale") == 0 && hasValue) {
+            options.scale = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--overlap") == 0 && hasValue) {
+            options.overlap = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--duplicates") == 0 && hasValue) {
+            options.duplicateRatio = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Неизвестный аргумент: " << argv[i] << std::endl;
+            usage();
+            return 2;
+        }
+    }
+    if (count < 0 || options.scale <= 0 || options.overlap <= 0 ||
+        options.duplicateRatio < 0 || options.duplicateRatio >= 1) {
+        usage();
+        return 2;
+    }
+
+    ThreadPool pool(threads);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    long long bytes = generateFigures(path, format, count, options, &pool);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (bytes < 0) {
+        std::cerr << "Ошибка записи: " << path << std::endl;
+        return 1;
+    }
+    std::cerr << count << " фигур, " << bytes / 1048576.0 << " МБ за " << seconds << " с ("
+              << count / seconds / 1e6 << " млн фигур/с, " << pool.getThreadCount() << " потоков)"
+              << std::endl;
+    return 0;
+}